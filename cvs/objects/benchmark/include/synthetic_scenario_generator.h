@@ -0,0 +1,138 @@
+#ifndef _SYNTHETIC_SCENARIO_GENERATOR_H_
+#define _SYNTHETIC_SCENARIO_GENERATOR_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file synthetic_scenario_generator.h
+ * \ingroup Objects
+ * \brief SyntheticScenarioGenerator class header file.
+ */
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+class Tabs;
+
+/*!
+ * \ingroup Objects
+ * \brief Writes synthetic but structurally realistic scenarios which can be
+ *        used to benchmark the model at arbitrary sizes.
+ * \details The generated scenario uses the same XML structure as the inputs
+ *          produced by the data system.  Each region contains:
+ *          - Population and GDP drivers.
+ *          - A number of depletable resources, each of which is a regional
+ *            market, set by the "markets" size.
+ *          - A chain of supply sectors where each subsector holds a single
+ *            technology.  Technologies of the first sector consume resources
+ *            while technologies of later sectors consume the output of earlier
+ *            sectors so that the dependencies are acyclic but densely linked.
+ *            Technologies are vintaged when the "vintages" size is greater
+ *            than one.
+ *          - Final demands for the last few sectors.
+ *          - A land allocator with the given number of land nodes each
+ *            containing a few unmanaged leaves with carbon densities.
+ *
+ *          Each region is written to its own scenario component so that parsing
+ *          exercises concurrent component loading.  A configuration file which
+ *          reads the scenario and enables solver telemetry is written alongside
+ *          it.
+ */
+class SyntheticScenarioGenerator {
+public:
+    SyntheticScenarioGenerator();
+
+    bool setSize( const std::string& aName, const int aValue );
+
+    void setSolverConfig( const std::string& aFileName );
+
+    bool generate( const std::string& aDirectory ) const;
+
+    void printSizes( std::ostream& aOut ) const;
+
+private:
+    //! The number of regions.
+    int mNumRegions;
+
+    //! The number of supply sectors in each region.
+    int mNumSectors;
+
+    //! The number of technologies in each sector.
+    int mNumTechnologies;
+
+    //! The number of vintages each technology operates for.
+    int mNumVintages;
+
+    //! The number of land nodes in each region.
+    int mNumLandNodes;
+
+    //! The number of resource markets in each region.
+    int mNumMarkets;
+
+    //! The solver configuration file to include as a scenario component.
+    std::string mSolverConfig;
+
+    //! The model years of the generated scenario.
+    std::vector<int> mYears;
+
+    //! The final calibration year of the generated scenario.
+    int mFinalCalibrationYear;
+
+    int getTimeStep( const size_t aYearIndex ) const;
+
+    void writeModelTime( std::ostream& aOut, Tabs* aTabs ) const;
+
+    void writeRegion( const int aRegion, std::ostream& aOut, Tabs* aTabs ) const;
+
+    void writeResources( const std::string& aRegionName, const int aRegion,
+                         std::ostream& aOut, Tabs* aTabs ) const;
+
+    void writeSectors( const std::string& aRegionName, std::ostream& aOut, Tabs* aTabs ) const;
+
+    void writeFinalDemands( const int aRegion, std::ostream& aOut, Tabs* aTabs ) const;
+
+    void writeLand( const int aRegion, std::ostream& aOut, Tabs* aTabs ) const;
+
+    void writeConfiguration( const std::string& aDirectory,
+                             const std::vector<std::string>& aComponents,
+                             std::ostream& aOut ) const;
+
+    static std::string getRegionName( const int aRegion );
+};
+
+#endif // _SYNTHETIC_SCENARIO_GENERATOR_H_
@@ -0,0 +1,401 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file benchmark_main.cpp
+ * \ingroup Objects
+ * \brief Entry point for the GCAM benchmark.
+ * \details The benchmark has two modes.  With --generate it writes a synthetic
+ *          scenario of the requested size, see SyntheticScenarioGenerator.
+ *          Otherwise it runs the scenario given by the configuration file one
+ *          period at a time and writes the following measurements as JSON:
+ *          - The time to parse and set up the scenario.
+ *          - The solve time and solver iterations of each period.  Iterations
+ *            are only available when the "solver-telemetry" file is enabled,
+ *            which it is for generated scenarios.
+ *          - The total time spent calculating Jacobians while solving.
+ *          - The time to write output.
+ *          - World::calc throughput, measured as a batch of full model
+ *            evaluations at the solved prices of the final period.
+ *          - The time for fdjac to calculate the full Jacobian of the final
+ *            period.
+ *          - The peak resident set size of the process.
+ */
+
+#include "util/base/include/definitions.h"
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <memory>
+#include <list>
+#include <vector>
+#include <cstdlib>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_scheduler_init.h>
+#endif
+
+#include "util/base/include/xml_helper.h"
+#include "util/base/include/configuration.h"
+#include "util/base/include/model_time.h"
+#include "util/base/include/timer.h"
+#include "util/base/include/util.h"
+#include "containers/include/scenario.h"
+#include "containers/include/iscenario_runner.h"
+#include "containers/include/scenario_runner_factory.h"
+#include "util/logger/include/ilogger.h"
+#include "util/logger/include/logger_factory.h"
+#include "reporting/include/xml_db_async_writer.h"
+#include "solution/util/include/solver_telemetry.h"
+#include "util/base/include/activity_profiler.h"
+#include "solution/util/include/period_evaluator.h"
+#include "benchmark/include/synthetic_scenario_generator.h"
+
+using namespace std;
+
+// Globals which are expected to be defined by the executable.
+ofstream outFile;
+Scenario* scenario;
+
+namespace {
+    //! Measurements of a single period.
+    struct PeriodResult {
+        //! The model period.
+        int mPeriod;
+
+        //! The model year.
+        int mYear;
+
+        //! Whether the period solved.
+        bool mSolved;
+
+        //! Time in seconds to calculate the period.
+        double mSolveTime;
+
+        //! Solver iterations or -1 if not known.
+        int mNumIterations;
+    };
+
+    /*!
+     * \brief Write a string value to JSON, escaping as necessary.
+     * \param aOut The stream to write to.
+     * \param aValue The value to write.
+     */
+    void writeString( ostream& aOut, const string& aValue ) {
+        aOut << '"';
+        for( string::const_iterator it = aValue.begin(); it != aValue.end(); ++it ) {
+            if( *it == '"' || *it == '\\' ) {
+                aOut << '\\';
+            }
+            aOut << *it;
+        }
+        aOut << '"';
+    }
+
+    /*!
+     * \brief Get the peak resident set size of this process.
+     * \return The peak RSS in megabytes, or -1 if it is not available.
+     */
+    double getPeakRSS() {
+#if defined(_WIN32)
+        return -1;
+#else
+        struct rusage usage;
+        if( getrusage( RUSAGE_SELF, &usage ) != 0 ) {
+            return -1;
+        }
+#if defined(__APPLE__)
+        // Reported in bytes.
+        return usage.ru_maxrss / ( 1024.0 * 1024.0 );
+#else
+        // Reported in kilobytes.
+        return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+    }
+}
+
+void parseArgs( unsigned int argc, char* argv[], string& confArg, string& logFacArg,
+                string& resultsArg, int& numEvals, string& generateDir,
+                SyntheticScenarioGenerator& aGenerator );
+void printUsageMessage( unsigned int argc, char* argv[] );
+
+//! Benchmark program.
+int main( int argc, char *argv[] ) {
+    string configurationArg = "configuration.xml";
+    string loggerFactoryArg = "log_conf.xml";
+    string resultsArg = "benchmark-results.json";
+    string generateDir;
+    int numEvals = 32;
+    SyntheticScenarioGenerator generator;
+    parseArgs( argc, argv, configurationArg, loggerFactoryArg, resultsArg, numEvals,
+               generateDir, generator );
+
+    if( !generateDir.empty() ) {
+        cout << "Generating synthetic scenario in " << generateDir << " with ";
+        generator.printSizes( cout );
+        if( !generator.generate( generateDir ) ) {
+            cout << "Could not write the synthetic scenario to " << generateDir << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    Timer timer;
+    timer.start();
+
+    // Initialize the LoggerFactory
+    LoggerFactoryWrapper loggerFactoryWrapper;
+    bool success = XMLHelper<void>::parseXML( loggerFactoryArg, &loggerFactoryWrapper );
+    if( !success ){
+        return 1;
+    }
+
+    // Parse configuration file.
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    mainLog.setLevel( ILogger::NOTICE );
+    mainLog << "Parsing input files..." << endl;
+    Configuration* conf = Configuration::getInstance();
+    success = XMLHelper<void>::parseXML( configurationArg, conf );
+    if( !success ){
+        return 1;
+    }
+
+    // Always use a single scenario runner, other runners would run the
+    // scenario many times.
+    auto_ptr<IScenarioRunner> runner = ScenarioRunnerFactory::create( "single-scenario-runner" );
+
+    Timer parseTimer;
+    parseTimer.start();
+    success = runner->setupScenarios( timer );
+    parseTimer.stop();
+    if( !success ){
+        return 1;
+    }
+
+    // Run one period at a time so that each can be timed.
+    Scenario* benchScenario = runner->getInternalScenario();
+    const Modeltime* modeltime = benchScenario->getModeltime();
+    vector<PeriodResult> periodResults;
+    Timer solveTimer;
+    for( int period = 0; period < modeltime->getmaxper(); ++period ) {
+        Timer periodTimer;
+        periodTimer.start();
+        solveTimer.start();
+        PeriodResult result;
+        result.mPeriod = period;
+        result.mYear = modeltime->getper_to_yr( period );
+        result.mSolved = runner->runScenarios( period, false, timer );
+        solveTimer.stop();
+        periodTimer.stop();
+        result.mSolveTime = periodTimer.getTotalTimeDifference();
+        result.mNumIterations = SolverTelemetry::getInstance().getNumIterations( period );
+        periodResults.push_back( result );
+    }
+    const double jacobianTime = TimerRegistry::getInstance().getTimer( TimerRegistry::JACOBIAN ).getTotalTimeDifference();
+
+    Timer outputTimer;
+    outputTimer.start();
+    runner->printOutput( timer );
+    // Include any database output still being written in the background.
+    XMLDBAsyncWriter::shutdown();
+    outputTimer.stop();
+
+    // Measure model evaluation throughput at the solution of the final period.
+    const int finalPeriod = modeltime->getmaxper() - 1;
+    int numMarkets = 0;
+    Timer calcTimer;
+    Timer fdjacTimer;
+    {
+        PeriodEvaluator evaluator( benchScenario, finalPeriod );
+        const vector<double> prices = evaluator.getPrices();
+        numMarkets = static_cast<int>( prices.size() );
+        vector<vector<double> > batch( numEvals, prices );
+        vector<vector<double> > excessDemands;
+        calcTimer.start();
+        evaluator.evaluate( batch, excessDemands );
+        calcTimer.stop();
+
+        vector<int> columns( numMarkets );
+        for( int i = 0; i < numMarkets; ++i ) {
+            columns[ i ] = i;
+        }
+        vector<double> baseExcessDemands;
+        vector<PeriodEvaluator::JacobianEntry> jacobian;
+        fdjacTimer.start();
+        evaluator.evaluateJacobian( prices, columns, baseExcessDemands, jacobian );
+        fdjacTimer.stop();
+    }
+
+#if GCAM_PARALLEL_ENABLED
+    const int numThreads = tbb::task_scheduler_init::default_num_threads();
+#else
+    const int numThreads = 1;
+#endif
+    const double peakRSS = getPeakRSS();
+    const double calcTime = calcTimer.getTotalTimeDifference();
+
+    ofstream results( resultsArg.c_str() );
+    util::checkIsOpen( results, resultsArg );
+    results << setprecision( 10 );
+    results << "{\n  \"configuration\": ";
+    writeString( results, configurationArg );
+    results << ",\n  \"threads\": " << numThreads
+            << ",\n  \"parse-time\": " << parseTimer.getTotalTimeDifference()
+            << ",\n  \"solve-time\": " << solveTimer.getTotalTimeDifference()
+            << ",\n  \"jacobian-time\": " << jacobianTime
+            << ",\n  \"output-time\": " << outputTimer.getTotalTimeDifference()
+            << ",\n  \"periods\": [";
+    for( size_t i = 0; i < periodResults.size(); ++i ) {
+        results << ( i == 0 ? "\n" : ",\n" )
+                << "    { \"period\": " << periodResults[ i ].mPeriod
+                << ", \"year\": " << periodResults[ i ].mYear
+                << ", \"solved\": " << ( periodResults[ i ].mSolved ? "true" : "false" )
+                << ", \"solve-time\": " << periodResults[ i ].mSolveTime
+                << ", \"iterations\": ";
+        if( periodResults[ i ].mNumIterations >= 0 ) {
+            results << periodResults[ i ].mNumIterations;
+        }
+        else {
+            results << "null";
+        }
+        results << " }";
+    }
+    results << ( periodResults.empty() ? "]" : "\n  ]" )
+            << ",\n  \"calc\": { \"period\": " << finalPeriod
+            << ", \"markets\": " << numMarkets
+            << ", \"evaluations\": " << numEvals
+            << ", \"time\": " << calcTime
+            << ", \"evaluations-per-second\": ";
+    if( calcTime > 0 ) {
+        results << numEvals / calcTime;
+    }
+    else {
+        results << "null";
+    }
+    results << " },\n  \"fdjac\": { \"period\": " << finalPeriod
+            << ", \"columns\": " << numMarkets
+            << ", \"time\": " << fdjacTimer.getTotalTimeDifference()
+            << " },\n  \"peak-rss-mb\": ";
+    if( peakRSS >= 0 ) {
+        results << peakRSS;
+    }
+    else {
+        results << "null";
+    }
+    results << "\n}\n";
+    results.close();
+
+    mainLog.setLevel( ILogger::WARNING );
+    mainLog << "Benchmark results written to " << resultsArg << endl;
+    ActivityProfiler::getInstance().flush();
+    runner->cleanup();
+    SolverTelemetry::getInstance().write();
+    ActivityProfiler::getInstance().write();
+    XMLHelper<void>::cleanupParser();
+
+    bool allSolved = true;
+    for( size_t i = 0; i < periodResults.size(); ++i ) {
+        allSolved &= periodResults[ i ].mSolved;
+    }
+    return allSolved ? 0 : 1;
+}
+
+/*!
+* \brief Function to parse the command line arguments.
+* \param argc Number of arguments.
+* \param argv List of arguments.
+* \param confArg [out] Name of the configuration file.
+* \param logFacArg [out] Name of the log configuration file.
+* \param resultsArg [out] Name of the file to write results to.
+* \param numEvals [out] Number of model evaluations used to measure throughput.
+* \param generateDir [out] Directory to generate a synthetic scenario into.
+* \param aGenerator [out] Synthetic scenario generator to set sizes in.
+*/
+void parseArgs( unsigned int argc, char* argv[], string& confArg, string& logFacArg,
+                string& resultsArg, int& numEvals, string& generateDir,
+                SyntheticScenarioGenerator& aGenerator )
+{
+    for( unsigned int i = 1; i < argc; i += 2 ){
+        string temp( argv[ i ] );
+        if( ( i + 1 ) == argc ) {
+            cout << "Not enough arguments" << endl;
+            printUsageMessage( argc, argv );
+            abort();
+        }
+        const string value( argv[ i + 1 ] );
+        if( temp == "-C" ) {
+            confArg = value;
+        }
+        else if( temp == "-L" ) {
+            logFacArg = value;
+        }
+        else if( temp == "-o" ) {
+            resultsArg = value;
+        }
+        else if( temp == "-n" ) {
+            numEvals = atoi( value.c_str() );
+        }
+        else if( temp == "--generate" ) {
+            generateDir = value;
+        }
+        else if( temp == "--solver-config" ) {
+            aGenerator.setSolverConfig( value );
+        }
+        else if( temp.compare( 0, 2, "--" ) != 0 || !aGenerator.setSize( temp.substr( 2 ), atoi( value.c_str() ) ) ) {
+            cout << "Invalid argument: " << temp << " " << value << endl;
+            printUsageMessage( argc, argv );
+            abort();
+        }
+    }
+}
+
+/*!
+ * \brief Print the command line usage message.
+ * \param argc Number of arguments.
+ * \param argv List of arguments.
+ */
+void printUsageMessage( unsigned int argc, char* argv[] ) {
+    cout << "Usage: " << argv[ 0 ] << " [-C configurationFileName] [-L loggerFactoryFileName]"
+         << " [-o resultsFileName] [-n numEvaluations]" << endl;
+    cout << "OR" << endl;
+    cout << "Usage: " << argv[ 0 ] << " --generate directory [--regions N] [--sectors N]"
+         << " [--technologies N] [--vintages N] [--land-nodes N] [--markets N]"
+         << " [--solver-config solverConfigFileName]" << endl;
+}
@@ -0,0 +1,469 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file synthetic_scenario_generator.cpp
+ * \ingroup Objects
+ * \brief SyntheticScenarioGenerator class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <algorithm>
+
+#include "benchmark/include/synthetic_scenario_generator.h"
+#include "util/base/include/xml_helper.h"
+#include "util/base/include/util.h"
+
+using namespace std;
+
+namespace {
+    //! The number of unmanaged leaves in each land node.
+    const int NUM_LEAVES_PER_NODE = 3;
+
+    //! The number of final demands in each region.
+    const int MAX_FINAL_DEMANDS = 3;
+
+    //! Units used throughout the scenario.
+    const string ENERGY_UNIT = "EJ";
+    const string PRICE_UNIT = "1975$/GJ";
+}
+
+//! Constructor
+SyntheticScenarioGenerator::SyntheticScenarioGenerator():
+mNumRegions( 4 ),
+mNumSectors( 6 ),
+mNumTechnologies( 4 ),
+mNumVintages( 1 ),
+mNumLandNodes( 2 ),
+mNumMarkets( 3 ),
+mSolverConfig( "../input/solution/cal_broyden_config.xml" ),
+mFinalCalibrationYear( 2010 )
+{
+    // Use the same time steps as the core scenario.
+    mYears.push_back( 1975 );
+    mYears.push_back( 1990 );
+    for( int year = 2005; year <= 2100; year += 5 ) {
+        mYears.push_back( year );
+    }
+}
+
+/*!
+ * \brief Set one of the sizes of the generated scenario.
+ * \param aName The name of the size which may be one of "regions", "sectors",
+ *              "technologies", "vintages", "land-nodes", or "markets".
+ * \param aValue The value to set.  All sizes must be at least one except for
+ *               land nodes which may be zero to generate no land.
+ * \return Whether the size was valid and set.
+ */
+bool SyntheticScenarioGenerator::setSize( const string& aName, const int aValue ) {
+    const int minValue = aName == "land-nodes" ? 0 : 1;
+    if( aValue < minValue ) {
+        return false;
+    }
+    if( aName == "regions" ) {
+        mNumRegions = aValue;
+    }
+    else if( aName == "sectors" ) {
+        mNumSectors = aValue;
+    }
+    else if( aName == "technologies" ) {
+        mNumTechnologies = aValue;
+    }
+    else if( aName == "vintages" ) {
+        mNumVintages = aValue;
+    }
+    else if( aName == "land-nodes" ) {
+        mNumLandNodes = aValue;
+    }
+    else if( aName == "markets" ) {
+        mNumMarkets = aValue;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Set the solver configuration the generated configuration should use.
+ * \param aFileName The solver configuration file, relative to where the model
+ *                  will be run.
+ */
+void SyntheticScenarioGenerator::setSolverConfig( const string& aFileName ) {
+    mSolverConfig = aFileName;
+}
+
+/*!
+ * \brief Write the sizes of the scenario that will be generated.
+ * \param aOut The stream to write to.
+ */
+void SyntheticScenarioGenerator::printSizes( ostream& aOut ) const {
+    aOut << "regions: " << mNumRegions << ", sectors: " << mNumSectors
+         << ", technologies: " << mNumTechnologies << ", vintages: " << mNumVintages
+         << ", land-nodes: " << mNumLandNodes << ", markets: " << mNumMarkets << endl;
+}
+
+/*!
+ * \brief Generate the scenario into the given directory.
+ * \details Writes synthetic_scenario.xml which contains the model time, one
+ *          synthetic_<region>.xml per region, and configuration.xml which
+ *          reads them all.
+ * \param aDirectory An existing directory to write the files into.
+ * \return Whether all files could be written.
+ */
+bool SyntheticScenarioGenerator::generate( const string& aDirectory ) const {
+    const string prefix = aDirectory.empty() ? "" : aDirectory + "/";
+    Tabs tabs;
+
+    const string scenarioFile = prefix + "synthetic_scenario.xml";
+    ofstream scenarioOut( scenarioFile.c_str() );
+    if( !scenarioOut ) {
+        return false;
+    }
+    scenarioOut << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl;
+    XMLWriteOpeningTag( "scenario", scenarioOut, &tabs, "synthetic" );
+    writeModelTime( scenarioOut, &tabs );
+    XMLWriteClosingTag( "scenario", scenarioOut, &tabs );
+
+    vector<string> components;
+    components.push_back( scenarioFile );
+    for( int region = 0; region < mNumRegions; ++region ) {
+        const string regionFile = prefix + "synthetic_" + getRegionName( region ) + ".xml";
+        ofstream regionOut( regionFile.c_str() );
+        if( !regionOut ) {
+            return false;
+        }
+        regionOut << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl;
+        XMLWriteOpeningTag( "scenario", regionOut, &tabs );
+        XMLWriteOpeningTag( "world", regionOut, &tabs );
+        writeRegion( region, regionOut, &tabs );
+        XMLWriteClosingTag( "world", regionOut, &tabs );
+        XMLWriteClosingTag( "scenario", regionOut, &tabs );
+        components.push_back( regionFile );
+    }
+
+    const string confFile = prefix + "configuration.xml";
+    ofstream confOut( confFile.c_str() );
+    if( !confOut ) {
+        return false;
+    }
+    writeConfiguration( prefix, components, confOut );
+    return true;
+}
+
+/*!
+ * \brief Get the number of years between the given model year and the
+ *        previous one.
+ * \param aYearIndex The index into the model years.
+ * \return The time step.
+ */
+int SyntheticScenarioGenerator::getTimeStep( const size_t aYearIndex ) const {
+    return aYearIndex == 0 ? mYears[ 1 ] - mYears[ 0 ] : mYears[ aYearIndex ] - mYears[ aYearIndex - 1 ];
+}
+
+/*!
+ * \brief Write the model time.
+ * \param aOut The stream to write to.
+ * \param aTabs Tabs object.
+ */
+void SyntheticScenarioGenerator::writeModelTime( ostream& aOut, Tabs* aTabs ) const {
+    XMLWriteOpeningTag( "modeltime", aOut, aTabs );
+    map<string, int> attrs;
+    for( size_t i = 0; i + 1 < mYears.size(); ++i ) {
+        // Only years at which the time step changes need to be written.
+        const int timeStep = getTimeStep( i + 1 );
+        if( i == 0 || timeStep != getTimeStep( i ) ) {
+            attrs[ "time-step" ] = timeStep;
+            XMLWriteElementWithAttributes( mYears[ i ], i == 0 ? "start-year" : "inter-year", aOut, aTabs, attrs );
+        }
+    }
+    XMLWriteElement( mFinalCalibrationYear, "final-calibration-year", aOut, aTabs );
+    XMLWriteElement( mYears.back(), "end-year", aOut, aTabs );
+    XMLWriteClosingTag( "modeltime", aOut, aTabs );
+}
+
+/*!
+ * \brief Write a single region.
+ * \param aRegion The index of the region.
+ * \param aOut The stream to write to.
+ * \param aTabs Tabs object.
+ */
+void SyntheticScenarioGenerator::writeRegion( const int aRegion, ostream& aOut, Tabs* aTabs ) const {
+    const string regionName = getRegionName( aRegion );
+    XMLWriteOpeningTag( "region", aOut, aTabs, regionName );
+
+    // Drivers, regions differ in size so that the markets are not identical.
+    const double sizeFactor = 1.0 + aRegion % 5;
+    XMLWriteOpeningTag( "demographics", aOut, aTabs );
+    for( size_t i = 0; i < mYears.size(); ++i ) {
+        XMLWriteOpeningTag( "populationMiniCAM", aOut, aTabs, "", mYears[ i ] );
+        XMLWriteElement( 1.0e5 * sizeFactor * ( 1.0 + 0.01 * ( mYears[ i ] - mYears[ 0 ] ) ), "totalPop", aOut, aTabs );
+        XMLWriteClosingTag( "populationMiniCAM", aOut, aTabs );
+    }
+    XMLWriteClosingTag( "demographics", aOut, aTabs );
+
+    XMLWriteOpeningTag( "GDP", aOut, aTabs );
+    XMLWriteElement( 1.0e6 * sizeFactor, "baseGDP", aOut, aTabs );
+    XMLWriteElement( 0.5, "laborforce", aOut, aTabs, mYears[ 0 ], "", true );
+    for( size_t i = 1; i < mYears.size(); ++i ) {
+        XMLWriteElement( 0.01 + 0.005 * ( aRegion % 3 ), "laborproductivity", aOut, aTabs, mYears[ i ] );
+    }
+    XMLWriteClosingTag( "GDP", aOut, aTabs );
+
+    writeResources( regionName, aRegion, aOut, aTabs );
+    writeSectors( regionName, aOut, aTabs );
+    writeFinalDemands( aRegion, aOut, aTabs );
+    writeLand( aRegion, aOut, aTabs );
+
+    XMLWriteClosingTag( "region", aOut, aTabs );
+}
+
+/*!
+ * \brief Write the depletable resources of a region.
+ * \param aRegionName The name of the region which is also the market.
+ * \param aRegion The index of the region.
+ * \param aOut The stream to write to.
+ * \param aTabs Tabs object.
+ */
+void SyntheticScenarioGenerator::writeResources( const string& aRegionName, const int aRegion,
+                                                 ostream& aOut, Tabs* aTabs ) const
+{
+    const double available[] = { 0.0, 1.0e3, 5.0e3, 2.0e4 };
+    const double cost[] = { 0.5, 1.0, 2.0, 5.0 };
+    for( int resource = 0; resource < mNumMarkets; ++resource ) {
+        XMLWriteOpeningTag( "depresource", aOut, aTabs, "resource-" + util::toString( resource ) );
+        XMLWriteElement( ENERGY_UNIT, "output-unit", aOut, aTabs );
+        XMLWriteElement( PRICE_UNIT, "price-unit", aOut, aTabs );
+        XMLWriteElement( aRegionName, "market", aOut, aTabs );
+        const double costFactor = 1.0 + 0.1 * ( ( resource + aRegion ) % 4 );
+        for( size_t i = 0; i < mYears.size() && mYears[ i ] <= mFinalCalibrationYear; ++i ) {
+            XMLWriteElement( cost[ 1 ] * costFactor, "price", aOut, aTabs, mYears[ i ] );
+        }
+        XMLWriteOpeningTag( "subresource", aOut, aTabs, "grades" );
+        for( size_t grade = 0; grade < sizeof( available ) / sizeof( available[ 0 ] ); ++grade ) {
+            XMLWriteOpeningTag( "grade", aOut, aTabs, "grade-" + util::toString( grade + 1 ) );
+            XMLWriteElement( available[ grade ], "available", aOut, aTabs );
+            XMLWriteElement( cost[ grade ] * costFactor, "extractioncost", aOut, aTabs );
+            XMLWriteClosingTag( "grade", aOut, aTabs );
+        }
+        XMLWriteClosingTag( "subresource", aOut, aTabs );
+        XMLWriteClosingTag( "depresource", aOut, aTabs );
+    }
+}
+
+/*!
+ * \brief Write the supply sectors of a region.
+ * \details Technology t of sector s consumes resource t % markets when s is
+ *          zero and otherwise the sector s - 1 - ( t % s ).
+ * \param aRegionName The name of the region which is also the market.
+ * \param aOut The stream to write to.
+ * \param aTabs Tabs object.
+ */
+void SyntheticScenarioGenerator::writeSectors( const string& aRegionName, ostream& aOut, Tabs* aTabs ) const {
+    for( int sector = 0; sector < mNumSectors; ++sector ) {
+        XMLWriteOpeningTag( "supplysector", aOut, aTabs, "sector-" + util::toString( sector ) );
+        XMLWriteElement( ENERGY_UNIT, "output-unit", aOut, aTabs );
+        XMLWriteElement( ENERGY_UNIT, "input-unit", aOut, aTabs );
+        XMLWriteElement( PRICE_UNIT, "price-unit", aOut, aTabs );
+        XMLWriteOpeningTag( "relative-cost-logit", aOut, aTabs );
+        XMLWriteElement( -3.0, "logit-exponent", aOut, aTabs, mYears[ 0 ], "", true );
+        XMLWriteClosingTag( "relative-cost-logit", aOut, aTabs );
+
+        for( int tech = 0; tech < mNumTechnologies; ++tech ) {
+            const string input = sector == 0 ? "resource-" + util::toString( tech % mNumMarkets )
+                                             : "sector-" + util::toString( sector - 1 - ( tech % sector ) );
+            XMLWriteOpeningTag( "subsector", aOut, aTabs, "subsector-" + util::toString( tech ) );
+            XMLWriteOpeningTag( "relative-cost-logit", aOut, aTabs );
+            XMLWriteElement( -6.0, "logit-exponent", aOut, aTabs, mYears[ 0 ], "", true );
+            XMLWriteClosingTag( "relative-cost-logit", aOut, aTabs );
+            XMLWriteElement( 1.0, "share-weight", aOut, aTabs, mYears[ 0 ], "", true );
+
+            XMLWriteOpeningTag( "technology", aOut, aTabs, "technology-" + util::toString( tech ) );
+            for( size_t i = 0; i < mYears.size(); ++i ) {
+                XMLWriteOpeningTag( "period", aOut, aTabs, "", mYears[ i ] );
+                XMLWriteElement( 1.0, "share-weight", aOut, aTabs );
+                if( mNumVintages > 1 ) {
+                    // Operate for the given number of following time steps.
+                    XMLWriteElement( mNumVintages * getTimeStep( min( i + 1, mYears.size() - 1 ) ),
+                                     "lifetime", aOut, aTabs );
+                }
+                XMLWriteOpeningTag( "minicam-energy-input", aOut, aTabs, input );
+                XMLWriteElement( 1.0 + 0.05 * ( ( tech + sector ) % 4 ), "coefficient", aOut, aTabs );
+                XMLWriteElement( aRegionName, "market-name", aOut, aTabs );
+                XMLWriteClosingTag( "minicam-energy-input", aOut, aTabs );
+                XMLWriteOpeningTag( "minicam-non-energy-input", aOut, aTabs, "non-energy" );
+                XMLWriteElement( 0.1 * ( tech + 1 ), "input-cost", aOut, aTabs );
+                XMLWriteClosingTag( "minicam-non-energy-input", aOut, aTabs );
+                XMLWriteClosingTag( "period", aOut, aTabs );
+            }
+            XMLWriteClosingTag( "technology", aOut, aTabs );
+            XMLWriteClosingTag( "subsector", aOut, aTabs );
+        }
+        XMLWriteClosingTag( "supplysector", aOut, aTabs );
+    }
+}
+
+/*!
+ * \brief Write the final demands of a region which are for the last few
+ *        sectors.
+ * \param aRegion The index of the region.
+ * \param aOut The stream to write to.
+ * \param aTabs Tabs object.
+ */
+void SyntheticScenarioGenerator::writeFinalDemands( const int aRegion, ostream& aOut, Tabs* aTabs ) const {
+    const int numDemands = min( mNumSectors, MAX_FINAL_DEMANDS );
+    for( int sector = mNumSectors - numDemands; sector < mNumSectors; ++sector ) {
+        XMLWriteOpeningTag( "energy-final-demand", aOut, aTabs, "sector-" + util::toString( sector ) );
+        XMLWriteElement( 1, "perCapitaBased", aOut, aTabs );
+        for( size_t i = 0; i < mYears.size(); ++i ) {
+            if( mYears[ i ] <= mFinalCalibrationYear ) {
+                XMLWriteElement( 10.0 * ( 1.0 + aRegion % 5 ) * ( 1.0 + 0.01 * ( mYears[ i ] - mYears[ 0 ] ) ),
+                                 "base-service", aOut, aTabs, mYears[ i ] );
+            }
+            else {
+                XMLWriteElement( 0.5, "income-elasticity", aOut, aTabs, mYears[ i ] );
+                XMLWriteElement( -0.3, "price-elasticity", aOut, aTabs, mYears[ i ] );
+            }
+        }
+        XMLWriteClosingTag( "energy-final-demand", aOut, aTabs );
+    }
+}
+
+/*!
+ * \brief Write the land allocator of a region if there are any land nodes.
+ * \param aRegion The index of the region.
+ * \param aOut The stream to write to.
+ * \param aTabs Tabs object.
+ */
+void SyntheticScenarioGenerator::writeLand( const int aRegion, ostream& aOut, Tabs* aTabs ) const {
+    if( mNumLandNodes == 0 ) {
+        return;
+    }
+    XMLWriteOpeningTag( "LandAllocatorRoot", aOut, aTabs, "root" );
+    XMLWriteElement( 0.0, "logit-exponent", aOut, aTabs, mYears[ 0 ], "", true );
+    for( int node = 0; node < mNumLandNodes; ++node ) {
+        XMLWriteOpeningTag( "LandNode", aOut, aTabs, "land-node-" + util::toString( node ) );
+        XMLWriteElement( 0.5, "logit-exponent", aOut, aTabs, mYears[ 0 ], "", true );
+        XMLWriteElement( 1.0 + 0.1 * ( ( node + aRegion ) % 5 ), "unManagedLandValue", aOut, aTabs );
+        for( int leaf = 0; leaf < NUM_LEAVES_PER_NODE; ++leaf ) {
+            const double area = 100.0 * ( 1 + leaf );
+            const double aboveDensity = 5.0 * ( 1 + leaf );
+            const double belowDensity = 10.0 * ( 1 + ( node + leaf ) % 3 );
+            XMLWriteOpeningTag( "UnmanagedLandLeaf", aOut, aTabs,
+                                "leaf-" + util::toString( node ) + "-" + util::toString( leaf ) );
+            for( size_t i = 0; i < mYears.size() && mYears[ i ] <= mFinalCalibrationYear; ++i ) {
+                // Slowly convert the first leaf to the others so that there are
+                // land use change emissions.
+                const double change = 0.1 * ( mYears[ i ] - mYears[ 0 ] ) * ( leaf == 0 ? -1.0 : 0.5 );
+                XMLWriteElement( area + change, "landAllocation", aOut, aTabs, mYears[ i ] );
+            }
+            XMLWriteOpeningTag( "land-use-history", aOut, aTabs );
+            XMLWriteElement( area, "allocation", aOut, aTabs, mYears[ 0 ] - 1 );
+            XMLWriteElement( aboveDensity, "above-ground-carbon-density", aOut, aTabs );
+            XMLWriteElement( belowDensity, "below-ground-carbon-density", aOut, aTabs );
+            XMLWriteClosingTag( "land-use-history", aOut, aTabs );
+            XMLWriteOpeningTag( "land-carbon-densities", aOut, aTabs );
+            XMLWriteElement( aboveDensity, "above-ground-carbon-density", aOut, aTabs );
+            XMLWriteElement( belowDensity, "below-ground-carbon-density", aOut, aTabs );
+            XMLWriteElement( leaf == 0 ? 30 : 1, "mature-age", aOut, aTabs, mYears[ 0 ], "", true );
+            XMLWriteClosingTag( "land-carbon-densities", aOut, aTabs );
+            XMLWriteClosingTag( "UnmanagedLandLeaf", aOut, aTabs );
+        }
+        XMLWriteClosingTag( "LandNode", aOut, aTabs );
+    }
+    XMLWriteClosingTag( "LandAllocatorRoot", aOut, aTabs );
+}
+
+/*!
+ * \brief Write a configuration file which runs the generated scenario.
+ * \details Solver telemetry and the XML output file are enabled so that the
+ *          benchmark can report solver iterations and output time, while the
+ *          XML database is disabled so that the benchmark does not require
+ *          Java.
+ * \param aDirectory The prefix for all files written by the run.
+ * \param aComponents The scenario components to read in order.
+ * \param aOut The stream to write to.
+ */
+void SyntheticScenarioGenerator::writeConfiguration( const string& aDirectory,
+                                                     const vector<string>& aComponents,
+                                                     ostream& aOut ) const
+{
+    Tabs tabs;
+    aOut << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << endl;
+    XMLWriteOpeningTag( "Configuration", aOut, &tabs );
+
+    XMLWriteOpeningTag( "Files", aOut, &tabs );
+    XMLWriteElement( aComponents[ 0 ], "Value", aOut, &tabs, 0, "xmlInputFileName" );
+    map<string, string> attrs;
+    attrs[ "append-scenario-name" ] = "0";
+    attrs[ "write-output" ] = "1";
+    attrs[ "name" ] = "xmlOutputFileName";
+    XMLWriteElementWithAttributes( aDirectory + "output.xml", "Value", aOut, &tabs, attrs );
+    attrs[ "name" ] = "outFileName";
+    XMLWriteElementWithAttributes( aDirectory + "outFile.csv", "Value", aOut, &tabs, attrs );
+    attrs[ "name" ] = "solver-telemetry";
+    XMLWriteElementWithAttributes( aDirectory + "solver-telemetry.json", "Value", aOut, &tabs, attrs );
+    attrs[ "write-output" ] = "0";
+    attrs[ "name" ] = "xmldb-location";
+    XMLWriteElementWithAttributes( aDirectory + "database_basexdb", "Value", aOut, &tabs, attrs );
+    attrs[ "name" ] = "xmlDebugFileName";
+    XMLWriteElementWithAttributes( aDirectory + "debug.xml", "Value", aOut, &tabs, attrs );
+    XMLWriteClosingTag( "Files", aOut, &tabs );
+
+    // The scenario file with the model time is the input file, the solver and
+    // regions are components.
+    XMLWriteOpeningTag( "ScenarioComponents", aOut, &tabs );
+    XMLWriteElement( mSolverConfig, "Value", aOut, &tabs, 0, "solver" );
+    for( size_t i = 1; i < aComponents.size(); ++i ) {
+        XMLWriteElement( aComponents[ i ], "Value", aOut, &tabs, 0, getRegionName( i - 1 ) );
+    }
+    XMLWriteClosingTag( "ScenarioComponents", aOut, &tabs );
+
+    XMLWriteOpeningTag( "Strings", aOut, &tabs );
+    XMLWriteElement( "synthetic", "Value", aOut, &tabs, 0, "scenarioName" );
+    XMLWriteClosingTag( "Strings", aOut, &tabs );
+
+    XMLWriteClosingTag( "Configuration", aOut, &tabs );
+}
+
+/*!
+ * \brief Get the name of a region.
+ * \param aRegion The index of the region.
+ * \return The region name.
+ */
+string SyntheticScenarioGenerator::getRegionName( const int aRegion ) {
+    return "region-" + util::toString( aRegion );
+}
@@ -148,14 +148,26 @@ protected:
     const LandLeaf* mLandLeaf;
     
     //! The difference in the sigmoid curve by year offset + 1 - year offset.
-    //! This value get precomputed during initcalc to avoid doing the computationally
-    //! expensive operations during calc.
-    std::vector<double> precalc_sigmoid_diff;
+    //! This is shared by all carbon calcs with the same mature age and is set
+    //! along with the mature age to avoid doing the computationally expensive
+    //! operations during calc.
+    const std::vector<double>* mSigmoidKernel;
+    
+    //! The fraction of a change in soil carbon which occurs by year offset.
+    //! This is shared by all carbon calcs with the same soil time scale.
+    const std::vector<double>* mSoilKernel;
     
     //! Flag to ensure historical emissions are only calculated a single time
     //! since they can not be reset.
     bool mHasCalculatedHistoricEmiss;
 
+    void calcAboveGroundCarbonChange( const double aPrevCarbonStock,
+                                      const double aPrevLandArea,
+                                      const double aCurrLandArea,
+                                      const double aPrevCarbonDensity,
+                                      double& aPulseEmiss,
+                                      double& aSigmoidChange ) const;
+
     template<typename DoubleType>
     void calcAboveGroundCarbonEmission(const double aPrevCarbonStock,
                                        const double aPrevLandArea,
@@ -198,52 +210,15 @@ void ASimpleCarbonCalc::calcAboveGroundCarbonEmission( const double aPrevCarbonS
                                                        const int aEndYear,
                                                        objects::YearVector<DoubleType>& aEmissVector)
 {
-    double carbonDiff = aPrevCarbonDensity * ( aPrevLandArea  - aCurrLandArea );
-    // If no emissions or sequestration occurred, then exit.
-    if( util::isEqual( carbonDiff, 0.0 ) ) {
-        return;
+    double pulseEmiss;
+    double sigmoidChange;
+    calcAboveGroundCarbonChange( aPrevCarbonStock, aPrevLandArea, aCurrLandArea, aPrevCarbonDensity,
+                                 pulseEmiss, sigmoidChange );
+    if( pulseEmiss != 0.0 ) {
+        aEmissVector[ aYear ] += pulseEmiss;
     }
-    
-    // Finally, calculate net land use change emissions from changes in
-    // above ground carbon.
-    if ( getMatureAge() > 1 && carbonDiff < 0.0 ) {
-        // If carbon content increases, then carbon was sequestered.
-        // Carbon sequestration is stretched out in time, based on mMatureAge, because some
-        // land cover types (notably forests) don't mature instantly.
-        calcSigmoidCurve( carbonDiff, aYear, aEndYear, aEmissVector );
-    }
-    else if( util::isEqual( aPrevLandArea, 0.0 ) ) {
-        // If this land category didn't exist before, and now it does,
-        // then the calculation below will generate a NaN.  Avoid that
-        // by taking the appropriate limit here.
-        aEmissVector[ aYear ] -= aCurrLandArea * aPrevCarbonDensity;
-    }
-    else {
-        // If carbon content decreases, then emissions have occurred.
-        // Compute the carbon emission as the carbon stock pro rata to
-        // the fraction of land converted.
-        
-        // If the mature age is just one year then sequestration
-        // (negative emission) can just be added here as well (so we
-        // don't have a separate branch for it).  (It's not obvious,
-        // but you can show that the formula below just reduces to the
-        // expression for carbonDiff at the top of the function.)
-        aEmissVector[ aYear ] += ( aPrevCarbonStock / aPrevLandArea ) * ( aPrevLandArea - aCurrLandArea );
-        if( getMatureAge() > 1 ) {
-            // Back out the pending future sequestration for the land
-            // that has been converted (i.e., that sequestration will
-            // no longer happen).  This calculation is necessarily
-            // approximate because we don't know how long the
-            // destroyed vegetation has been growing.  We do know that
-            // when the vegetation is fully mature,
-            // carbonStock/LandArea == carbonDensity, so the
-            // difference between those two quantities tells us how
-            // much pending sequestration we have.  Distribute the
-            // correction as a sigmoid between aYear and aEndYear.
-            double carbonFutureAdjust = ( aPrevLandArea - aCurrLandArea ) * ( aPrevCarbonDensity -
-                                                                             ( aPrevCarbonStock / aPrevLandArea ) );
-            calcSigmoidCurve( carbonFutureAdjust, aYear, aEndYear, aEmissVector );
-        }
+    if( sigmoidChange != 0.0 ) {
+        calcSigmoidCurve( sigmoidChange, aYear, aEndYear, aEmissVector );
     }
 }
 
@@ -272,17 +247,10 @@ void ASimpleCarbonCalc::calcBelowGroundCarbonEmission( const double aCarbonDiff,
     // Note also that the aCarbonDiff is passed here as previous carbon minus current carbon
     // so a positive difference means that emissions will occur and a negative means uptake.
     
-    const double halfLife = mSoilTimeScale / 10.0;
-    const double log2 = log( 2.0 );
-    const double lambda = log2 / halfLife;
-    int yearCounter = 0;
-    double cumStockDiff_t1, cumStockDiff_t2;
-    cumStockDiff_t1 = 0.0;
+    // The change by year has already been precomputed for the soil time scale.
+    const std::vector<double>& soilKernel = *mSoilKernel;
     for( int currYear = aYear; currYear <= aEndYear; ++currYear ) {
-        yearCounter += 1;
-        cumStockDiff_t2 = aCarbonDiff * ( 1.0 - exp( -1.0 * lambda * yearCounter ) );
-        aEmissVector[ currYear ] += cumStockDiff_t2 - cumStockDiff_t1;
-        cumStockDiff_t1 = cumStockDiff_t2;
+        aEmissVector[ currYear ] += soilKernel[ currYear - aYear ] * aCarbonDiff;
     }
 }
 
@@ -306,10 +274,11 @@ void ASimpleCarbonCalc::calcSigmoidCurve( const double aCarbonDiff,
      */
     assert( getMatureAge() > 1 );
     
+    // To avoid expensive calculations the difference in the sigmoid curve
+    // has already been precomputed.
+    const std::vector<double>& sigmoidKernel = *mSigmoidKernel;
     for( int currYear = aYear; currYear <= aEndYear; ++currYear ){
-        // To avoid expensive calculations the difference in the sigmoid curve
-        // has already been precomputed.
-        aEmissVector[ currYear ] += precalc_sigmoid_diff[ currYear - aYear ] * aCarbonDiff;
+        aEmissVector[ currYear ] += sigmoidKernel[ currYear - aYear ] * aCarbonDiff;
     }
 }
 
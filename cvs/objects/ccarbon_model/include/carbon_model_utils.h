@@ -44,6 +44,7 @@
  * \author Jim Naslund and Ming Chang
  */
 
+#include <vector>
 #include "util/base/include/time_vector.h"
 
 class LandUseHistory;
@@ -65,6 +66,9 @@ public:
     static int getStartYear();
     static int getEndYear();
 
+    static const std::vector<double>& getSigmoidKernel( const int aMatureAge );
+    static const std::vector<double>& getSoilKernel( const int aSoilTimeScale );
+
     static double interpYearHelper( const objects::PeriodVector<double>& aPeriodVector,
                                     const unsigned int aYear );
 
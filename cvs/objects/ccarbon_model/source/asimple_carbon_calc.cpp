@@ -49,12 +49,34 @@
 #include "land_allocator/include/land_leaf.h"
 #include "util/logger/include/ilogger.h"
 
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
 using namespace std;
 using namespace xercesc;
 using namespace objects;
 
 extern Scenario* scenario;
 
+namespace {
+    /*!
+     * \brief Scratch space for the carbon changes by year within a period.
+     * \details These are shared by all carbon calcs and only ever grow so that
+     *          calc does not need to allocate.  Carbon calcs may be calculated
+     *          concurrently so each thread gets its own buffers.
+     */
+    struct CarbonChangeBuffers {
+        vector<double> mSigmoidChange;
+        vector<double> mSoilChange;
+    };
+#if GCAM_PARALLEL_ENABLED
+    tbb::enumerable_thread_specific<CarbonChangeBuffers> sCarbonChangeBuffers;
+#else
+    CarbonChangeBuffers sCarbonChangeBuffers;
+#endif
+}
+
 ASimpleCarbonCalc::ASimpleCarbonCalc():
 mTotalEmissions( CarbonModelUtils::getStartYear(), CarbonModelUtils::getEndYear() ),
 mTotalEmissionsAbove( CarbonModelUtils::getStartYear(), CarbonModelUtils::getEndYear() ),
@@ -67,6 +89,8 @@ mCarbonStock( scenario->getModeltime()->getStartYear(), CarbonModelUtils::getEnd
     mLandUseHistory = 0;
     mLandLeaf = 0;
     mSoilTimeScale = CarbonModelUtils::getSoilTimeScale();
+    mSoilKernel = &CarbonModelUtils::getSoilKernel( mSoilTimeScale );
+    mSigmoidKernel = 0;
     mHasCalculatedHistoricEmiss = false;
 
     // Note we are not allocating space for period zero since that is historical
@@ -158,22 +182,73 @@ double ASimpleCarbonCalc::calc( const int aPeriod, const int aEndYear, const boo
             currEmissionsBelow[ year ] = 0.0;
         }
         
+        // The carbon changes in each year of the period are spread into the future
+        // as a convolution with the shared response kernels.  Emissions within the
+        // period are needed to track the carbon stock so they are accumulated as
+        // we go, while the remaining years are filled in a single pass over the
+        // future once all of the changes in the period are known.  This avoids
+        // accumulating into the state vectors once per year of the period.
+        const int timestep = modelYear - prevModelYear;
+        const bool hasSigmoid = getMatureAge() > 1;
+#if GCAM_PARALLEL_ENABLED
+        CarbonChangeBuffers& buffers = sCarbonChangeBuffers.local();
+#else
+        CarbonChangeBuffers& buffers = sCarbonChangeBuffers;
+#endif
+        vector<double>& sigmoidChange = buffers.mSigmoidChange;
+        vector<double>& soilChange = buffers.mSoilChange;
+        sigmoidChange.assign( timestep, 0.0 );
+        soilChange.assign( timestep, 0.0 );
+        const vector<double>& soilKernel = *mSoilKernel;
+        
         year = prevModelYear;
         double currLand = aPeriod == 1 ? mLandUseHistory->getAllocation( prevModelYear ) : mLandLeaf->getLandAllocation( mLandLeaf->getName(), aPeriod - 1 );
         const double avgAnnualChangeInLand = ( mLandLeaf->getLandAllocation( mLandLeaf->getName(), aPeriod ) - currLand )
             / modeltime->gettimestep( aPeriod );
         double prevCarbonBelow = currLand * getActualBelowGroundCarbonDensity( year );
-        for( ++year; year <= modelYear; ++year ) {
+        for( int offset = 0; offset < timestep; ++offset ) {
+            year = prevModelYear + 1 + offset;
             double prevLand = currLand;
             currLand += avgAnnualChangeInLand;
             double currCarbonBelow = currLand * getActualBelowGroundCarbonDensity( year);
-            calcAboveGroundCarbonEmission( mCarbonStock[ year - 1 ], prevLand, currLand, getActualAboveGroundCarbonDensity( year ), year, aEndYear, currEmissionsAbove );
-            calcBelowGroundCarbonEmission( prevCarbonBelow - currCarbonBelow, year, aEndYear, currEmissionsBelow );
+            double pulseEmiss;
+            calcAboveGroundCarbonChange( mCarbonStock[ year - 1 ], prevLand, currLand, getActualAboveGroundCarbonDensity( year ),
+                                         pulseEmiss, sigmoidChange[ offset ] );
+            if( !util::isEqual( prevCarbonBelow - currCarbonBelow, 0.0 ) ) {
+                soilChange[ offset ] = prevCarbonBelow - currCarbonBelow;
+            }
+            
+            if( year <= aEndYear ) {
+                double emissAbove = pulseEmiss;
+                double emissBelow = 0.0;
+                for( int changeOffset = 0; changeOffset <= offset; ++changeOffset ) {
+                    if( hasSigmoid ) {
+                        emissAbove += sigmoidChange[ changeOffset ] * ( *mSigmoidKernel )[ offset - changeOffset ];
+                    }
+                    emissBelow += soilChange[ changeOffset ] * soilKernel[ offset - changeOffset ];
+                }
+                currEmissionsAbove[ year ] += emissAbove;
+                currEmissionsBelow[ year ] += emissBelow;
+            }
 
             mCarbonStock[ year ] = mCarbonStock[ year - 1 ] - ( mTotalEmissionsAbove[ year ] + currEmissionsAbove[ year ] );
             prevCarbonBelow = currCarbonBelow;
         }
         
+        for( year = modelYear + 1; year <= aEndYear; ++year ) {
+            const int offset = year - prevModelYear - 1;
+            double emissAbove = 0.0;
+            double emissBelow = 0.0;
+            for( int changeOffset = 0; changeOffset < timestep; ++changeOffset ) {
+                if( hasSigmoid ) {
+                    emissAbove += sigmoidChange[ changeOffset ] * ( *mSigmoidKernel )[ offset - changeOffset ];
+                }
+                emissBelow += soilChange[ changeOffset ] * soilKernel[ offset - changeOffset ];
+            }
+            currEmissionsAbove[ year ] += emissAbove;
+            currEmissionsBelow[ year ] += emissBelow;
+        }
+        
         if( aStoreFullEmiss ) {
             // add current emissions to the total
             for( year = prevModelYear + 1; year <= aEndYear; ++year ) {
@@ -192,6 +267,75 @@ double ASimpleCarbonCalc::calc( const int aPeriod, const int aEndYear, const boo
     return mTotalEmissions[ aEndYear ];
 }
 
+/*!
+ * \brief Calculate the change in above ground carbon for a given year.
+ * \details Above ground carbon is emitted as a pulse, and will uptake over
+ *          mature age along a sigmoid curve.  The caller is responsible for
+ *          spreading the sigmoid change into the future.
+ * \param aPrevCarbonStock The carbon stock from the previous year.
+ * \param aPrevLandArea The land area during the previous year.
+ * \param aCurrLandArea The land area which will expand/contract to.
+ * \param aPrevCarbonDensity The potential carbon density for the previous year.
+ * \param aPulseEmiss The emissions which occur in the year.
+ * \param aSigmoidChange The change which is spread along the sigmoid curve.
+ */
+void ASimpleCarbonCalc::calcAboveGroundCarbonChange( const double aPrevCarbonStock,
+                                                     const double aPrevLandArea,
+                                                     const double aCurrLandArea,
+                                                     const double aPrevCarbonDensity,
+                                                     double& aPulseEmiss,
+                                                     double& aSigmoidChange ) const
+{
+    aPulseEmiss = 0.0;
+    aSigmoidChange = 0.0;
+    double carbonDiff = aPrevCarbonDensity * ( aPrevLandArea  - aCurrLandArea );
+    // If no emissions or sequestration occurred, then exit.
+    if( util::isEqual( carbonDiff, 0.0 ) ) {
+        return;
+    }
+    
+    // Finally, calculate net land use change emissions from changes in
+    // above ground carbon.
+    if ( getMatureAge() > 1 && carbonDiff < 0.0 ) {
+        // If carbon content increases, then carbon was sequestered.
+        // Carbon sequestration is stretched out in time, based on mMatureAge, because some
+        // land cover types (notably forests) don't mature instantly.
+        aSigmoidChange = carbonDiff;
+    }
+    else if( util::isEqual( aPrevLandArea, 0.0 ) ) {
+        // If this land category didn't exist before, and now it does,
+        // then the calculation below will generate a NaN.  Avoid that
+        // by taking the appropriate limit here.
+        aPulseEmiss = -aCurrLandArea * aPrevCarbonDensity;
+    }
+    else {
+        // If carbon content decreases, then emissions have occurred.
+        // Compute the carbon emission as the carbon stock pro rata to
+        // the fraction of land converted.
+        
+        // If the mature age is just one year then sequestration
+        // (negative emission) can just be added here as well (so we
+        // don't have a separate branch for it).  (It's not obvious,
+        // but you can show that the formula below just reduces to the
+        // expression for carbonDiff at the top of the function.)
+        aPulseEmiss = ( aPrevCarbonStock / aPrevLandArea ) * ( aPrevLandArea - aCurrLandArea );
+        if( getMatureAge() > 1 ) {
+            // Back out the pending future sequestration for the land
+            // that has been converted (i.e., that sequestration will
+            // no longer happen).  This calculation is necessarily
+            // approximate because we don't know how long the
+            // destroyed vegetation has been growing.  We do know that
+            // when the vegetation is fully mature,
+            // carbonStock/LandArea == carbonDensity, so the
+            // difference between those two quantities tells us how
+            // much pending sequestration we have.  Distribute the
+            // correction as a sigmoid from the year on.
+            aSigmoidChange = ( aPrevLandArea - aCurrLandArea ) * ( aPrevCarbonDensity -
+                                                                 ( aPrevCarbonStock / aPrevLandArea ) );
+        }
+    }
+}
+
 double ASimpleCarbonCalc::getNetLandUseChangeEmission( const int aYear ) const {
     return mTotalEmissions[ aYear ];
 }
@@ -272,6 +416,7 @@ double ASimpleCarbonCalc::getAboveGroundCarbonSubsidyDiscountFactor( ){
 
 void ASimpleCarbonCalc::setSoilTimeScale( const int aTimeScale ) {
     mSoilTimeScale = aTimeScale;
+    mSoilKernel = &CarbonModelUtils::getSoilKernel( mSoilTimeScale );
 }
 
 double ASimpleCarbonCalc::getAboveGroundCarbonStock( const int aYear ) const {
@@ -41,6 +41,8 @@
 #include "util/base/include/definitions.h"
 #include <cassert>
 #include <cfloat>
+#include <cmath>
+#include <map>
 
 #include "ccarbon_model/include/carbon_model_utils.h"
 #include "util/base/include/util.h"
@@ -131,6 +133,65 @@ int CarbonModelUtils::getEndYear(){
     return END_YEAR;
 }
 
+/*!
+ * \brief Get the response of above ground carbon to a unit change in carbon
+ *        which is taken up along a sigmoid curve.
+ * \details Element i is the fraction of the change which occurs in the i'th
+ *          year after the change, out to the length of the carbon cycle.  The
+ *          kernel is calculated once for each mature age and shared by all
+ *          carbon calculators which use it.
+ * \param aMatureAge The mature age, which must be greater than one.
+ * \return The response kernel.
+ * \warning The kernels are cached without locking so this must only be called
+ *          during initialization and not from a parallel calculation.
+ */
+const vector<double>& CarbonModelUtils::getSigmoidKernel( const int aMatureAge ){
+    /*! \pre The sigmoid is only used when the mature age is greater than 1. */
+    assert( aMatureAge > 1 );
+    static map<int, vector<double> > kernels;
+    vector<double>& kernel = kernels[ aMatureAge ];
+    if( kernel.empty() ){
+        kernel.resize( getEndYear() - getStartYear() + 1 );
+        double prevSigmoid = 0.0;
+        for( size_t offsetYear = 0; offsetYear < kernel.size(); ++offsetYear ){
+            double currSigmoid = pow( 1 - exp( ( -3.0 * ( offsetYear + 1 ) ) / aMatureAge ), 2.0 );
+            kernel[ offsetYear ] = currSigmoid - prevSigmoid;
+            prevSigmoid = currSigmoid;
+        }
+    }
+    return kernel;
+}
+
+/*!
+ * \brief Get the response of soil carbon to a unit change in carbon which
+ *        decays exponentially.
+ * \details Element i is the fraction of the change which occurs in the i'th
+ *          year after the change, out to the length of the carbon cycle.  The
+ *          half-life is assumed to be the soil time scale divided by ten.  The
+ *          kernel is calculated once for each time scale and shared by all
+ *          carbon calculators which use it.
+ * \param aSoilTimeScale The soil time scale.
+ * \return The response kernel.
+ * \warning The kernels are cached without locking so this must only be called
+ *          during initialization and not from a parallel calculation.
+ */
+const vector<double>& CarbonModelUtils::getSoilKernel( const int aSoilTimeScale ){
+    static map<int, vector<double> > kernels;
+    vector<double>& kernel = kernels[ aSoilTimeScale ];
+    if( kernel.empty() ){
+        kernel.resize( getEndYear() - getStartYear() + 1 );
+        const double halfLife = aSoilTimeScale / 10.0;
+        const double lambda = log( 2.0 ) / halfLife;
+        double prevCumulative = 0.0;
+        for( size_t offsetYear = 0; offsetYear < kernel.size(); ++offsetYear ){
+            double currCumulative = 1.0 - exp( -1.0 * lambda * ( offsetYear + 1 ) );
+            kernel[ offsetYear ] = currCumulative - prevCumulative;
+            prevCumulative = currCumulative;
+        }
+    }
+    return kernel;
+}
+
 /*
  * \brief Returns a parameter which defines the time scale for the soil
  *        emissions decay function.
@@ -44,6 +44,9 @@
 // iTp is used extensively in array declarations, so it's special
 #define iTp 740
 
+#include <string>
+#include <map>
+#include <iosfwd>
 #include "climate/include/MAGICC_array.h"
 
 //#define DEBUG_MAGICC++
@@ -329,22 +332,81 @@ typedef struct {
     int KEYDW;
 } VARW_block;
 
+/*! \brief Values which the MAGICC subroutines must keep between calls.
+ * \details These were function level statics (Fortran SAVE variables) and are
+ *          kept per instance so that multiple instances do not interfere.
+ */
+struct SAVE_block {
+    SAVE_block();
+    // TSLCALC
+    float TCUM, TBASE, XX, GS1990, B19901, B19902, B19903, B19904;
+    float BZERO1, BZERO2, BZERO3, BZERO4;
+    float GSPREV1, GSPREV2, GSPREV3, GSPREV4;
+    float VZ1, VZ2, VZ3, VZ4;
+    // DELTAQ
+    float T00LO, T00MID, T00HI, T00USER;
+    float DQOZ, QOZ1;
+    float TX, DELT90, DELT00;
+    // CARBON
+    float DELC;
+};
+
+/*! \brief The contents of the MAGICC input and configuration files.
+ * \details The files are read from the MAGICC input directory once and then
+ *          shared read-only by all MAGICC instances.
+ */
+struct MAGICC_inputs {
+    MAGICC_inputs( const std::string& aInputDir );
+    //! The contents of each input file by file name.
+    std::map<std::string, std::string> mFiles;
+};
+
+/*! \brief The complete state of a single MAGICC instance.
+ * \details CLIMAT reads the parameter overrides and gas emissions from this
+ *          object and stores the results back into it.  The results can then
+ *          be queried through the accessor functions.  Separate instances may
+ *          be run concurrently.
+ */
+struct MAGICC_state {
+    MAGICC_state();
+    CARB_block CARB;
+    TANDSL_block TANDSL;
+    CONCS_block CONCS;
+    NEWCONCS_block NEWCONCS;
+    STOREDVALS_block STOREDVALS;
+    METH1_block METH1;
+    CAR_block CAR;
+    FORCE_block FORCE;
+    JSTART_block JSTART;
+    QADD_block QADD;
+    HALOF_block HALOF;
+    NEWPARAMS_block NEWPARAMS;
+    BCOC_block BCOC;
+    SAVE_block SAVE;
+    //! The gas emissions in the gas.emk format.
+    std::string GAS_EMK_DATA;
+    //! Whether to write the MAGICC diagnostic output files.
+    bool WRITE_OUTPUT;
+};
+
 // Function prototypes
-void CLIMAT();
+void CLIMAT( MAGICC_state* aState );
 void tslcalc( int N, Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, CARB_block* CARB,
              TANDSL_block* TANDSL, VARW_block* VARW, QSPLIT_block* QSPLIT, ICE_block* ICE, 
-             NSIM_block* NSIM, std::ofstream* outfile8 );
+             NSIM_block* NSIM, SAVE_block* SAVE, std::ofstream* outfile8 );
 void init( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, TANDSL_block* TANDSL, FORCE_block* FORCE, 
           Sulph_block* Sulph, VARW_block* VARW, ICE_block* ICE, AREAS_block* AREAS, NSIM_block* NSIM,
           OZ_block* OZ, NEWCONCS_block* NEWCONCS, CARB_block* CARB, CAR_block* CAR, METH1_block* METH1,
           METH2_block* METH2, METH3_block* METH3, METH4_block* METH4, CO2READ_block* CO2READ, JSTART_block* JSTART,
-          CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, TauNitr_block* TauNitr, QADD_block* QADD );
+          CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, TauNitr_block* TauNitr, QADD_block* QADD,
+          SAVE_block* SAVE );
 void interp( int NVAL, int ISTART, int IY[], float X[], magicc_array* Y, int KEND );
 void deltaq( Limits_block* Limits, OZ_block* OZ, CLIM_block* CLIM, CONCS_block* CONCS,
             NEWCONCS_block* NEWCONCS, CARB_block* CARB, TANDSL_block* TANDSL, CAR_block* CAR,
             METH1_block* METH1, FORCE_block* FORCE, METH2_block* METH2, METH3_block* METH3,
             METH4_block* METH4, TauNitr_block* TauNitr, Sulph_block* Sulph, NSIM_block* NSIM, 
-            CO2READ_block* CO2READ, JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS );
+            CO2READ_block* CO2READ, JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS,
+            SAVE_block* SAVE );
 void initcar( const int NN, const float D80, const float F80, COBS_block* COBS, 
              CARB_block* CARB, CAR_block* CAR );
 void halocarb( const int N, float C0, float E, float* C1, float* Q, float TAU00, float TAUCH4 );
@@ -359,7 +421,7 @@ void carbon( const int MM, float TEM, float EFOSS, float ENETDEF, float CPP, flo
             float PL, float HU, float SO, float REGRO, float ETOT,
             float* PL1, float* HU1, float* SO1, float* REGRO1, float* ETOT1,
             float* SUMEM, float* FLUX, float* DELM, float* EGROSSD, float* C1,
-            CAR_block* CAR ); 
+            CAR_block* CAR, SAVE_block* SAVE );
 void sulphate( const int JY, float ESO2, float ESO21, float ECO, float* QSO2, 
               float* QDIR, float* QFOC, float* QMN, Sulph_block* Sulph );
 void lamcalc( float Q, float FNHL, float FSHL, float XK, float XKH, float DT2X, 
@@ -369,33 +431,37 @@ void runmod( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, CARB_bl
             AREAS_block* AREAS, QADD_block* QADD, BCOC_block* BCOC, FORCE_block* FORCE, NSIM_block* NSIM,
             OZ_block* OZ, NEWCONCS_block* NEWCONCS, CAR_block* CAR, METH1_block* METH1, METH2_block* METH2, 
             METH3_block* METH3, METH4_block* METH4, TauNitr_block* TauNitr,
-            JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, ICE_block* ICE, std::ofstream* outfile8 );
+            JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, ICE_block* ICE,
+            SAVE_block* SAVE, std::ofstream* outfile8 );
 void split( const float QGLOBE, const float A, const float BN, const float BS, float* QNO, float* QNL, 
            float* QSO, float* QSL, AREAS_block* AREAS );
 
-void setGlobals( CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
+void setGlobals( MAGICC_state* aState, CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
                 STOREDVALS_block* STOREDVALS, NEWPARAMS_block* NEWPARAMS, BCOC_block* BCOC, 
                 METH1_block* METH1, CAR_block* CAR, FORCE_block* FORCE, JSTART_block* JSTART,
                 QADD_block* QADD, HALOF_block* HALOF, std::string& GAS_EMK_DATA );
-void setLocals( CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
+void setLocals( const MAGICC_state* aState, CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
                 STOREDVALS_block* STOREDVALS, NEWPARAMS_block* NEWPARAMS, BCOC_block* BCOC, 
                 METH1_block* METH1, CAR_block* CAR, FORCE_block* FORCE, JSTART_block* JSTART,
                 QADD_block* QADD, HALOF_block* HALOF, std::string& GAS_EMK_DATA );
 
 // Externally called methods
 
-float getSLR( const int inYear );
-float GETFORCING( const int iGasNumber, const int inYear );
-float GETGHGCONC(int, int);
-float GETGMTEMP(int);
-float GETCARBONRESULTS(int, int);
-void SETPARAMETERVALUES(int, float);
+float getSLR( const MAGICC_state* aState, const int inYear );
+float GETFORCING( const MAGICC_state* aState, const int iGasNumber, const int inYear );
+float GETGHGCONC( const MAGICC_state* aState, int, int );
+float GETGMTEMP( const MAGICC_state* aState, int );
+float GETCARBONRESULTS( const MAGICC_state* aState, int, int );
+void SETPARAMETERVALUES( MAGICC_state* aState, int, float );
 void overrideParameters( NEWPARAMS_block* NEWPARAMS, CAR_block* CAR, METH1_block* METH1, BCOC_block* BCOC );
-void SET_GAS_EMK( const std::string& GAS_EMK_DATA );
+void SET_GAS_EMK( MAGICC_state* aState, const std::string& GAS_EMK_DATA );
+void loadMAGICCInputs();
+const MAGICC_inputs& getMAGICCInputs();
 
 // Internal helper methods
 
 void openfile_read( std::ifstream* infile, const std::string& f, bool echo );
+void openinput_read( std::istringstream* infile, const MAGICC_inputs& aInputs, const std::string& f, bool echo );
 void skipline( std::istream* infile, bool echo );
 float read_csv_value( std::istream* infile, bool echo );
 float read_and_discard( std::istream* infile, bool echo );
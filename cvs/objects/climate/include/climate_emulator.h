@@ -0,0 +1,195 @@
+#ifndef _CLIMATE_EMULATOR_H_
+#define _CLIMATE_EMULATOR_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file climate_emulator.h
+* \ingroup Objects
+* \brief The ClimateEmulator header file.
+*/
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "climate/include/iclimate_model.h"
+
+/*! 
+* \ingroup Objects
+* \brief A reduced form emulator of a full climate model.
+* \details The ClimateEmulator wraps a full climate model and passes all calls
+*          through to it until emulation is switched on.  Each full model run
+*          is kept as an anchor.  While emulating, the climate outputs are
+*          calculated as the anchor plus a linear impulse response to the
+*          change in emissions since the anchor run.  The impulse responses are
+*          fit to the full model the first time emulation is requested, by
+*          perturbing the emissions of each gas in the first model period after
+*          calibration and shifting the responses to the other periods.
+*
+*          Only outputs which have been read from the model before the fit are
+*          emulated, other outputs return the anchor value.  Emissions are
+*          always forwarded to the full model so that switching emulation off
+*          can rerun the full model on the current emissions and verify the
+*          emulated result.
+*
+*          The emulator is not read from XML, it is created by the World when
+*          the "climate-emulator" configuration option is set.
+*/
+class ClimateEmulator: public IClimateModel {
+public:
+    ClimateEmulator( IClimateModel* aFullModel );
+    virtual ~ClimateEmulator();
+
+    bool setEmulating( const bool aEmulate );
+    bool isEmulating() const;
+
+    static const std::string& getXMLNameStatic();
+    virtual const std::string& getXMLName() const { return getXMLNameStatic(); }
+    virtual void XMLParse( const xercesc::DOMNode* node );
+    virtual void toInputXML( std::ostream& out, Tabs* tabs ) const;
+    virtual void toDebugXML( const int period, std::ostream& out, Tabs* tabs ) const;
+    virtual void completeInit( const std::string& aScenarioName );
+
+    virtual bool setEmissions( const std::string& aGasName,
+                               const int aPeriod,
+                               const double aEmission );
+
+    virtual bool setLUCEmissions( const std::string& aGasName,
+                                  const int aYear,
+                                  const double aEmission );
+
+    virtual double getEmissions( const std::string& aGasName,
+                                 const int aYear ) const;
+
+    virtual enum runModelStatus runModel();
+    virtual enum runModelStatus runModel( const int aYear );
+
+    virtual double getConcentration( const std::string& aGasName,
+                                     const int aYear ) const;
+
+    virtual double getTemperature( const int aYear ) const;
+
+    virtual double getForcing( const std::string& aGasName,
+                               const int aYear ) const;
+
+    virtual double getTotalForcing( const int aYear ) const;
+
+    virtual double getNetTerrestrialUptake( const int aYear ) const;
+
+    virtual double getNetOceanUptake( const int aYear ) const;
+
+    virtual int getCarbonModelStartYear() const;
+
+    virtual void printFileOutput() const;
+    virtual void printDBOutput() const;
+    virtual void accept( IVisitor* aVisitor, const int aPeriod ) const;
+
+private:
+    //! Emissions by gas and period, or by gas and year for LUC emissions.
+    typedef std::map<std::string, std::map<int, double> > EmissionsMap;
+
+    //! Output values by output key and year offset from the start year.
+    typedef std::map<std::string, std::vector<double> > OutputMap;
+
+    //! Type of a kernel key: the emissions gas and whether it is a LUC
+    //! emissions gas, since a gas may be set both by period and by year.
+    typedef std::pair<std::string, bool> KernelKey;
+
+    //! The wrapped full climate model, which is not owned.
+    IClimateModel* mFullModel;
+
+    //! Whether outputs are currently calculated by the emulator.
+    bool mIsEmulating;
+
+    //! Whether the emulated outputs have been calculated since the last full
+    //! model run, in which case the full model is out of date.
+    bool mHasEmulatedRun;
+
+    //! Whether the anchor is the result of a successful full model run.
+    bool mHasAnchor;
+
+    //! Whether the impulse responses have been fit.
+    bool mIsFit;
+
+    //! The first year of the output vectors.
+    int mStartYear;
+
+    //! The model period in which emissions were perturbed to fit the
+    //! impulse responses.
+    int mFitPeriod;
+
+    //! The year of mFitPeriod.
+    int mFitYear;
+
+    //! Current emissions by gas and period.
+    EmissionsMap mEmissions;
+
+    //! Current LUC emissions by gas and year.
+    EmissionsMap mLUCEmissions;
+
+    //! Emissions by gas and period of the anchor run.
+    EmissionsMap mAnchorEmissions;
+
+    //! LUC emissions by gas and year of the anchor run.
+    EmissionsMap mAnchorLUCEmissions;
+
+    //! Outputs of the anchor run.
+    OutputMap mAnchorOutputs;
+
+    //! Emulated outputs.
+    OutputMap mEmulatedOutputs;
+
+    //! Impulse responses by emissions gas, LUC flag and output key to a unit
+    //! change in emissions in mFitPeriod, indexed in the same way as the
+    //! outputs.
+    std::map<KernelKey, OutputMap> mKernels;
+
+    //! The output keys which have been read and should be emulated.
+    mutable std::set<std::string> mTrackedOutputs;
+
+    double getOutput( const std::string& aKey, const int aYear ) const;
+    double getFullOutput( const std::string& aKey, const int aYear ) const;
+    std::vector<double> getFullOutputs( const std::string& aKey ) const;
+    void setAnchor();
+    void fit();
+    void emulate();
+    std::map<int, double> calcPeriodDeltas( const std::string& aGasName,
+                                            const bool aIsLUC ) const;
+};
+
+#endif // _CLIMATE_EMULATOR_H_
@@ -48,9 +48,11 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <memory>
 #include "climate/include/iclimate_model.h"
 
 class IVisitor;
+struct MAGICC_state;
 
 /*! 
 * \ingroup Objects
@@ -61,10 +63,12 @@ class IVisitor;
 *          contained in the C++ MagiccModel code. This wrapper is responsible
 *          for reading in a set of default gas emissions for each gas by period,
 *          overriding those with values from the model where calculated, and
-*          interpolating them into a set of inputs for MAGICC. It then writes
-*          those values to a file and calls MAGICC to calculate climate
-*          parameters. A subset of those output can then be written by this
-*          wrapper to the database and a CSV file.
+*          interpolating them into a set of inputs for MAGICC. It then passes
+*          those values in memory to its own MAGICC instance and calls MAGICC to
+*          calculate climate parameters. A subset of those output can then be
+*          written by this wrapper to the database and a CSV file. Each
+*          MagiccModel has a separate MAGICC instance so that multiple models
+*          may be run concurrently.
 * \note It is possible to run MAGICC using the Objects framework without running
 *       the economic model. This is done by reading in a scenario container with
 *       only a modeltime object and an empty world object. It will run off the
@@ -75,6 +79,7 @@ class IVisitor;
 class MagiccModel: public IClimateModel {
 public:
     MagiccModel();
+    virtual ~MagiccModel();
 
     virtual void completeInit( const std::string& aScenarioName );
     
@@ -192,6 +197,9 @@ protected:
     //CREATE_SIMPLE_VARIABLE( mNumberHistoricalDataPoints, int, "num-historical-data-points" ),
     int mNumberHistoricalDataPoints;
 
+    //! The state of the MAGICC instance used by this model.
+    std::auto_ptr<MAGICC_state> mState;
+
 private:
 
     bool isValidClimateModelYear( const int aYear ) const;
@@ -200,7 +208,7 @@ private:
     static unsigned int getNumInputGases();
     void readFile();
     void overwriteMAGICCParameters( );
-    void writeMAGICCEmissionsFile( );
+    void setMAGICCEmissions( );
     void writeComma( int gasNumber, int& numberOfDataPoints, std::ostringstream& gasFile );
         
     static int getNumAdditionalGasPoints();
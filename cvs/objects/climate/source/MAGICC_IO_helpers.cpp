@@ -42,6 +42,9 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <sstream>
+
+#include "climate/include/ObjECTS_MAGICC.h"
 
 using namespace std;
 
@@ -57,6 +60,18 @@ void openfile_read( ifstream* infile, const string& f, bool echo )
     if ( echo ) cout << "Opened file " << f << " for read OK\n";
 }
 
+void openinput_read( istringstream* infile, const MAGICC_inputs& aInputs, const string& f, bool echo )
+{
+    map<string, string>::const_iterator iter = aInputs.mFiles.find( f );
+    if ( iter == aInputs.mFiles.end() ) {
+        cerr << "Unable to open file " << f << " for read\n";
+        exit( 1 );
+    }
+    (*infile).clear();
+    (*infile).str( iter->second );
+    if ( echo ) cout << "Opened file " << f << " for read OK\n";
+}
+
 void skipline( istream* infile, bool echo )
 {
     string line;
@@ -37,6 +37,7 @@
 #include <math.h>
 #include <time.h>
 #include <stdlib.h>
+#include <cassert>
 
 
 #include "climate/include/ObjECTS_MAGICC.h"
@@ -47,18 +48,76 @@
 
 using namespace std;
 
+//! The MAGICC input files shared by all instances, null until loaded.
+static const MAGICC_inputs* sMAGICCInputs = 0;
+
+
+/*! \brief Read all of the MAGICC input files into memory.
+ * \details Files which do not exist are skipped, it is an error for CLIMAT to
+ *          request one of them.
+ * \param aInputDir The MAGICC input directory.
+ */
+MAGICC_inputs::MAGICC_inputs( const string& aInputDir )
+{
+    const char* FILE_NAMES[] = { "co2hist_c.in", "maguser_c.cfg", "magice_c.cfg", "maggas_c.cfg",
+                                 "magmod_c.cfg", "magrun_c.cfg", "magxtra_c.cfg", "qhalos_c.in",
+                                 "Co2input_c.dat", "qextra_c.in", "BCOCHist_c.csv" };
+    for( size_t i = 0; i < sizeof( FILE_NAMES ) / sizeof( FILE_NAMES[ 0 ] ); ++i ) {
+        ifstream infile( ( aInputDir + "/" + FILE_NAMES[ i ] ).c_str(), ios::in );
+        if( infile ) {
+            ostringstream contents;
+            contents << infile.rdbuf();
+            mFiles[ FILE_NAMES[ i ] ] = contents.str();
+        }
+    }
+}
+
+/*! \brief Read the MAGICC input files from the MAGICC-input-dir if they have
+ *         not already been read.
+ * \details This must be called before any instance runs CLIMAT, and not
+ *          concurrently with it.  The files are shared by all instances.
+ */
+void loadMAGICCInputs()
+{
+    if( !sMAGICCInputs ) {
+        sMAGICCInputs = new MAGICC_inputs( Configuration::getInstance()->getString( "MAGICC-input-dir",
+                                                                                  "../input/magicc/inputs" ) );
+    }
+}
+
+/*! \brief Get the MAGICC input files.
+ * \pre loadMAGICCInputs has been called.
+ * \return The MAGICC input files.
+ */
+const MAGICC_inputs& getMAGICCInputs()
+{
+    assert( sMAGICCInputs );
+    return *sMAGICCInputs;
+}
+
+/*! \brief Open a MAGICC output file if the instance writes output files.
+ * \details The stream is left closed otherwise so that anything written to it
+ *          is discarded.
+ */
+static void openoutput_write( const MAGICC_state* aState, ofstream* outfile, const string& f, bool echo )
+{
+    if( aState->WRITE_OUTPUT ) {
+        openfile_write( outfile, f, echo );
+    }
+}
 
 // The climat() function is up here so as to encapsulate all these stinking variables;
 // we're not going to allow any globals in the C++ code
-void CLIMAT()
+void CLIMAT( MAGICC_state* aState )
 {
-    // Get input and output file directories from the configuration.  Opening files
-    // will be done relative to these paths.
+    // Get the output file directory from the configuration.  Opening files
+    // will be done relative to this path.  The input files are read once and
+    // shared by all instances.
     const Configuration* conf = Configuration::getInstance();
     const string BASE_OUTPUT_DIR = conf->getString( "MAGICC-output-dir", "../output" );
-    const string BASE_INPUT_DIR = conf->getString( "MAGICC-input-dir", "../input/magicc/inputs" );
+    const MAGICC_inputs& inputs = getMAGICCInputs();
     ofstream outfile8; // need to do this here; see line F395 and F658
-    openfile_write( &outfile8, BASE_OUTPUT_DIR + "/mag_c.csv", DEBUG_IO );
+    openoutput_write( aState, &outfile8, BASE_OUTPUT_DIR + "/mag_c.csv", DEBUG_IO );
     
     //F   1 ! MAGTAR.FOR
     //F   2 !
@@ -389,7 +448,7 @@ void CLIMAT()
     string GAS_EMK_DATA;
 
     // The MAGICC routines need access to these data structures, so set some global references
-    setLocals( &CARB, &TANDSL, &CONCS, &NEWCONCS, 
+    setLocals( aState, &CARB, &TANDSL, &CONCS, &NEWCONCS, 
                 &STOREDVALS, &NEWPARAMS, &BCOC, 
                 &METH1, &CAR, &FORCE, &JSTART,
                 &QADD, &HALOF, GAS_EMK_DATA );
@@ -477,8 +536,8 @@ void CLIMAT()
     //F 254 !
     //F 255       lun = 42   ! spare logical unit no.
     //F 256       open(unit=lun,file='./magicc_files/CO2HIST.IN',status='OLD')
-    ifstream infile;
-    openfile_read( &infile, BASE_INPUT_DIR + "/co2hist_c.in", DEBUG_IO );
+    istringstream infile;
+    openinput_read( &infile, inputs, "co2hist_c.in", DEBUG_IO );
     //F 257       DO ICO2=0,JSTART
     for( int ICO2=0; ICO2<=JSTART.JSTART; ICO2++ ) {
         //F 258       READ(LUN,4445)IIII,COBS(ICO2),FOSSHIST(ICO2)
@@ -486,13 +545,12 @@ void CLIMAT()
         //F 259       END DO
     }
     //F 260       CLOSE(lun)
-    infile.close();
     //F 261 !
     //F 262 !  READ PARAMETERS FROM MAGUSER.CFG.
     //F 263 !
     //F 264       lun = 42   ! spare logical unit no.
     //F 265       open(unit=lun,file='./magicc_files/MAGUSER.CFG',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/maguser_c.cfg", DEBUG_IO );
+    openinput_read( &infile, inputs, "maguser_c.cfg", DEBUG_IO );
     //F 266 !
     //F 267         READ(LUN,4240) LEVCO2
     CO2READ.LEVCO2 = read_and_discard( &infile, false );
@@ -522,7 +580,6 @@ void CLIMAT()
     const int NONOFF = 0;
     //F 280 !
     //F 281       close(lun)
-    infile.close();
     //F 282 !
     //F 283       LASTMAX=1764+iTp
     const int LASTMAX = 1764 + iTp;
@@ -535,7 +592,7 @@ void CLIMAT()
     //F 289 !
     //F 290       lun = 42   ! spare logical unit no.
     //F 291       open(unit=lun,file='./magicc_files/MAGICE.CFG',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/magice_c.cfg", DEBUG_IO );
+    openinput_read( &infile, inputs, "magice_c.cfg", DEBUG_IO );
     //F 292 !
     //F 293         READ(LUN,4240) NEWGSIC  ! SET = 1 TO USE NEW ALGORITHM
     ICE.NEWGSIC = read_and_discard( &infile, false );
@@ -549,7 +606,6 @@ void CLIMAT()
     const float ASEN = read_and_discard( &infile, false );
     //F 298 !
     //F 299       CLOSE(lun)
-    infile.close();
     //F 300 !
     //F 301 !  ********************************************************************
     //F 302 !
@@ -558,7 +614,7 @@ void CLIMAT()
     //F 305 !
     //F 306       lun = 42   ! spare logical unit no.
     //F 307       open(unit=lun,file='./magicc_files/MAGGAS.CFG',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/maggas_c.cfg", DEBUG_IO );
+    openinput_read( &infile, inputs, "maggas_c.cfg", DEBUG_IO );
     //F 308 !
     //F 309         READ(LUN,4240) OVRWRITE
     OVRWRITE = read_and_discard( &infile, false );
@@ -635,7 +691,6 @@ void CLIMAT()
     METH3.ICH4FEED = read_and_discard( &infile, false );
     //F 344 !
     //F 345       close(lun)
-    infile.close();
     //F 346 
     //! Initiailize internal BC-OC vars
     //aBCUnitForcing = 0
@@ -731,7 +786,7 @@ void CLIMAT()
     //F 403 !
     //F 404       lun = 42   ! spare logical unit no.
     //F 405       open(unit=lun,file='./magicc_files/MAGMOD.CFG',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/magmod_c.cfg", DEBUG_IO );
+    openinput_read( &infile, inputs, "magmod_c.cfg", DEBUG_IO );
     //F 406 !
     //F 407         READ(LUN,4241) ADJUST
     DSENS.ADJUST = read_and_discard( &infile, false );
@@ -774,7 +829,6 @@ void CLIMAT()
     }
     //F 427 !
     //F 428       close(lun)
-    infile.close();
     //F 429 !
     //F 430 !   Call overrite subroutine after each file that may have parameters to overwrite
     //F 431       call overrideParameters( )	! sjs
@@ -1068,7 +1122,7 @@ void CLIMAT()
     //F 589 !
     //F 590       lun = 42   ! spare logical unit no.
     //F 591       open(unit=lun,file='./magicc_files/MAGRUN.CFG',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/magrun_c.cfg", DEBUG_IO );
+    openinput_read( &infile, inputs, "magrun_c.cfg", DEBUG_IO );
     //F 592 !
     //F 593         READ(LUN,4240) ISCENGEN
     NSIM.ISCENGEN = read_and_discard( &infile, false );
@@ -1091,7 +1145,6 @@ void CLIMAT()
     /* //UNUSED const float D2400 = */ read_and_discard( &infile, false );
     //F 603 !
     //F 604       close(lun)
-    infile.close();
     //F 605 !
     //F 606 !  ********************************************************************
     //F 607 !
@@ -1099,7 +1152,7 @@ void CLIMAT()
     //F 609 !
     //F 610       lun = 42   ! spare logical unit no.
     //F 611       open(unit=lun,file='./magicc_files/MAGXTRA.CFG',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/magxtra_c.cfg", DEBUG_IO );
+    openinput_read( &infile, inputs, "magxtra_c.cfg", DEBUG_IO );
     //F 612 !
     //F 613         READ(LUN,4240) IOLDTZ
     QADD.IOLDTZ = read_and_discard( &infile, false );
@@ -1161,7 +1214,6 @@ void CLIMAT()
     const int IYRQALL = 1990;
     //F 642 !
     //F 643       close(lun)
-    infile.close();
     //F 644 !
     //F 645 !   Call overrite subroutine after each file that may have parameters to overwrite
     //F 646       call overrideParameters( ) !sjs
@@ -1183,7 +1235,7 @@ void CLIMAT()
     // Handled at beginning of climat()
     //F 660       OPEN(UNIT=88,file='./outputs/CCSM.TXT', STATUS='UNKNOWN')
     ofstream outfile88;
-    openfile_write( &outfile88, BASE_OUTPUT_DIR + "/ccsm_c.txt", DEBUG_IO );
+    openoutput_write( aState, &outfile88, BASE_OUTPUT_DIR + "/ccsm_c.txt", DEBUG_IO );
     //F 661 !
     //F 662 !  INTERIM CORRECTION TO AVOID CRASH IF S90IND SET TO ZERO IN
     //F 663 !   MAGUSER.CFG
@@ -1282,7 +1334,7 @@ void CLIMAT()
     //F 722 !
     //F 723       lun = 42   ! spare logical unit no.
     //F 724       open(unit=lun,file='./magicc_files/QHALOS.IN',status='OLD')
-    openfile_read( &infile, BASE_INPUT_DIR + "/qhalos_c.in", DEBUG_IO );
+    openinput_read( &infile, inputs, "qhalos_c.in", DEBUG_IO );
     //F 725 !
     //F 726       READ(LUN,4446)IHALO1
     int IHALO1 = read_and_discard( &infile, false );
@@ -1330,7 +1382,6 @@ void CLIMAT()
     }
     //F 747 !
     //F 748       CLOSE(lun)
-    infile.close();
     //F 749 !
     //F 750 !  TAU FOR CH4 SOIL SINK CHANGED TO ACCORD WITH IPCC94 (160 yr).
     //F 751 !  SPECIFICATION OF TauSoil MOVED TO MAGEXTRA.CFG ON 1/10/97.
@@ -1404,7 +1455,7 @@ void CLIMAT()
     if( CO2READ.ICO2READ >= 1 && CO2READ.ICO2READ <= 4 ) {
         //F 796         lun = 42   ! spare logical unit no.
         //F 797         open(unit=lun,file='./magicc_files/Co2input.dat',status='OLD')
-        openfile_read( &infile, BASE_INPUT_DIR + "/Co2input_c.dat", DEBUG_IO );
+        openinput_read( &infile, inputs, "Co2input_c.dat", DEBUG_IO );
         //F 798 !
         //F 799 !  CO2INPUT.DAT MUST HAVE FIRST YEAR = 1990 AND MUST HAVE ANNUAL END
         //F 800 !   OF YEAR VALUES. FIRST LINE OF FILE GIVES LAST YEAR OF ARRAY.
@@ -1433,7 +1484,6 @@ void CLIMAT()
             //F 815         ENDIF
         }
         //F 816         close(lun)
-        infile.close();
         //F 817       ENDIF
     }
     //F 818 !
@@ -1450,7 +1500,7 @@ void CLIMAT()
     if( QADD.IQREAD >= 1 ) {
         //F 829         lun = 42   ! spare logical unit no.
         //F 830         open(unit=lun,file='./magicc_files/qextra.in',status='OLD')
-        openfile_read( &infile, BASE_INPUT_DIR + "/qextra_c.in", DEBUG_IO );
+        openinput_read( &infile, inputs, "qextra_c.in", DEBUG_IO );
         //F 831 !
         //F 832         READ(LUN,900)NCOLS
         //F 833         READ(lun,901)IQFIRST,IQLAST
@@ -1551,7 +1601,6 @@ void CLIMAT()
             //F 882         ENDIF
         }
         //F 883         close(lun)
-        infile.close();
         //F 884       ELSE
     } else {
         //F 885         JQLAST=2100-1764
@@ -1590,7 +1639,7 @@ void CLIMAT()
         //F 911 
         //F 912         lun = 42   ! spare logical unit no.
         //F 913         open(unit=lun,file='../cvs/objects/magicc/inputs/BCOCHist.csv',status='OLD')
-        openfile_read( &infile, BASE_INPUT_DIR + "/BCOCHist_c.csv", DEBUG_IO );  //FIX location
+        openinput_read( &infile, inputs, "BCOCHist_c.csv", DEBUG_IO );  //FIX location
         //F 914 !
         //F 915         READ(LUN,*)QtempBCUnitForcing, aBCBaseEmissions
         float QtempBCUnitForcing=0.0f, QtempOCUnitForcing=0.0f;
@@ -1656,7 +1705,6 @@ void CLIMAT()
         }
         //F 950         
         //F 951         close(lun)
-        infile.close();
         //F 952         
         //F 953         ! Flag to use QExtra forcing
         //F 954         IQREAD = 1
@@ -2101,7 +2149,7 @@ void CLIMAT()
     //F1202       CALL INIT
     init( &Limits, &CLIM, &CONCS, &TANDSL, &FORCE, &Sulph, &VARW, &ICE, &AREAS, &NSIM,
          &OZ, &NEWCONCS, &CARB, &CAR, &METH1, &METH2, &METH3, &METH4, &CO2READ, &JSTART,
-         &CORREN, &HALOF, &COBS, &TauNitr, &QADD );
+         &CORREN, &HALOF, &COBS, &TauNitr, &QADD, &aState->SAVE );
     //F1203 !
     //F1204 !  LINEARLY EXTRAPOLATE LAST ESO2 VALUES FOR ONE YEAR
     //F1205 !
@@ -2357,7 +2405,7 @@ void CLIMAT()
              &Sulph, &VARW, &ICE, &AREAS, &NSIM,
              &OZ, &NEWCONCS, &CARB, &CAR, &METH1,
              &METH2, &METH3, &METH4, &CO2READ, &JSTART,
-             &CORREN, &HALOF, &COBS, &TauNitr, &QADD );     
+             &CORREN, &HALOF, &COBS, &TauNitr, &QADD, &aState->SAVE );     
          //F1372 !
         //F1373       IF(NESO2.EQ.1)THEN
         if( NESO2 == 1 ) {
@@ -2458,7 +2506,7 @@ void CLIMAT()
                &CO2READ, &Sulph, &DSENS, &VARW, &QSPLIT,
                &AREAS, &QADD, &BCOC, &FORCE, &NSIM,
                &OZ, &NEWCONCS, &CAR, &METH1, &METH2, &METH3, &METH4, &TauNitr,
-               &JSTART, &CORREN, &HALOF, &COBS, &ICE, &outfile8 );
+               &JSTART, &CORREN, &HALOF, &COBS, &ICE, &aState->SAVE, &outfile8 );
         //F1423 !
         //F1424 !  EXTRA CALL TO RUNMOD TO GET FINAL FORCING VALUES FOR K=KEND
         //F1425 !   WHEN DT=1.0
@@ -3827,13 +3875,13 @@ void CLIMAT()
         //F2238 	OPEN (UNIT=9, file='./outputs/MAGOUT.CSV')
 
         // GetForcing now relies on globals, and these need to be set
-        setGlobals( &CARB, &TANDSL, &CONCS, &NEWCONCS, 
+        setGlobals( aState, &CARB, &TANDSL, &CONCS, &NEWCONCS, 
                    &STOREDVALS, &NEWPARAMS, &BCOC, 
                    &METH1, &CAR, &FORCE, &JSTART,
                    &QADD, &HALOF, GAS_EMK_DATA );
 
         ofstream outfile9;
-        openfile_write( &outfile9, BASE_OUTPUT_DIR + "/magout_c.csv", DEBUG_IO ); //FIX filename
+        openoutput_write( aState, &outfile9, BASE_OUTPUT_DIR + "/magout_c.csv", DEBUG_IO ); //FIX filename
         //F2239 
         //F2240   100 FORMAT(I5,1H,,27(F15.5,1H,))
         //F2241 
@@ -3874,26 +3922,26 @@ void CLIMAT()
 
             // RADIATIVE FORCING
             //F2273 	 MAGICCCResults(13,(K-1990)/IIPRT+1) = GETFORCING( 0, K ) ! Total antro forcing
-            MAGICCCResults[ 4 ][ yrindex ] = GETFORCING( 0, K );
+            MAGICCCResults[ 4 ][ yrindex ] = GETFORCING( aState, 0, K );
             //F2282 	 MAGICCCResults(22,(K-1990)/IIPRT+1) = & !Kyoto Forcing
             //F2283 	    GETFORCING( 1, K ) + GETFORCING( 2, K )  + GETFORCING( 3, K ) + & ! CO2, CH4, and N2O
             //F2284 	    GETFORCING( 4, K ) + GETFORCING( 9, K ) + GETFORCING( 10, K ) + &! Long-lived F-gases
             //F2285 	    GETFORCING( 5, K ) + GETFORCING( 6, K ) + GETFORCING( 7, K ) + &
             //F2286 	    GETFORCING( 8, K ) + GETFORCING( 11, K ) + GETFORCING( 12, K ) ! Shorter-lived F-gases
-            MAGICCCResults[ 5 ][ yrindex ] = GETFORCING( 1, K ) + GETFORCING( 2, K ) + GETFORCING( 3, K ) +
-                GETFORCING( 4, K ) + GETFORCING( 9, K ) + GETFORCING( 10, K ) +
-                GETFORCING( 5, K ) + GETFORCING( 6, K ) + GETFORCING( 7, K ) +
-                GETFORCING( 8, K ) + GETFORCING( 11, K ) + GETFORCING( 12, K );
+            MAGICCCResults[ 5 ][ yrindex ] = GETFORCING( aState, 1, K ) + GETFORCING( aState, 2, K ) + GETFORCING( aState, 3, K ) +
+                GETFORCING( aState, 4, K ) + GETFORCING( aState, 9, K ) + GETFORCING( aState, 10, K ) +
+                GETFORCING( aState, 5, K ) + GETFORCING( aState, 6, K ) + GETFORCING( aState, 7, K ) +
+                GETFORCING( aState, 8, K ) + GETFORCING( aState, 11, K ) + GETFORCING( aState, 12, K );
             //F2262 	 MAGICCCResults(5,(K-1990)/IIPRT+1) = GETFORCING( 1, K ) ! CO2
-            MAGICCCResults[ 6 ][ yrindex ] = GETFORCING( 1, K );
+            MAGICCCResults[ 6 ][ yrindex ] = GETFORCING( aState, 1, K );
             //F2263 	 MAGICCCResults(6,(K-1990)/IIPRT+1) = GETFORCING( 2, K ) ! CH4 (no indirect components)
-            MAGICCCResults[ 7 ][ yrindex ] = GETFORCING( 2, K );
+            MAGICCCResults[ 7 ][ yrindex ] = GETFORCING( aState, 2, K );
             //F2264 	 MAGICCCResults(7,(K-1990)/IIPRT+1) = GETFORCING( 3, K ) ! N2O
-            MAGICCCResults[ 8 ][ yrindex ] = GETFORCING( 3, K );
+            MAGICCCResults[ 8 ][ yrindex ] = GETFORCING( aState, 3, K );
             //F2270 	 MAGICCCResults(10,(K-1990)/IIPRT+1) = GETFORCING( 14, K ) ! SO2 direct only
-            MAGICCCResults[ 9 ][ yrindex ] = GETFORCING( 14, K );
+            MAGICCCResults[ 9 ][ yrindex ] = GETFORCING( aState, 14, K );
             //F2271 	 MAGICCCResults(11,(K-1990)/IIPRT+1) = GETFORCING( 13, K ) - GETFORCING( 14, K ) ! indirect only
-            MAGICCCResults[ 10 ][ yrindex ] = GETFORCING( 13, K ) - GETFORCING( 14, K );
+            MAGICCCResults[ 10 ][ yrindex ] = GETFORCING( aState, 13, K ) - GETFORCING( aState, 14, K );
 
             // EMISSIONS
             //F2274 	 MAGICCCResults(14,(K-1990)/IIPRT+1) = EF(IYR)
@@ -3915,17 +3963,17 @@ void CLIMAT()
             //F2258 	 MAGICCCResults(1,(K-1990)/IIPRT+1) = TEMUSER(IYR)+TGAV(226)
             MAGICCCResults[ 18 ][ yrindex ] = STOREDVALS.TEMUSER[ IYR ] + TANDSL.TGAV[ 226 ];
             //F2281 	 MAGICCCResults(21,(K-1990)/IIPRT+1) = getSLR( IYR ) ! getSLR is external fn with acutal year as argument
-            MAGICCCResults[ 19 ][ yrindex ] = getSLR( K );
+            MAGICCCResults[ 19 ][ yrindex ] = getSLR( aState, K );
 
             // BC/OC FORCING
             //F2293 	 MAGICCCResults(26,(K-1990)/IIPRT+1) = GETFORCING( 24, K )	! BC forcing 
-         //   MAGICCCResults[ 20 ][ yrindex ] = GETFORCING( 24, K );
+         //   MAGICCCResults[ 20 ][ yrindex ] = GETFORCING( aState, 24, K );
             //F2294 	 MAGICCCResults(27,(K-1990)/IIPRT+1) = GETFORCING( 25, K )	! OC forcing 
-         //   MAGICCCResults[ 21 ][ yrindex ] = GETFORCING( 25, K );
+         //   MAGICCCResults[ 21 ][ yrindex ] = GETFORCING( aState, 25, K );
             // Fossil BC/OC Forcing
-            MAGICCCResults[ 20 ][ yrindex ] = GETFORCING( 28, K );
+            MAGICCCResults[ 20 ][ yrindex ] = GETFORCING( aState, 28, K );
             // Biomass Burning Aerosol Forcing
-            MAGICCCResults[ 21 ][ yrindex ] = GETFORCING( 20, K );
+            MAGICCCResults[ 21 ][ yrindex ] = GETFORCING( aState, 20, K );
             
             //F2295 
             //F2296 ! now we can write stuff out
@@ -3956,7 +4004,7 @@ void CLIMAT()
         if( NSIM.ISCENGEN == 9 || NSIM.NSIM == 4 ) {
             //F2314 !
             //F2315       open(unit=9,file='./outputs/concs.dis',status='UNKNOWN')
-            openfile_write( &outfile9, BASE_OUTPUT_DIR + "/concs_c.dis", DEBUG_IO );
+            openoutput_write( aState, &outfile9, BASE_OUTPUT_DIR + "/concs_c.dis", DEBUG_IO );
             //F2316 !
             //F2317         WRITE (9,211)
             outfile9 << "YEAR CO2USER   CO2LO  CO2MID   CO2HI CH4USER   CH4LO  CH4MID   CH4HI     N2O MIDTAUCH4" << endl;
@@ -4082,7 +4130,7 @@ void CLIMAT()
             //F2394 !  WRITE FORCING CHANGES FROM MID-1990 TO MAG DISPLAY FILE
             //F2395 !
             //F2396       open(unit=9,file='./outputs/forcings.dis',status='UNKNOWN')
-            openfile_write( &outfile9, BASE_OUTPUT_DIR + "/forcings_c.dis", DEBUG_IO );
+            openoutput_write( aState, &outfile9, BASE_OUTPUT_DIR + "/forcings_c.dis", DEBUG_IO );
             //F2397 !
             //F2398         WRITE (9,57)
             outfile9 << "YEAR,CO2,CH4tot,N2O, HALOtot,TROPOZ,SO4DIR,SO4IND,BIOAER,FOC+FBC,QAERMN,QLAND, TOTAL, YEAR,CH4-O3," << endl;
@@ -4291,22 +4339,22 @@ void CLIMAT()
         //F2524 !
         //F2525         OPEN(UNIT=10,file='./outputs/lodrive.raw' ,STATUS='UNKNOWN')
         ofstream outfile10, outfile11, outfile12, outfile13, outfile14, outfile15, outfile16, outfile17;
-        openfile_write( &outfile10, BASE_OUTPUT_DIR + "/lodrive.raw", DEBUG_IO );
+        openoutput_write( aState, &outfile10, BASE_OUTPUT_DIR + "/lodrive.raw", DEBUG_IO );
         //F2526         OPEN(UNIT=11,file='./outputs/middrive.raw',STATUS='UNKNOWN')
-        openfile_write( &outfile11, BASE_OUTPUT_DIR + "/middrive.raw", DEBUG_IO );
+        openoutput_write( aState, &outfile11, BASE_OUTPUT_DIR + "/middrive.raw", DEBUG_IO );
         //F2527         OPEN(UNIT=12,file='./outputs/hidrive.raw' ,STATUS='UNKNOWN')
-        openfile_write( &outfile12, BASE_OUTPUT_DIR + "/hidrive.raw", DEBUG_IO );
+        openoutput_write( aState, &outfile12, BASE_OUTPUT_DIR + "/hidrive.raw", DEBUG_IO );
         //F2528         OPEN(UNIT=13,file='./outputs/usrdrive.raw',STATUS='UNKNOWN')
-        openfile_write( &outfile13, BASE_OUTPUT_DIR + "/usrdrive.raw", DEBUG_IO );
+        openoutput_write( aState, &outfile13, BASE_OUTPUT_DIR + "/usrdrive.raw", DEBUG_IO );
         //F2529 !
         //F2530         OPEN(UNIT=14,file='./outputs/lodrive.out' ,STATUS='UNKNOWN')
-        openfile_write( &outfile14, BASE_OUTPUT_DIR + "/lodrive.out", DEBUG_IO );
+        openoutput_write( aState, &outfile14, BASE_OUTPUT_DIR + "/lodrive.out", DEBUG_IO );
         //F2531         OPEN(UNIT=15,file='./outputs/middrive.out',STATUS='UNKNOWN')
-        openfile_write( &outfile15, BASE_OUTPUT_DIR + "/middrive.out", DEBUG_IO );
+        openoutput_write( aState, &outfile15, BASE_OUTPUT_DIR + "/middrive.out", DEBUG_IO );
         //F2532         OPEN(UNIT=16,file='./outputs/hidrive.out' ,STATUS='UNKNOWN')
-        openfile_write( &outfile16, BASE_OUTPUT_DIR + "/hidrive.out", DEBUG_IO );
+        openoutput_write( aState, &outfile16, BASE_OUTPUT_DIR + "/hidrive.out", DEBUG_IO );
         //F2533         OPEN(UNIT=17,file='./outputs/usrdrive.out',STATUS='UNKNOWN')
-        openfile_write( &outfile17, BASE_OUTPUT_DIR + "/usrdrive.out", DEBUG_IO );
+        openoutput_write( aState, &outfile17, BASE_OUTPUT_DIR + "/usrdrive.out", DEBUG_IO );
         //F2534 !
         //F2535         DO NCLIM=1,4
         for( NSIM.NCLIM=1; NSIM.NCLIM<=4; NSIM.NCLIM++ ) {
@@ -4522,7 +4570,7 @@ void CLIMAT()
     //F2649 !
     //F2650       open(unit=9,file='./outputs/temps.dis',status='UNKNOWN')
     ofstream outfile9;
-    openfile_write( &outfile9, BASE_OUTPUT_DIR + "/temps_c.dis", DEBUG_IO );
+    openoutput_write( aState, &outfile9, BASE_OUTPUT_DIR + "/temps_c.dis", DEBUG_IO );
     //F2651 !
     //F2652         WRITE (9,213)
     outfile9 << "YEAR  TEMUSER    TEMLO   TEMMID    TEMHI TEMNOSO2" << endl;
@@ -4550,7 +4598,7 @@ void CLIMAT()
     //F2668 !  WRITE SEALEVEL CHANGES TO MAG DISPLAY FILE
     //F2669 !
     //F2670       open(unit=9,file='./outputs/sealev.dis',status='UNKNOWN')
-    openfile_write( &outfile9, BASE_OUTPUT_DIR + "/sealev_c.dis", DEBUG_IO );
+    openoutput_write( aState, &outfile9, BASE_OUTPUT_DIR + "/sealev_c.dis", DEBUG_IO );
     //F2671 !
     //F2672         WRITE (9,214)
     outfile9 << "YEAR  MSLUSER    MSLLO   MSLMID    MSLHI" << endl;
@@ -4578,7 +4626,7 @@ void CLIMAT()
     //F2688 !  WRITE EMISSIONS TO MAG DISPLAY FILE
     //F2689 !
     //F2690       open(unit=9,file='./outputs/emiss.dis',status='UNKNOWN')
-    openfile_write( &outfile9, BASE_OUTPUT_DIR + "/emiss_c.dis", DEBUG_IO );
+    openoutput_write( aState, &outfile9, BASE_OUTPUT_DIR + "/emiss_c.dis", DEBUG_IO );
     //F2691 !
     //F2692         WRITE (9,212)
     outfile9 << "YEAR  FOSSCO2 NETDEFOR      CH4      N2O SO2-REG1 SO2-REG2 SO2-REG3   SO2-GL" << endl;
@@ -4632,7 +4680,7 @@ void CLIMAT()
     //F2725 !
     //F2726       OPEN(UNIT=888,file='./outputs/FRACLEFT.OUT',STATUS='UNKNOWN')
     ofstream outfile888;
-    openfile_write( &outfile888, BASE_OUTPUT_DIR + "/fracleft_c.out", DEBUG_IO );
+    openoutput_write( aState, &outfile888, BASE_OUTPUT_DIR + "/fracleft_c.out", DEBUG_IO );
     //F2727 !
     //F2728 !  FRACTION OF CO2 REMAINING IN ATMOSPHERE
     //F2729 !
@@ -4998,7 +5046,7 @@ void CLIMAT()
     //F3057         end
     outfile8.close();
 
-    setGlobals( &CARB, &TANDSL, &CONCS, &NEWCONCS, 
+    setGlobals( aState, &CARB, &TANDSL, &CONCS, &NEWCONCS, 
               &STOREDVALS, &NEWPARAMS, &BCOC, 
               &METH1, &CAR, &FORCE, &JSTART,
               &QADD, &HALOF, GAS_EMK_DATA );
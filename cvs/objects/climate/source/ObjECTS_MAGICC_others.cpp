@@ -92,7 +92,8 @@ void init( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, TANDSL_bl
           Sulph_block* Sulph, VARW_block* VARW, ICE_block* ICE, AREAS_block* AREAS, NSIM_block* NSIM,
           OZ_block* OZ, NEWCONCS_block* NEWCONCS, CARB_block* CARB, CAR_block* CAR, METH1_block* METH1,
           METH2_block* METH2, METH3_block* METH3, METH4_block* METH4, CO2READ_block* CO2READ, JSTART_block* JSTART,
-          CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, TauNitr_block* TauNitr, QADD_block* QADD )
+          CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, TauNitr_block* TauNitr, QADD_block* QADD,
+          SAVE_block* SAVE )
 {
     //    std::cout << "SUBROUTINE INIT" << endl;
     f_enter( __func__ );
@@ -361,7 +362,7 @@ void init( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, TANDSL_bl
                NEWCONCS, CARB, TANDSL, CAR,
                METH1, FORCE, METH2, METH3,
                METH4, TauNitr, Sulph, NSIM, CO2READ, JSTART,
-               CORREN, HALOF, COBS );
+               CORREN, HALOF, COBS, SAVE );
         //F3218 !
         //F3219 !  INITIALISE QTOT ETC AT START OF 1765.
         //F3220 !  THIS ENSURES THAT ALL FORCINGS ARE ZERO AT THE MIDPOINT OF 1765.
@@ -403,7 +404,7 @@ void init( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, TANDSL_bl
 //F3241       SUBROUTINE TSLCALC(N)
 void tslcalc( int N, Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, CARB_block* CARB,
              TANDSL_block* TANDSL, VARW_block* VARW, QSPLIT_block* QSPLIT, ICE_block* ICE, 
-             NSIM_block* NSIM, std::ofstream* outfile8 )
+             NSIM_block* NSIM, SAVE_block* SAVE, std::ofstream* outfile8 )
 {
     //    std::cout << "SUBROUTINE TSLCALC" << endl;
     f_enter( __func__ );
@@ -548,7 +549,7 @@ void tslcalc( int N, Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS,
     //F3343 !
     //F3344       IF(N.LE.226)THEN
     float TBAR = 0.0;
-    static float TCUM = 0.0;
+    float& TCUM = SAVE->TCUM;
     if( N <= 226 ) {
         //F3345         TBAR = 0.0
         //F3346         TCUM = 0.0
@@ -558,10 +559,11 @@ void tslcalc( int N, Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS,
         //F3348       ENDIF
     }
     //F3349 !
-    static float TBASE = 0.0, XX = 0.0, GS1990 = 0.0, B19901 = 0.0, B19902 = 0.0, B19903 = 0.0, B19904 = 0.0;
-    static float BZERO1 = 0.0, BZERO2 = 0.0, BZERO3 = 0.0, BZERO4 = 0.0;
-    static float GSPREV1 = 0.0, GSPREV2 = 0.0, GSPREV3 = 0.0, GSPREV4 = 0.0;
-    static float VZ1 = 0.0, VZ2 = 0.0, VZ3 = 0.0, VZ4 = 0.0;
+    float& TBASE = SAVE->TBASE; float& XX = SAVE->XX; float& GS1990 = SAVE->GS1990;
+    float& B19901 = SAVE->B19901; float& B19902 = SAVE->B19902; float& B19903 = SAVE->B19903; float& B19904 = SAVE->B19904;
+    float& BZERO1 = SAVE->BZERO1; float& BZERO2 = SAVE->BZERO2; float& BZERO3 = SAVE->BZERO3; float& BZERO4 = SAVE->BZERO4;
+    float& GSPREV1 = SAVE->GSPREV1; float& GSPREV2 = SAVE->GSPREV2; float& GSPREV3 = SAVE->GSPREV3; float& GSPREV4 = SAVE->GSPREV4;
+    float& VZ1 = SAVE->VZ1; float& VZ2 = SAVE->VZ2; float& VZ3 = SAVE->VZ3; float& VZ4 = SAVE->VZ4;
     float GS, GS1, GS2, GS3, GS4;
     GS = GS1 = GS2 = GS3 = GS4 = 0.0;
     //F3350       IF(N.EQ.226)THEN
@@ -1060,7 +1062,8 @@ void runmod( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, CARB_bl
             AREAS_block* AREAS, QADD_block* QADD, BCOC_block* BCOC, FORCE_block* FORCE, NSIM_block* NSIM,
             OZ_block* OZ, NEWCONCS_block* NEWCONCS, CAR_block* CAR, METH1_block* METH1, METH2_block* METH2, 
             METH3_block* METH3, METH4_block* METH4, TauNitr_block* TauNitr,
-            JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, ICE_block* ICE, std::ofstream* outfile8 )
+            JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS, ICE_block* ICE,
+            SAVE_block* SAVE, std::ofstream* outfile8 )
 {
     //    std::cout << "SUBROUTINE RUNMOD" << endl;    
     f_enter( __func__ );
@@ -1173,7 +1176,7 @@ void runmod( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, CARB_bl
                                          NEWCONCS, CARB, TANDSL, CAR,
                                          METH1, FORCE, METH2, METH3,
                                          METH4, TauNitr, Sulph, NSIM, 
-                                         CO2READ, JSTART, CORREN, HALOF, COBS );
+                                         CO2READ, JSTART, CORREN, HALOF, COBS, SAVE );
         //F3738 !
         //F3739 !      ENDIF
         //F3740 !
@@ -2044,7 +2047,7 @@ void runmod( Limits_block* Limits, CLIM_block* CLIM, CONCS_block* CONCS, CARB_bl
         CLIM->KC = int( CLIM->T + 1.01 );
         //F4264       IF(KC.GT.KP)CALL TSLCALC(KC)
         if( CLIM->KC > KP ) tslcalc( CLIM->KC, Limits, CLIM, CONCS, CARB,
-                                    TANDSL, VARW, QSPLIT, ICE, NSIM, outfile8 );
+                                    TANDSL, VARW, QSPLIT, ICE, NSIM, SAVE, outfile8 );
         //F4265 !
         //F4266       IF(T.GE.TEND)RETURN
         //F4267       GO TO  11
@@ -2060,7 +2063,8 @@ void deltaq( Limits_block* Limits, OZ_block* OZ, CLIM_block* CLIM, CONCS_block*
             NEWCONCS_block* NEWCONCS, CARB_block* CARB, TANDSL_block* TANDSL, CAR_block* CAR,
             METH1_block* METH1, FORCE_block* FORCE, METH2_block* METH2, METH3_block* METH3,
             METH4_block* METH4, TauNitr_block* TauNitr, Sulph_block* Sulph, NSIM_block* NSIM, 
-            CO2READ_block* CO2READ, JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS )
+            CO2READ_block* CO2READ, JSTART_block* JSTART, CORREN_block* CORREN, HALOF_block* HALOF, COBS_block* COBS,
+            SAVE_block* SAVE )
 {
     f_enter( __func__ );
     //F4273       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
@@ -2134,7 +2138,7 @@ void deltaq( Limits_block* Limits, OZ_block* OZ, CLIM_block* CLIM, CONCS_block*
     //F4341 !
     //F4342       SAVE T00LO,T00MID,T00HI,T00USER
     //F4343 ! sjs -- change to make MAGICC  work. need to save these vars
-    static float T00LO, T00MID, T00HI, T00USER;
+    float& T00LO = SAVE->T00LO; float& T00MID = SAVE->T00MID; float& T00HI = SAVE->T00HI; float& T00USER = SAVE->T00USER;
     //F4344 
     //F4345 ! sjs -- add storage for halocarbon variables
     //F4346       COMMON /HALOF/QCF4_ar(0:iTp),QC2F6_ar(0:iTp),qSF6_ar(0:iTp), &
@@ -2143,8 +2147,8 @@ void deltaq( Limits_block* Limits, OZ_block* OZ, CLIM_block* CLIM, CONCS_block*
     //F4349 
     //F4350 ! sjs-- g95 seems to have optomized away these local variables, so put them in common block
     //F4351      COMMON /TEMPSTOR/DQOZPP, DQOZ
-    static float /* DQOZPP,*/ DQOZ = 0.0; // DQOZPP unused
-    static float QOZ1 = 0.0;
+    float& /* DQOZPP,*/ DQOZ = SAVE->DQOZ; // DQOZPP unused
+    float& QOZ1 = SAVE->QOZ1;
     const float fffrac = 0.18;
     float TAUCH4 = 0.0;
     
@@ -2158,7 +2162,7 @@ void deltaq( Limits_block* Limits, OZ_block* OZ, CLIM_block* CLIM, CONCS_block*
     //F4359 !
     //F4360       QLAND90=-0.2
     const float QLAND90 = -0.2;
-    static float TX=0.0, DELT90=0.0, DELT00=0.0;
+    float& TX = SAVE->TX; float& DELT90 = SAVE->DELT90; float& DELT00 = SAVE->DELT00;
     //F4361 !
     //F4362       DO 10 J=IP+1,IC
     for( int J=CLIM->IP+1; J<=CLIM->IC; J++ ) {
@@ -2676,7 +2680,7 @@ void deltaq( Limits_block* Limits, OZ_block* OZ, CLIM_block* CLIM, CONCS_block*
                        CARB->PL.getval( NC, J-1 ), CARB->HL.getval( NC, J-1 ), CARB->SOIL.getval( NC, J-1 ),  CARB->REGROW.getval( NC, J-1 ),  CARB->ETOT.getval( NC, J-1 ),
                        CARB->PL.getptr( NC, J ), CARB->HL.getptr( NC, J ), CARB->SOIL.getptr( NC, J ),  CARB->REGROW.getptr( NC, J ),  CARB->ETOT.getptr( NC, J ),
                        CARB->ESUM.getptr( J ), CARB->FOC.getptr( NC, J ), CAR->DELMASS.getptr( NC, J ), CARB->EDGROSS.getptr( NC, J ), CARB->CCO2.getptr( NC, J ),
-                       CAR );
+                       CAR, SAVE );
                 //F4703 !
                 //F4704   444   CONTINUE
             } // for
@@ -3511,7 +3515,7 @@ void carbon( const int MM, float TEM, float EFOSS, float ENETDEF, float CPP, flo
             float PL, float HU, float SO, float REGRO, float ETOT,
             float* PL1, float* HU1, float* SO1, float* REGRO1, float* ETOT1,
             float* SUMEM1, float* FLUX, float* DELM, float* EGROSSD, float* C1,
-            CAR_block* CAR )
+            CAR_block* CAR, SAVE_block* SAVE )
 {
     f_enter( __func__ );
     //F5283       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
@@ -3699,7 +3703,7 @@ void carbon( const int MM, float TEM, float EFOSS, float ENETDEF, float CPP, flo
     //F5406       SUMEM1=EFOSS-DELB
     *SUMEM1 = EFOSS - DELB;
     //F5407       FLUX=SUMEM1-FACTOR*DELC
-    static float DELC = 0.0;    // this is exceedingly weird -- a static var -- see note in documentation
+    float& DELC = SAVE->DELC;    // this is exceedingly weird -- a saved var -- see note in documentation
     *FLUX = *SUMEM1 - CAR->FACTOR * DELC;
     //F5408       IF(TOTEM.EQ.1)ETOT1=ETOT+SUMEM1
     if( CAR->TOTEM == 1 ) *ETOT1 = ETOT + *SUMEM1;
@@ -4791,84 +4795,68 @@ void lamcalc( float Q, float FNHL, float FSHL, float XK, float XKH, float DT2X,
 //F6117 
 
 /*  These functions are called by MAGICC and need a way to extract values from data structures.
- For now, we use some globals that are initialized with a call from CLIMAT.
+ All of the values are held in the MAGICC_state of the instance that was run.
  */
 
-/* Fundamental difference from Fortran: we're going to get call by GCAM w/o
- CLIMAT having initialized things first. So take care of it here. */
-CARB_block* G_CARB = new CARB_block;
-TANDSL_block* G_TANDSL = new TANDSL_block;
-CONCS_block* G_CONCS = new CONCS_block;
-NEWCONCS_block* G_NEWCONCS = new NEWCONCS_block;
-STOREDVALS_block* G_STOREDVALS = new STOREDVALS_block;
-METH1_block* G_METH1 = new METH1_block;
-CAR_block* G_CAR = new CAR_block;
-FORCE_block* G_FORCE = new FORCE_block;
-JSTART_block* G_JSTART = new JSTART_block;
-QADD_block* G_QADD = new QADD_block;
-HALOF_block* G_HALOF = new HALOF_block;
-NEWPARAMS_block* G_NEWPARAMS = new NEWPARAMS_block;
-BCOC_block* G_BCOC = new BCOC_block;
-string G_GAS_EMK_DATA;
-
-
+SAVE_block::SAVE_block()
+{
+    TCUM = TBASE = XX = GS1990 = B19901 = B19902 = B19903 = B19904 = 0.0;
+    BZERO1 = BZERO2 = BZERO3 = BZERO4 = 0.0;
+    GSPREV1 = GSPREV2 = GSPREV3 = GSPREV4 = 0.0;
+    VZ1 = VZ2 = VZ3 = VZ4 = 0.0;
+    T00LO = T00MID = T00HI = T00USER = 0.0;
+    DQOZ = QOZ1 = 0.0;
+    TX = DELT90 = DELT00 = 0.0;
+    DELC = 0.0;
+}
 
+MAGICC_state::MAGICC_state():
+CARB(), TANDSL(), CONCS(), NEWCONCS(), STOREDVALS(), METH1(), CAR(), FORCE(), JSTART(),
+QADD(), HALOF(), WRITE_OUTPUT( false )
+{
+}
 
-void setLocals( CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
+void setLocals( const MAGICC_state* aState, CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
                 STOREDVALS_block* STOREDVALS, NEWPARAMS_block* NEWPARAMS, BCOC_block* BCOC, 
                 METH1_block* METH1, CAR_block* CAR, FORCE_block* FORCE, JSTART_block* JSTART,
                 QADD_block* QADD, HALOF_block* HALOF, string& GAS_EMK_DATA )
 {
     f_enter( __func__ );
-/*    G_CARB = CARB;
-    G_TANDSL = TANDSL;
-    G_CONCS = CONCS;
-    G_NEWCONCS = NEWCONCS;
-    G_STOREDVALS = STOREDVALS; */
-    *NEWPARAMS = *G_NEWPARAMS;
-    *BCOC = *G_BCOC;
-/*    G_METH1 = METH1;
-    G_CAR = CAR;
-    G_FORCE = FORCE;
-    G_JSTART = JSTART;
-    G_QADD = QADD;
-    G_HALOF = HALOF; */
-    GAS_EMK_DATA = G_GAS_EMK_DATA;
+    *NEWPARAMS = aState->NEWPARAMS;
+    *BCOC = aState->BCOC;
+    GAS_EMK_DATA = aState->GAS_EMK_DATA;
     f_exit( __func__ );
 }
 
-void setGlobals( CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
+void setGlobals( MAGICC_state* aState, CARB_block* CARB, TANDSL_block* TANDSL, CONCS_block* CONCS, NEWCONCS_block* NEWCONCS, 
                STOREDVALS_block* STOREDVALS, NEWPARAMS_block* NEWPARAMS, BCOC_block* BCOC, 
                METH1_block* METH1, CAR_block* CAR, FORCE_block* FORCE, JSTART_block* JSTART,
                QADD_block* QADD, HALOF_block* HALOF, string& GAS_EMK_DATA )
 {
     f_enter( __func__ );
-    *G_CARB = *CARB;
-     *G_TANDSL = *TANDSL;
-     *G_CONCS = *CONCS;
-     *G_NEWCONCS = *NEWCONCS;
-     *G_STOREDVALS = *STOREDVALS;
-    *G_NEWPARAMS = *NEWPARAMS;
-    *G_BCOC = *BCOC;
-    *G_METH1 = *METH1;
-     *G_CAR = *CAR;
-     *G_FORCE = *FORCE;
-     *G_JSTART = *JSTART;
-     *G_QADD = *QADD;
-     *G_HALOF = *HALOF;
-     G_GAS_EMK_DATA = GAS_EMK_DATA;
+    aState->CARB = *CARB;
+    aState->TANDSL = *TANDSL;
+    aState->CONCS = *CONCS;
+    aState->NEWCONCS = *NEWCONCS;
+    aState->STOREDVALS = *STOREDVALS;
+    aState->NEWPARAMS = *NEWPARAMS;
+    aState->BCOC = *BCOC;
+    aState->METH1 = *METH1;
+    aState->CAR = *CAR;
+    aState->FORCE = *FORCE;
+    aState->JSTART = *JSTART;
+    aState->QADD = *QADD;
+    aState->HALOF = *HALOF;
+    aState->GAS_EMK_DATA = GAS_EMK_DATA;
     f_exit( __func__ );
 }
 
 
 //F6118       FUNCTION getCO2Conc( inYear )
-float getCO2Conc( int inYear )
+float getCO2Conc( const MAGICC_state* aState, int inYear )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     //F6119       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6120 ! Expose subroutine co2Conc to users of this DLL
     //F6121 !DEC$ATTRIBUTES DLLEXPORT::getCO2Conc
@@ -4886,7 +4874,7 @@ float getCO2Conc( int inYear )
     const int IYR = inYear - 1990 + 226;
     //F6133 
     //F6134       getCO2Conc = CO2( IYR )
-    return( G_CARB->CO2[ IYR ] );
+    return( aState->CARB.CO2[ IYR ] );
     //F6135 
     //F6136       RETURN 
     //F6137 	  END
@@ -4894,13 +4882,10 @@ float getCO2Conc( int inYear )
 }
 //F6138 	    
 //F6139       FUNCTION getSLR( inYear )
-float getSLR( const int inYear )
+float getSLR( const MAGICC_state* aState, const int inYear )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     //F6140       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6141 ! Expose subroutine co2Conc to users of this DLL
     //F6142 !DEC$ATTRIBUTES DLLEXPORT::getCO2Conc
@@ -4919,9 +4904,9 @@ float getSLR( const int inYear )
     //F6155       IYR = inYear-1990+226
     const int IYR = inYear - 1990 + 226;
     //F6156       ST1=SLT(IYR)
-    const float ST1 = G_TANDSL->SLT[ IYR ];
+    const float ST1 = aState->TANDSL.SLT[ IYR ];
     //F6157       SO1=SLO(IYR)
-    const float SO1 = G_TANDSL->SLO[ IYR ];
+    const float SO1 = aState->TANDSL.SLO[ IYR ];
     //F6158       SLRAW1=ST1-SO1
     const float SLRAW1 = ST1 - SO1;
     //F6159 
@@ -4934,13 +4919,10 @@ float getSLR( const int inYear )
 }
 //F6164 
 //F6165       FUNCTION getGHGConc( ghgNumber, inYear )
-float GETGHGCONC( int ghgNumber, int inYear )
+float GETGHGCONC( const MAGICC_state* aState, int ghgNumber, int inYear )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     //F6166       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6167 ! Expose subroutine ghgConc to users of this DLL
     //F6168 !DEC$ATTRIBUTES DLLEXPORT::getGHGConc
@@ -4974,27 +4956,27 @@ float GETGHGCONC( int ghgNumber, int inYear )
     //F6194       select case (ghgNumber)
     switch( ghgNumber ) {
             //F6195       case(1); getGHGConc = CO2( IYR )
-        case 1: returnValue = G_CARB->CO2[ IYR ]; break;
+        case 1: returnValue = aState->CARB.CO2[ IYR ]; break;
             //F6196       case(2); getGHGConc = CH4( IYR )
-        case 2: returnValue = G_CONCS->CH4[ IYR ]; break;
+        case 2: returnValue = aState->CONCS.CH4[ IYR ]; break;
             //F6197       case(3); getGHGConc = CN2O( IYR )
-        case 3: returnValue = G_CONCS->CN2O[ IYR ]; break;
+        case 3: returnValue = aState->CONCS.CN2O[ IYR ]; break;
             //F6198       case(4); getGHGConc = C2F6( IYR )
-        case 4: returnValue = G_NEWCONCS->C2F6[ IYR ]; break;
+        case 4: returnValue = aState->NEWCONCS.C2F6[ IYR ]; break;
             //F6199       case(5); getGHGConc = C125( IYR )
-        case 5: returnValue = G_NEWCONCS->C125[ IYR ]; break;
+        case 5: returnValue = aState->NEWCONCS.C125[ IYR ]; break;
             //F6200       case(6); getGHGConc = C134A( IYR )
-        case 6: returnValue = G_NEWCONCS->C134A[ IYR ]; break;
+        case 6: returnValue = aState->NEWCONCS.C134A[ IYR ]; break;
             //F6201       case(7); getGHGConc = C143A( IYR )
-        case 7: returnValue = G_NEWCONCS->C143A[ IYR ]; break;
+        case 7: returnValue = aState->NEWCONCS.C143A[ IYR ]; break;
             //F6202       case(8); getGHGConc = C245( IYR )
-        case 8: returnValue = G_NEWCONCS->C245[ IYR ]; break;
+        case 8: returnValue = aState->NEWCONCS.C245[ IYR ]; break;
             //F6203       case(9); getGHGConc = CSF6( IYR )
-        case 9: returnValue = G_NEWCONCS->CSF6[ IYR ]; break;
+        case 9: returnValue = aState->NEWCONCS.CSF6[ IYR ]; break;
             //F6204       case(10); getGHGConc = CF4( IYR )
-        case 10: returnValue = G_NEWCONCS->CF4[ IYR ]; break;
+        case 10: returnValue = aState->NEWCONCS.CF4[ IYR ]; break;
             //F6205       case(11); getGHGConc = C227( IYR )
-        case 11: returnValue = G_NEWCONCS->C227[ IYR ]; break;
+        case 11: returnValue = aState->NEWCONCS.C227[ IYR ]; break;
             //F6206       case default; getGHGConc = -1.0
         default: returnValue = std::numeric_limits<float>::max();
                 cerr << __func__ << " undefined gas " << ghgNumber << flush;
@@ -5010,13 +4992,10 @@ float GETGHGCONC( int ghgNumber, int inYear )
 //F6212 	  
 //F6213 ! Returns mid-year forcing for a given gas
 //F6214       FUNCTION getForcing( iGasNumber, inYear )
-float GETFORCING( const int iGasNumber, const int inYear )
+float GETFORCING( const MAGICC_state* aState, const int iGasNumber, const int inYear )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     //F6215       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6216 ! Expose subroutine getForcing to users of this DLL
     //F6217 !DEC$ATTRIBUTES DLLEXPORT::getForcing
@@ -5068,17 +5047,17 @@ float GETFORCING( const int iGasNumber, const int inYear )
     //F6258       
     //F6259 ! Calculate mid-year forcing components
     //F6260         QQQCO2 = (QCO2(IYR)+QCO2(IYRP))/2.
-    const float QQQCO2 = ( G_FORCE->QCO2[ IYR ] + G_FORCE->QCO2[ IYRP ] ) / 2.0;
+    const float QQQCO2 = ( aState->FORCE.QCO2[ IYR ] + aState->FORCE.QCO2[ IYRP ] ) / 2.0;
     //F6261         QQQM   = (QM(IYR)+QM(IYRP))/2.
-    /* const */ float QQQM = ( G_FORCE->QM[ IYR ] + G_FORCE->QM[ IYRP ] ) / 2.0;
+    /* const */ float QQQM = ( aState->FORCE.QM[ IYR ] + aState->FORCE.QM[ IYRP ] ) / 2.0;
     //F6262         QQQN   = (QN(IYR)+QN(IYRP))/2.
-    const float QQQN = ( G_FORCE->QN[ IYR ] + G_FORCE->QN[ IYRP ] ) / 2.0;
+    const float QQQN = ( aState->FORCE.QN[ IYR ] + aState->FORCE.QN[ IYRP ] ) / 2.0;
     //F6263         QQQCFC = (QCFC(IYR)+QCFC(IYRP))/2.
-    const float QQQCFC = ( G_FORCE->QCFC[ IYR ] + G_FORCE->QCFC[ IYRP ] ) / 2.0;
+    const float QQQCFC = ( aState->FORCE.QCFC[ IYR ] + aState->FORCE.QCFC[ IYRP ] ) / 2.0;
     //F6264         QQQOZ  = (QOZ(IYR)+QOZ(IYRP))/2.
-    /* const */ float QQQOZ = ( G_TANDSL->QOZ[ IYR ] + G_TANDSL->QOZ[ IYRP ] ) / 2.0;
+    /* const */ float QQQOZ = ( aState->TANDSL.QOZ[ IYR ] + aState->TANDSL.QOZ[ IYRP ] ) / 2.0;
     //F6265         QQQFOCR  = (QFOC(IYR)     +QFOC(IYRP))     /2.
-    const float QQQFOCR = ( G_JSTART->QFOC[ IYR ] + G_JSTART->QFOC[ IYRP ] ) / 2.0;
+    const float QQQFOCR = ( aState->JSTART.QFOC[ IYR ] + aState->JSTART.QFOC[ IYRP ] ) / 2.0;
     //F6266 
     //F6267         QQQSO2 = 0.0
     float QQQSO2 = 0.0;
@@ -5087,15 +5066,15 @@ float GETFORCING( const int iGasNumber, const int inYear )
     //F6269         IF(inYear.GT.1860)THEN
     if( inYear > 1860 ) {
         //F6270           QQQSO2 = (QSO2SAVE(IYR)+QSO2SAVE(IYRP))/2.
-        QQQSO2 = ( G_STOREDVALS->QSO2SAVE[ IYR ] + G_STOREDVALS->QSO2SAVE[ IYRP ] ) / 2.0;
+        QQQSO2 = ( aState->STOREDVALS.QSO2SAVE[ IYR ] + aState->STOREDVALS.QSO2SAVE[ IYRP ] ) / 2.0;
         //F6271           QQQDIR = (QDIRSAVE(IYR)+QDIRSAVE(IYRP))/2.
-        QQQDIR = ( G_STOREDVALS->QDIRSAVE[ IYR ] + G_STOREDVALS->QDIRSAVE[ IYRP ] ) / 2.0;
+        QQQDIR = ( aState->STOREDVALS.QDIRSAVE[ IYR ] + aState->STOREDVALS.QDIRSAVE[ IYRP ] ) / 2.0;
         //F6272         ENDIF
     }
     //F6273          QQQIND = QQQSO2-QQQDIR
     //UNUSED const float QQQIND = QQQSO2 - QQQDIR;
     //F6274          DELQFOC = (QFOC(IYR)+QFOC(IYRP))/2.-QQQFOCR
-    const float DELQFOC = ( G_JSTART->QFOC[ IYR ] + G_JSTART->QFOC[ IYRP ] ) / 2.0;
+    const float DELQFOC = ( aState->JSTART.QFOC[ IYR ] + aState->JSTART.QFOC[ IYRP ] ) / 2.0;
     //F6275 !
     //F6276          QQQCO2 = (QCO2(IYR)+QCO2(IYRP))/2.
     //UNNECESSARY const float QQQCO2 = ( FORCE->QCO2[ IYR ] + FORCE->QCO2[ IYRP ] ) / 2.0;
@@ -5110,28 +5089,28 @@ float GETFORCING( const int iGasNumber, const int inYear )
     //F6281          QQQFOC = (QFOC(IYR)+QFOC(IYRP))/2.
     //UNNECESSARY const float QQQFOC = ( JSTART->QFOC[ M00 ] + JSTART->QFOC[ M01 ] ) / 2.0;
     //F6282          QQQMN  = (QMN(IYR)+QMN(IYRP))/2.
-    const float QQQMN = ( G_TANDSL->QMN[ IYR ] + G_TANDSL->QMN[ IYRP ] ) / 2.0;
+    const float QQQMN = ( aState->TANDSL.QMN[ IYR ] + aState->TANDSL.QMN[ IYRP ] ) / 2.0;
     //F6283          
     //F6284          QQQEXTRA = ( QEXNH(IYR)+QEXSH(IYR)+QEXNHO(IYR)+QEXNHL(IYR) + &
     //F6285                       QEXNH(IYRP)+QEXSH(IYRP)+QEXNHO(IYRP)+QEXNHL(IYRP) )/2.
-    float QQQEXTRA = ( G_QADD->QEXNH[ IYR ] + G_QADD->QEXSH[ IYR ] + G_QADD->QEXNHO[ IYR ] + G_QADD->QEXNHL[ IYR ] + 
-                      G_QADD->QEXNH[ IYRP ] + G_QADD->QEXSH[ IYRP ] + G_QADD->QEXNHO[ IYRP ] + G_QADD->QEXNHL[ IYRP ]  ) / 2.0;
+    float QQQEXTRA = ( aState->QADD.QEXNH[ IYR ] + aState->QADD.QEXSH[ IYR ] + aState->QADD.QEXNHO[ IYR ] + aState->QADD.QEXNHL[ IYR ] + 
+                      aState->QADD.QEXNH[ IYRP ] + aState->QADD.QEXSH[ IYRP ] + aState->QADD.QEXNHO[ IYRP ] + aState->QADD.QEXNHL[ IYRP ]  ) / 2.0;
     //F6286 !
     //F6287 ! NOTE SPECIAL CASE FOR QOZ BECAUSE OF NONLINEAR CHANGE OVER 1990
     //F6288 !
     //F6289          IF(IYR.EQ.226)QQQOZ=QOZ(IYR)
-    if( IYR == 226 ) QQQOZ = G_TANDSL->QOZ[ IYR ];
+    if( IYR == 226 ) QQQOZ = aState->TANDSL.QOZ[ IYR ];
     //F6290 !
     //F6291          QQQLAND= (QLAND(IYR)+QLAND(IYRP))/2.
-    const float QQQLAND = ( G_TANDSL->QLAND[ IYR ] + G_TANDSL->QLAND[ IYRP ] ) / 2.0;
+    const float QQQLAND = ( aState->TANDSL.QLAND[ IYR ] + aState->TANDSL.QLAND[ IYRP ] ) / 2.0;
     //F6292          QQQBIO = (QBIO(IYR)+QBIO(IYRP))/2.
-    const float QQQBIO = ( G_TANDSL->QBIO[ IYR ] + G_TANDSL->QBIO[ IYRP ] ) / 2.0;
+    const float QQQBIO = ( aState->TANDSL.QBIO[ IYR ] + aState->TANDSL.QBIO[ IYRP ] ) / 2.0;
     //F6293          QQQTOT = QQQCO2+QQQM+QQQN+QQQCFC+QQQSO2+QQQBIO+QQQOZ+QQQLAND &
     //F6294          +QQQMN
     float QQQTOT = QQQCO2 + QQQM + QQQN + QQQCFC + QQQSO2 + QQQBIO + QQQOZ + QQQLAND + QQQMN;
     //F6295 !
     //F6296          QQCH4O3= (QCH4O3(IYR)+QCH4O3(IYRP))/2.
-    const float QQCH4O3 = ( G_FORCE->QCH4O3[ IYR ] + G_FORCE->QCH4O3[ IYRP ] ) / 2.0;
+    const float QQCH4O3 = ( aState->FORCE.QCH4O3[ IYR ] + aState->FORCE.QCH4O3[ IYRP ] ) / 2.0;
     //F6297          QQQM   = QQQM-QQCH4O3
     QQQM -= QQCH4O3;
     //F6298          QQQOZ  = QQQOZ+QQCH4O3
@@ -5140,26 +5119,26 @@ float GETFORCING( const int iGasNumber, const int inYear )
     //UNUSED const float QQQD = QQQDIR - QQQFOCR;    //CHANGE since QQQFOC = QQQFOCR
     //F6300  
     //F6301          QQQSTROZ= (QSTRATOZ(IYR)+QSTRATOZ(IYRP))/2.
-    float QQQSTROZ = ( G_FORCE->QSTRATOZ[ IYR ] + G_FORCE->QSTRATOZ[ IYRP ] ) / 2.0;
+    float QQQSTROZ = ( aState->FORCE.QSTRATOZ[ IYR ] + aState->FORCE.QSTRATOZ[ IYRP ] ) / 2.0;
     //F6302          IF(IO3FEED.EQ.0)QQQSTROZ=0.0 
-    if( G_METH1->IO3FEED == 0 ) QQQSTROZ = 0.0;
+    if( aState->METH1.IO3FEED == 0 ) QQQSTROZ = 0.0;
     //F6303 !
     //F6304          QQQKYMAG = (QKYMAG(IYR)+QKYMAG(IYRP))/2.
     //UNUSED const float QQQKYMAG = ( JSTART->QKYMAG[ IYR ] + JSTART->QKYMAG[ IYRP ] ) / 2.0;
     //F6305          QQQMONT  = (QMONT(IYR) +QMONT(IYRP)) /2.
-    const float QQQMONT = ( G_FORCE->QMONT[ IYR ] + G_FORCE->QMONT[ IYRP ] ) / 2.0;
+    const float QQQMONT = ( aState->FORCE.QMONT[ IYR ] + aState->FORCE.QMONT[ IYRP ] ) / 2.0;
     //F6306          QQQOTHER = (QOTHER(IYR)+QOTHER(IYRP))/2.
-    const float QQQOTHER = ( G_FORCE->QOTHER[ IYR ] + G_FORCE->QOTHER[ IYRP ] ) / 2.0;
+    const float QQQOTHER = ( aState->FORCE.QOTHER[ IYR ] + aState->FORCE.QOTHER[ IYRP ] ) / 2.0;
     //F6307          QQQKYOTO = QQQKYMAG+QQQOTHER
     //UNUSED const float QQQKYOTO = QQQKYMAG + QQQOTHER;
     //F6308 !
     //F6309          QQQStratCH4H2O = (QCH4H2O(IYR)+QCH4H2O(IYRP))/2.	! Strat H2O forcing from CH4
-    const float QQQStratCH4H2O = ( G_FORCE->QCH4H2O[ IYR ] + G_FORCE->QCH4H2O[ IYRP ] ) / 2.0;
+    const float QQQStratCH4H2O = ( aState->FORCE.QCH4H2O[ IYR ] + aState->FORCE.QCH4H2O[ IYRP ] ) / 2.0;
     //F6310 
     //F6311          QQQBC = ( QBC(IYR) + QBC(IYRP) )/2.
-    const float QQQBC = ( G_FORCE->QBC[ IYR ] + G_FORCE->QBC[ IYRP ] ) / 2.0;
+    const float QQQBC = ( aState->FORCE.QBC[ IYR ] + aState->FORCE.QBC[ IYRP ] ) / 2.0;
     //F6312          QQQOC = ( QOC(IYR) + QOC(IYRP) )/2.
-    const float QQQOC = ( G_FORCE->QOC[ IYR ] + G_FORCE->QOC[ IYRP ] ) / 2.0;
+    const float QQQOC = ( aState->FORCE.QOC[ IYR ] + aState->FORCE.QOC[ IYRP ] ) / 2.0;
     //F6313  
     //F6314  	     QQQTOT = QQQTOT + QQQBC + QQQOC
     QQQTOT += ( QQQBC + QQQOC );
@@ -5175,25 +5154,25 @@ float GETFORCING( const int iGasNumber, const int inYear )
             //F6320       case(1); getForcing = (QCO2(IYR)+QCO2(IYRP))/2.
         case 1: returnValue = QQQCO2;  break; //CHANGE  why recalculate this?
             //F6321       case(2); getForcing = (qm(IYR)+qm(IYRP))/2. - QQQStratCH4H2O - QQCH4O3! CH4 forcing, subtract indirect components so are just reporting just CH4 forcing
-        case 2: returnValue = ( G_FORCE->QM[ IYR ] + G_FORCE->QM[ IYRP ] ) / 2.0 - QQQStratCH4H2O - QQCH4O3;  break;
+        case 2: returnValue = ( aState->FORCE.QM[ IYR ] + aState->FORCE.QM[ IYRP ] ) / 2.0 - QQQStratCH4H2O - QQCH4O3;  break;
             //F6322       case(3); getForcing = (qn(IYR)+qn(IYRP))/2.  ! N2O forcing
         case 3: returnValue = QQQN; break; //CHANGE  why recalculate this?
             //F6323       case(4); getForcing = (QC2F6_ar(IYR)+QC2F6_ar(IYRP))/2.
-        case 4: returnValue = ( G_HALOF->QC2F6_ar[ IYR ] + G_HALOF->QC2F6_ar[ IYRP ] ) / 2.0; break;
+        case 4: returnValue = ( aState->HALOF.QC2F6_ar[ IYR ] + aState->HALOF.QC2F6_ar[ IYRP ] ) / 2.0; break;
             //F6324       case(5); getForcing = (Q125_ar(IYR)+Q125_ar(IYRP))/2.
-        case 5: returnValue = ( G_HALOF->Q125_ar[ IYR ] + G_HALOF->Q125_ar[ IYRP ] ) / 2.0; break;
+        case 5: returnValue = ( aState->HALOF.Q125_ar[ IYR ] + aState->HALOF.Q125_ar[ IYRP ] ) / 2.0; break;
             //F6325       case(6); getForcing = (Q134A_ar(IYR)+Q134A_ar(IYRP))/2.
-        case 6: returnValue = ( G_HALOF->Q134A_ar[ IYR ] + G_HALOF->Q134A_ar[ IYRP ] ) / 2.0; break;
+        case 6: returnValue = ( aState->HALOF.Q134A_ar[ IYR ] + aState->HALOF.Q134A_ar[ IYRP ] ) / 2.0; break;
             //F6326       case(7); getForcing = (Q143A_ar(IYR)+Q143A_ar(IYRP))/2.
-        case 7: returnValue = ( G_HALOF->Q143A_ar[ IYR ] + G_HALOF->Q143A_ar[ IYRP ] ) / 2.0; break;
+        case 7: returnValue = ( aState->HALOF.Q143A_ar[ IYR ] + aState->HALOF.Q143A_ar[ IYRP ] ) / 2.0; break;
             //F6327       case(8); getForcing = (Q245_ar(IYR)+Q245_ar(IYRP))/2.
-        case 8: returnValue = ( G_HALOF->Q245_ar[ IYR ] + G_HALOF->Q245_ar[ IYRP ] ) / 2.0; break;
+        case 8: returnValue = ( aState->HALOF.Q245_ar[ IYR ] + aState->HALOF.Q245_ar[ IYRP ] ) / 2.0; break;
             //F6328       case(9); getForcing = (qSF6_ar(IYR)+qSF6_ar(IYRP))/2.
-        case 9: returnValue = ( G_HALOF->qSF6_ar[ IYR ] + G_HALOF->qSF6_ar[ IYRP ] ) / 2.0; break;
+        case 9: returnValue = ( aState->HALOF.qSF6_ar[ IYR ] + aState->HALOF.qSF6_ar[ IYRP ] ) / 2.0; break;
             //F6329       case(10); getForcing = (QCF4_ar(IYR)+QCF4_ar(IYRP))/2.
-        case 10: returnValue = ( G_HALOF->QCF4_ar[ IYR ] + G_HALOF->QCF4_ar[ IYRP ] ) / 2.0; break;
+        case 10: returnValue = ( aState->HALOF.QCF4_ar[ IYR ] + aState->HALOF.QCF4_ar[ IYRP ] ) / 2.0; break;
             //F6330       case(11); getForcing = (Q227_ar(IYR)+Q227_ar(IYRP))/2.
-        case 11: returnValue = ( G_HALOF->Q227_ar[ IYR ] + G_HALOF->Q227_ar[ IYRP ] ) / 2.0; break;
+        case 11: returnValue = ( aState->HALOF.Q227_ar[ IYR ] + aState->HALOF.Q227_ar[ IYRP ] ) / 2.0; break;
             //F6331       case(12); getForcing = (QOTHER(IYR)+QOTHER(IYRP))/2.	! Other halo forcing (exogenous input)
         case 12: returnValue = QQQOTHER; break; //CHANGE  why recalculate this?
             //F6332       case(13); getForcing = QQQSO2 - DELQFOC ! Total SO2 forcing. Note QSO2 and QDIR includes FOC
@@ -5213,7 +5192,7 @@ float GETFORCING( const int iGasNumber, const int inYear )
             //F6339       case(20); getForcing = QQQBIO  ! MAGICC biomass burning aerosol forcing
         case 20: returnValue = QQQBIO; break;
             //F6340       case(21); getForcing = (QFOC(IYR)+QFOC(IYRP))/2. ! MAGICC internal fossil BC+OC
-        case 21: returnValue = ( G_JSTART->QFOC[ IYR ] + G_JSTART->QFOC[ IYRP ] ) / 2.0; break;
+        case 21: returnValue = ( aState->JSTART.QFOC[ IYR ] + aState->JSTART.QFOC[ IYRP ] ) / 2.0; break;
             //F6341       case(22); getForcing = QQQLAND ! Land Surface Albedo forcing
         case 22: returnValue = QQQLAND; break;
             //F6342       case(23); getForcing = QQQMN	! Mineral and nitrous oxide aerosol forcing
@@ -5243,13 +5222,10 @@ float GETFORCING( const int iGasNumber, const int inYear )
 }
 //F6354 	  
 //F6355       FUNCTION getGMTemp( inYear )
-float GETGMTEMP( int inYear )
+float GETGMTEMP( const MAGICC_state* aState, int inYear )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     //F6356       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6357 ! Expose subroutine gmTemp to users of this DLL
     //F6358 !DEC$ATTRIBUTES DLLEXPORT::gmTemp
@@ -5269,11 +5245,11 @@ float GETGMTEMP( int inYear )
     //F6372 	  REAL*4 getGMTemp
     //F6373 
     //F6374       KREF  = KYRREF-1764
-    const int KREF = G_STOREDVALS->KYRREF - 1764;
+    const int KREF = aState->STOREDVALS.KYRREF - 1764;
     //F6375       IYR = inYear-1990+226
     const int IYR = inYear - 1990 + 226;
     //F6376       getGMTemp = TEMUSER(IYR)+TGAV(226)
-    return( G_STOREDVALS->TEMUSER[ IYR ] + G_TANDSL->TGAV[ 226 ] );
+    return( aState->STOREDVALS.TEMUSER[ IYR ] + aState->TANDSL.TGAV[ 226 ] );
     //F6377 
     //F6378       RETURN 
     //F6379 	  END
@@ -5282,14 +5258,11 @@ float GETGMTEMP( int inYear )
 //F6380 
 //F6381 ! Routine to pass in new values of parameters from calling program (e.g. ObjECTS) - sjs	  
 //F6382     SUBROUTINE setParameterValues( index, value )
-void SETPARAMETERVALUES( int index, float value )
+void SETPARAMETERVALUES( MAGICC_state* aState, int index, float value )
 {
     f_enter( __func__ );
     
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     
     //F6383       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6384 ! Expose subroutine co2Conc to users of this DLL
@@ -5308,25 +5281,25 @@ void SETPARAMETERVALUES( int index, float value )
     //F6397       select case (index)
     switch( index ) {
             //F6398       case(1); aNewClimSens = value
-        case 1: G_NEWPARAMS->aNewClimSens = value; break;
+        case 1: aState->NEWPARAMS.aNewClimSens = value; break;
             //F6399       case(2); aNewBTsoil = value
-        case 2: G_NEWPARAMS->aNewBTsoil = value; break;
+        case 2: aState->NEWPARAMS.aNewBTsoil = value; break;
             //F6400       case(3); aNewBTHumus = value
-        case 3: G_NEWPARAMS->aNewBTHumus = value; break;
+        case 3: aState->NEWPARAMS.aNewBTHumus = value; break;
             //F6401       case(4); aNewBTGPP = value
-        case 4: G_NEWPARAMS->aNewBTGPP = value; break;
+        case 4: aState->NEWPARAMS.aNewBTGPP = value; break;
             //F6402       case(5); aNewDUSER = value
-        case 5: G_NEWPARAMS->aNewDUSER = value; break;
+        case 5: aState->NEWPARAMS.aNewDUSER = value; break;
             //F6403       case(6); aNewFUSER = value
-        case 6: G_NEWPARAMS->aNewFUSER = value; break;
+        case 6: aState->NEWPARAMS.aNewFUSER = value; break;
             //F6404       case(7); aNewSO2dir1990 = value
-        case 7: G_NEWPARAMS->aNewSO2dir1990 = value; break;
+        case 7: aState->NEWPARAMS.aNewSO2dir1990 = value; break;
             //F6405       case(8); aNewSO2ind1990 = value
-        case 8: G_NEWPARAMS->aNewSO2ind1990 = value; break;
+        case 8: aState->NEWPARAMS.aNewSO2ind1990 = value; break;
             //F6406       case(9); aBCUnitForcing = value
-        case 9: G_BCOC->aBCUnitForcing = value; break;
+        case 9: aState->BCOC.aBCUnitForcing = value; break;
             //F6407       case(10); aOCUnitForcing = value
-        case 10: G_BCOC->aOCUnitForcing = value; break;
+        case 10: aState->BCOC.aOCUnitForcing = value; break;
             //F6408       case default; 
             //F6409       end select;
     }
@@ -5341,10 +5314,6 @@ void SETPARAMETERVALUES( int index, float value )
 void overrideParameters( NEWPARAMS_block* NEWPARAMS, CAR_block* CAR, METH1_block* METH1, BCOC_block* BCOC )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
     //F6416       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6417 
     //F6418       parameter (iTp=740)
@@ -5416,13 +5385,10 @@ void overrideParameters( NEWPARAMS_block* NEWPARAMS, CAR_block* CAR, METH1_block
 //F6474 	    
 //F6475 ! Returns climate results forcing for a given gas
 //F6476       FUNCTION getCarbonResults( iResultNumber, inYear )
-float GETCARBONRESULTS( int iResultNumber, int inYear )
+float GETCARBONRESULTS( const MAGICC_state* aState, int iResultNumber, int inYear )
 {
     f_enter( __func__ );
-    assert( G_CARB != NULL && G_TANDSL != NULL && G_CONCS != NULL && G_NEWCONCS != NULL &&
-           G_STOREDVALS != NULL && G_NEWPARAMS != NULL && G_BCOC != NULL && 
-           G_METH1 != NULL && G_CAR != NULL && G_FORCE != NULL && G_JSTART != NULL && 
-           G_QADD != NULL && G_HALOF != NULL );
+    assert( aState );
     //F6477       IMPLICIT REAL*4 (a-h,o-z), Integer (I-N)
     //F6478 ! Expose subroutine getCarbonResults to users of this DLL
     //F6479 !DEC$ATTRIBUTES DLLEXPORT::getCarbonResults
@@ -5458,18 +5424,18 @@ float GETCARBONRESULTS( int iResultNumber, int inYear )
     //F6507       IF ( inYear .ge. 1990 ) THEN
     if( inYear >= 1990 ) {
         //F6508       IF(IMETH.EQ.0)THEN
-        if( G_METH1->IMETH == 0.0 )
+        if( aState->METH1.IMETH == 0.0 )
             //F6509         TOTE=EF(IYR)+EDNET(IYR)
-            TOTE = G_CARB->EF.getval( IYR ) + G_METH1->ednet.getval( IYR );
+            TOTE = aState->CARB.EF.getval( IYR ) + aState->METH1.ednet.getval( IYR );
         //F6510       ELSE
         //F6511         TOTE=EF(IYR)+EDNET(IYR)+EMETH(IYR)
         else 
-            TOTE = G_CARB->EF.getval( IYR ) + G_METH1->ednet.getval( IYR ) + G_METH1->emeth.getval( IYR );
+            TOTE = aState->CARB.EF.getval( IYR ) + aState->METH1.ednet.getval( IYR ) + aState->METH1.emeth.getval( IYR );
         //F6512       ENDIF
         //F6513 	    NetDef = EDNET(IYR)
-        NetDef = G_METH1->ednet.getval( IYR );
+        NetDef = aState->METH1.ednet.getval( IYR );
         //F6514 	    GrossDef = EDGROSS(4,IYR)
-        GrossDef = G_CARB->EDGROSS.getval( 4, IYR );
+        GrossDef = aState->CARB.EDGROSS.getval( 4, IYR );
     } else {
         //F6515 	  ELSE
         //F6516         TOTE = -1.0
@@ -5480,9 +5446,9 @@ float GETCARBONRESULTS( int iResultNumber, int inYear )
     }
     //F6520 !
     //F6521       ECH4OX=EMETH(IYR)
-    float ECH4OX = G_METH1->emeth.getval( IYR );
+    float ECH4OX = aState->METH1.emeth.getval( IYR );
     //F6522       IF(IMETH.EQ.0)ECH4OX=0.0
-    if( G_METH1->IMETH == 0.0 ) ECH4OX = 0.0;
+    if( aState->METH1.IMETH == 0.0 ) ECH4OX = 0.0;
     //F6523       
     //F6524       getCarbonResults = - 1.0
     float returnValue=0.0f;
@@ -5492,25 +5458,25 @@ float GETCARBONRESULTS( int iResultNumber, int inYear )
             //F6527       case(0); getCarbonResults = TOTE    ! Total emissions (fossil + netDef + Oxidation)
         case 0: returnValue = TOTE; break;
             //F6528       case(1); getCarbonResults = EF(IYR) ! Fossil Emissions as used by MAGICC
-        case 1: returnValue = G_CARB->EF.getval( IYR ); break;
+        case 1: returnValue = aState->CARB.EF.getval( IYR ); break;
             //F6529       case(2); getCarbonResults = NetDef  ! Net Deforestation
         case 2: returnValue = NetDef; break;
             //F6530       case(3); getCarbonResults = GrossDef  ! Gross Deforestation
         case 3: returnValue = GrossDef; break;
             //F6531       case(4); getCarbonResults = FOC(4,IYR)  ! Ocean Flux
-        case 4: returnValue = G_CARB->FOC.getval( 4, IYR ); break;
+        case 4: returnValue = aState->CARB.FOC.getval( 4, IYR ); break;
             //F6532       case(5); getCarbonResults = PL(4,IYR) ! Plant Carbon
-        case 5: returnValue = G_CARB->PL.getval( 4, IYR ); break;
+        case 5: returnValue = aState->CARB.PL.getval( 4, IYR ); break;
             //F6533       case(6); getCarbonResults = HL(4,IYR) ! Carbon in Litter
-        case 6: returnValue = G_CARB->HL.getval( 4, IYR ); break;
+        case 6: returnValue = aState->CARB.HL.getval( 4, IYR ); break;
             //F6534       case(7); getCarbonResults = SOIL(4,IYR) ! Carbon in Soils
-        case 7: returnValue = G_CARB->SOIL.getval( 4, IYR ); break;
+        case 7: returnValue = aState->CARB.SOIL.getval( 4, IYR ); break;
             //F6535       case(8); getCarbonResults = DELMASS(4,IYR)  ! Atmospheric Increase
-        case 8: returnValue = G_CAR->DELMASS.getval( 4, IYR ); break;
+        case 8: returnValue = aState->CAR.DELMASS.getval( 4, IYR ); break;
             //F6536       case(9); getCarbonResults = ECH4OX  ! Oxidation Addition to Atmosphere
         case 9: returnValue = ECH4OX; break;
             //F6537       case(10); IF(inYear .ge. 1990 ) getCarbonResults = EF(IYR)+ECH4OX-(FOC(4,IYR)+DELMASS(4,IYR)) ! Net Terrestrial Uptake
-        case 10: if( inYear >= 1990 ) returnValue = G_CARB->EF.getval( IYR ) + ECH4OX - (G_CARB->FOC.getval( 4, IYR ) + G_CAR->DELMASS.getval( 4, IYR )); break;
+        case 10: if( inYear >= 1990 ) returnValue = aState->CARB.EF.getval( IYR ) + ECH4OX - (aState->CARB.FOC.getval( 4, IYR ) + aState->CAR.DELMASS.getval( 4, IYR )); break;
             //F6538       case default; getCarbonResults = -1.0
         default: returnValue = std::numeric_limits<float>::max();
                 cerr << __func__ << " undefined result " << iResultNumber << flush;;
@@ -5525,7 +5491,7 @@ float GETCARBONRESULTS( int iResultNumber, int inYear )
 //F6543 
 
 // A method to set the gas.emk data from GCAM.
-void SET_GAS_EMK( const string& GAS_EMK_DATA ) {
-    G_GAS_EMK_DATA = GAS_EMK_DATA;
+void SET_GAS_EMK( MAGICC_state* aState, const string& GAS_EMK_DATA ) {
+    aState->GAS_EMK_DATA = GAS_EMK_DATA;
 }
 
@@ -0,0 +1,499 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file climate_emulator.cpp
+* \ingroup Objects
+* \brief This file contains the source for the ClimateEmulator class.
+*/
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include "climate/include/climate_emulator.h"
+#include "containers/include/scenario.h"
+#include "util/base/include/model_time.h"
+#include "util/logger/include/ilogger.h"
+
+using namespace std;
+using namespace xercesc;
+
+extern Scenario* scenario;
+
+namespace {
+    //! The relative change in emissions used to fit the impulse responses.
+    const double FIT_PERTURBATION = 0.05;
+
+    //! The absolute change in emissions used to fit the impulse responses if
+    //! the emissions are zero.
+    const double MIN_FIT_PERTURBATION = 1e-3;
+
+    const string TOTAL_FORCING_KEY = "total-forcing";
+    const string TEMPERATURE_KEY = "temperature";
+    const string NET_TERRESTRIAL_UPTAKE_KEY = "net-terrestrial-uptake";
+    const string NET_OCEAN_UPTAKE_KEY = "net-ocean-uptake";
+    const string CONCENTRATION_PREFIX = "concentration:";
+    const string FORCING_PREFIX = "forcing:";
+}
+
+/*!
+ * \brief Constructor.
+ * \param aFullModel The full climate model to wrap, which must outlive the
+ *        emulator.
+ */
+ClimateEmulator::ClimateEmulator( IClimateModel* aFullModel ):
+mFullModel( aFullModel ),
+mIsEmulating( false ),
+mHasEmulatedRun( false ),
+mHasAnchor( false ),
+mIsFit( false ),
+mFitPeriod( -1 ),
+mFitYear( -1 )
+{
+    assert( mFullModel );
+    const Modeltime* modeltime = scenario->getModeltime();
+    mStartYear = modeltime->getper_to_yr( modeltime->getFinalCalibrationPeriod() );
+}
+
+//! Destructor.
+ClimateEmulator::~ClimateEmulator() {
+}
+
+const string& ClimateEmulator::getXMLNameStatic() {
+    static const string XML_NAME = "climate-emulator";
+    return XML_NAME;
+}
+
+/*!
+ * \brief Switch emulation on or off.
+ * \details Switching emulation on fits the impulse responses if they have not
+ *          been fit yet, which requires that the full model has been run.
+ *          Switching emulation off reruns the full model if any outputs have
+ *          been emulated so that all outputs are from the full model.
+ * \param aEmulate Whether to emulate the climate outputs.
+ * \return Whether the climate outputs are now emulated.
+ */
+bool ClimateEmulator::setEmulating( const bool aEmulate ) {
+    if( aEmulate ) {
+        if( !mIsFit && mHasAnchor ) {
+            fit();
+        }
+        mIsEmulating = mIsFit;
+    }
+    else if( mIsEmulating ) {
+        mIsEmulating = false;
+        if( mHasEmulatedRun ) {
+            runModel();
+        }
+    }
+    return mIsEmulating;
+}
+
+/*!
+ * \brief Get whether the climate outputs are currently emulated.
+ * \return Whether the climate outputs are currently emulated.
+ */
+bool ClimateEmulator::isEmulating() const {
+    return mIsEmulating;
+}
+
+void ClimateEmulator::XMLParse( const DOMNode* node ) {
+    mFullModel->XMLParse( node );
+}
+
+void ClimateEmulator::toInputXML( ostream& out, Tabs* tabs ) const {
+    mFullModel->toInputXML( out, tabs );
+}
+
+void ClimateEmulator::toDebugXML( const int period, ostream& out, Tabs* tabs ) const {
+    mFullModel->toDebugXML( period, out, tabs );
+}
+
+void ClimateEmulator::completeInit( const string& aScenarioName ) {
+    mFullModel->completeInit( aScenarioName );
+}
+
+bool ClimateEmulator::setEmissions( const string& aGasName,
+                                    const int aPeriod,
+                                    const double aEmission )
+{
+    const bool success = mFullModel->setEmissions( aGasName, aPeriod, aEmission );
+    if( success ) {
+        mEmissions[ aGasName ][ aPeriod ] = aEmission;
+    }
+    return success;
+}
+
+bool ClimateEmulator::setLUCEmissions( const string& aGasName,
+                                       const int aYear,
+                                       const double aEmission )
+{
+    const bool success = mFullModel->setLUCEmissions( aGasName, aYear, aEmission );
+    if( success ) {
+        mLUCEmissions[ aGasName ][ aYear ] = aEmission;
+    }
+    return success;
+}
+
+double ClimateEmulator::getEmissions( const string& aGasName,
+                                      const int aYear ) const
+{
+    return mFullModel->getEmissions( aGasName, aYear );
+}
+
+IClimateModel::runModelStatus ClimateEmulator::runModel() {
+    if( mIsEmulating ) {
+        emulate();
+        mHasEmulatedRun = true;
+        return SUCCESS;
+    }
+
+    const runModelStatus status = mFullModel->runModel();
+    mHasEmulatedRun = false;
+    if( status == SUCCESS ) {
+        setAnchor();
+    }
+    else {
+        mHasAnchor = false;
+    }
+    return status;
+}
+
+IClimateModel::runModelStatus ClimateEmulator::runModel( const int aYear ) {
+    // The emulator is cheap enough to always calculate all years.
+    if( mIsEmulating ) {
+        return runModel();
+    }
+
+    // A partial run does not replace the anchor as later years are not yet
+    // consistent with the emissions.
+    mHasEmulatedRun = false;
+    return mFullModel->runModel( aYear );
+}
+
+double ClimateEmulator::getConcentration( const string& aGasName,
+                                          const int aYear ) const
+{
+    return getOutput( CONCENTRATION_PREFIX + aGasName, aYear );
+}
+
+double ClimateEmulator::getTemperature( const int aYear ) const {
+    return getOutput( TEMPERATURE_KEY, aYear );
+}
+
+double ClimateEmulator::getForcing( const string& aGasName,
+                                    const int aYear ) const
+{
+    return getOutput( FORCING_PREFIX + aGasName, aYear );
+}
+
+double ClimateEmulator::getTotalForcing( const int aYear ) const {
+    return getOutput( TOTAL_FORCING_KEY, aYear );
+}
+
+double ClimateEmulator::getNetTerrestrialUptake( const int aYear ) const {
+    return getOutput( NET_TERRESTRIAL_UPTAKE_KEY, aYear );
+}
+
+double ClimateEmulator::getNetOceanUptake( const int aYear ) const {
+    return getOutput( NET_OCEAN_UPTAKE_KEY, aYear );
+}
+
+int ClimateEmulator::getCarbonModelStartYear() const {
+    return mFullModel->getCarbonModelStartYear();
+}
+
+void ClimateEmulator::printFileOutput() const {
+    mFullModel->printFileOutput();
+}
+
+void ClimateEmulator::printDBOutput() const {
+    mFullModel->printDBOutput();
+}
+
+void ClimateEmulator::accept( IVisitor* aVisitor, const int aPeriod ) const {
+    mFullModel->accept( aVisitor, aPeriod );
+}
+
+/*!
+ * \brief Get an output value, emulated if possible.
+ * \details The output is marked as tracked so that it will be included in the
+ *          next anchor and fit.
+ * \param aKey The output key.
+ * \param aYear The year of the output.
+ * \return The output value.
+ */
+double ClimateEmulator::getOutput( const string& aKey, const int aYear ) const {
+    mTrackedOutputs.insert( aKey );
+    if( mIsEmulating && mHasEmulatedRun ) {
+        OutputMap::const_iterator outputIter = mEmulatedOutputs.find( aKey );
+        const int index = aYear - mStartYear;
+        if( outputIter != mEmulatedOutputs.end() && index >= 0
+            && index < static_cast<int>( outputIter->second.size() ) )
+        {
+            return outputIter->second[ index ];
+        }
+    }
+    return getFullOutput( aKey, aYear );
+}
+
+/*!
+ * \brief Get an output value from the full model.
+ * \param aKey The output key.
+ * \param aYear The year of the output.
+ * \return The output value from the full model.
+ */
+double ClimateEmulator::getFullOutput( const string& aKey, const int aYear ) const {
+    if( aKey == TOTAL_FORCING_KEY ) {
+        return mFullModel->getTotalForcing( aYear );
+    }
+    else if( aKey == TEMPERATURE_KEY ) {
+        return mFullModel->getTemperature( aYear );
+    }
+    else if( aKey == NET_TERRESTRIAL_UPTAKE_KEY ) {
+        return mFullModel->getNetTerrestrialUptake( aYear );
+    }
+    else if( aKey == NET_OCEAN_UPTAKE_KEY ) {
+        return mFullModel->getNetOceanUptake( aYear );
+    }
+    else if( aKey.compare( 0, CONCENTRATION_PREFIX.size(), CONCENTRATION_PREFIX ) == 0 ) {
+        return mFullModel->getConcentration( aKey.substr( CONCENTRATION_PREFIX.size() ), aYear );
+    }
+    assert( aKey.compare( 0, FORCING_PREFIX.size(), FORCING_PREFIX ) == 0 );
+    return mFullModel->getForcing( aKey.substr( FORCING_PREFIX.size() ), aYear );
+}
+
+/*!
+ * \brief Get the values of an output from the full model for all emulated
+ *        years.
+ * \param aKey The output key.
+ * \return The output values from the start year through the end year.
+ */
+vector<double> ClimateEmulator::getFullOutputs( const string& aKey ) const {
+    const int endYear = scenario->getModeltime()->getEndYear();
+    vector<double> outputs( max( endYear - mStartYear + 1, 0 ) );
+    for( unsigned int index = 0; index < outputs.size(); ++index ) {
+        outputs[ index ] = getFullOutput( aKey, mStartYear + index );
+    }
+    return outputs;
+}
+
+/*!
+ * \brief Store the emissions and tracked outputs of a full model run as the
+ *        anchor for emulation.
+ */
+void ClimateEmulator::setAnchor() {
+    mAnchorEmissions = mEmissions;
+    mAnchorLUCEmissions = mLUCEmissions;
+    mAnchorOutputs.clear();
+    for( set<string>::const_iterator keyIter = mTrackedOutputs.begin();
+         keyIter != mTrackedOutputs.end(); ++keyIter )
+    {
+        mAnchorOutputs[ *keyIter ] = getFullOutputs( *keyIter );
+    }
+    mHasAnchor = true;
+}
+
+/*!
+ * \brief Fit the impulse responses of the tracked outputs to each emissions
+ *        gas.
+ * \details Runs the full model once for each gas with the emissions in the
+ *          first period after calibration perturbed, and once more to restore
+ *          the anchor.  LUC emissions are perturbed in every year of that
+ *          period.
+ */
+void ClimateEmulator::fit() {
+    const Modeltime* modeltime = scenario->getModeltime();
+    mFitPeriod = modeltime->getFinalCalibrationPeriod() + 1;
+    if( mFitPeriod >= modeltime->getmaxper() ) {
+        return;
+    }
+    mFitYear = modeltime->getper_to_yr( mFitPeriod );
+
+    // Make sure the anchor is consistent with the current emissions.
+    mIsEmulating = false;
+    if( runModel() != SUCCESS ) {
+        return;
+    }
+
+    ILogger& climateLog = ILogger::getLogger( "climate-log" );
+    climateLog.setLevel( ILogger::NOTICE );
+    climateLog << "Fitting the climate emulator to " << mTrackedOutputs.size()
+               << " outputs." << endl;
+
+    mKernels.clear();
+    bool success = true;
+    for( EmissionsMap::const_iterator gasIter = mEmissions.begin();
+         gasIter != mEmissions.end() && success; ++gasIter )
+    {
+        map<int, double>::const_iterator emissIter = gasIter->second.find( mFitPeriod );
+        if( emissIter == gasIter->second.end() ) {
+            continue;
+        }
+        const double baseEmissions = emissIter->second;
+        const double delta = max( fabs( baseEmissions ) * FIT_PERTURBATION, MIN_FIT_PERTURBATION );
+        mFullModel->setEmissions( gasIter->first, mFitPeriod, baseEmissions + delta );
+        success = mFullModel->runModel() == SUCCESS;
+        OutputMap& kernels = mKernels[ KernelKey( gasIter->first, false ) ];
+        for( OutputMap::const_iterator outputIter = mAnchorOutputs.begin();
+             outputIter != mAnchorOutputs.end() && success; ++outputIter )
+        {
+            vector<double>& kernel = kernels[ outputIter->first ] = getFullOutputs( outputIter->first );
+            for( unsigned int index = 0; index < kernel.size(); ++index ) {
+                kernel[ index ] = ( kernel[ index ] - outputIter->second[ index ] ) / delta;
+            }
+        }
+        mFullModel->setEmissions( gasIter->first, mFitPeriod, baseEmissions );
+    }
+
+    const int prevYear = modeltime->getper_to_yr( mFitPeriod - 1 );
+    for( EmissionsMap::const_iterator gasIter = mLUCEmissions.begin();
+         gasIter != mLUCEmissions.end() && success; ++gasIter )
+    {
+        const map<int, double>::const_iterator firstIter = gasIter->second.upper_bound( prevYear );
+        const map<int, double>::const_iterator lastIter = gasIter->second.upper_bound( mFitYear );
+        if( firstIter == lastIter ) {
+            continue;
+        }
+        double delta = MIN_FIT_PERTURBATION;
+        for( map<int, double>::const_iterator emissIter = firstIter; emissIter != lastIter; ++emissIter ) {
+            delta = max( delta, fabs( emissIter->second ) * FIT_PERTURBATION );
+        }
+        for( map<int, double>::const_iterator emissIter = firstIter; emissIter != lastIter; ++emissIter ) {
+            mFullModel->setLUCEmissions( gasIter->first, emissIter->first, emissIter->second + delta );
+        }
+        success = mFullModel->runModel() == SUCCESS;
+        OutputMap& kernels = mKernels[ KernelKey( gasIter->first, true ) ];
+        for( OutputMap::const_iterator outputIter = mAnchorOutputs.begin();
+             outputIter != mAnchorOutputs.end() && success; ++outputIter )
+        {
+            vector<double>& kernel = kernels[ outputIter->first ] = getFullOutputs( outputIter->first );
+            for( unsigned int index = 0; index < kernel.size(); ++index ) {
+                kernel[ index ] = ( kernel[ index ] - outputIter->second[ index ] ) / delta;
+            }
+        }
+        for( map<int, double>::const_iterator emissIter = firstIter; emissIter != lastIter; ++emissIter ) {
+            mFullModel->setLUCEmissions( gasIter->first, emissIter->first, emissIter->second );
+        }
+    }
+
+    // Restore the full model outputs to the anchor.
+    success &= mFullModel->runModel() == SUCCESS;
+    mIsFit = success;
+    if( !success ) {
+        climateLog.setLevel( ILogger::WARNING );
+        climateLog << "The climate model failed while fitting the emulator, emulation is disabled." << endl;
+        mKernels.clear();
+        mHasAnchor = false;
+    }
+}
+
+/*!
+ * \brief Calculate the emulated outputs from the anchor and the change in
+ *        emissions since the anchor.
+ * \details Each period's change in emissions is applied with the impulse
+ *          response fit in mFitPeriod shifted by the difference in years.
+ *          Responses beyond the end of the fit are held at their last value.
+ */
+void ClimateEmulator::emulate() {
+    const Modeltime* modeltime = scenario->getModeltime();
+    mEmulatedOutputs = mAnchorOutputs;
+    for( map<KernelKey, OutputMap>::const_iterator gasIter = mKernels.begin();
+         gasIter != mKernels.end(); ++gasIter )
+    {
+        const map<int, double> deltas = calcPeriodDeltas( gasIter->first.first, gasIter->first.second );
+        for( map<int, double>::const_iterator deltaIter = deltas.begin(); deltaIter != deltas.end(); ++deltaIter ) {
+            if( deltaIter->second == 0.0 ) {
+                continue;
+            }
+            const int shift = modeltime->getper_to_yr( deltaIter->first ) - mFitYear;
+            for( OutputMap::const_iterator kernelIter = gasIter->second.begin();
+                 kernelIter != gasIter->second.end(); ++kernelIter )
+            {
+                const vector<double>& kernel = kernelIter->second;
+                vector<double>& outputs = mEmulatedOutputs[ kernelIter->first ];
+                for( int index = max( shift, 0 ); index < static_cast<int>( outputs.size() ); ++index ) {
+                    const int kernelIndex = min( index - shift, static_cast<int>( kernel.size() ) - 1 );
+                    outputs[ index ] += deltaIter->second * kernel[ kernelIndex ];
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Calculate the change in emissions of a gas since the anchor by
+ *        period.
+ * \details LUC emissions are averaged over the years of each period.
+ * \param aGasName The emissions gas.
+ * \param aIsLUC Whether the gas is a LUC emissions gas which is set by year.
+ * \return The change in emissions by period.
+ */
+map<int, double> ClimateEmulator::calcPeriodDeltas( const string& aGasName,
+                                                    const bool aIsLUC ) const
+{
+    map<int, double> deltas;
+    const EmissionsMap& emissions = aIsLUC ? mLUCEmissions : mEmissions;
+    const EmissionsMap& anchorEmissions = aIsLUC ? mAnchorLUCEmissions : mAnchorEmissions;
+    EmissionsMap::const_iterator currIter = emissions.find( aGasName );
+    EmissionsMap::const_iterator anchorIter = anchorEmissions.find( aGasName );
+    if( currIter == emissions.end() || anchorIter == anchorEmissions.end() ) {
+        return deltas;
+    }
+
+    const Modeltime* modeltime = scenario->getModeltime();
+    map<int, int> numYears;
+    for( map<int, double>::const_iterator emissIter = currIter->second.begin();
+         emissIter != currIter->second.end(); ++emissIter )
+    {
+        map<int, double>::const_iterator anchorEmissIter = anchorIter->second.find( emissIter->first );
+        if( anchorEmissIter == anchorIter->second.end() ) {
+            continue;
+        }
+        const double delta = emissIter->second - anchorEmissIter->second;
+        if( !aIsLUC ) {
+            deltas[ emissIter->first ] = delta;
+        }
+        else if( emissIter->first > modeltime->getStartYear() && emissIter->first <= modeltime->getEndYear() ) {
+            // Years between periods map to the period which ends them.
+            const int period = modeltime->getyr_to_per( emissIter->first );
+            deltas[ period ] += delta;
+            ++numYears[ period ];
+        }
+    }
+    for( map<int, int>::const_iterator yearsIter = numYears.begin(); yearsIter != numYears.end(); ++yearsIter ) {
+        deltas[ yearsIter->first ] /= yearsIter->second;
+    }
+    return deltas;
+}
@@ -129,6 +129,11 @@ MagiccModel::MagiccModel()
     mLastHistoricalYear = 0; // default to zero -- use only model data
     mCarbonModelStartYear = 1975; // Need to have first model year here, but should be 1990 for MAGICC. FIX.
     mNumberHistoricalDataPoints = 0; // internal counter
+    mState.reset( new MAGICC_state() );
+}
+
+//! Destructor
+MagiccModel::~MagiccModel() {
 }
 
 /*! \brief Complete the initialization of the MagiccModel.
@@ -193,6 +198,14 @@ void MagiccModel::completeInit( const string& aScenarioName ){
     mOutputGasNameMap[ "EXTRA" ] = 26; // Extra forcing
     mOutputGasNameMap[ "RCP" ] = 27; // RCP radiative forcing (total - nitrate, albedo, mineral dust)
     
+    // The MAGICC diagnostic files would collide between concurrent instances and
+    // add disk I/O to every run so they may be turned off.
+    mState->WRITE_OUTPUT = Configuration::getInstance()->getBool( "MAGICC-write-files", true );
+
+    // Read the input files shared by all instances now so that running the
+    // model does not have to.
+    loadMAGICCInputs();
+
     overwriteMAGICCParameters( );
 }
 
@@ -201,25 +214,25 @@ void MagiccModel::completeInit( const string& aScenarioName ){
 void MagiccModel::overwriteMAGICCParameters( ){
     // Override parameters in MAGICC if necessary
     int varIndex = 1;
-    SETPARAMETERVALUES( varIndex, mClimateSensitivity );
+    SETPARAMETERVALUES( mState.get(), varIndex, mClimateSensitivity );
     varIndex = 2;
-    SETPARAMETERVALUES( varIndex, mSoilTempFeedback );
+    SETPARAMETERVALUES( mState.get(), varIndex, mSoilTempFeedback );
     varIndex = 3;
-    SETPARAMETERVALUES( varIndex, mHumusTempFeedback );
+    SETPARAMETERVALUES( mState.get(), varIndex, mHumusTempFeedback );
     varIndex = 4;
-    SETPARAMETERVALUES( varIndex, mGPPTempFeedback );
+    SETPARAMETERVALUES( mState.get(), varIndex, mGPPTempFeedback );
     varIndex = 5;
-    SETPARAMETERVALUES( varIndex, mNetDeforestCarbFlux80s );
+    SETPARAMETERVALUES( mState.get(), varIndex, mNetDeforestCarbFlux80s );
     varIndex = 6;
-    SETPARAMETERVALUES( varIndex, mOceanCarbFlux80s );
+    SETPARAMETERVALUES( mState.get(), varIndex, mOceanCarbFlux80s );
     varIndex = 7;
-    SETPARAMETERVALUES( varIndex, mSO2Dir1990 );
+    SETPARAMETERVALUES( mState.get(), varIndex, mSO2Dir1990 );
     varIndex = 8;
-    SETPARAMETERVALUES( varIndex, mSO2Ind1990 );
+    SETPARAMETERVALUES( mState.get(), varIndex, mSO2Ind1990 );
     varIndex = 9;
-    SETPARAMETERVALUES( varIndex, mBCUnitForcing );
+    SETPARAMETERVALUES( mState.get(), varIndex, mBCUnitForcing );
     varIndex = 10;
-    SETPARAMETERVALUES( varIndex, mOCUnitForcing );
+    SETPARAMETERVALUES( mState.get(), varIndex, mOCUnitForcing );
 }
 
 //! parse MAGICC xml object
@@ -536,8 +549,9 @@ double MagiccModel::getEmissions( const string& aGasName,
     return static_cast<double>( ( aYear - x1 ) * ( y2 - y1 ) ) / static_cast<double>( ( x2 - x1 ) ) + y1;
 }
 
-/*! \brief Write out the MAGICC emissions file.
- * \details This function writes emissions to the MAGICC input file.
+/*! \brief Set the emissions into the MAGICC instance.
+ * \details This function passes emissions to the MAGICC instance in memory in
+ *          the gas.emk format.
  *          The first part of this function writes out historical data from
  *          the default emissions file. This data can be for any years, but
  *          must include the model critical year (2000). 
@@ -545,7 +559,7 @@ double MagiccModel::getEmissions( const string& aGasName,
  *          as specified by the user. 
  *          Emissions are interpolated in-between years without data.
  */
-void MagiccModel::writeMAGICCEmissionsFile(){
+void MagiccModel::setMAGICCEmissions(){
     const int OUT_PRECISION = 4; // Number of decimals
     
     // Open a stringstream until are ready to print to file
@@ -696,13 +710,15 @@ void MagiccModel::writeMAGICCEmissionsFile(){
     gasStream << gasFileData.str(); 
     
     // Set the gas data into MAGICC.
-    SET_GAS_EMK( gasStream.str() );
+    SET_GAS_EMK( mState.get(), gasStream.str() );
     
     // Check if the users still wants the gas data saved as a file which may be
     // useful for debugging or to use as input for a stand alone MAGICC run.
-    AutoOutputFile gasFile( "climatFileName", "gas.emk" );
-    string gasEMKData = gasStream.str();
-    gasFile << gasEMKData;
+    if( mState->WRITE_OUTPUT ) {
+        AutoOutputFile gasFile( "climatFileName", "gas.emk" );
+        string gasEMKData = gasStream.str();
+        gasFile << gasEMKData;
+    }
 }
 
 /*! \brief Write comma.
@@ -722,8 +738,8 @@ void MagiccModel::writeComma( int gasNumber, int& numberOfDataPoints, ostringstr
 /*! \brief Run the MAGICC emissions model.
 * \details This function will run the MAGICC model with the currently stored
 *          emissions levels. It will first extrapolate future points for each
-*          gas, set equal to the last period. It then prints the gases to the
-*          MAGICC input file and calls MAGICC.
+*          gas, set equal to the last period. It then passes the gases to the
+*          MAGICC instance and calls MAGICC.
 * \return Whether the model ran successfully.
 */
 enum MagiccModel::runModelStatus MagiccModel::runModel(){
@@ -737,7 +753,7 @@ enum MagiccModel::runModelStatus MagiccModel::runModel(){
               mModelEmissionsByGas[ gasNumber ][ finalPeriod ] );
     }
     
-    writeMAGICCEmissionsFile( );
+    setMAGICCEmissions( );
     
     // First overwrite parameters
     overwriteMAGICCParameters( );
@@ -746,7 +762,7 @@ enum MagiccModel::runModelStatus MagiccModel::runModel(){
     ILogger& mainLog = ILogger::getLogger( "main_log" );
     mainLog.setLevel( ILogger::NOTICE );
     mainLog << "Calling the climate model..."<< endl;
-    CLIMAT();
+    CLIMAT( mState.get() );
     mainLog.setLevel( ILogger::DEBUG );
     mainLog << "Finished with CLIMAT()" << endl;
     mIsValid = true;
@@ -776,7 +792,7 @@ double MagiccModel::getConcentration( const string& aGasName,
     int year = aYear;
     int gasNumber = util::searchForValue( mOutputGasNameMap, aGasName );
     if ( gasNumber != 0 ) {
-        return GETGHGCONC( gasNumber, year );
+        return GETGHGCONC( mState.get(), gasNumber, year );
     }
     return -1;
 }
@@ -789,7 +805,7 @@ double MagiccModel::getTemperature( const int aYear ) const {
 
     // Need to store the year locally so it can be passed by reference.
     int year = aYear;
-    return GETGMTEMP( year );
+    return GETGMTEMP( mState.get(), year );
 }
 
 double MagiccModel::getForcing( const string& aGasName, const int aYear ) const {
@@ -801,7 +817,7 @@ double MagiccModel::getForcing( const string& aGasName, const int aYear ) const
     int year = aYear;
     int gasNumber = util::searchForValue( mOutputGasNameMap, aGasName );
     if ( gasNumber != 0 ) {
-        return GETFORCING( gasNumber, year );
+        return GETFORCING( mState.get(), gasNumber, year );
     }
     return -1;
 }
@@ -820,7 +836,7 @@ double MagiccModel::getNetTerrestrialUptake( const int aYear ) const {
 
     int year = aYear;
     int itemNumber = 10;
-    return GETCARBONRESULTS( itemNumber, year );
+    return GETCARBONRESULTS( mState.get(), itemNumber, year );
 }
 
 double MagiccModel::getNetOceanUptake( const int aYear ) const {
@@ -837,7 +853,7 @@ double MagiccModel::getNetOceanUptake( const int aYear ) const {
 
     int year = aYear;
     int itemNumber = 4;
-    return GETCARBONRESULTS( itemNumber, year );
+    return GETCARBONRESULTS( mState.get(), itemNumber, year );
 }
 
 double MagiccModel::getNetLandUseChangeEmission( const int aYear ) const {
@@ -854,7 +870,7 @@ double MagiccModel::getNetLandUseChangeEmission( const int aYear ) const {
 
     int itemNumber = 2;
     int year = aYear;
-    return GETCARBONRESULTS( itemNumber, year );
+    return GETCARBONRESULTS( mState.get(), itemNumber, year );
 }
 
 double MagiccModel::getTotalForcing( const int aYear ) const {
@@ -866,7 +882,7 @@ double MagiccModel::getTotalForcing( const int aYear ) const {
     // Need to store the year and gas number locally so it can be passed by reference.
     int year = aYear;
     int gasNumber = 0; // global forcing
-    return GETFORCING( gasNumber, year );
+    return GETFORCING( mState.get(), gasNumber, year );
 }
 
 
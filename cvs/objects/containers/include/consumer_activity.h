@@ -66,6 +66,8 @@ public:
     virtual void calc( const int aPeriod );
     
     virtual std::string getDescription() const;
+    
+    virtual const void* getCalcObject() const;
 private:
     //! The wrapped consumer.
     Consumer* mConsumer;
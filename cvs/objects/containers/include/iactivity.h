@@ -71,6 +71,18 @@ public:
      * \return A description of this activity.
      */
     virtual std::string getDescription() const = 0;
+    
+    /*!
+     * \brief Get the model object which this activity calculates.
+     * \details The returned pointer is only used to identify the object.  STATE
+     *          data contained in it is assumed to only be changed when one of the
+     *          activities which calculate it is calculated, which allows
+     *          ManageStateVariables to reset the state of only the activities
+     *          in a partial derivative.
+     * \return The object calculated by this activity, or null if it is not a
+     *         single object.
+     */
+    virtual const void* getCalcObject() const = 0;
 };
 
 // Inline definitions.
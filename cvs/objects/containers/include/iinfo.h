@@ -48,13 +48,14 @@
 #include <iosfwd>
 
 class Tabs;
+class InfoKey;
 
 /*!
 * \ingroup Objects
 * \brief This interface represents a set of properties which can be accessed by
 *        their unique identifier.
 * \details The IInfo interface represents a set of searchable properties
-*          accessed by their string key. The properties may be booleans,
+*          accessed by their string key or an equivalent interned InfoKey. The properties may be booleans,
 *          integers, double or strings. Operations exist to set or update values
 *          for a key, query if a key exists, and get the value for a key.
 * \todo Evaluate whether functions to add to a double value, and update an
@@ -201,6 +202,71 @@ public:
     */
     virtual bool hasValue( const std::string& aStringKey ) const = 0;
 
+    /*! \brief Set a boolean value for a given interned key.
+    * \param aKey The key for which to set or update the value.
+    * \param aValue The new value.
+    * \sa setBoolean
+    */
+    virtual bool setBoolean( const InfoKey& aKey, const bool aValue ) = 0;
+
+    /*! \brief Set an integer value for a given interned key.
+    * \param aKey The key for which to set or update the value.
+    * \param aValue The new value.
+    * \sa setInteger
+    */
+    virtual bool setInteger( const InfoKey& aKey, const int aValue ) = 0;
+
+    /*! \brief Set a double value for a given interned key.
+    * \param aKey The key for which to set or update the value.
+    * \param aValue The new value.
+    * \sa setDouble
+    */
+    virtual bool setDouble( const InfoKey& aKey, const double aValue ) = 0;
+
+    /*! \brief Set a string value for a given interned key.
+    * \param aKey The key for which to set or update the value.
+    * \param aValue The new value.
+    * \sa setString
+    */
+    virtual bool setString( const InfoKey& aKey, const std::string& aValue ) = 0;
+
+    /*! \brief Get a boolean from the IInfo with a specified interned key.
+    * \details Unlike the string key version this does not need to hash the
+    *          key and so should be preferred during calc.
+    * \param aKey The key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The boolean associated with the key or false if it does not exist.
+    */
+    virtual bool getBoolean( const InfoKey& aKey, const bool aMustExist ) const = 0;
+
+    /*! \brief Get an integer from the IInfo with a specified interned key.
+    * \param aKey The key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The integer associated with the key or zero if it does not exist.
+    */
+    virtual int getInteger( const InfoKey& aKey, const bool aMustExist ) const = 0;
+
+    /*! \brief Get a double from the IInfo with a specified interned key.
+    * \param aKey The key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The double associated with the key or zero if it does not exist.
+    */
+    virtual double getDouble( const InfoKey& aKey, const bool aMustExist ) const = 0;
+
+    /*! \brief Get a string from the IInfo with a specified interned key.
+    * \param aKey The key for which to search the IInfo object.
+    * \param aMustExist Whether the value should exist in the IInfo.
+    * \return The string(by reference) associated with the key or the empty
+    *         string if it does not exist.
+    */
+    virtual const std::string& getString( const InfoKey& aKey, const bool aMustExist ) const = 0;
+
+    /*! \brief Return whether a value exists in the IInfo for an interned key.
+    * \param aKey The key for which to search the IInfo object.
+    * \return Whether the key exists in the IInfo.
+    */
+    virtual bool hasValue( const InfoKey& aKey ) const = 0;
+
     /*! \brief Write the IInfo object to an output stream as XML.
     * \details Writes the set of keys and values to an output stream as XML.
     * \param aPeriod Model period for which to write debugging information.
@@ -47,17 +47,20 @@
 
 #include <string>
 #include <iosfwd>
-#include <boost/any.hpp>
+#include <list>
+#include <atomic>
 #include <boost/noncopyable.hpp>
 #include "containers/include/iinfo.h"
+#include "containers/include/info_key.h"
 
-// Can't forward declare because operations are used in template functions.
-#include "util/base/include/hash_map.h"
 #include "util/base/include/xml_helper.h"
 #include "util/base/include/configuration.h"
 
 #if GCAM_PARALLEL_ENABLED
-#include <tbb/queuing_rw_mutex.h>
+#include <tbb/concurrent_unordered_map.h>
+#include <tbb/spin_mutex.h>
+#else
+#include <unordered_map>
 #endif
 
 class Tabs;
@@ -66,6 +69,20 @@ class Tabs;
 * \ingroup Objects
 * \brief This class contains a set of properties which can be accessed by their
 *        unique identifier.
+* \details Values are stored in typed slots indexed by the interned InfoKey of
+*          their name.  Reads do not take any locks: slots are never removed
+*          once created and their values are atomics, so a reader will always
+*          see either the old or the new value of a concurrent update.  Writes
+*          to an existing numeric slot are likewise lock free, only creating a
+*          new slot or updating a string takes the write mutex.
+*
+*          A key which is not found locally is resolved through the chain of
+*          parent Info objects.  The slot it resolves to is cached so that
+*          subsequent reads need a single lookup.  Any time a new slot is
+*          created anywhere in the model the cached resolutions are considered
+*          stale since the new slot may shadow one found previously.  New slots
+*          are generally only created during initialization so in practice the
+*          cache is stable during calc.
 * \author Josh Lurz
 * \todo Add longevity to properties.
 */
@@ -102,6 +119,24 @@ public:
 
     bool hasValue( const std::string& aStringKey ) const;
 
+    bool setBoolean( const InfoKey& aKey, const bool aValue );
+
+    bool setInteger( const InfoKey& aKey, const int aValue );
+
+    bool setDouble( const InfoKey& aKey, const double aValue );
+
+    bool setString( const InfoKey& aKey, const std::string& aValue );
+
+    bool getBoolean( const InfoKey& aKey, const bool aMustExist ) const;
+
+    int getInteger( const InfoKey& aKey, const bool aMustExist ) const;
+
+    double getDouble( const InfoKey& aKey, const bool aMustExist ) const;
+
+    const std::string& getString( const InfoKey& aKey, const bool aMustExist ) const;
+
+    bool hasValue( const InfoKey& aKey ) const;
+
     void toDebugXML( const int aPeriod, Tabs* aTabs, std::ostream& aOut ) const;
 protected:
     Info( const IInfo* aParentInfo, const std::string& aOwnerName );
@@ -127,175 +162,97 @@ private:
         eString
     };
 
-    template<class T> bool setItemValueLocal( const std::string& aStringKey,
-                                              const AnyType aType,
-                                              const T& aValue );
+    /*!
+     * \brief Storage for a single value.
+     * \details Only the member matching mType is meaningful.  Booleans are
+     *          stored in mInteger.  Strings are owned by the Info's string
+     *          store so that references handed out by getString remain valid
+     *          after the value is updated.
+     */
+    struct Slot {
+        explicit Slot( const AnyType aType );
 
-    template<class T> const T& getItemValueLocal( const std::string& aStringKey, bool& aExists ) const;
+        //! The type of the value currently stored.
+        std::atomic<int> mType;
 
-    size_t getInitialSize() const;
+        //! The value if it is a double.
+        std::atomic<double> mDouble;
 
-    void printItemNotFoundWarning( const std::string& aStringKey ) const;
+        //! The value if it is an integer or boolean.
+        std::atomic<int> mInteger;
 
-    void printBadCastWarning( const std::string& aStringKey, bool aIsUpdate ) const;
-
-    void printShadowWarning( const std::string& aStringKey ) const;
+        //! The value if it is a string.
+        std::atomic<const std::string*> mString;
+    };
 
-    template<class T> void printItem( const boost::any& aValue,
-                                      std::ostream& aOut,
-                                      Tabs* aTabs ) const;
+    /*!
+     * \brief The result of resolving a key through the parent chain.
+     * \details mGeneration is zero while the entry is being updated.
+     */
+    struct ResolvedSlot {
+        ResolvedSlot();
 
-    //! Type of the item stored as the value in the storage map.
-    typedef std::pair<AnyType, boost::any> ValueType;
+        //! The slot generation at which mSlot was resolved.
+        std::atomic<unsigned int> mGeneration;
 
-    //! Type of the internal storage map.
-    typedef HashMap<const std::string, ValueType> InfoMap;
+        //! The slot the key resolved to or null if it was not found.
+        std::atomic<const Slot*> mSlot;
+    };
 
-    //! Internal storage mapping item names to item values.
-    std::auto_ptr<InfoMap> mInfoMap;
 #if GCAM_PARALLEL_ENABLED
-    // actions that modify mInfoMap MUST obtain a write lock on the info map.
-    // Those that merely read it MUST obtain a read lock
-    mutable tbb::queuing_rw_mutex mInfoMapMutex;
+    typedef tbb::concurrent_unordered_map<int, Slot*> SlotMap;
+    typedef tbb::concurrent_unordered_map<int, ResolvedSlot*> ResolvedSlotMap;
+#else
+    typedef std::unordered_map<int, Slot*> SlotMap;
+    typedef std::unordered_map<int, ResolvedSlot*> ResolvedSlotMap;
 #endif
 
-    //! A pointer to the parent of this Info object which can be null.
-    const IInfo* mParentInfo;
-};
+    const Slot* findLocalSlot( const int aKey ) const;
 
-/*! \brief Set a name and value for a piece of information related.
-* \details This function will check the info map for the associated key, if it
-*          exists it will update the associated value to itemValue, otherwise it
-*          will create a new name value pair.
-* \param aStringKey The string key to use as the key for this information value.
-* \param aType Enum value of the type.
-* \param aValue The value to be associated with this key. 
-*/
-template<class T> bool Info::setItemValueLocal( const std::string& aStringKey,
-                                                const AnyType aType,
-                                                const T& aValue )
-{
-    /*! \pre A valid key was passed. */
-    assert( !aStringKey.empty() );
-
-    // If debug checking is turned on search for the key in the current object
-    // to determine if the type of the existing and new types match. Search in
-    // the parent to see if this new item will shadow a variable in the parent.
-    const static bool debugChecking = Configuration::getInstance()->getBool( "debugChecking" );
-    if( debugChecking ){
-#if GCAM_PARALLEL_ENABLED
-        // obtain read lock
-        // XXX FIXME:  We should arrange to release this lock BEFORE we recurse into
-        // the mParentInfo->hasValue calls
-        tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex,false);
-#endif
-        InfoMap::const_iterator curr = mInfoMap->find( aStringKey );
-        if( curr != mInfoMap->end() ){
-            // Check that the types match.
-            try {
-                boost::any_cast<T>( curr->second.second );
-            }
-            catch( boost::bad_any_cast ){
-                printBadCastWarning( aStringKey, true );
-            }
-        }
-        // Check if the value exists in a parent info.
-        else if( mParentInfo && mParentInfo->hasValue( aStringKey ) ){
-            printShadowWarning( aStringKey );
-        }
-    }
+    const Slot* resolveSlot( const int aKey ) const;
 
-#if GCAM_PARALLEL_ENABLED
-    // acquire a write lock for updating the infomap
-    tbb::queuing_rw_mutex::scoped_lock writelock(mInfoMapMutex, true);
-#endif
-    // Add the value regardless of whether a warning was printed.
-    mInfoMap->insert( std::make_pair( aStringKey, std::make_pair( aType, boost::any( aValue ) ) ) );
-    return true;
-}
+    template<class T> bool setItemValueLocal( const int aKey, const AnyType aType,
+                                              const T aValue );
 
-/*! \brief Get the value of an item based on a string key and a passed in
-*          location.
-* \author Josh Lurz
-* \param aStringKey The string key for which to find the value.
-* \param aMustExist Whether it is an error for the item to be missing.
-* \param aExists Return parameter to update with whether the item existed.
-* \return The value associated with the key if it exists, the default value
-*         otherwise. 
-* \warning This function returns a reference to an item stored in a map.  If
-*          the map entry is deleted or overwritten, we will wind up with a
-*          dangling reference.  We could return by value, but for string values
-*          that involves making several string temporaries (as this function is
-*          normally called indirectly through getString), which can be very
-*          painful in multithreaded code because of the synchronization buried
-*          in the string object's malloc call.
-*/
-template<class T>
-const T& Info::getItemValueLocal( const std::string& aStringKey,
-                                 bool& aExists ) const
-{
-    /*! \pre A valid key was passed. */
-    assert( !aStringKey.empty() );
+    static void storeValue( Slot* aSlot, const bool aValue );
+
+    static void storeValue( Slot* aSlot, const int aValue );
+
+    static void storeValue( Slot* aSlot, const double aValue );
+
+    static void storeValue( Slot* aSlot, const std::string* aValue );
+
+    static const std::string& getStringValue( const Slot* aSlot );
+
+    const Slot* getTypedSlot( const int aKey, const AnyType aType,
+                              const bool aMustExist, const std::string* aStringKey ) const;
+
+    void printItemNotFoundWarning( const std::string& aStringKey ) const;
+
+    void printBadCastWarning( const std::string& aStringKey, bool aIsUpdate ) const;
+
+    void printShadowWarning( const std::string& aStringKey ) const;
+
+    //! Internal storage mapping interned keys to slots.
+    SlotMap mSlots;
+
+    //! Cache of keys resolved through the parent chain.
+    mutable ResolvedSlotMap mResolvedSlots;
+
+    //! Storage for all string values ever set, see Slot.
+    std::list<std::string> mStringStore;
 
 #if GCAM_PARALLEL_ENABLED
-    // read lock for reading the map
-    tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex, false);
+    // Actions that create a slot, update a string, or update a resolved slot
+    // MUST hold this lock.  Readers do not lock.
+    mutable tbb::spin_mutex mWriteMutex;
 #endif
-    // Check for the value.
-    InfoMap::const_iterator curr = mInfoMap->find( aStringKey );
-    if( curr != mInfoMap->end() ){
-        aExists = true;
-        // Attempt to set the return value to the found value. This requires
-        // converting the data from the actual type to the requested type.
-        try {
-            // NB: By my reading of the boost docs, the pointer version of
-            // any_cast() used below will never throw an exception, so this
-            // try block is useless.  The docs don't say what WILL happen if
-            // the cast fails in the pointer version, but I'm assuming it
-            // returns a null pointer.  Thus, I've added a test that replicates
-            // the exception behavior in the event of a null pointer return.
-            // I've also left the try-catch in place, in case there are some
-            // versions of the boost libs that actually do throw an exception
-            // for the pointer version of the cast.
-            const T *valp = boost::any_cast<T>( &curr->second.second );
-            if(valp)
-                return *valp;
-            else
-                printBadCastWarning(aStringKey, false);
-        }
-        // Catch bad data conversions and print an error.
-        // See note within the try-block
-        catch( boost::bad_any_cast ){
-            printBadCastWarning( aStringKey, false );
-        }
-    }
-
-    // Return the default value if a successful return has not already occurred.
-    aExists = false;
-    static const T defaultValue = T();
-    return defaultValue;
-}
 
-/*!
- * \brief Print a single any type value to XML.
- * \param aValue Value stored as an any type.
- * \param aOut Output stream.
- * \param aTabs Tabs object.
- */
-template<class T>
-void Info::printItem( const boost::any& aValue,
-                      std::ostream& aOut,
-                      Tabs* aTabs ) const
-{
-    try {
-        T value = boost::any_cast<T>( aValue );
-        XMLWriteElement( value, "Value", aOut, aTabs );
-    }
-    // Catch bad data conversions.
-    catch( boost::bad_any_cast ){
-        // Wrong type stored with the item.
-        assert( false );
-    }
-}
+    //! Incremented each time a slot is created in any Info.
+    static std::atomic<unsigned int> sSlotGeneration;
+
+    //! A pointer to the parent of this Info object which can be null.
+    const Info* mParentInfo;
+};
 
 #endif // _INFO_H_
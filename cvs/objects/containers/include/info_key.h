@@ -0,0 +1,96 @@
+#ifndef _INFO_KEY_H_
+#define _INFO_KEY_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file info_key.h
+ * \ingroup Objects
+ * \brief The InfoKey class header file.
+ */
+
+#include <string>
+
+/*!
+ * \ingroup Objects
+ * \brief An interned key used to access values in an IInfo object.
+ * \details Each distinct key name is assigned a dense integer slot the first
+ *          time it is interned.  The slot is global to the model so that the
+ *          same InfoKey may be used to access any IInfo.  Objects which read an
+ *          IInfo during calc should construct the keys they need once, typically
+ *          in completeInit or initCalc, and use the InfoKey overloads of the
+ *          IInfo accessors to avoid rebuilding and hashing string keys on each
+ *          access.
+ *
+ *          Interning a new name takes a lock however looking up an existing
+ *          name or the name of a slot does not.
+ */
+class InfoKey
+{
+public:
+    InfoKey();
+
+    explicit InfoKey( const std::string& aName );
+
+    //! Whether this key was constructed from a name.
+    bool isValid() const {
+        return mID != INVALID_ID;
+    }
+
+    //! The interned slot for this key.
+    int getID() const {
+        return mID;
+    }
+
+    const std::string& getName() const;
+
+    static int intern( const std::string& aName );
+
+    static int find( const std::string& aName );
+
+    static const std::string& getName( const int aID );
+
+    static int getNumKeys();
+
+    //! The slot used to flag a key which has not been interned.
+    static const int INVALID_ID = -1;
+private:
+    //! The interned slot.
+    int mID;
+};
+
+#endif // _INFO_KEY_H_
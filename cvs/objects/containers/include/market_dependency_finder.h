@@ -49,10 +49,13 @@
 #include <string>
 #include <set>
 
+#include "parallel/include/bitvector.hpp"
+
 class Marketplace;
 class IActivity;
 #if GCAM_PARALLEL_ENABLED
 class GcamFlowGraph;
+struct GrainSchedule;
 #endif
 
 /*! 
@@ -76,9 +79,10 @@ class GcamFlowGraph;
  *                this process markets will be bound to the activities which
  *                are directly affected by a change in the price of that market.
  *              - Get the global ordering via getOrdering() or a market specific
- *                ordering via getOrdering(int marketNumber).  Note that for market
- *                specific ordering a search will be performed to get a complete
- *                list of items to calculate.
+ *                ordering via getOrdering(int marketNumber).  Note that market
+ *                specific orderings are stored compactly as a bitvector over the
+ *                global ordering which may be retrieved without copying via
+ *                getCalcMask(int marketNumber).
  *
  * \author Pralit Patel
  */
@@ -95,9 +99,13 @@ public:
                         const bool aCanBeBroken = true );
 
     const std::vector<IActivity*> getOrdering( const int aMarketNumber = -1 ) const;
+    
+    const bitvector& getCalcMask( const int aMarketNumber ) const;
 
 #if GCAM_PARALLEL_ENABLED
     GcamFlowGraph* getFlowGraph( const int aMarketNumber = -1 );
+    
+    void buildFlowGraphs( const std::vector<int>& aMarketNumbers );
 #endif
 
     void resolveActivityToDependency( const std::string& aRegionName, 
@@ -291,10 +299,10 @@ public:
         //! it's price.
         std::set<CalcVertex*> mImpliedVertices;
 
-        //! A complete list of vertices to re-calculate should this market change
-        //! it's price.  Note that this is essentially a cache and only computed
-        //! the first time it is needed.
-        std::vector<IActivity*> mCalcList;
+        //! The complete set of activities to re-calculate should this market change
+        //! it's price as indices into the global ordering.  This is computed for
+        //! all markets at once at the end of createOrdering.
+        bitvector mCalcMask;
 
 #if GCAM_PARALLEL_ENABLED
         //! A flow graph of vertices to re-calculate in parallel should this market
@@ -335,12 +343,21 @@ public:
 #if GCAM_PARALLEL_ENABLED
     //! The global flow graph to calculate the full model in parallel
     GcamFlowGraph* mTBBGraphGlobal;
+    
+    //! The grain schedule for the full model from which all flow graphs are
+    //! created.
+    GrainSchedule* mGrainSchedule;
+    
+    void createGrainSchedule();
+    
+    GcamFlowGraph* createMarketFlowGraph( const int aMarketNumber ) const;
 #endif
     
-    void findVerticesToCalculate( CalcVertex* aVertex, std::set<IActivity*>& aVisited ) const;
+    void createCalcMasks();
     void findStronglyConnected( CalcVertex* aCurrVertex, int& aMaxIndex,std::list<CalcVertex*>& aHasVisited,
                                 CalcVertexCountMap& aTotalVisits ) const;
     int markCycles( CalcVertex* aCurrVertex, std::list<CalcVertex*>& aHasVisited, CalcVertexCountMap& aTotalVisits ) const;
+    CMarketToDepIterator findMarketToDep( const int aMarketNumber ) const;
     void createTrialsForItem( CItemIterator aItemToReset, CalcVertexCountMap& aNumDependencies );
 };
 
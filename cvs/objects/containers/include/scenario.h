@@ -89,6 +89,7 @@ class ManageStateVariables;
 class Scenario: public IParsable, public IVisitable, public IRoundTrippable
 {
     friend class LogEDFun;
+    friend class PeriodEvaluator;
 public:
     Scenario();
     ~Scenario();
@@ -114,6 +115,7 @@ public:
     static const std::string& getXMLNameStatic();
     const std::vector<int>& getUnsolvedPeriods() const;
     void invalidatePeriod( const int aPeriod );
+    bool setClimateEmulation( const bool aEmulate );
     ManageStateVariables* getManageStateVariables() const;
 
     //! Constant which when passed to the run method means to run all model periods.
@@ -165,6 +167,8 @@ protected:
 
     bool solve( const int period );
 
+    void initPeriod( const int aPeriod );
+
     bool calculatePeriod( const int aPeriod,
         std::ostream& aXMLDebugFile,
         std::ostream& aSGMDebugFile,
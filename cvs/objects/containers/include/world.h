@@ -62,9 +62,12 @@ class ILogger;
 class Curve;
 class CalcCounter;
 class IClimateModel;
+class ClimateEmulator;
 class GHGPolicy;
 class GlobalTechnologyDatabase;
 class IActivity;
+class IShardableVisitor;
+class bitvector;
 
 #if GCAM_PARALLEL_ENABLED
 class GcamFlowGraph;
@@ -100,10 +103,12 @@ public:
 
     void calc( const int period );
     void calc( const int period, const std::vector<IActivity*>& aRegionsToCalc );
+    void calc( const int aPeriod, const bitvector& aItemsToCalc );
     void updateSummary( const std::list<std::string> aPrimaryFuelList, const int period ); 
     void setEmissions( int period );
     void runClimateModel();
     void runClimateModel( int period );
+    bool setClimateEmulation( const bool aEmulate );
     void csvOutputFile() const; 
     void dbOutput( const std::list<std::string>& aPrimaryFuelList ) const; 
     const std::map<std::string,int> getOutputRegionMap() const;
@@ -118,6 +123,7 @@ public:
     const GlobalTechnologyDatabase* getGlobalTechnologyDatabase() const;
 
 	void accept( IVisitor* aVisitor, const int aPeriod ) const;
+    void acceptRegion( const std::string& aRegionName, IVisitor* aVisitor, const int aPeriod ) const;
     void csvSGMOutputFile( std::ostream& aFile, const int period ) const;
     void csvSGMGenFile( std::ostream& aFile ) const;
 
@@ -166,9 +172,14 @@ protected:
     //! The global ordering of activities which can be used to calculate the model.
     std::vector<IActivity*> mGlobalOrdering;
 
+    //! An optional emulator of the climate model which wraps mClimateModel.
+    ClimateEmulator* mClimateEmulator;
+
     void clear();
 
     void csvGlobalDataFile() const;
+
+    void acceptRegionShards( IShardableVisitor* aShardableVisitor, const int aPeriod ) const;
 };
 
 #endif // _WORLD_H_
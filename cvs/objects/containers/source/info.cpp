@@ -46,213 +46,196 @@
 
 using namespace std;
 
+// Start at one so that a zero generation can flag a ResolvedSlot in update.
+atomic<unsigned int> Info::sSlotGeneration( 1 );
+
 /*! \brief Constructor
-* \details Constructs the Info object by allocating a hashmap to store the
-*          information objects, and initializes a link to the conceptual parent
-*          of this hashmap. Any search that fails in this hashmap will proceed
-*          to search the parent hashmap. This link may be null in which case all
+* \param aType The type of the value which will be stored.
+*/
+Info::Slot::Slot( const AnyType aType ):
+mType( aType ),
+mDouble( 0.0 ),
+mInteger( 0 ),
+mString( 0 )
+{
+}
+
+//! Constructor
+Info::ResolvedSlot::ResolvedSlot():
+mGeneration( 0 ),
+mSlot( 0 )
+{
+}
+
+/*! \brief Constructor
+* \details Constructs the Info object and initializes a link to the conceptual
+*          parent of this Info. Any search that fails in this Info will proceed
+*          to search the parent. This link may be null in which case all
 *          searches are local.
 * \param aParentInfo A pointer to the parent Info object of this Info object
 *        which may be null.
 */
 Info::Info( const IInfo* aParentInfo, const string& aOwnerName ) :
 mOwnerName( aOwnerName ),
-mInfoMap( new InfoMap( getInitialSize() ) ),
-mParentInfo( aParentInfo )
+mParentInfo( dynamic_cast<const Info*>( aParentInfo ) )
 {
+    // Resolving through the parent chain relies on all parents being Info
+    // objects which is ensured by the InfoFactory.
+    assert( mParentInfo || !aParentInfo );
 }
 
-/*! \brief Destructor
-* \details The explicit destructor is needed to prevent it from being inlined
-*          into the header file where the hashmap definition file would not have
-*          been seen yet. The auto_ptr will delete the hashmap automatically
-*          here.
-*/
+//! Destructor
 Info::~Info(){
+    for( SlotMap::const_iterator it = mSlots.begin(); it != mSlots.end(); ++it ){
+        delete it->second;
+    }
+    for( ResolvedSlotMap::const_iterator it = mResolvedSlots.begin(); it != mResolvedSlots.end(); ++it ){
+        delete it->second;
+    }
 }
 
 bool Info::setBoolean( const string& aStringKey, const bool aValue ){
-    return setItemValueLocal( aStringKey, eBoolean, aValue );
+    return setBoolean( InfoKey( aStringKey ), aValue );
 }
 
 bool Info::setInteger( const string& aStringKey, const int aValue ){
-    return setItemValueLocal( aStringKey, eInteger, aValue );
+    return setInteger( InfoKey( aStringKey ), aValue );
 }
 
 bool Info::setDouble( const string& aStringKey, const double aValue ){
-    return setItemValueLocal( aStringKey, eDouble, aValue );
+    return setDouble( InfoKey( aStringKey ), aValue );
 }
 
 bool Info::setString( const string& aStringKey, const string& aValue ){
-    return setItemValueLocal( aStringKey, eString, aValue );
+    return setString( InfoKey( aStringKey ), aValue );
 }
-    
+
 bool Info::getBoolean( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
-    bool found = false;
-    bool value = getItemValueLocal<bool>( aStringKey, found );
-    
-    // If the item wasn't found search the parent info.
-    if( !found ){
-        if( mParentInfo ){
-            value = mParentInfo->getBooleanHelper( aStringKey, found );
-        }
-        // The item must exist and was not found or there was no parent to search.
-        if( aMustExist && !found ){
-            printItemNotFoundWarning( aStringKey );
-        }
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eBoolean, aMustExist, &aStringKey );
+    return slot ? slot->mInteger.load() != 0 : false;
 }
 
 int Info::getInteger( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
-    bool found = false;
-    int value = getItemValueLocal<int>( aStringKey, found );
-    
-    // If the item wasn't found search the parent info.
-    if( !found ){
-        if( mParentInfo ){
-            value = mParentInfo->getIntegerHelper( aStringKey, found );
-        }
-        // The item must exist and was not found or there was no parent to search.
-        if( aMustExist && !found ){
-            printItemNotFoundWarning( aStringKey );
-        }
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eInteger, aMustExist, &aStringKey );
+    return slot ? slot->mInteger.load() : 0;
 }
 
 double Info::getDouble( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
-    bool found = false;
-    double value = getItemValueLocal<double>( aStringKey, found );
-
-    // If the item wasn't found search the parent info.
-    if( !found ){
-        if( mParentInfo ){
-            value = mParentInfo->getDoubleHelper( aStringKey, found );
-        }
-        // The item must exist and was not found or there was no parent to search.
-        if( aMustExist && !found ){
-            printItemNotFoundWarning( aStringKey );
-        }
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eDouble, aMustExist, &aStringKey );
+    return slot ? slot->mDouble.load() : 0.0;
 }
 
 const string& Info::getString( const string& aStringKey, const bool aMustExist ) const
 {
-    // Perform a local search.
-    bool found = false;
-    const string& value = getItemValueLocal<string>( aStringKey, found );
-    if( !found ){
-        // If the item wasn't found search the parent info.
-        if( mParentInfo ){
-            return mParentInfo->getStringHelper( aStringKey, found );
-        }
-        // The item must exist and was not found or there was no parent to search.
-        if( aMustExist && !found ){
-            printItemNotFoundWarning( aStringKey );
-        }
-    }
-    // Value will be initialized to the default value string by
-    // getItemValueLocal
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eString, aMustExist, &aStringKey );
+    return getStringValue( slot );
 }
 
 bool Info::getBooleanHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    bool value = getItemValueLocal<bool>( aStringKey, aFound );
-    
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        value = mParentInfo->getBooleanHelper( aStringKey, aFound );
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eBoolean, false, &aStringKey );
+    aFound = slot != 0;
+    return slot ? slot->mInteger.load() != 0 : false;
 }
 
 int Info::getIntegerHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    int value = getItemValueLocal<int>( aStringKey, aFound );
-    
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        value = mParentInfo->getIntegerHelper( aStringKey, aFound );
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eInteger, false, &aStringKey );
+    aFound = slot != 0;
+    return slot ? slot->mInteger.load() : 0;
 }
 
 double Info::getDoubleHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    double value = getItemValueLocal<double>( aStringKey, aFound );
-    
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        value = mParentInfo->getDoubleHelper( aStringKey, aFound );
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eDouble, false, &aStringKey );
+    aFound = slot != 0;
+    return slot ? slot->mDouble.load() : 0.0;
 }
 
 const string& Info::getStringHelper( const string& aStringKey, bool& aFound ) const
 {
-    // Perform a local search.
-    const string& value = getItemValueLocal<string>( aStringKey, aFound );
-    
-    // If the item wasn't found and parent exists, search the parent info.
-    if( !aFound && mParentInfo ){
-        return mParentInfo->getStringHelper( aStringKey, aFound );
-    }
-    return value;
+    const Slot* slot = getTypedSlot( InfoKey::find( aStringKey ), eString, false, &aStringKey );
+    aFound = slot != 0;
+    return getStringValue( slot );
 }
 
 bool Info::hasValue( const string& aStringKey ) const {
-#if GCAM_PARALLEL_ENABLED
-    // get a read lock on the info map
-    tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex,false);
-#endif
-    // Check the local store. 
-    bool currHasValue = ( mInfoMap->find( aStringKey ) != mInfoMap->end() );
+    const int key = InfoKey::find( aStringKey );
+    // A key which was never interned can not have been set anywhere.
+    return key != InfoKey::INVALID_ID && resolveSlot( key );
+}
 
+bool Info::setBoolean( const InfoKey& aKey, const bool aValue ){
+    return setItemValueLocal( aKey.getID(), eBoolean, aValue );
+}
+
+bool Info::setInteger( const InfoKey& aKey, const int aValue ){
+    return setItemValueLocal( aKey.getID(), eInteger, aValue );
+}
+
+bool Info::setDouble( const InfoKey& aKey, const double aValue ){
+    return setItemValueLocal( aKey.getID(), eDouble, aValue );
+}
+
+bool Info::setString( const InfoKey& aKey, const string& aValue ){
+    const string* value;
+    {
 #if GCAM_PARALLEL_ENABLED
-    // the lock on our local map is no longer needed.  Release before
-    // recursing into parent structures
-    readlock.release();
+        tbb::spin_mutex::scoped_lock lock( mWriteMutex );
 #endif
-    // If the value was not found, check the parent.
-    if( !currHasValue && mParentInfo ){
-        currHasValue = mParentInfo->hasValue( aStringKey );
+        // Previous values are kept since a reference to them may have been
+        // returned by getString.
+        mStringStore.push_back( aValue );
+        value = &mStringStore.back();
     }
-    return currHasValue;
+    return setItemValueLocal( aKey.getID(), eString, value );
+}
+
+bool Info::getBoolean( const InfoKey& aKey, const bool aMustExist ) const {
+    const Slot* slot = getTypedSlot( aKey.getID(), eBoolean, aMustExist, 0 );
+    return slot ? slot->mInteger.load() != 0 : false;
+}
+
+int Info::getInteger( const InfoKey& aKey, const bool aMustExist ) const {
+    const Slot* slot = getTypedSlot( aKey.getID(), eInteger, aMustExist, 0 );
+    return slot ? slot->mInteger.load() : 0;
+}
+
+double Info::getDouble( const InfoKey& aKey, const bool aMustExist ) const {
+    const Slot* slot = getTypedSlot( aKey.getID(), eDouble, aMustExist, 0 );
+    return slot ? slot->mDouble.load() : 0.0;
+}
+
+const string& Info::getString( const InfoKey& aKey, const bool aMustExist ) const {
+    const Slot* slot = getTypedSlot( aKey.getID(), eString, aMustExist, 0 );
+    return getStringValue( slot );
+}
+
+bool Info::hasValue( const InfoKey& aKey ) const {
+    return aKey.isValid() && resolveSlot( aKey.getID() );
 }
 
 void Info::toDebugXML( const int aperiod, Tabs* aTabs, ostream& aOut ) const {
-#if GCAM_PARALLEL_ENABLED
-    // get read lock for the info map
-    tbb::queuing_rw_mutex::scoped_lock readlock(mInfoMapMutex, false);
-#endif
     XMLWriteOpeningTag( "Info", aOut, aTabs );
-    for( InfoMap::const_iterator item = mInfoMap->begin(); item != mInfoMap->end(); ++item ){
+    for( SlotMap::const_iterator item = mSlots.begin(); item != mSlots.end(); ++item ){
+        const Slot* slot = item->second;
         XMLWriteOpeningTag( "Pair", aOut, aTabs );
-        XMLWriteElement( item->first, "Key", aOut, aTabs );
-        switch( item->second.first ){
+        XMLWriteElement( InfoKey::getName( item->first ), "Key", aOut, aTabs );
+        switch( static_cast<AnyType>( slot->mType.load() ) ){
             case eBoolean:
-                printItem<bool>( item->second.second, aOut, aTabs );
+                XMLWriteElement( slot->mInteger.load() != 0, "Value", aOut, aTabs );
                 break;
             case eInteger:
-                printItem<int>( item->second.second, aOut, aTabs );
+                XMLWriteElement( slot->mInteger.load(), "Value", aOut, aTabs );
                 break;
             case eDouble:
-                printItem<double>( item->second.second, aOut, aTabs );
+                XMLWriteElement( slot->mDouble.load(), "Value", aOut, aTabs );
                 break;
             case eString:
-                printItem<string>( item->second.second, aOut, aTabs );
+                XMLWriteElement( getStringValue( slot ), "Value", aOut, aTabs );
                 break;
             // No default so the compiler can flag omissions.
         }
@@ -261,18 +244,185 @@ void Info::toDebugXML( const int aperiod, Tabs* aTabs, ostream& aOut ) const {
     XMLWriteClosingTag( "Info", aOut, aTabs );
 }
 
-/*! \brief Return the initial size for the underlying hashmap.
-* \details Returns how many slots to allocate initially for the hashmap. The
-*          hashmap will increase in size if it gets too full, but the resize
-*          operation is slow and so should be avoided if possible. This number
-*          should also be prime to reduce the number of collisions in the
-*          hashmap.
-* \return The initial size of the underlying hashmap.
+/*! \brief Find the slot for a key in this Info only.
+* \param aKey An interned key.
+* \return The slot or null if the key has not been set in this Info.
+*/
+const Info::Slot* Info::findLocalSlot( const int aKey ) const {
+    SlotMap::const_iterator curr = mSlots.find( aKey );
+    return curr != mSlots.end() ? curr->second : 0;
+}
+
+/*! \brief Find the slot for a key in this Info or the closest ancestor which
+*          contains it.
+* \details Resolutions through the parent chain are cached and reused until a
+*          new slot is created anywhere in the model.  To allow readers to
+*          proceed without locking the cached entry is updated seqlock style:
+*          the generation is cleared while the slot is updated and a reader
+*          only uses the slot if it read the same, current generation before
+*          and after reading it.
+* \param aKey An interned key.
+* \return The slot or null if the key has not been set in this Info or any of
+*         its ancestors.
+*/
+const Info::Slot* Info::resolveSlot( const int aKey ) const {
+    const Slot* slot = findLocalSlot( aKey );
+    if( slot || !mParentInfo ){
+        return slot;
+    }
+
+    const unsigned int generation = sSlotGeneration.load();
+    ResolvedSlotMap::const_iterator cached = mResolvedSlots.find( aKey );
+    if( cached != mResolvedSlots.end() && cached->second->mGeneration.load() == generation ){
+        const Slot* cachedSlot = cached->second->mSlot.load();
+        if( cached->second->mGeneration.load() == generation ){
+            return cachedSlot;
+        }
+    }
+
+    // Walk the parent chain.  If a slot is created concurrently the generation
+    // read above will already be stale and so this result will not be reused.
+    for( const Info* curr = mParentInfo; curr && !slot; curr = curr->mParentInfo ){
+        slot = curr->findLocalSlot( aKey );
+    }
+
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lock( mWriteMutex );
+    // Another thread may have cached the key while we waited for the lock.
+    cached = mResolvedSlots.find( aKey );
+#endif
+    ResolvedSlot* resolved;
+    if( cached != mResolvedSlots.end() ){
+        resolved = cached->second;
+    }
+    else {
+        resolved = new ResolvedSlot();
+        mResolvedSlots.insert( make_pair( aKey, resolved ) );
+    }
+    resolved->mGeneration.store( 0 );
+    resolved->mSlot.store( slot );
+    resolved->mGeneration.store( generation );
+    return slot;
+}
+
+/*! \brief Set the value for a key in this Info, creating the slot if it does
+*          not exist.
+* \details If debug checking is turned on the type of an existing slot is
+*          checked against the new type and a new slot is checked for
+*          shadowing a value in a parent.  An update of an existing slot of the
+*          same type does not lock.
+* \param aKey An interned key.
+* \param aType The type of the value.
+* \param aValue The value to be associated with this key.
+*/
+template<class T>
+bool Info::setItemValueLocal( const int aKey, const AnyType aType, const T aValue ){
+    /*! \pre A valid key was passed. */
+    assert( aKey != InfoKey::INVALID_ID );
+
+    SlotMap::const_iterator curr = mSlots.find( aKey );
+    if( curr != mSlots.end() && curr->second->mType.load() == aType ){
+        storeValue( curr->second, aValue );
+        return true;
+    }
+
+    const static bool debugChecking = Configuration::getInstance()->getBool( "debugChecking" );
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lock( mWriteMutex );
+    // Another thread may have created the slot while we waited for the lock.
+    curr = mSlots.find( aKey );
+#endif
+    if( curr == mSlots.end() ){
+        if( debugChecking && mParentInfo && mParentInfo->resolveSlot( aKey ) ){
+            printShadowWarning( InfoKey::getName( aKey ) );
+        }
+        // Fully initialize the slot before publishing it so a reader never
+        // sees it without a value.
+        Slot* slot = new Slot( aType );
+        storeValue( slot, aValue );
+        mSlots.insert( make_pair( aKey, slot ) );
+        // The slot must be published before the generation changes, see
+        // resolveSlot.
+        ++sSlotGeneration;
+    }
+    else {
+        if( debugChecking && curr->second->mType.load() != aType ){
+            printBadCastWarning( InfoKey::getName( aKey ), true );
+        }
+        // Store the value regardless of whether a warning was printed.
+        storeValue( curr->second, aValue );
+        curr->second->mType.store( aType );
+    }
+    return true;
+}
+
+//! Store a boolean value in a slot.
+void Info::storeValue( Slot* aSlot, const bool aValue ){
+    aSlot->mInteger.store( aValue ? 1 : 0 );
+}
+
+//! Store an integer value in a slot.
+void Info::storeValue( Slot* aSlot, const int aValue ){
+    aSlot->mInteger.store( aValue );
+}
+
+//! Store a double value in a slot.
+void Info::storeValue( Slot* aSlot, const double aValue ){
+    aSlot->mDouble.store( aValue );
+}
+
+//! Store a string value, owned by mStringStore, in a slot.
+void Info::storeValue( Slot* aSlot, const string* aValue ){
+    aSlot->mString.store( aValue );
+}
+
+/*! \brief Find the slot for a key and check it holds the requested type.
+* \details A value of a different type does not hide a value of the requested
+*          type in an ancestor, so if the closest value is of the wrong type the
+*          search continues with the parents of the Info which holds it.
+* \param aKey An interned key which may be InfoKey::INVALID_ID.
+* \param aType The type of the value requested.
+* \param aMustExist Whether it is an error for the item to be missing.
+* \param aStringKey The string key used for warnings, or null to use the name
+*        of aKey.
+* \return The slot or null if no value of the requested type was found.
+*/
+const Info::Slot* Info::getTypedSlot( const int aKey, const AnyType aType,
+                                      const bool aMustExist, const string* aStringKey ) const
+{
+    const Slot* slot = aKey != InfoKey::INVALID_ID ? resolveSlot( aKey ) : 0;
+    if( slot && slot->mType.load() != aType ){
+        // This is not expected to be common so the chain is searched without
+        // the resolution cache.
+        slot = 0;
+        for( const Info* curr = this; curr && !slot; curr = curr->mParentInfo ){
+            const Slot* currSlot = curr->findLocalSlot( aKey );
+            if( currSlot && currSlot->mType.load() != aType ){
+                curr->printBadCastWarning( aStringKey ? *aStringKey : InfoKey::getName( aKey ), false );
+            }
+            else {
+                slot = currSlot;
+            }
+        }
+    }
+    if( !slot ){
+        // The item must exist and was not found or there was no parent to search.
+        if( aMustExist ){
+            printItemNotFoundWarning( aStringKey ? *aStringKey : InfoKey::getName( aKey ) );
+        }
+        return 0;
+    }
+    return slot;
+}
+
+/*! \brief Get the string stored in a slot.
+* \param aSlot A slot holding a string or null.
+* \return The string or the empty string if the slot is null.
 */
-size_t Info::getInitialSize() const {
-    // Medium size prime number.
-    const size_t INITIAL_SIZE = 29;
-    return INITIAL_SIZE;
+const string& Info::getStringValue( const Slot* aSlot ){
+    const string* value = aSlot ? aSlot->mString.load() : 0;
+    static const string defaultValue;
+    return value ? *value : defaultValue;
 }
 
 /*! \brief Print a warning message to the user that the item does not exist in
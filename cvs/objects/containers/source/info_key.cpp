@@ -0,0 +1,168 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file info_key.cpp
+ * \ingroup Objects
+ * \brief The InfoKey class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/concurrent_unordered_map.h>
+#include <tbb/concurrent_vector.h>
+#include <tbb/spin_mutex.h>
+#else
+#include <unordered_map>
+#include <deque>
+#endif
+
+#include "containers/include/info_key.h"
+
+using namespace std;
+
+namespace {
+    /*!
+     * \brief The global table of interned key names.
+     * \details Names are only ever appended so references to them, and the
+     *          slots assigned to them, remain valid for the life of the model.
+     *          In parallel builds lookups may proceed concurrently with an
+     *          intern which holds the mutex.
+     */
+    struct InfoKeyRegistry {
+#if GCAM_PARALLEL_ENABLED
+        tbb::concurrent_unordered_map<string, int> mIDs;
+        tbb::concurrent_vector<string> mNames;
+        tbb::spin_mutex mMutex;
+#else
+        unordered_map<string, int> mIDs;
+        deque<string> mNames;
+#endif
+    };
+
+    InfoKeyRegistry& getRegistry() {
+        static InfoKeyRegistry registry;
+        return registry;
+    }
+}
+
+//! Default constructor which creates an invalid key.
+InfoKey::InfoKey():
+mID( INVALID_ID )
+{
+}
+
+/*!
+ * \brief Constructor which interns the given name.
+ * \param aName The key name.
+ */
+InfoKey::InfoKey( const string& aName ):
+mID( intern( aName ) )
+{
+}
+
+/*!
+ * \brief Get the name this key was interned from.
+ * \return The key name.
+ */
+const string& InfoKey::getName() const {
+    return getName( mID );
+}
+
+/*!
+ * \brief Get the slot for a name, assigning a new one if the name has not yet
+ *        been seen.
+ * \param aName The key name.
+ * \return The slot for the name.
+ */
+int InfoKey::intern( const string& aName ) {
+    /*! \pre A valid key was passed. */
+    assert( !aName.empty() );
+
+    const int existingID = find( aName );
+    if( existingID != INVALID_ID ) {
+        return existingID;
+    }
+
+    InfoKeyRegistry& registry = getRegistry();
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lock( registry.mMutex );
+    // Another thread may have interned the name while we waited for the lock.
+    auto curr = registry.mIDs.find( aName );
+    if( curr != registry.mIDs.end() ) {
+        return curr->second;
+    }
+#endif
+    // The name must be stored before the slot is published so that a
+    // concurrent lookup of the slot's name never reads past the end.
+    const int newID = static_cast<int>( registry.mNames.size() );
+    registry.mNames.push_back( aName );
+    registry.mIDs.insert( make_pair( aName, newID ) );
+    return newID;
+}
+
+/*!
+ * \brief Get the slot for a name without interning it.
+ * \param aName The key name.
+ * \return The slot for the name or INVALID_ID if it has never been interned.
+ */
+int InfoKey::find( const string& aName ) {
+    const InfoKeyRegistry& registry = getRegistry();
+    auto curr = registry.mIDs.find( aName );
+    return curr != registry.mIDs.end() ? curr->second : INVALID_ID;
+}
+
+/*!
+ * \brief Get the name for an interned slot.
+ * \param aID An interned slot.
+ * \return The name the slot was interned from or the empty string if it is
+ *         not valid.
+ */
+const string& InfoKey::getName( const int aID ) {
+    const InfoKeyRegistry& registry = getRegistry();
+    if( aID < 0 || aID >= static_cast<int>( registry.mNames.size() ) ) {
+        static const string EMPTY;
+        return EMPTY;
+    }
+    return registry.mNames[ aID ];
+}
+
+/*!
+ * \brief Get the number of names interned so far.
+ * \return The number of interned keys.
+ */
+int InfoKey::getNumKeys() {
+    return static_cast<int>( getRegistry().mNames.size() );
+}
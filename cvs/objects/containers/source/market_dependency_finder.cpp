@@ -40,6 +40,7 @@
 
 #include "util/base/include/definitions.h"
 #include <cassert>
+#include <map>
 #include "containers/include/market_dependency_finder.h"
 #include "util/logger/include/ilogger.h"
 #include "marketplace/include/marketplace.h"
@@ -50,7 +51,14 @@
 #include "containers/include/iactivity.h"
 
 #if GCAM_PARALLEL_ENABLED
+#include <fstream>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
 #include "parallel/include/gcam_parallel.hpp"
+#include "util/base/include/configuration.h"
+#include "util/base/include/util.h"
+#include "util/base/include/activity_profiler.h"
 #endif
 
 using namespace std;
@@ -62,7 +70,8 @@ using namespace std;
 MarketDependencyFinder::MarketDependencyFinder( Marketplace* aMarketplace ):
 mMarketplace( aMarketplace ), mCalcVertexUIDCount( 0 )
 #if GCAM_PARALLEL_ENABLED
-,mTBBGraphGlobal( 0 )
+,mTBBGraphGlobal( 0 ),
+mGrainSchedule( 0 )
 #endif
 {
 }
@@ -78,6 +87,8 @@ MarketDependencyFinder::~MarketDependencyFinder() {
     }
 #if GCAM_PARALLEL_ENABLED
     delete mTBBGraphGlobal;
+    ActivityProfiler::getInstance().setGrainSchedule( 0, 0 );
+    delete mGrainSchedule;
     for( CMarketToDepIterator it = mMarketsToDep.begin(); it != mMarketsToDep.end(); ++it ) {
         delete (*it)->mFlowGraph;
     }
@@ -207,55 +218,32 @@ const vector<IActivity*> MarketDependencyFinder::getOrdering( const int aMarketN
         return mGlobalOrdering;
     }
     else {
-        // Find the entry points into the graph for the given market.
-        auto_ptr<MarketToDependencyItem> marketToDep( new MarketToDependencyItem( aMarketNumber ) );
-        CMarketToDepIterator mrktIter = mMarketsToDep.find( marketToDep.get() );
-        if( mrktIter == mMarketsToDep.end() ) {
-            // Somehow this market was not linked to any entry points into the graph.
-            ILogger& mainLog = ILogger::getLogger( "main_log" );
-            mainLog.setLevel( ILogger::ERROR );
-            mainLog << "Could not find market: " << mMarketplace->mMarkets[ aMarketNumber ]->getName()
-                    << " to get an ordering for." << endl;
-            exit( 1 );
-        }
-
-        // First check the MarketToDependencyItem and see if we have this cached.
-        if( !(*mrktIter)->mCalcList.empty() ) {
-            return (*mrktIter)->mCalcList;
-        }
-
-        // We must generate the full list of nodes to calculate.  The createOrdering
-        // method has created a link from markets to "entry points" into the graph.
-        // We must then do a search on the graph from those entry points to come up
-        // with a full set of items which must be recalculated.
-        // To ensure the set of items are in order we can utilize the already created
-        // global ordering.
-        
-        
-        // Do a search from all of the entry points to get a set of unique items
-        // to calculate.
-        set<IActivity*> dependenentCalcs;
-        typedef set<CalcVertex*>::const_iterator CVertexIterator;
-        for( CVertexIterator it = (*mrktIter)->mImpliedVertices.begin(); it != (*mrktIter)->mImpliedVertices.end(); ++it ) {
-            findVerticesToCalculate( *it, dependenentCalcs );
-        }
-        
-        // Loop over the global ordering and move an item from the dependenentCalcs
-        // into the ordered list to return should it exist in dependenentCalcs.
+        // Expand the calculation mask into an in-order list.  Note callers which
+        // are performance sensitive should use getCalcMask directly instead.
+        const bitvector& calcMask = getCalcMask( aMarketNumber );
         vector<IActivity*> orderedListForMarket;
-        for( vector<IActivity*>::const_iterator it = mGlobalOrdering.begin(); it != mGlobalOrdering.end(); ++it ) {
-            set<IActivity*>::iterator dependIter = dependenentCalcs.find( *it );
-            if( dependIter != dependenentCalcs.end() ) {
-                orderedListForMarket.push_back( *dependIter );
-                dependenentCalcs.erase( dependIter );
-            }
+        orderedListForMarket.reserve( calcMask.count() );
+        bitvector_iterator it( &calcMask );
+        while( it.next() ) {
+            orderedListForMarket.push_back( mGlobalOrdering[ it.bindex() ] );
         }
-        // Go ahead and cache this list so we do not need to calculate it again.
-        (*mrktIter)->mCalcList = orderedListForMarket;
         return orderedListForMarket;
     }
 }
 
+/*!
+ * \brief Get the set of activities which would be affected by the given market
+ *        changing it's price.
+ * \details The set is a bitvector over the global ordering, so iterating over the
+ *          set bits will visit the affected activities in order.
+ * \param aMarketNumber The market number to get the affected activities for.
+ * \return The set of activities to calculate for the given market.  Note the
+ *         returned reference is valid for the lifetime of this object.
+ */
+const bitvector& MarketDependencyFinder::getCalcMask( const int aMarketNumber ) const {
+    return (*findMarketToDep( aMarketNumber ))->mCalcMask;
+}
+
 #if GCAM_PARALLEL_ENABLED
 /*!
  * \brief Get flow graph which can be used to calculate the model in parallel.
@@ -263,7 +251,8 @@ const vector<IActivity*> MarketDependencyFinder::getOrdering( const int aMarketN
  *          graph which will calculate all objects in the model is returned.
  *          When a valid market number is given the flow graph of activities which
  *          would be affected by that market changing it's price would be generated
- *          and returned.
+ *          and returned.  All flow graphs are created from a single grain schedule
+ *          for the full model so that only a single graph analysis is required.
  * \param aMarketNumber The market number to get a flow graph of items which
  *                      are required to be calculated if that market changes prices,
  *                      or if -1 the full global list.
@@ -271,99 +260,217 @@ const vector<IActivity*> MarketDependencyFinder::getOrdering( const int aMarketN
  *         Note the caller is not responsible for the returned memory.
  */
 GcamFlowGraph* MarketDependencyFinder::getFlowGraph( const int aMarketNumber ) {
+    if( !mGrainSchedule ) {
+        createGrainSchedule();
+    }
+    
     if( aMarketNumber == -1 ) {
         if( !mTBBGraphGlobal ) {
-            // reads parameters from the global configuration
-            GcamParallel config;
-            GcamParallel::FlowGraph gcamFlowGraph;
-            GcamParallel::FlowGraph grainGraph;
-
-            // convert dependency table to flow graph 
-            config.makeGCAMFlowGraph( *this, gcamFlowGraph );
-            // parse flow graph
-            config.graphParseGrainCollect( gcamFlowGraph, grainGraph ); 
-            if( !gcamFlowGraph.topology_valid() ) {
-                ILogger& mainLog = ILogger::getLogger( "main_log" );
-                mainLog.setLevel( ILogger::ERROR );
-                mainLog << "Topological indices not computed." << endl;
-                abort();
-            }
             // build the tbb graph structure
+            GcamParallel config;
             mTBBGraphGlobal = new GcamFlowGraph();
-            config.makeTBBFlowGraph( grainGraph, gcamFlowGraph, *mTBBGraphGlobal ); 
+            config.makeTBBFlowGraph( *mGrainSchedule, mGlobalOrdering, 0, *mTBBGraphGlobal );
         }
         return mTBBGraphGlobal;
     }
     else {
-        // Find the entry points into the graph for the given market.
-        auto_ptr<MarketToDependencyItem> marketToDep( new MarketToDependencyItem( aMarketNumber ) );
-        CMarketToDepIterator mrktIter = mMarketsToDep.find( marketToDep.get() );
-        if( mrktIter == mMarketsToDep.end() ) {
-            // Somehow this market was not linked to any entry points into the graph.
-            ILogger& mainLog = ILogger::getLogger( "main_log" );
-            mainLog.setLevel( ILogger::ERROR );
-            mainLog << "Could not find market: " << mMarketplace->mMarkets[ aMarketNumber ]->getName()
-                    << " to get an ordering for." << endl;
-            exit( 1 );
-        }
+        CMarketToDepIterator mrktIter = findMarketToDep( aMarketNumber );
 
         // First check the MarketToDependencyItem and see if we have this cached.
-        if( (*mrktIter)->mFlowGraph ) {
-            return (*mrktIter)->mFlowGraph;
+        if( !(*mrktIter)->mFlowGraph ) {
+            (*mrktIter)->mFlowGraph = createMarketFlowGraph( aMarketNumber );
         }
+        return (*mrktIter)->mFlowGraph;
+    }
+}
 
-        // We must generate the flow graph following the same procedure as the global graph.
-        // It may be a good idea to make some of these tempararies members to avoid recalculating
-        // them over and over.
-        GcamParallel config;
-        GcamParallel::FlowGraph gcamFlowGraph;
-        GcamParallel::FlowGraph grainGraph;
-        
-        // convert dependency table to flow graph
-        config.makeGCAMFlowGraph( *this, gcamFlowGraph );
-        // Parse flow graph subsetting for only the activities effected.  Use getOrdering
-        // to get this list incase it has not yet been calculated.
-        config.graphParseGrainCollect( gcamFlowGraph, grainGraph, getOrdering( aMarketNumber ) );
-        if( !gcamFlowGraph.topology_valid() ) {
+/*!
+ * \brief Create the flow graphs for the given markets in parallel.
+ * \details Flow graphs which have already been created are skipped.  This allows
+ *          callers which know they will need flow graphs for many markets to
+ *          create them all at once rather than one at a time as they are needed.
+ * \param aMarketNumbers The market numbers to create flow graphs for.
+ */
+void MarketDependencyFinder::buildFlowGraphs( const vector<int>& aMarketNumbers ) {
+    if( !mGrainSchedule ) {
+        createGrainSchedule();
+    }
+    
+    vector<MarketToDependencyItem*> toBuild;
+    for( vector<int>::const_iterator it = aMarketNumbers.begin(); it != aMarketNumbers.end(); ++it ) {
+        CMarketToDepIterator mrktIter = findMarketToDep( *it );
+        if( !(*mrktIter)->mFlowGraph && find( toBuild.begin(), toBuild.end(), *mrktIter ) == toBuild.end() ) {
+            toBuild.push_back( *mrktIter );
+        }
+    }
+    
+    // Each market writes only to it's own MarketToDependencyItem and the grain
+    // schedule is only read so this is safe to do in parallel.
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, toBuild.size() ),
+        [this, &toBuild]( const tbb::blocked_range<size_t>& aRange ) {
+            for( size_t i = aRange.begin(); i != aRange.end(); ++i ) {
+                toBuild[ i ]->mFlowGraph = createMarketFlowGraph( toBuild[ i ]->mMarket );
+            }
+        } );
+}
+
+/*!
+ * \brief Create the grain schedule for the full model.
+ * \details The flow graph for the full model is parsed and collected into grains
+ *          only once.  If the "parallel-grain-cache" file is enabled the schedule
+ *          is read from that file when it was created for the same dependency
+ *          structure, otherwise it is created and then written to it.
+ */
+void MarketDependencyFinder::createGrainSchedule() {
+    const Configuration* conf = Configuration::getInstance();
+    const bool useCache = conf->shouldWriteFile( "parallel-grain-cache", false, false );
+    const string cacheFileName = conf->getFile( "parallel-grain-cache", "gcam-grain-cache.txt", false );
+    
+    // reads parameters from the global configuration
+    GcamParallel config;
+    mGrainSchedule = new GrainSchedule();
+    ActivityProfiler::getInstance().setGrainSchedule( mGrainSchedule, &mGlobalOrdering );
+    if( useCache ) {
+        ifstream cacheFile( cacheFileName.c_str() );
+        if( cacheFile && config.readGrainSchedule( cacheFile, *this, mGlobalOrdering, *mGrainSchedule ) ) {
             ILogger& mainLog = ILogger::getLogger( "main_log" );
-            mainLog.setLevel( ILogger::ERROR );
-            mainLog << "Topological indices not computed." << endl;
-            abort();
+            mainLog.setLevel( ILogger::NOTICE );
+            mainLog << "Read parallel grain schedule from " << cacheFileName << endl;
+            return;
         }
-        // build the tbb graph structure
-        (*mrktIter)->mFlowGraph = new GcamFlowGraph();
-        config.makeTBBFlowGraph( grainGraph, gcamFlowGraph, *(*mrktIter)->mFlowGraph );
-        return (*mrktIter)->mFlowGraph;
+    }
+    
+    GcamParallel::FlowGraph gcamFlowGraph;
+    GcamParallel::FlowGraph grainGraph;
+    
+    // convert dependency table to flow graph 
+    config.makeGCAMFlowGraph( *this, gcamFlowGraph );
+    // parse flow graph
+    config.graphParseGrainCollect( gcamFlowGraph, grainGraph ); 
+    if( !gcamFlowGraph.topology_valid() ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::ERROR );
+        mainLog << "Topological indices not computed." << endl;
+        abort();
+    }
+    config.makeGrainSchedule( grainGraph, mGlobalOrdering, *mGrainSchedule );
+    
+    if( useCache ) {
+        ofstream cacheFile( cacheFileName.c_str() );
+        util::checkIsOpen( cacheFile, cacheFileName );
+        config.writeGrainSchedule( cacheFile, *this, mGlobalOrdering, *mGrainSchedule );
     }
 }
+
+/*!
+ * \brief Create the flow graph of activities affected by a change in the price
+ *        of the given market.
+ * \details The flow graph is created by masking the grain schedule for the full
+ *          model with the market's calculation mask.
+ * \param aMarketNumber The market number to create a flow graph for.
+ * \return The newly created flow graph which the caller is responsible for.
+ * \pre The grain schedule has been created.
+ */
+GcamFlowGraph* MarketDependencyFinder::createMarketFlowGraph( const int aMarketNumber ) const {
+    GcamParallel config;
+    GcamFlowGraph* flowGraph = new GcamFlowGraph();
+    config.makeTBBFlowGraph( *mGrainSchedule, mGlobalOrdering, &getCalcMask( aMarketNumber ), *flowGraph );
+    return flowGraph;
+}
 #endif
 
 /*!
- * \brief A depth first search collecting a unique set of the vertices visited.
- * \details Recursively search for vertices.  The end points for recursion are if
- *          at vertices which have already been found or that have no out edges.
- * \param aVertex The current vertex being visited.
- * \param aVisited The set of vertices which have already been visited.
+ * \brief Find the link between the given market and the vertices in the graph
+ *        it affects.
+ * \details If the market was not linked to any vertices an error is logged and
+ *          the model will exit.
+ * \param aMarketNumber The market number to find.
+ * \return An iterator to the MarketToDependencyItem for the market.
  */
-void MarketDependencyFinder::findVerticesToCalculate( CalcVertex* aVertex, std::set<IActivity*>& aVisited ) const {
-    // Attempt to add the current vertex to the list of visited vertices.
-    if( !aVisited.insert( aVertex->mCalcItem ).second ) {
-        // Already processed this subgraph so no need to continue search from
-        // here.
+MarketDependencyFinder::CMarketToDepIterator MarketDependencyFinder::findMarketToDep( const int aMarketNumber ) const {
+    MarketToDependencyItem marketToDep( aMarketNumber );
+    CMarketToDepIterator mrktIter = mMarketsToDep.find( &marketToDep );
+    if( mrktIter == mMarketsToDep.end() ) {
+        // Somehow this market was not linked to any entry points into the graph.
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::ERROR );
+        mainLog << "Could not find market: " << mMarketplace->mMarkets[ aMarketNumber ]->getName()
+                << " to get an ordering for." << endl;
+        exit( 1 );
+    }
+    return mrktIter;
+}
+
+/*!
+ * \brief Create the set of activities which must be recalculated when each solved
+ *        market changes it's price.
+ * \details The sets are created for all markets at once by sweeping through the
+ *          activities in global order and passing the set of markets which affect
+ *          each activity along to it's dependents (including any implied vertices
+ *          which is a special case for the land-allocator).  Implied vertices may
+ *          come earlier in the global ordering in which case the sweep is repeated
+ *          until nothing changes.  The result is then transposed into a bitvector
+ *          over the global ordering for each market.
+ */
+void MarketDependencyFinder::createCalcMasks() {
+    if( mMarketsToDep.empty() ) {
         return;
     }
     
-    // Visit all vertices along the out edges from aVertex.
-    typedef vector<CalcVertex*>::const_iterator CVertexIterator;
-    for( CVertexIterator it = aVertex->mOutEdges.begin(); it != aVertex->mOutEdges.end(); ++it ) {
-        findVerticesToCalculate( *it, aVisited );
+    const size_t numActivities = mGlobalOrdering.size();
+    map<IActivity*, int> orderingIndex;
+    for( size_t i = 0; i < numActivities; ++i ) {
+        orderingIndex[ mGlobalOrdering[ i ] ] = i;
     }
-
-    // Add any implied in edges that should be calculated (special case for the
-    // land-allocator).
-    typedef set<CalcVertex*>::const_iterator CImpVertexIterator;
-    for( CImpVertexIterator it = aVertex->mImpliedInEdges.begin(); it != aVertex->mImpliedInEdges.end(); ++it ) {
-        findVerticesToCalculate( *it, aVisited );
+    vector<CalcVertex*> vertices( numActivities, 0 );
+    for( CItemIterator itemIter = mDependencyItems.begin(); itemIter != mDependencyItems.end(); ++itemIter ) {
+        for( CVertexIterator it = (*itemIter)->mPriceVertices.begin(); it != (*itemIter)->mPriceVertices.end(); ++it ) {
+            vertices[ orderingIndex[ (*it)->mCalcItem ] ] = *it;
+        }
+        for( CVertexIterator it = (*itemIter)->mDemandVertices.begin(); it != (*itemIter)->mDemandVertices.end(); ++it ) {
+            vertices[ orderingIndex[ (*it)->mCalcItem ] ] = *it;
+        }
+    }
+    
+    // Mark the entry points into the graph for each market.
+    vector<MarketToDependencyItem*> markets( mMarketsToDep.begin(), mMarketsToDep.end() );
+    vector<bitvector> affectedBy( numActivities, bitvector( markets.size() ) );
+    for( size_t marketIndex = 0; marketIndex < markets.size(); ++marketIndex ) {
+        const set<CalcVertex*>& entryPoints = markets[ marketIndex ]->mImpliedVertices;
+        for( set<CalcVertex*>::const_iterator it = entryPoints.begin(); it != entryPoints.end(); ++it ) {
+            affectedBy[ orderingIndex[ (*it)->mCalcItem ] ].set( marketIndex );
+        }
+    }
+    
+    bool changed = true;
+    while( changed ) {
+        changed = false;
+        for( size_t i = 0; i < numActivities; ++i ) {
+            if( !vertices[ i ] || affectedBy[ i ].empty() ) {
+                continue;
+            }
+            vector<CalcVertex*> dependents( vertices[ i ]->mOutEdges );
+            dependents.insert( dependents.end(), vertices[ i ]->mImpliedInEdges.begin(), vertices[ i ]->mImpliedInEdges.end() );
+            for( CVertexIterator it = dependents.begin(); it != dependents.end(); ++it ) {
+                const size_t depIndex = orderingIndex[ (*it)->mCalcItem ];
+                if( !affectedBy[ i ].subset( affectedBy[ depIndex ] ) ) {
+                    affectedBy[ depIndex ].setunion( affectedBy[ i ] );
+                    // Only need another sweep if we have updated an activity we
+                    // have already passed.
+                    changed = changed || depIndex <= i;
+                }
+            }
+        }
+    }
+    
+    for( size_t marketIndex = 0; marketIndex < markets.size(); ++marketIndex ) {
+        markets[ marketIndex ]->mCalcMask = bitvector( numActivities );
+    }
+    for( size_t i = 0; i < numActivities; ++i ) {
+        bitvector_iterator it( &affectedBy[ i ] );
+        while( it.next() ) {
+            markets[ it.bindex() ]->mCalcMask.set( i );
+        }
     }
 }
 
@@ -726,6 +833,8 @@ void MarketDependencyFinder::createOrdering() {
     for( vector<IActivity*>::iterator it = mGlobalOrdering.begin(); it != mGlobalOrdering.end(); ++it ) {
         depLog << "- " << (*it)->getDescription() << endl;
     }
+    
+    createCalcMasks();
 }
 
 /*!
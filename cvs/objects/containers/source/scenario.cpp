@@ -40,6 +40,7 @@
 
 #include "util/base/include/definitions.h"
 #include <string>
+#include <algorithm>
 #include <fstream>
 #include <cassert>
 #include <ctime>
@@ -58,6 +59,7 @@
 #include "solution/solvers/include/solver.h"
 #include "util/base/include/auto_file.h"
 #include "util/base/include/timer.h"
+#include "util/base/include/activity_profiler.h"
 #include "reporting/include/graph_printer.h"
 #include "reporting/include/land_allocator_printer.h"
 #include "containers/include/output_meta_data.h"
@@ -305,8 +307,19 @@ bool Scenario::run( const int aSinglePeriod,
                     const bool aPrintDebugging,
                     const string& aFilenameEnding )
 {
-    // Avoid accumulating unsolved periods.
-    mUnsolvedPeriods.clear();
+    // Avoid accumulating unsolved periods.  When running a single period the
+    // periods which are still valid will not be recalculated so they keep
+    // their status.
+    if( aSinglePeriod == RUN_ALL_PERIODS ) {
+        mUnsolvedPeriods.clear();
+    }
+    else {
+        mUnsolvedPeriods.erase( remove_if( mUnsolvedPeriods.begin(), mUnsolvedPeriods.end(),
+                                           [&]( const int aPeriod ) {
+                                               return aPeriod >= aSinglePeriod || !mIsValidPeriod[ aPeriod ];
+                                           } ),
+                                mUnsolvedPeriods.end() );
+    }
     
     // Open the debugging files.
     AutoOutputFile XMLDebugFile( "xmlDebugFileName", "debug.xml", aPrintDebugging );
@@ -381,6 +394,8 @@ bool Scenario::run( const int aSinglePeriod,
 
     mainLog.setLevel( ILogger::DEBUG );
     fullScenarioTimer.stop();
+    // Resolve profiled activities to their descriptions while they still exist.
+    ActivityProfiler::getInstance().flush();
     TimerRegistry::getInstance().printAllTimers( mainLog );
 
     // Run the climate model.
@@ -397,22 +412,13 @@ bool Scenario::run( const int aSinglePeriod,
     return success;
 }
 
-/*! \brief Calculate a single period.
-* \param aPeriod Period to calculate.
-* \param aXMLDebugFile XML debugging file.
-* \param aSGMDebugFile SGM debugging file.
-* \param aTabs Tabs formatting object.
-* \param aPrintDebugging Whether to print debugging information.
-* \return Whether the period was calculated successfully.
+/*! \brief Initialize a period so that it is ready to be calculated.
+* \details Initializes the markets and the world for the period and sets up
+*          the state data for the period.  Supplies and demands are not yet
+*          calculated.
+* \param aPeriod Period to initialize.
 */
-bool Scenario::calculatePeriod( const int aPeriod,
-                                ostream& aXMLDebugFile,
-                                ostream& aSGMDebugFile,
-                                Tabs* aTabs,
-                                bool aPrintDebugging )
-{
-    logPeriodBeginning( aPeriod );
-
+void Scenario::initPeriod( const int aPeriod ) {
     // If this is period 0 initialize market price.
     if( aPeriod == 0 ){
         mMarketplace->initPrices(); // initialize prices
@@ -438,6 +444,25 @@ bool Scenario::calculatePeriod( const int aPeriod,
     if( aPeriod == 0 ){
         mMarketplace->nullSuppliesAndDemands( aPeriod );
     }
+}
+
+/*! \brief Calculate a single period.
+* \param aPeriod Period to calculate.
+* \param aXMLDebugFile XML debugging file.
+* \param aSGMDebugFile SGM debugging file.
+* \param aTabs Tabs formatting object.
+* \param aPrintDebugging Whether to print debugging information.
+* \return Whether the period was calculated successfully.
+*/
+bool Scenario::calculatePeriod( const int aPeriod,
+                                ostream& aXMLDebugFile,
+                                ostream& aSGMDebugFile,
+                                Tabs* aTabs,
+                                bool aPrintDebugging )
+{
+    logPeriodBeginning( aPeriod );
+
+    initPeriod( aPeriod );
 
 #if GCAM_PARALLEL_ENABLED && PARALLEL_DEBUG
     mWorld->calc( aPeriod );       // get rid of transient bad data
@@ -641,8 +666,9 @@ void Scenario::printGraphs( const int aPeriod ) const {
     // Create a graph printer.
     GraphPrinter graphPrinter( regionToGraph, *graphStream );
     
-    // Update the graph printer with information from the model.
-    accept( &graphPrinter, aPeriod );
+    // Update the graph printer with information from the model.  Only the
+    // graphed region needs to be visited.
+    mWorld->acceptRegion( regionToGraph, &graphPrinter, aPeriod );
     
     // Print the graph.
     graphPrinter.finish();
@@ -662,8 +688,9 @@ void Scenario::printLandAllocatorGraph( const int aPeriod, const bool aPrintValu
     LandAllocatorPrinter landAllocatorPrinter( regionToGraph, *landAllocatorStream,
                                                aPrintValues, true );
 
-    // Update the land allocator printer with information from the model.
-    accept( &landAllocatorPrinter, aPeriod );
+    // Update the land allocator printer with information from the model.  Only
+    // the graphed region needs to be visited.
+    mWorld->acceptRegion( regionToGraph, &landAllocatorPrinter, aPeriod );
 
     // Print the graph.
     landAllocatorPrinter.finish();
@@ -880,6 +907,16 @@ void Scenario::invalidatePeriod( const int aPeriod ) {
     mIsValidPeriod[ aPeriod ] = false;
 }
 
+/*!
+ * \brief Switch the climate emulator on or off.
+ * \param aEmulate Whether to emulate the climate model.
+ * \return Whether the climate model is now emulated.
+ * \sa World::setClimateEmulation
+ */
+bool Scenario::setClimateEmulation( const bool aEmulate ) {
+    return mWorld->setClimateEmulation( aEmulate );
+}
+
 /*!
  * \brief Get a reference to the object responsible for managing state.
  * \return The ManageStateVariables object.
@@ -84,7 +84,9 @@ SectorActivity::~SectorActivity() {
 void SectorActivity::setPrices( const int aPeriod ) {
     const bool calibrationPeriod = aPeriod <= scenario->getModeltime()->getFinalCalibrationPeriod();
     static const bool calibrationActive = Configuration::getInstance()->getBool( "CalibrationActive" );
-    if( calibrationActive && calibrationPeriod ) {
+    if( calibrationActive && calibrationPeriod && !mSector->calibrateShareWeights( mGDP, aPeriod ) ) {
+        // The sector did not prepare a calibration plan for this period so
+        // fall back to finding the calibration values by visiting the sector.
         CalibrateShareWeightVisitor calibrator( mRegionName, mGDP );
         mSector->accept( &calibrator, aPeriod );
     }
@@ -108,6 +110,14 @@ string SectorActivity::getDescription() const {
     return mRegionName + " " + mSector->getName();
 }
 
+/*!
+ * \brief Get the sector which is calculated by both the price and demand activity.
+ * \return The wrapped sector.
+ */
+const void* SectorActivity::getCalcObject() const {
+    return mSector;
+}
+
 /*!
  * \brief Get the activity that will calculate the prices of this sector.
  * \return The associated price activity.
@@ -148,6 +158,10 @@ string SectorPriceActivity::getDescription() const {
     return mSectorActivity->getDescription() + " Price";
 }
 
+const void* SectorPriceActivity::getCalcObject() const {
+    return mSectorActivity->getCalcObject();
+}
+
 /*!
  * \brief Constructor linking back to the sector activity which will do the work.
  * \param aSectorActivity The shared sector activity.
@@ -171,3 +185,7 @@ void SectorDemandActivity::calc( const int aPeriod ) {
 string SectorDemandActivity::getDescription() const {
     return mSectorActivity->getDescription() + " Demand";
 }
+
+const void* SectorDemandActivity::getCalcObject() const {
+    return mSectorActivity->getCalcObject();
+}
@@ -44,6 +44,7 @@
 #include "containers/include/single_scenario_runner.h"
 #include "containers/include/scenario.h"
 #include "util/base/include/xml_helper.h"
+#include "util/base/include/xml_component_loader.h"
 #include "util/base/include/configuration.h"
 #include "util/base/include/timer.h"
 #include "util/base/include/configuration.h"
@@ -51,6 +52,7 @@
 #include "util/logger/include/ilogger.h"
 #include "util/logger/include/logger_factory.h"
 #include "reporting/include/xml_db_outputter.h"
+#include "solution/util/include/solver_warm_start_store.h"
 
 using namespace std;
 using namespace xercesc;
@@ -126,23 +128,23 @@ bool SingleScenarioRunner::setupScenarios( Timer& timer,
 	{
         scenComponents.push_back( *curr );
     }
+
+    // Solver warm starts may only be shared between scenarios built from the
+    // same components.
+    SolverWarmStartStore::getInstance().setScenarioComponents( scenComponents );
     
-    // Iterate over the vector.
-    typedef list<string>::const_iterator ScenCompIter;
-    ILogger& mainLog = ILogger::getLogger( "main_log" );
-    for( ScenCompIter currComp = scenComponents.begin();
-		 currComp != scenComponents.end(); ++currComp )
-	{
-        mainLog.setLevel( ILogger::NOTICE );
-        mainLog << "Parsing " << *currComp << " scenario component." << endl;
-        success = XMLHelper<void>::parseXML( *currComp, mScenario.get() );
-        
-        // Check if parsing succeeded.
-        if( !success ){
-            return false;
-        }
+    // Parse the scenario components, concurrently if possible, and apply them
+    // in order.  Schema validation may be skipped for trusted inputs.
+    success = XMLComponentLoader::parseXMLFiles( scenComponents, mScenario.get(),
+                                                 !conf->getBool( "skip-xml-validation" ) );
+    
+    // Check if parsing succeeded.
+    if( !success ){
+        return false;
     }
     
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    
     // Override scenario name from data file with that from configuration file
     const string overrideName = conf->getString( "scenarioName" ) + aName;
     if ( !overrideName.empty() ) {
@@ -40,6 +40,7 @@
 
 #include "util/base/include/definitions.h"
 #include "util/base/include/timer.h"
+#include "util/base/include/activity_profiler.h"
 
 #include <string>
 #include <cassert>
@@ -67,10 +68,12 @@
 #include "solution/util/include/calc_counter.h"
 #include "util/logger/include/ilogger.h"
 #include "util/base/include/ivisitor.h"
+#include "util/base/include/ishardable_visitor.h"
 #include "climate/include/iclimate_model.h"
 // Could hide with a factory method.
 #include "climate/include/magicc_model.h"
 #include "climate/include/hector_model.hpp"
+#include "climate/include/climate_emulator.h"
 #include "emissions/include/emissions_summer.h"
 #include "emissions/include/luc_emissions_summer.h"
 #include "technologies/include/global_technology_database.h"
@@ -78,9 +81,12 @@
 #include "containers/include/market_dependency_finder.h"
 #include "technologies/include/global_technology_database.h"
 #include "containers/include/iactivity.h"
+#include "parallel/include/bitvector.hpp"
 
 #if GCAM_PARALLEL_ENABLED
 #include "parallel/include/gcam_parallel.hpp"
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
 #endif
 
 // Uncommenting the following two lines will turn on floating-point exceptions within World::calc(),
@@ -99,6 +105,7 @@ extern Scenario* scenario;
 World::World()
 {
     mClimateModel = 0;
+    mClimateEmulator = 0;
     mCalcCounter = new CalcCounter();
     mGlobalTechDB = new GlobalTechnologyDatabase();
 }
@@ -113,6 +120,7 @@ void World::clear(){
     for ( RegionIterator regionIter = mRegions.begin(); regionIter != mRegions.end(); regionIter++ ) {
         delete *regionIter;
     }
+    delete mClimateEmulator;
     delete mClimateModel;
     delete mCalcCounter;
     delete mGlobalTechDB;
@@ -175,6 +183,12 @@ void World::completeInit() {
     
     // Initialize Climate Model
     mClimateModel->completeInit( scenario->getName() );
+
+    // Optionally wrap the climate model in an emulator which the target finder
+    // can use to avoid running the full climate model in each iteration.
+    if( Configuration::getInstance()->getBool( "climate-emulator", false ) ) {
+        mClimateEmulator = new ClimateEmulator( mClimateModel );
+    }
     
     // Finish initializing all the regions.
     for( RegionIterator regionIter = mRegions.begin(); regionIter != mRegions.end(); regionIter++ ) {
@@ -337,8 +351,58 @@ void World::calc( const int aPeriod, const std::vector<IActivity*>& aItemsToCalc
     mCalcCounter->incrementCount( static_cast<double>( aItemsToCalc.size() ) / static_cast<double>( mGlobalOrdering.size() ) );
     
     // Perform calculation on each item to calculate. 
-    for( vector<IActivity*>::const_iterator it = aItemsToCalc.begin(); it != aItemsToCalc.end(); ++it ) {
-        (*it)->calc( aPeriod );
+    ActivityProfiler& profiler = ActivityProfiler::getInstance();
+    if( profiler.isEnabled() ) {
+        profiler.startCalc( aPeriod, false );
+        for( vector<IActivity*>::const_iterator it = aItemsToCalc.begin(); it != aItemsToCalc.end(); ++it ) {
+            profiler.calcActivity( *it, aPeriod );
+        }
+        profiler.endCalc();
+    }
+    else {
+        for( vector<IActivity*>::const_iterator it = aItemsToCalc.begin(); it != aItemsToCalc.end(); ++it ) {
+            (*it)->calc( aPeriod );
+        }
+    }
+#ifdef GNU_SOURCE
+    feenableexcept(except);
+#endif
+}
+
+/*! \brief Calculate supply and demand and emissions for the given items.
+* \details Loops through the set bits of aItemsToCalc and calls calc on the
+*          corresponding activities in the global ordering.  This allows the
+*          compact calculation masks from the MarketDependencyFinder to be used
+*          directly without expanding them into a list first.
+* \param aPeriod Period to calculate.
+* \param aItemsToCalc The set of items to calculate as indices into the global
+*                     ordering.
+*/
+void World::calc( const int aPeriod, const bitvector& aItemsToCalc ) {
+    /*! \invariant The calculation mask must be sized to the global ordering. */
+    assert( aItemsToCalc.length() == mGlobalOrdering.size() );
+
+#ifdef GNU_SOURCE
+    int except = feenableexcept(FE_DIVBYZERO | FE_INVALID);
+#endif
+    
+    // Increment the world.calc count based on the number of items to solve. 
+    mCalcCounter->incrementCount( static_cast<double>( aItemsToCalc.count() ) / static_cast<double>( mGlobalOrdering.size() ) );
+    
+    // Perform calculation on each item to calculate. 
+    ActivityProfiler& profiler = ActivityProfiler::getInstance();
+    bitvector_iterator it( &aItemsToCalc );
+    if( profiler.isEnabled() ) {
+        profiler.startCalc( aPeriod, false );
+        while( it.next() ) {
+            profiler.calcActivity( mGlobalOrdering[ it.bindex() ], aPeriod );
+        }
+        profiler.endCalc();
+    }
+    else {
+        while( it.next() ) {
+            mGlobalOrdering[ it.bindex() ]->calc( aPeriod );
+        }
     }
 #ifdef GNU_SOURCE
     feenableexcept(except);
@@ -381,8 +445,15 @@ void World::calc( const int aPeriod, GcamFlowGraph *aWorkGraph, const vector<IAc
     }
     aWorkGraph->mPeriod = aPeriod;
     // do the model calculation
+    ActivityProfiler& profiler = ActivityProfiler::getInstance();
+    if( profiler.isEnabled() ) {
+        profiler.startCalc( aPeriod, true );
+    }
     aWorkGraph->mHead.try_put( tbb::flow::continue_msg() );
     aWorkGraph->mTBBFlowGraph.wait_for_all();
+    if( profiler.isEnabled() ) {
+        profiler.endCalc();
+    }
 
 #ifdef GNU_SOURCE
     feenableexcept(except);
@@ -504,6 +575,10 @@ void World::setEmissions( int period ) {
     const double HFC365_TO_245 = ( 794.0 / 1030.0 );
     const double HFC43_TO_134 = ( 1640.0 / 1430.0 );
     
+    // Pass emissions through the emulator, if there is one, so that it can
+    // track the change in emissions since the last full climate model run.
+    IClimateModel* climateModel = mClimateEmulator ? mClimateEmulator : mClimateModel;
+
     // Update all emissions values.
     accept( &allSummer, period );
     accept( &co2LandUseSummer, period );
@@ -511,52 +586,52 @@ void World::setEmissions( int period ) {
     // Only set emissions if they are valid. If these are not set
     // MAGICC will use the default values.
     if( co2Summer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "CO2", period,
-                                     co2Summer.getEmissions( period )
-                                     / TG_TO_PG );
+        climateModel->setEmissions( "CO2", period,
+                                    co2Summer.getEmissions( period )
+                                    / TG_TO_PG );
     }
     
     const int currYear = scenario->getModeltime()->getper_to_yr( period );
     const int startYear = currYear - scenario->getModeltime()->gettimestep( period ) + 1;
     for ( int i = startYear; i <= currYear; i++ ) {
         if( co2LandUseSummer.areEmissionsSet( i ) ){
-            mClimateModel->setLUCEmissions( "CO2NetLandUse", i,
-                                            co2LandUseSummer.getEmissions( i )
-                                            / TG_TO_PG );
+            climateModel->setLUCEmissions( "CO2NetLandUse", i,
+                                           co2LandUseSummer.getEmissions( i )
+                                           / TG_TO_PG );
         }
     }
     
     if( ch4Summer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "CH4", period,
-                                     ch4Summer.getEmissions( period ) +
-                                     ch4agrSummer.getEmissions( period ) + 
-                                     ch4awbSummer.getEmissions( period ));
+        climateModel->setEmissions( "CH4", period,
+                                    ch4Summer.getEmissions( period ) +
+                                    ch4agrSummer.getEmissions( period ) + 
+                                    ch4awbSummer.getEmissions( period ));
     }
     
     if( coSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "CO", period,
-                                     coSummer.getEmissions( period ) +
-                                     coagrSummer.getEmissions( period ) +
-                                     coawbSummer.getEmissions( period ));
+        climateModel->setEmissions( "CO", period,
+                                    coSummer.getEmissions( period ) +
+                                    coagrSummer.getEmissions( period ) +
+                                    coawbSummer.getEmissions( period ));
     }
     
     // MAGICC wants N2O emissions in Tg N, but miniCAM calculates Tg N2O
     if( n2oSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "N2O", period,
-                                     ( n2oSummer.getEmissions( period ) +
-                                       n2oawbSummer.getEmissions( period ) +
-                                       n2oagrSummer.getEmissions( period )  )
-                                     / N_TO_N2O );
+        climateModel->setEmissions( "N2O", period,
+                                    ( n2oSummer.getEmissions( period ) +
+                                      n2oawbSummer.getEmissions( period ) +
+                                      n2oagrSummer.getEmissions( period )  )
+                                    / N_TO_N2O );
     }
     
     // MAGICC wants NOx emissions in Tg N, but miniCAM calculates Tg NOx
     // FORTRAN code uses the conversion for NO2
     if( noxSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "NOx", period,
-                                     ( noxSummer.getEmissions( period ) +
-                                       noxagrSummer.getEmissions( period ) +
-                                       noxawbSummer.getEmissions( period ))
-                                     / N_TO_NO2 );
+        climateModel->setEmissions( "NOx", period,
+                                    ( noxSummer.getEmissions( period ) +
+                                      noxagrSummer.getEmissions( period ) +
+                                      noxawbSummer.getEmissions( period ))
+                                    / N_TO_NO2 );
     }
     
     double so2total=0.0;
@@ -568,7 +643,7 @@ void World::setEmissions( int period ) {
             + 0.6*so24Summer.getEmissions( period ) 
             + 0.6*so24awbSummer.getEmissions( period ); 
         
-        mClimateModel->setEmissions( "SOXreg1", period, so21/S_TO_SO2);
+        climateModel->setEmissions( "SOXreg1", period, so21/S_TO_SO2);
         so2total += so21;
     }
     
@@ -580,7 +655,7 @@ void World::setEmissions( int period ) {
             + 0.4*so24Summer.getEmissions( period ) 
             + 0.4*so24awbSummer.getEmissions( period );
         
-        mClimateModel->setEmissions( "SOXreg2", period, so22 / S_TO_SO2);
+        climateModel->setEmissions( "SOXreg2", period, so22 / S_TO_SO2);
         so2total += so22;
     }
     
@@ -589,91 +664,91 @@ void World::setEmissions( int period ) {
         double so23 = so23Summer.getEmissions( period ) +
             so23awbSummer.getEmissions( period );
         
-        mClimateModel->setEmissions( "SOXreg3", period, so23 / S_TO_SO2 );
+        climateModel->setEmissions( "SOXreg3", period, so23 / S_TO_SO2 );
         so2total += so23;
     }
     
     // set total SO2 emissions for those models that want it.
     // Emissions are in Tg SO2; it is up to models that want
     // something different to make their own conversion.
-    mClimateModel->setEmissions("SO2tot", period, so2total);
+    climateModel->setEmissions("SO2tot", period, so2total);
     
     if( cf4Summer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "CF4", period,
-                                     cf4Summer.getEmissions( period ) );
+        climateModel->setEmissions( "CF4", period,
+                                    cf4Summer.getEmissions( period ) );
     }
     
     if( c2f6Summer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "C2F6", period,
-                                     c2f6Summer.getEmissions( period ) );
+        climateModel->setEmissions( "C2F6", period,
+                                    c2f6Summer.getEmissions( period ) );
     }
     
     if( sf6Summer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "SF6", period,
-                                     sf6Summer.getEmissions( period ) );
+        climateModel->setEmissions( "SF6", period,
+                                    sf6Summer.getEmissions( period ) );
     }
     
     if( hfc125Summer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "HFC125", period,
-                                     hfc125Summer.getEmissions( period ) );
+        climateModel->setEmissions( "HFC125", period,
+                                    hfc125Summer.getEmissions( period ) );
     } 
     
     if( hfc134aSummer.areEmissionsSet( period ) && hfc43Summer.areEmissionsSet( period )  ){
-        mClimateModel->setEmissions( "HFC134a", period,
-                                     hfc134aSummer.getEmissions( period ) +
-                                     hfc43Summer.getEmissions( period ) * HFC43_TO_134);
+        climateModel->setEmissions( "HFC134a", period,
+                                    hfc134aSummer.getEmissions( period ) +
+                                    hfc43Summer.getEmissions( period ) * HFC43_TO_134);
     }
 
     if( hfc245faSummer.areEmissionsSet( period ) && hfc32Summer.areEmissionsSet( period ) && hfc365mfcSummer.areEmissionsSet( period ) && hfc152aSummer.areEmissionsSet( period ) ){
         // MAGICC needs HFC245fa in kton of HFC245ca
-        mClimateModel->setEmissions( "HFC245ca", period,
-                                     hfc245faSummer.getEmissions( period ) / HFC_CA_TO_FA +
-                                     hfc32Summer.getEmissions( period ) * HFC32_TO_245 +
-                                     hfc365mfcSummer.getEmissions( period ) * HFC365_TO_245 +
-                                     hfc152aSummer.getEmissions( period ) * HFC152_TO_245);
-        // For models that need ktonnes of HFC245fa (no single model should implement both of these):
-        mClimateModel->setEmissions("HFC245fa", period,
-                                    hfc245faSummer.getEmissions(period)+
+        climateModel->setEmissions( "HFC245ca", period,
+                                    hfc245faSummer.getEmissions( period ) / HFC_CA_TO_FA +
                                     hfc32Summer.getEmissions( period ) * HFC32_TO_245 +
                                     hfc365mfcSummer.getEmissions( period ) * HFC365_TO_245 +
                                     hfc152aSummer.getEmissions( period ) * HFC152_TO_245);
+        // For models that need ktonnes of HFC245fa (no single model should implement both of these):
+        climateModel->setEmissions("HFC245fa", period,
+                                   hfc245faSummer.getEmissions(period)+
+                                   hfc32Summer.getEmissions( period ) * HFC32_TO_245 +
+                                   hfc365mfcSummer.getEmissions( period ) * HFC365_TO_245 +
+                                   hfc152aSummer.getEmissions( period ) * HFC152_TO_245);
     }
     
     // MAGICC needs this in tons of VOC. Input is in TgC
     if( vocSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "NMVOCs", period,
-                                     ( vocSummer.getEmissions( period ) +
-                                       vocagrSummer.getEmissions( period ) +
-                                       vocawbSummer.getEmissions( period ) ));
+        climateModel->setEmissions( "NMVOCs", period,
+                                    ( vocSummer.getEmissions( period ) +
+                                      vocagrSummer.getEmissions( period ) +
+                                      vocawbSummer.getEmissions( period ) ));
     }
     
     // MAGICC needs this in GgC. Model output is in TgC
     if( bcSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "BC", period,
-                                     ( bcSummer.getEmissions( period ) +
-                                       bcawbSummer.getEmissions( period ) )
-                                     * TG_TO_PG );
+        climateModel->setEmissions( "BC", period,
+                                    ( bcSummer.getEmissions( period ) +
+                                      bcawbSummer.getEmissions( period ) )
+                                    * TG_TO_PG );
     }
     
     // MAGICC needs this in GgC. Model output is in TgC
     if( ocSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "OC", period,
-                                     ( ocSummer.getEmissions( period ) +
-                                       ocawbSummer.getEmissions( period ) )
-                                     * TG_TO_PG );
+        climateModel->setEmissions( "OC", period,
+                                    ( ocSummer.getEmissions( period ) +
+                                      ocawbSummer.getEmissions( period ) )
+                                    * TG_TO_PG );
     }
     
     
     if( hfc227eaSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "HFC227ea", period,
-                                     hfc227eaSummer.getEmissions( period ) );
+        climateModel->setEmissions( "HFC227ea", period,
+                                    hfc227eaSummer.getEmissions( period ) );
     }
     
     if( hfc143aSummer.areEmissionsSet( period ) && hfc23Summer.areEmissionsSet( period ) && hfc236faSummer.areEmissionsSet( period ) ){
-        mClimateModel->setEmissions( "HFC143a", period,
-                                     hfc143aSummer.getEmissions( period ) +
-                                     hfc23Summer.getEmissions( period ) * HFC23_TO_143 +
-                                     hfc236faSummer.getEmissions( period ) * HFC236_TO_143);
+        climateModel->setEmissions( "HFC143a", period,
+                                    hfc143aSummer.getEmissions( period ) +
+                                    hfc23Summer.getEmissions( period ) * HFC23_TO_143 +
+                                    hfc236faSummer.getEmissions( period ) * HFC236_TO_143);
     }
 }
     
@@ -684,16 +759,31 @@ void World::runClimateModel() {
     }
     
     // Run the model.
-    mClimateModel->runModel();
+    IClimateModel* climateModel = mClimateEmulator ? mClimateEmulator : mClimateModel;
+    climateModel->runModel();
 }
 
 void World::runClimateModel( int aPeriod ) {
     if( aPeriod > 0 ) {
         setEmissions( aPeriod );
-        mClimateModel->runModel( scenario->getModeltime()->getper_to_yr( aPeriod ) );
+        IClimateModel* climateModel = mClimateEmulator ? mClimateEmulator : mClimateModel;
+        climateModel->runModel( scenario->getModeltime()->getper_to_yr( aPeriod ) );
     }
 }
 
+/*!
+ * \brief Switch the climate emulator on or off.
+ * \details While the emulator is on the climate model runs are performed by
+ *          the emulator.  Switching it off reruns the full climate model if any
+ *          emulated runs were performed.
+ * \param aEmulate Whether to emulate the climate model.
+ * \return Whether the climate model is now emulated, which is always false if
+ *         the "climate-emulator" option is not set.
+ */
+bool World::setClimateEmulation( const bool aEmulate ) {
+    return mClimateEmulator ? mClimateEmulator->setEmulating( aEmulate ) : false;
+}
+
 
 //! write results for all regions to file
 void World::csvOutputFile() const {
@@ -812,6 +902,9 @@ void World::setTax( const GHGPolicy* aTax ){
 * \return The climate model.
 */
 const IClimateModel* World::getClimateModel() const {
+    if( mClimateEmulator ) {
+        return mClimateEmulator;
+    }
     return mClimateModel;
 }
 
@@ -911,10 +1004,70 @@ void World::accept( IVisitor* aVisitor, const int aPeriod ) const {
     // Visit the climate model.
     mClimateModel->accept( aVisitor, aPeriod );
 
-    // loop for regions
-    for( CRegionIterator currRegion = mRegions.begin(); currRegion != mRegions.end(); ++currRegion ){
-        (*currRegion)->accept( aVisitor, aPeriod );
+    // Visitors which are able to may visit the regions in shards, otherwise
+    // loop for regions.
+    IShardableVisitor* shardableVisitor = dynamic_cast<IShardableVisitor*>( aVisitor );
+    if( shardableVisitor && shardableVisitor->shouldShardRegions() ) {
+        acceptRegionShards( shardableVisitor, aPeriod );
+    }
+    else {
+        for( CRegionIterator currRegion = mRegions.begin(); currRegion != mRegions.end(); ++currRegion ){
+            (*currRegion)->accept( aVisitor, aPeriod );
+        }
     }
 
     aVisitor->endVisitWorld( this, aPeriod );
 }
+
+/*!
+ * \brief Visit each region with a separate shard of the given visitor.
+ * \details Each region gets its own shard created by the visitor so that the
+ *          regions may be visited concurrently when GCAM_PARALLEL_ENABLED.  Once
+ *          all regions have been visited the shards are merged back into the
+ *          visitor in region order from the calling thread so that the results
+ *          are the same as a serial traversal.
+ * \param aShardableVisitor The visitor which will create and merge the shards.
+ * \param aPeriod Period to update.
+ */
+void World::acceptRegionShards( IShardableVisitor* aShardableVisitor, const int aPeriod ) const {
+    vector<IVisitor*> regionShards( mRegions.size() );
+    for( size_t regionIndex = 0; regionIndex < mRegions.size(); ++regionIndex ) {
+        regionShards[ regionIndex ] = aShardableVisitor->createRegionShard();
+    }
+
+#if GCAM_PARALLEL_ENABLED
+    tbb::parallel_for( tbb::blocked_range<size_t>( 0, mRegions.size(), 1 ),
+        [this, &regionShards, aPeriod]( const tbb::blocked_range<size_t>& aRange ) {
+            for( size_t regionIndex = aRange.begin(); regionIndex != aRange.end(); ++regionIndex ) {
+                mRegions[ regionIndex ]->accept( regionShards[ regionIndex ], aPeriod );
+            }
+        } );
+#else
+    for( size_t regionIndex = 0; regionIndex < mRegions.size(); ++regionIndex ) {
+        mRegions[ regionIndex ]->accept( regionShards[ regionIndex ], aPeriod );
+    }
+#endif
+
+    // Stitch the results back together in a deterministic order.
+    for( size_t regionIndex = 0; regionIndex < mRegions.size(); ++regionIndex ) {
+        aShardableVisitor->mergeRegionShard( regionShards[ regionIndex ] );
+        delete regionShards[ regionIndex ];
+    }
+}
+
+/*!
+ * \brief Update a visitor for a single region only.
+ * \details This is useful for reporting which is only interested in a single
+ *          region, such as the debugging graphs, and avoids visiting every region
+ *          in the model.  Note start/endVisitWorld are not called.
+ * \param aRegionName The name of the region to visit.
+ * \param aVisitor Visitor to update.
+ * \param aPeriod Period to update.
+ */
+void World::acceptRegion( const string& aRegionName, IVisitor* aVisitor, const int aPeriod ) const {
+    for( CRegionIterator currRegion = mRegions.begin(); currRegion != mRegions.end(); ++currRegion ){
+        if( (*currRegion)->getName() == aRegionName ) {
+            (*currRegion)->accept( aVisitor, aPeriod );
+        }
+    }
+}
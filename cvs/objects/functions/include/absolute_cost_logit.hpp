@@ -89,6 +89,11 @@ public:
     virtual double calcUnnormalizedShare( const double aShareWeight, const double aCost,
                                           const int aPeriod ) const;
 
+    virtual void calcUnnormalizedShares( const std::vector<double>& aShareWeights,
+                                         const std::vector<double>& aCosts,
+                                         const int aPeriod,
+                                         std::vector<double>& aLogShares ) const;
+
     virtual double calcShareWeight( const double aShare, const double aCost, const double aAnchorShare,
                                     const double aAnchorCost, const int aPeriod ) const;
 
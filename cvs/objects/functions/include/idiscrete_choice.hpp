@@ -43,6 +43,7 @@
  * \brief IDiscreteChoice class declaration file
  * \author Robert Link
  */
+#include <vector>
 #include <boost/core/noncopyable.hpp>
 
 #include "util/base/include/iparsable.h"
@@ -107,6 +108,22 @@ public:
     virtual double calcUnnormalizedShare( const double aShareWeight, const double aCost,
                                           const int aPeriod ) const = 0;
 
+    /*!
+     * \brief Compute the unnormalized shares for a set of options at once.
+     * \details Equivalent to calling calcUnnormalizedShare for each option
+     *          however subclasses should override this to hoist any per period
+     *          terms out of a single tight loop over the options.
+     * \param aShareWeights The weighting term for each option.
+     * \param aCosts The cost of each option.
+     * \param aPeriod The current model period.
+     * \param aLogShares The unnormalized share of each option, must be at
+     *                   least as long as aShareWeights.
+     */
+    virtual void calcUnnormalizedShares( const std::vector<double>& aShareWeights,
+                                         const std::vector<double>& aCosts,
+                                         const int aPeriod,
+                                         std::vector<double>& aLogShares ) const;
+
     /*!
      * \brief Compute the share weight by inverting the discrete choice function
      *        given the values of the other terms in the equation.
@@ -149,4 +166,14 @@ inline IDiscreteChoice::IDiscreteChoice(){
 inline IDiscreteChoice::~IDiscreteChoice(){
 }
 
+inline void IDiscreteChoice::calcUnnormalizedShares( const std::vector<double>& aShareWeights,
+                                                     const std::vector<double>& aCosts,
+                                                     const int aPeriod,
+                                                     std::vector<double>& aLogShares ) const
+{
+    for( size_t i = 0; i < aShareWeights.size(); ++i ) {
+        aLogShares[ i ] = calcUnnormalizedShare( aShareWeights[ i ], aCosts[ i ], aPeriod );
+    }
+}
+
 #endif // _IDISCRETE_CHOICE_HPP_
@@ -189,6 +189,36 @@ double AbsoluteCostLogit::calcUnnormalizedShare( const double aShareWeight, cons
     return logShareWeight + mLogitExponent[ aPeriod ] * aCost / mBaseCost;
 }
 
+/*!
+ * \brief Batched version of calcUnnormalizedShare.
+ * \details Performs exactly the same calculation for each option with the
+ *          period specific terms looked up once.
+ */
+void AbsoluteCostLogit::calcUnnormalizedShares( const std::vector<double>& aShareWeights,
+                                                const std::vector<double>& aCosts,
+                                                const int aPeriod,
+                                                std::vector<double>& aLogShares ) const
+{
+    /*!
+     * \pre A valid logit exponent has been set.
+     */
+    assert( mLogitExponent[ aPeriod ] <= 0 );
+
+    /*!
+     * \pre A valid base cost has been set.
+     */
+    assert( mBaseCost != 0 );
+
+    const double logitExponent = mLogitExponent[ aPeriod ];
+    const double baseCost = mBaseCost;
+    const double minInf = -std::numeric_limits<double>::infinity();
+    const size_t numOptions = aShareWeights.size();
+    for( size_t i = 0; i < numOptions; ++i ) {
+        double logShareWeight = aShareWeights[ i ] > 0.0 ? log( aShareWeights[ i ] ) : minInf;
+        aLogShares[ i ] = logShareWeight + logitExponent * aCosts[ i ] / baseCost;
+    }
+}
+
 /*!
  * \brief Share weight calculation for the absolute cost logit.
  * \details Given an an "anchor" subsector with observed share and cost and another choice
@@ -162,6 +162,31 @@ double RelativeCostLogit::calcUnnormalizedShare( const double aShareWeight, cons
     // logit and the absolute cost logit.
 }
 
+/*!
+ * \brief Batched version of calcUnnormalizedShare.
+ * \details Performs exactly the same calculation for each option with the
+ *          period specific terms looked up once.
+ */
+void RelativeCostLogit::calcUnnormalizedShares( const std::vector<double>& aShareWeights,
+                                                const std::vector<double>& aCosts,
+                                                const int aPeriod,
+                                                std::vector<double>& aLogShares ) const
+{
+    /*!
+     * \pre A valid logit exponent has been set.
+     */
+    assert( mLogitExponent[ aPeriod ] <= 0 );
+
+    const double logitExponent = mLogitExponent[ aPeriod ];
+    const double minCost = getMinCostThreshold();
+    const double minInf = -std::numeric_limits<double>::infinity();
+    const size_t numOptions = aShareWeights.size();
+    for( size_t i = 0; i < numOptions; ++i ) {
+        double logShareWeight = aShareWeights[ i ] > 0.0 ? log( aShareWeights[ i ] ) : minInf;
+        aLogShares[ i ] = logShareWeight + logitExponent * log( std::max( aCosts[ i ], minCost ) );
+    }
+}
+
 /*!
  * \brief Share weight calculation for the relative cost logit.
  * \details  Given an an "anchor" choice with observed share and price and another choice
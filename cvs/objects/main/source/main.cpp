@@ -75,6 +75,10 @@
 #include "util/logger/include/logger_factory.h"
 #include "util/base/include/timer.h"
 #include "util/base/include/version.h"
+#include "reporting/include/xml_db_async_writer.h"
+#include "solution/util/include/solver_warm_start_store.h"
+#include "solution/util/include/solver_telemetry.h"
+#include "util/base/include/activity_profiler.h"
 
 using namespace std;
 using namespace xercesc;
@@ -194,6 +198,15 @@ int main( int argc, char *argv[] ) {
     mainLog.setLevel( ILogger::WARNING ); // Increase level so that user will know that model is done
     mainLog << "Model exiting successfully." << endl;
     runner->cleanup();
+    // Ensure any results still being written to the XML database in the background
+    // have finished.
+    success = XMLDBAsyncWriter::shutdown() && success;
+    // Save any solutions which may be used to warm start the solver in later runs.
+    SolverWarmStartStore::getInstance().save();
+    // Write out solver performance statistics if requested.
+    SolverTelemetry::getInstance().write();
+    // Write out the activity profile if requested.
+    ActivityProfiler::getInstance().write();
     // Cleanup Xerces. This should be encapsulated with an initializer object to ensure against leakage.
     XMLHelper<void>::cleanupParser();
     
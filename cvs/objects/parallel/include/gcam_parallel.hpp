@@ -38,6 +38,8 @@
 /* standard headers */
 #include <list>
 #include <set>
+#include <vector>
+#include <iosfwd>
 
 /* graph analysis headers */
 #include "parallel/include/digraph.hpp"
@@ -48,6 +50,7 @@
 // Forward declare when possible
 class IActivity;
 class MarketDependencyFinder;
+class bitvector;
 
 /*!
  * \brief Class to package all of the information we need to carry around to use the flow graph
@@ -77,6 +80,21 @@ private:
     const std::vector<IActivity*>* mCalcList;
 };
 
+/*!
+ * \brief A compact representation of the grain graph for the full model which
+ *        can be masked to quickly create flow graphs for a subset of the model.
+ * \details Activities are identified by their index in the global ordering, which
+ *          is a valid topological ordering, and grains are stored in topological
+ *          order so that a masked flow graph can be created in a single sweep.
+ */
+struct GrainSchedule {
+    //! The global ordering indices of the activities in each grain in ascending order.
+    std::vector<std::vector<int> > mGrainNodes;
+    
+    //! The indices of the grains which directly depend on each grain.
+    std::vector<std::vector<int> > mGrainSuccessors;
+};
+
 /*!
  * \brief A class which converts activities and dependecies tracked by the MarketDependencyFinder
  *        and turn them into a TBB flow graph which can be calculated in parallel.
@@ -106,6 +124,21 @@ public:
     
     void makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGraph& aTopology,
                            GcamFlowGraph& aTBBGraph );
+    
+    /* Grain schedule methods */
+    void makeGrainSchedule( const FlowGraph& aGrainGraph, const std::vector<FlowGraphNodeType>& aOrdering,
+                            GrainSchedule& aSchedule ) const;
+    
+    void makeTBBFlowGraph( const GrainSchedule& aSchedule, const std::vector<FlowGraphNodeType>& aOrdering,
+                           const bitvector* aMask, GcamFlowGraph& aTBBGraph ) const;
+    
+    bool readGrainSchedule( std::istream& aIn, const MarketDependencyFinder& aDependencyFinder,
+                            const std::vector<FlowGraphNodeType>& aOrdering,
+                            GrainSchedule& aSchedule ) const;
+    
+    void writeGrainSchedule( std::ostream& aOut, const MarketDependencyFinder& aDependencyFinder,
+                             const std::vector<FlowGraphNodeType>& aOrdering,
+                             const GrainSchedule& aSchedule ) const;
   
 protected:
     //! Helper class for sorting lists in topological order
@@ -136,6 +169,9 @@ protected:
         TBBFlowGraphBody( const std::set<FlowGraphNodeType>& aNodes, const FlowGraph& aTopology,
                           const GcamFlowGraph& aGraph );
         
+        TBBFlowGraphBody( const std::list<FlowGraphNodeType>& aNodes, const GcamFlowGraph& aGraph,
+                          const int aGrainIndex );
+        
         void operator()( tbb::flow::continue_msg aMessage );
 
         //! The list of activities which will be calculated when TBB calls this class
@@ -144,6 +180,10 @@ protected:
         
         //! A reference to the TBB flow graph to which this node belongs.
         const GcamFlowGraph& mGraph;
+        
+        //! The index of this grain in the grain schedule, or -1 if it was not
+        //! created from one.  Used to attribute profiled time to grains.
+        int mGrainIndex;
     };
     
     /* data members */
@@ -161,6 +201,9 @@ protected:
     //! Default grain size
     static const int DEFAULT_GRAIN_SIZE;
     
+    unsigned long long calcScheduleSignature( const MarketDependencyFinder& aDependencyFinder,
+                                              const std::vector<FlowGraphNodeType>& aOrdering ) const;
+    
     // right now, grain size is the only parameter in the heuristics.
     // We may add more later.
 };
@@ -0,0 +1,87 @@
+#ifndef _NUMA_TOPOLOGY_HPP_
+#define _NUMA_TOPOLOGY_HPP_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#if GCAM_PARALLEL_ENABLED
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+ * \file numa_topology.hpp
+ * \ingroup Objects
+ * \brief The NumaTopology class header file.
+ */
+
+#include <vector>
+#include <functional>
+
+/*!
+ * \ingroup Objects
+ * \brief Describes the NUMA nodes (sockets) of the machine and binds threads
+ *        to them.
+ * \details The nodes and the CPUs which belong to each are read from sysfs on
+ *          Linux and limited to the CPUs this process may run on.  Elsewhere,
+ *          or if they can not be read, the machine is treated as a single node
+ *          and binding threads has no effect.  Memory on Linux is placed on the
+ *          node of the thread which first touches it, so binding a thread
+ *          before it first writes its data is enough to keep that data local.
+ *
+ *          The node a thread was last bound to is remembered per thread so
+ *          that callers can find the data local to the calling thread.
+ */
+class NumaTopology {
+public:
+    static const NumaTopology& getInstance();
+    
+    int getNumNodes() const;
+    
+    int getNumCPUs( const int aNode ) const;
+    
+    bool bindCurrentThread( const int aNode ) const;
+    
+    void runOnNode( const int aNode, const std::function<void()>& aFunction ) const;
+    
+    static int getCurrentThreadNode();
+    
+private:
+    NumaTopology();
+    
+    //! The CPUs which belong to each node with at least one usable CPU.
+    std::vector<std::vector<int> > mNodeCPUs;
+};
+
+#endif // GCAM_PARALLEL_ENABLED
+
+#endif // _NUMA_TOPOLOGY_HPP_
@@ -32,6 +32,9 @@
 
 #if GCAM_PARALLEL_ENABLED
 #include <map>
+#include <queue>
+#include <algorithm>
+#include <iostream>
 /* gcam headers */
 #include "parallel/include/gcam_parallel.hpp"
 #include "util/base/include/configuration.h"
@@ -40,12 +43,14 @@
 #include "containers/include/market_dependency_finder.h"
 #include "util/logger/include/ilogger.h"
 #include "util/base/include/timer.h"
+#include "util/base/include/activity_profiler.h"
 #include "util/base/include/auto_file.h"
 /* more graph analysis headers */
 #include "parallel/include/clanid.hpp"
 #include "parallel/include/graph-parse.hpp"
 #include "parallel/include/grain-collect.hpp"
 #include "parallel/include/digraph-output.hpp"
+#include "parallel/include/bitvector.hpp"
 
 using namespace std;
 
@@ -317,23 +322,361 @@ void GcamParallel::makeTBBFlowGraph( const FlowGraph& aGrainGraph, const FlowGra
     // TBB flow graph is ready to go.
 }
 
+/*!
+ * \brief Convert a grain graph into a GrainSchedule.
+ * \details The schedule identifies activities by their index in aOrdering and
+ *          stores grains in topological order.  Once created the schedule can be
+ *          used to build flow graphs for the full model or any subset of it
+ *          without having to parse the graph again.
+ * \param[in] aGrainGraph: graph of the computational grains
+ *            (produced by graph_parse_grain_collect()) 
+ * \param[in] aOrdering: The global ordering of all activities.
+ * \param[out] aSchedule: The schedule created from the grain graph.
+ */
+void GcamParallel::makeGrainSchedule( const FlowGraph& aGrainGraph, const vector<FlowGraphNodeType>& aOrdering,
+                                      GrainSchedule& aSchedule ) const
+{
+    map<FlowGraphNodeType, int> activityIndex;
+    for( size_t i = 0; i < aOrdering.size(); ++i ) {
+        activityIndex[ aOrdering[ i ] ] = i;
+    }
+    
+    // Count the predecessors of each grain so that we can sort them topologically.
+    map<FlowGraphNodeType, int> numPredecessors;
+    for( FlowGraph::nodelist_c_iter_t gnodeIt = aGrainGraph.nodelist().begin();
+         gnodeIt != aGrainGraph.nodelist().end(); ++gnodeIt )
+    {
+        numPredecessors[ gnodeIt->first ];
+        const set<FlowGraphNodeType>& successors = gnodeIt->second.successors;
+        for( set<FlowGraphNodeType>::const_iterator succIt = successors.begin(); succIt != successors.end(); ++succIt ) {
+            ++numPredecessors[ *succIt ];
+        }
+    }
+    queue<FlowGraphNodeType> ready;
+    for( map<FlowGraphNodeType, int>::const_iterator it = numPredecessors.begin(); it != numPredecessors.end(); ++it ) {
+        if( it->second == 0 ) {
+            ready.push( it->first );
+        }
+    }
+    vector<FlowGraphNodeType> grainOrder;
+    while( !ready.empty() ) {
+        FlowGraphNodeType grain = ready.front();
+        ready.pop();
+        grainOrder.push_back( grain );
+        const set<FlowGraphNodeType>& successors = aGrainGraph.nodelist().find( grain )->second.successors;
+        for( set<FlowGraphNodeType>::const_iterator succIt = successors.begin(); succIt != successors.end(); ++succIt ) {
+            if( --numPredecessors[ *succIt ] == 0 ) {
+                ready.push( *succIt );
+            }
+        }
+    }
+    
+    map<FlowGraphNodeType, int> grainIndex;
+    for( size_t i = 0; i < grainOrder.size(); ++i ) {
+        grainIndex[ grainOrder[ i ] ] = i;
+    }
+    
+    aSchedule.mGrainNodes.clear();
+    aSchedule.mGrainNodes.resize( grainOrder.size() );
+    aSchedule.mGrainSuccessors.clear();
+    aSchedule.mGrainSuccessors.resize( grainOrder.size() );
+    for( size_t i = 0; i < grainOrder.size(); ++i ) {
+        const FlowGraph::node_t& grainNode = aGrainGraph.nodelist().find( grainOrder[ i ] )->second;
+        vector<FlowGraphNodeType> subGraphNodes;
+        if( grainNode.subgraph ) {
+            getkeys( grainNode.subgraph->nodelist(), subGraphNodes );
+        }
+        else {
+            subGraphNodes.push_back( grainOrder[ i ] );
+        }
+        for( vector<FlowGraphNodeType>::const_iterator it = subGraphNodes.begin(); it != subGraphNodes.end(); ++it ) {
+            aSchedule.mGrainNodes[ i ].push_back( activityIndex[ *it ] );
+        }
+        sort( aSchedule.mGrainNodes[ i ].begin(), aSchedule.mGrainNodes[ i ].end() );
+        
+        const set<FlowGraphNodeType>& successors = grainNode.successors;
+        for( set<FlowGraphNodeType>::const_iterator succIt = successors.begin(); succIt != successors.end(); ++succIt ) {
+            aSchedule.mGrainSuccessors[ i ].push_back( grainIndex[ *succIt ] );
+        }
+    }
+}
+
+/*!
+ * \brief Build the TBB flow graph from a grain schedule, optionally masked to
+ *        include only a subset of the activities.
+ * \details Grains which contain no activities in the mask are dropped.  Any ordering
+ *          constraints which went through dropped grains are passed along to their
+ *          successors so that the masked graph remains correctly ordered.  Since no
+ *          graph analysis is required this is very cheap relative to parsing a
+ *          subset of the full flow graph.
+ * \param[in] aSchedule: The grain schedule for the full model.
+ * \param[in] aOrdering: The global ordering of all activities which was used to
+ *            create aSchedule.
+ * \param[in] aMask: A bitvector over the global ordering indicating which activities
+ *            to include, or null to include all of them.
+ * \param[inout] aTBBGraph: The class that will hold the flow graph.  On input it
+ *               should be default-constructed.
+ */
+void GcamParallel::makeTBBFlowGraph( const GrainSchedule& aSchedule, const vector<FlowGraphNodeType>& aOrdering,
+                                     const bitvector* aMask, GcamFlowGraph& aTBBGraph ) const
+{
+    using tbb::flow::continue_node;
+    using tbb::flow::continue_msg;
+    
+    tbb::flow::graph& tbbFlowGraph = aTBBGraph.mTBBFlowGraph;
+    tbb::flow::broadcast_node<tbb::flow::continue_msg>& head = aTBBGraph.mHead;
+    
+    const size_t numGrains = aSchedule.mGrainNodes.size();
+    vector<continue_node<continue_msg>*> nodeTable( numGrains, 0 );
+    // The kept grains which must be calculated before each grain.
+    vector<set<int> > mustPrecede( numGrains );
+    for( size_t grain = 0; grain < numGrains; ++grain ) {
+        list<FlowGraphNodeType> grainActivities;
+        const vector<int>& grainNodes = aSchedule.mGrainNodes[ grain ];
+        for( vector<int>::const_iterator it = grainNodes.begin(); it != grainNodes.end(); ++it ) {
+            if( !aMask || aMask->get( *it ) ) {
+                grainActivities.push_back( aOrdering[ *it ] );
+            }
+        }
+        
+        const vector<int>& successors = aSchedule.mGrainSuccessors[ grain ];
+        if( !grainActivities.empty() ) {
+            nodeTable[ grain ] = new continue_node<continue_msg>( tbbFlowGraph,
+                TBBFlowGraphBody( grainActivities, aTBBGraph, static_cast<int>( grain ) ) );
+            if( mustPrecede[ grain ].empty() ) {
+                tbb::flow::make_edge( head, *nodeTable[ grain ] );
+            }
+            for( set<int>::const_iterator predIt = mustPrecede[ grain ].begin(); predIt != mustPrecede[ grain ].end(); ++predIt ) {
+                tbb::flow::make_edge( *nodeTable[ *predIt ], *nodeTable[ grain ] );
+            }
+            for( vector<int>::const_iterator succIt = successors.begin(); succIt != successors.end(); ++succIt ) {
+                mustPrecede[ *succIt ].insert( grain );
+            }
+        }
+        else {
+            // This grain has been dropped, pass along its constraints.
+            for( vector<int>::const_iterator succIt = successors.begin(); succIt != successors.end(); ++succIt ) {
+                mustPrecede[ *succIt ].insert( mustPrecede[ grain ].begin(), mustPrecede[ grain ].end() );
+            }
+        }
+        mustPrecede[ grain ].clear();
+    }
+}
+
+namespace {
+    //! The 64 bit FNV-1a offset basis.
+    const unsigned long long FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+    //! The 64 bit FNV-1a prime.
+    const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+    //! Mask to keep the hash to 64 bits should unsigned long long be wider.
+    const unsigned long long FNV_MASK = 0xFFFFFFFFFFFFFFFFULL;
+
+    // add a single byte to an FNV-1a hash
+    void fnvHashByte( unsigned long long& aHash, const unsigned char aByte ) {
+        aHash = ( ( aHash ^ aByte ) * FNV_PRIME ) & FNV_MASK;
+    }
+
+    // add an integer to an FNV-1a hash, least significant byte first so that
+    // the result does not depend on the byte order of the platform
+    void fnvHashInt( unsigned long long& aHash, const long long aValue ) {
+        unsigned long long value = static_cast<unsigned long long>( aValue );
+        for( int i = 0; i < 8; ++i ) {
+            fnvHashByte( aHash, static_cast<unsigned char>( value & 0xFF ) );
+            value >>= 8;
+        }
+    }
+
+    // add a string, including its length, to an FNV-1a hash
+    void fnvHashString( unsigned long long& aHash, const string& aValue ) {
+        fnvHashInt( aHash, aValue.size() );
+        for( string::const_iterator it = aValue.begin(); it != aValue.end(); ++it ) {
+            fnvHashByte( aHash, static_cast<unsigned char>( *it ) );
+        }
+    }
+}
+
+/*!
+ * \brief Calculate a signature which identifies the dependency structure a grain
+ *        schedule was created for.
+ * \details The signature includes the target grain size, the descriptions of all
+ *          activities in the global ordering and every out edge and implied edge
+ *          of the dependency graph by global ordering index.  Since the signature
+ *          is saved to disk it is calculated with FNV-1a, which unlike std::hash
+ *          gives the same result for every build and run.
+ * \param aDependencyFinder The dependency finder which contains the dependency
+ *        graph.
+ * \param aOrdering The global ordering of all activities.
+ * \return The signature.
+ */
+unsigned long long GcamParallel::calcScheduleSignature( const MarketDependencyFinder& aDependencyFinder,
+                                                        const vector<FlowGraphNodeType>& aOrdering ) const
+{
+    unsigned long long signature = FNV_OFFSET_BASIS;
+    fnvHashInt( signature, mGrainSizeTarget );
+    fnvHashInt( signature, aOrdering.size() );
+    map<FlowGraphNodeType, int> activityIndex;
+    for( size_t i = 0; i < aOrdering.size(); ++i ) {
+        fnvHashString( signature, aOrdering[ i ]->getDescription() );
+        activityIndex[ aOrdering[ i ] ] = i;
+    }
+    
+    // Collect the edges by index and sort them so that the signature does not
+    // depend on the order the graph was built in.
+    vector<pair<int, int> > outEdges;
+    vector<pair<int, int> > impliedEdges;
+    const MarketDependencyFinder::DependencyItemSet& dependencyItems = aDependencyFinder.getDependencyItems();
+    for( MarketDependencyFinder::CItemIterator diIter = dependencyItems.begin(); diIter != dependencyItems.end(); ++diIter ) {
+        for( int priceOrDemand = 0; priceOrDemand <= 1; ++priceOrDemand ) {
+            const MarketDependencyFinder::VertexList& cvertices = priceOrDemand ?
+                (*diIter)->mPriceVertices : (*diIter)->mDemandVertices;
+            for( MarketDependencyFinder::CVertexIterator vIter = cvertices.begin(); vIter != cvertices.end(); ++vIter ) {
+                map<FlowGraphNodeType, int>::const_iterator fromIt = activityIndex.find( (*vIter)->mCalcItem );
+                const int from = fromIt != activityIndex.end() ? fromIt->second : -1;
+                for( MarketDependencyFinder::CVertexIterator cIter = (*vIter)->mOutEdges.begin();
+                     cIter != (*vIter)->mOutEdges.end(); ++cIter )
+                {
+                    map<FlowGraphNodeType, int>::const_iterator toIt = activityIndex.find( (*cIter)->mCalcItem );
+                    outEdges.push_back( make_pair( from, toIt != activityIndex.end() ? toIt->second : -1 ) );
+                }
+                for( set<MarketDependencyFinder::CalcVertex*>::const_iterator implIter = (*vIter)->mImpliedInEdges.begin();
+                     implIter != (*vIter)->mImpliedInEdges.end(); ++implIter )
+                {
+                    map<FlowGraphNodeType, int>::const_iterator toIt = activityIndex.find( (*implIter)->mCalcItem );
+                    impliedEdges.push_back( make_pair( from, toIt != activityIndex.end() ? toIt->second : -1 ) );
+                }
+            }
+        }
+    }
+    sort( outEdges.begin(), outEdges.end() );
+    sort( impliedEdges.begin(), impliedEdges.end() );
+    fnvHashInt( signature, outEdges.size() );
+    for( vector<pair<int, int> >::const_iterator it = outEdges.begin(); it != outEdges.end(); ++it ) {
+        fnvHashInt( signature, it->first );
+        fnvHashInt( signature, it->second );
+    }
+    fnvHashInt( signature, impliedEdges.size() );
+    for( vector<pair<int, int> >::const_iterator it = impliedEdges.begin(); it != impliedEdges.end(); ++it ) {
+        fnvHashInt( signature, it->first );
+        fnvHashInt( signature, it->second );
+    }
+    return signature;
+}
+
+/*!
+ * \brief Read a grain schedule which was previously saved with writeGrainSchedule.
+ * \details The schedule will only be read if it was created for the same dependency
+ *          structure and grain size.
+ * \param aIn The stream to read from.
+ * \param aDependencyFinder The dependency finder which contains the dependency
+ *        graph.
+ * \param aOrdering The global ordering of all activities.
+ * \param aSchedule The schedule to read into.
+ * \return Whether a valid schedule was read.
+ */
+bool GcamParallel::readGrainSchedule( istream& aIn, const MarketDependencyFinder& aDependencyFinder,
+                                      const vector<FlowGraphNodeType>& aOrdering,
+                                      GrainSchedule& aSchedule ) const
+{
+    string header;
+    unsigned long long signature = 0;
+    size_t numGrains = 0;
+    if( !( aIn >> header >> signature >> numGrains ) || header != "gcam-grain-schedule"
+        || signature != calcScheduleSignature( aDependencyFinder, aOrdering ) )
+    {
+        return false;
+    }
+    
+    const int numActivities = aOrdering.size();
+    aSchedule.mGrainNodes.assign( numGrains, vector<int>() );
+    aSchedule.mGrainSuccessors.assign( numGrains, vector<int>() );
+    for( size_t grain = 0; grain < numGrains; ++grain ) {
+        size_t numNodes = 0;
+        aIn >> numNodes;
+        aSchedule.mGrainNodes[ grain ].resize( numNodes );
+        for( size_t i = 0; i < numNodes; ++i ) {
+            aIn >> aSchedule.mGrainNodes[ grain ][ i ];
+            if( !aIn || aSchedule.mGrainNodes[ grain ][ i ] < 0 || aSchedule.mGrainNodes[ grain ][ i ] >= numActivities ) {
+                return false;
+            }
+        }
+        size_t numSuccessors = 0;
+        aIn >> numSuccessors;
+        aSchedule.mGrainSuccessors[ grain ].resize( numSuccessors );
+        for( size_t i = 0; i < numSuccessors; ++i ) {
+            aIn >> aSchedule.mGrainSuccessors[ grain ][ i ];
+            // successors must come later in the topological order
+            if( !aIn || aSchedule.mGrainSuccessors[ grain ][ i ] <= static_cast<int>( grain )
+                || aSchedule.mGrainSuccessors[ grain ][ i ] >= static_cast<int>( numGrains ) )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Write a grain schedule so that it may be reused by later runs with the
+ *        same dependency structure.
+ * \param aOut The stream to write to.
+ * \param aDependencyFinder The dependency finder which contains the dependency
+ *        graph.
+ * \param aOrdering The global ordering of all activities.
+ * \param aSchedule The schedule to write.
+ */
+void GcamParallel::writeGrainSchedule( ostream& aOut, const MarketDependencyFinder& aDependencyFinder,
+                                       const vector<FlowGraphNodeType>& aOrdering,
+                                       const GrainSchedule& aSchedule ) const
+{
+    aOut << "gcam-grain-schedule " << calcScheduleSignature( aDependencyFinder, aOrdering ) << ' '
+         << aSchedule.mGrainNodes.size() << '\n';
+    for( size_t grain = 0; grain < aSchedule.mGrainNodes.size(); ++grain ) {
+        const vector<int>& grainNodes = aSchedule.mGrainNodes[ grain ];
+        aOut << grainNodes.size();
+        for( size_t i = 0; i < grainNodes.size(); ++i ) {
+            aOut << ' ' << grainNodes[ i ];
+        }
+        const vector<int>& successors = aSchedule.mGrainSuccessors[ grain ];
+        aOut << '\n' << successors.size();
+        for( size_t i = 0; i < successors.size(); ++i ) {
+            aOut << ' ' << successors[ i ];
+        }
+        aOut << '\n';
+    }
+}
+
 void GcamParallel::TBBFlowGraphBody::operator()( tbb::flow::continue_msg aMessage )
 {
+    ActivityProfiler& profiler = ActivityProfiler::getInstance();
+    const bool isProfiling = profiler.isEnabled();
+    if( isProfiling ) {
+        profiler.startGrain();
+    }
     for( list<FlowGraphNodeType>::const_iterator nodeIt = mNodes.begin();
          nodeIt != mNodes.end(); ++nodeIt )
     {
         if( !mGraph.mCalcList ||
             find( mGraph.mCalcList->begin(), mGraph.mCalcList->end(), *nodeIt ) != mGraph.mCalcList->end() )
         {
-            (*nodeIt)->calc( mGraph.mPeriod );
+            if( isProfiling ) {
+                profiler.calcActivity( *nodeIt, mGraph.mPeriod );
+            }
+            else {
+                (*nodeIt)->calc( mGraph.mPeriod );
+            }
         }
     }
+    if( isProfiling ) {
+        profiler.endGrain( mGrainIndex );
+    }
 }
 
 GcamParallel::TBBFlowGraphBody::TBBFlowGraphBody( const std::set<FlowGraphNodeType>& aNodes,
                                                   const FlowGraph& aTopology,
                                                   const GcamFlowGraph& aGraph )
-:mGraph( aGraph )
+:mGraph( aGraph ), mGrainIndex( -1 )
 {
     ILogger& pgLog = ILogger::getLogger( "parallel-grain-log" );
     pgLog.setLevel( ILogger::NOTICE );
@@ -361,6 +704,20 @@ GcamParallel::TBBFlowGraphBody::TBBFlowGraphBody( const std::set<FlowGraphNodeTy
     pgLog << endl;
 }
 
+/*!
+ * \brief Constructor for a grain whose activities have already been sorted in
+ *        topological order.
+ * \param aNodes The activities in this grain in the order to calculate them.
+ * \param aGraph The TBB flow graph to which this node belongs.
+ * \param aGrainIndex The index of this grain in the grain schedule.
+ */
+GcamParallel::TBBFlowGraphBody::TBBFlowGraphBody( const list<FlowGraphNodeType>& aNodes,
+                                                  const GcamFlowGraph& aGraph,
+                                                  const int aGrainIndex )
+:mNodes( aNodes ), mGraph( aGraph ), mGrainIndex( aGrainIndex )
+{
+}
+
 /*!
  * \brief A helper method used by digraph-output to pretty print
  *        IActivity* objects with it's description as it's label.
@@ -0,0 +1,198 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+/*! 
+ * \file numa_topology.cpp
+ * \ingroup Objects
+ * \brief The NumaTopology class source file.
+ */
+
+#if GCAM_PARALLEL_ENABLED
+#include "util/base/include/definitions.h"
+#include <fstream>
+#include <string>
+#include <tbb/task_scheduler_init.h>
+#include <boost/algorithm/string.hpp>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "parallel/include/numa_topology.hpp"
+#include "util/base/include/util.h"
+
+using namespace std;
+
+namespace {
+    //! The node the calling thread was last bound to, or -1 if it never was.
+    thread_local int gThreadNode = -1;
+    
+#if defined(__linux__)
+    /*!
+     * \brief Read a sysfs list of the form "0-3,8,10-11".
+     * \param aFileName The file to read.
+     * \return The values in the list, empty if the file could not be read.
+     */
+    vector<int> readList( const string& aFileName ) {
+        vector<int> values;
+        ifstream listFile( aFileName.c_str() );
+        string line;
+        if( !listFile || !getline( listFile, line ) ) {
+            return values;
+        }
+        vector<string> ranges;
+        boost::split( ranges, line, boost::is_any_of( "," ) );
+        for( vector<string>::const_iterator it = ranges.begin(); it != ranges.end(); ++it ) {
+            if( it->empty() ) {
+                continue;
+            }
+            const size_t dash = it->find( '-' );
+            const int first = atoi( it->substr( 0, dash ).c_str() );
+            const int last = dash == string::npos ? first : atoi( it->substr( dash + 1 ).c_str() );
+            for( int value = first; value <= last; ++value ) {
+                values.push_back( value );
+            }
+        }
+        return values;
+    }
+#endif
+}
+
+/*!
+ * \brief Get the topology of the machine, which is read the first time it is
+ *        requested.
+ * \return The NUMA topology.
+ */
+const NumaTopology& NumaTopology::getInstance() {
+    static const NumaTopology sInstance;
+    return sInstance;
+}
+
+//! Constructor which reads the topology.
+NumaTopology::NumaTopology() {
+#if defined(__linux__)
+    cpu_set_t processCPUs;
+    CPU_ZERO( &processCPUs );
+    const bool hasProcessCPUs = sched_getaffinity( 0, sizeof( processCPUs ), &processCPUs ) == 0;
+    const string nodeDir = "/sys/devices/system/node/";
+    const vector<int> nodes = readList( nodeDir + "online" );
+    for( vector<int>::const_iterator nodeIt = nodes.begin(); nodeIt != nodes.end(); ++nodeIt ) {
+        const vector<int> cpus = readList( nodeDir + "node" + util::toString( *nodeIt ) + "/cpulist" );
+        vector<int> usableCPUs;
+        for( vector<int>::const_iterator cpuIt = cpus.begin(); cpuIt != cpus.end(); ++cpuIt ) {
+            if( *cpuIt < CPU_SETSIZE && ( !hasProcessCPUs || CPU_ISSET( *cpuIt, &processCPUs ) ) ) {
+                usableCPUs.push_back( *cpuIt );
+            }
+        }
+        // Nodes with only memory can not run threads.
+        if( !usableCPUs.empty() ) {
+            mNodeCPUs.push_back( usableCPUs );
+        }
+    }
+#endif
+    if( mNodeCPUs.empty() ) {
+        // Treat the machine as a single node with unknown CPUs.
+        mNodeCPUs.push_back( vector<int>() );
+    }
+}
+
+/*!
+ * \brief Get the number of nodes which can run threads.
+ * \return The number of nodes, at least one.
+ */
+int NumaTopology::getNumNodes() const {
+    return static_cast<int>( mNodeCPUs.size() );
+}
+
+/*!
+ * \brief Get the number of CPUs which this process can use on a node.
+ * \param aNode The node index.
+ * \return The number of CPUs.
+ */
+int NumaTopology::getNumCPUs( const int aNode ) const {
+    const int numCPUs = static_cast<int>( mNodeCPUs[ aNode ].size() );
+    return numCPUs > 0 ? numCPUs : tbb::task_scheduler_init::default_num_threads();
+}
+
+/*!
+ * \brief Restrict the calling thread to the CPUs of a node.
+ * \param aNode The node index.
+ * \return Whether the thread was bound.
+ */
+bool NumaTopology::bindCurrentThread( const int aNode ) const {
+    gThreadNode = aNode;
+#if defined(__linux__)
+    const vector<int>& cpus = mNodeCPUs[ aNode ];
+    if( !cpus.empty() ) {
+        cpu_set_t nodeCPUs;
+        CPU_ZERO( &nodeCPUs );
+        for( vector<int>::const_iterator it = cpus.begin(); it != cpus.end(); ++it ) {
+            CPU_SET( *it, &nodeCPUs );
+        }
+        return sched_setaffinity( 0, sizeof( nodeCPUs ), &nodeCPUs ) == 0;
+    }
+#endif
+    return false;
+}
+
+/*!
+ * \brief Run a function in the calling thread while it is bound to a node.
+ * \details The thread's previous binding is restored afterwards.  This can be
+ *          used to place memory on a node by writing it in aFunction.
+ * \param aNode The node index.
+ * \param aFunction The function to run.
+ */
+void NumaTopology::runOnNode( const int aNode, const function<void()>& aFunction ) const {
+    const int prevNode = gThreadNode;
+#if defined(__linux__)
+    cpu_set_t prevCPUs;
+    const bool hasPrevCPUs = sched_getaffinity( 0, sizeof( prevCPUs ), &prevCPUs ) == 0;
+#endif
+    bindCurrentThread( aNode );
+    aFunction();
+#if defined(__linux__)
+    if( hasPrevCPUs ) {
+        sched_setaffinity( 0, sizeof( prevCPUs ), &prevCPUs );
+    }
+#endif
+    gThreadNode = prevNode;
+}
+
+/*!
+ * \brief Get the node the calling thread is bound to.
+ * \return The node index or -1 if the thread has not been bound.
+ */
+int NumaTopology::getCurrentThreadNode() {
+    return gThreadNode;
+}
+
+#endif // GCAM_PARALLEL_ENABLED
@@ -0,0 +1,162 @@
+#ifndef _XML_DB_ASYNC_WRITER_H_
+#define _XML_DB_ASYNC_WRITER_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file xml_db_async_writer.h
+ * \ingroup Objects
+ * \brief XMLDBAsyncWriter class header file.
+ */
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <boost/noncopyable.hpp>
+
+/*!
+ * \ingroup Objects
+ * \brief Writes snapshots of scenario results to the XML database on a
+ *        background thread.
+ * \details When asynchronous database output is enabled the XMLDBOutputter will
+ *          generate the XML for a scenario into memory and hand it off to this
+ *          class rather than waiting for the database to consume it.  A single
+ *          background thread processes the submitted requests strictly in the
+ *          order they were received so that any data appended to a document, and
+ *          the final close of the database, happen after the document itself was
+ *          written.  This allows the next scenario, for instance in a batch run,
+ *          to start computing while the previous one is still being written.
+ *
+ *          Memory use is bounded by the "xmldb-async-max-buffer-mb" configuration
+ *          value.  If submitting a new document would exceed that limit the
+ *          calling thread will block until enough previously submitted documents
+ *          have been written.  A document is always accepted if nothing else is
+ *          pending so that progress is guaranteed.
+ *
+ *          The single instance is created on first use and should be shut down by
+ *          calling shutdown() before the program exits to find out if all results
+ *          made it to the database.  It is also shut down when the program exits
+ *          through exit() so that pending results are not lost on error paths.
+ */
+class XMLDBAsyncWriter : private boost::noncopyable {
+public:
+    static XMLDBAsyncWriter* getInstance();
+
+    static bool shutdown();
+
+    void submitDocument( const std::string& aContainerName,
+                         const std::string& aDocName,
+                         std::string&& aData );
+
+    void submitAppend( const std::string& aData, const std::string& aLocation );
+
+    void submitFinalize();
+
+    bool waitForCompletion();
+
+private:
+    XMLDBAsyncWriter();
+    ~XMLDBAsyncWriter();
+
+    static void shutdownAtExit();
+
+    //! A unit of work to be processed by the background thread.
+    struct WriteRequest {
+        //! The type of requests which may be made.
+        enum Type {
+            //! Open a new document in the database and write the data to it.
+            DOCUMENT,
+
+            //! Append data to the currently open document.
+            APPEND,
+
+            //! Finalize and close the database.
+            FINALIZE
+        };
+
+        //! The type of this request.
+        Type mType;
+
+        //! The database location, only used by DOCUMENT.
+        std::string mContainerName;
+
+        //! The document name, only used by DOCUMENT.
+        std::string mDocName;
+
+        //! The XML to write or append.
+        std::string mData;
+
+        //! The XPath to append after, only used by APPEND.
+        std::string mLocation;
+    };
+
+    void processRequests();
+
+    //! The single instance which is lazily created.
+    static XMLDBAsyncWriter* sInstance;
+
+    //! The pending requests in the order they were submitted.
+    std::deque<WriteRequest> mRequests;
+
+    //! The total size of documents that have been submitted but not yet written.
+    size_t mQueuedBytes;
+
+    //! The maximum number of bytes to allow to be queued before blocking.
+    const size_t mMaxQueuedBytes;
+
+    //! If the background thread is currently processing a request.
+    bool mIsBusy;
+
+    //! Flag to indicate the background thread should exit.
+    bool mShouldExit;
+
+    //! If any request processed so far has failed.
+    bool mHasFailed;
+
+    //! Mutex which guards all of the state shared with the background thread.
+    std::mutex mMutex;
+
+    //! Condition which is signaled any time the shared state changes.
+    std::condition_variable mStateChanged;
+
+    //! The background thread which does the writing.
+    std::thread mWriterThread;
+};
+
+#endif // _XML_DB_ASYNC_WRITER_H_
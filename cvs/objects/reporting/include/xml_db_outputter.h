@@ -49,6 +49,7 @@
 #include <iosfwd>
 #include <boost/iostreams/filtering_stream.hpp>
 #include "util/base/include/default_visitor.h"
+#include "util/base/include/ishardable_visitor.h"
 
 #if( __HAVE_JAVA__ )
 #include <jni.h>
@@ -60,11 +61,20 @@ class IndirectEmissionsCalculator;
 /*! 
 * \ingroup Objects
 * \brief A visitor which writes model results to an XML database.
-* \details
+* \details The regions may be written concurrently by way of the IShardableVisitor
+*          interface.  Each region shard writes its XML into an in memory string
+*          which is then forwarded to the database, in region order, on the thread
+*          which owns the Java environment.
+*
+*          If the "xmldb-async-write" configuration flag is set the XML for the
+*          entire scenario will instead be snapshot into memory and handed off to
+*          the XMLDBAsyncWriter so that the model may continue on with the next
+*          scenario while the results are written.
 * \author Josh Lurz
 */
 
-class XMLDBOutputter : public DefaultVisitor {
+class XMLDBOutputter : public DefaultVisitor, public IShardableVisitor {
+    friend class XMLDBAsyncWriter;
 public:
     XMLDBOutputter();
 
@@ -225,10 +235,34 @@ public:
     virtual void endVisitBuildingServiceInput( const BuildingServiceInput* aBuildingServiceInput, const int aPeriod );
 
     bool appendData( const std::string& aData, const std::string& aLocation );
+
+    // IShardableVisitor methods
+    virtual bool shouldShardRegions() const;
+    virtual IVisitor* createRegionShard() const;
+    virtual void mergeRegionShard( IVisitor* aShard );
 private:
+    //! The XML written by a region shard which will be merged back into the
+    //! parent outputter, or the snapshot of the scenario to be written
+    //! asynchronously.  Only used when mIsShard or mIsAsync is set.
+    mutable std::string mBufferedData;
+
     //! A boost iostream which will send output to the DB as it is printed.
     mutable boost::iostreams::filtering_ostream mBuffer;
 
+    //! Flag indicating this instance is a region shard which buffers into
+    //! mBufferedData rather than sending data to the DB.
+    const bool mIsShard;
+
+    //! Flag indicating the output is buffered into mBufferedData and sent to
+    //! the XMLDBAsyncWriter rather than sending data to the DB directly.
+    const bool mIsAsync;
+
+    //! The location of the database to write to.
+    const std::string mContainerName;
+
+    //! The unique name of the document to write in the database.
+    const std::string mDocName;
+
     //! Current region name.
     std::string mCurrentRegion;
 
@@ -296,10 +330,20 @@ private:
     //! the like of the XMLDBOutputter.
     const std::auto_ptr<JNIContainer> mJNIContainer;
 
-    static std::auto_ptr<JNIContainer> createContainer( const bool aTestingOnly );
+    static std::auto_ptr<JNIContainer> createContainer( const bool aTestingOnly,
+                                                        const std::string& aContainerName,
+                                                        const std::string& aDocName );
 #endif
     static const std::string createContainerName( const std::string& aScenarioName );
 
+    static const std::string getContainerLocation();
+
+    static void detachCurrentThread();
+
+    XMLDBOutputter( const Tabs& aTabs );
+
+    XMLDBOutputter( const std::string& aContainerName, const std::string& aDocName );
+
     void writeItemToBuffer( const double aValue,
         const std::string& aName,
         std::ostream& out,
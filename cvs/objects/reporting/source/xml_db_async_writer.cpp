@@ -0,0 +1,276 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file xml_db_async_writer.cpp
+ * \ingroup Objects
+ * \brief XMLDBAsyncWriter class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+#include <cstdlib>
+#include <memory>
+
+#include "reporting/include/xml_db_async_writer.h"
+#include "util/base/include/xml_helper.h"
+#include "util/base/include/time_vector.h"
+#include "reporting/include/xml_db_outputter.h"
+#include "util/base/include/configuration.h"
+#include "util/logger/include/ilogger.h"
+
+using namespace std;
+
+// Static initialize the instance to be null
+XMLDBAsyncWriter* XMLDBAsyncWriter::sInstance = 0;
+
+/*!
+ * \brief Constructor which starts the background writer thread.
+ */
+XMLDBAsyncWriter::XMLDBAsyncWriter():
+mQueuedBytes( 0 ),
+mMaxQueuedBytes( static_cast<size_t>( Configuration::getInstance()->getInt( "xmldb-async-max-buffer-mb", 1024 ) ) * 1024 * 1024 ),
+mIsBusy( false ),
+mShouldExit( false ),
+mHasFailed( false )
+{
+    mWriterThread = thread( &XMLDBAsyncWriter::processRequests, this );
+}
+
+/*!
+ * \brief Destructor which waits for all pending requests to be written and then
+ *        stops the background thread.
+ */
+XMLDBAsyncWriter::~XMLDBAsyncWriter() {
+    {
+        lock_guard<mutex> lock( mMutex );
+        mShouldExit = true;
+    }
+    mStateChanged.notify_all();
+    if( mWriterThread.joinable() ) {
+        mWriterThread.join();
+    }
+}
+
+/*!
+ * \brief Get the single instance, creating it if it did not already exist.
+ * \warning This method should only be called from the main thread.
+ * \return The asynchronous writer.
+ */
+XMLDBAsyncWriter* XMLDBAsyncWriter::getInstance() {
+    if( !sInstance ) {
+        sInstance = new XMLDBAsyncWriter();
+        // Make sure pending output is written even if the model exits early.
+        atexit( &XMLDBAsyncWriter::shutdownAtExit );
+    }
+    return sInstance;
+}
+
+/*!
+ * \brief Wait for all pending output to be written and stop the background thread.
+ * \details This is safe to call even if asynchronous writing was never used.
+ * \return Whether all of the output was written successfully.
+ */
+bool XMLDBAsyncWriter::shutdown() {
+    bool success = true;
+    if( sInstance ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::NOTICE );
+        mainLog << "Waiting for XML database output to complete." << endl;
+        success = sInstance->waitForCompletion();
+        delete sInstance;
+        sInstance = 0;
+        if( !success ) {
+            mainLog.setLevel( ILogger::SEVERE );
+            mainLog << "Failed to write all output to the XML database." << endl;
+        }
+    }
+    return success;
+}
+
+/*!
+ * \brief Shut down the writer when the program exits through exit().
+ * \details Registered with atexit when the instance is created.  This does
+ *          nothing if shutdown() was already called.
+ */
+void XMLDBAsyncWriter::shutdownAtExit() {
+    shutdown();
+}
+
+/*!
+ * \brief Submit a snapshot of scenario results to be written to a new document
+ *        in the database.
+ * \details If the amount of data already queued would exceed the configured limit
+ *          this call will block until the writer has caught up.
+ * \param aContainerName The location of the database.
+ * \param aDocName The unique name of the document to create.
+ * \param aData The XML to write which will be moved from.
+ */
+void XMLDBAsyncWriter::submitDocument( const string& aContainerName,
+                                       const string& aDocName,
+                                       string&& aData )
+{
+    const size_t dataSize = aData.size();
+    WriteRequest request;
+    request.mType = WriteRequest::DOCUMENT;
+    request.mContainerName = aContainerName;
+    request.mDocName = aDocName;
+    request.mData = std::move( aData );
+    {
+        unique_lock<mutex> lock( mMutex );
+        if( mQueuedBytes > 0 && mQueuedBytes + dataSize > mMaxQueuedBytes ) {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::NOTICE );
+            mainLog << "Waiting for previous XML database output to make room." << endl;
+        }
+        mStateChanged.wait( lock, [this, dataSize] {
+            return mQueuedBytes == 0 || mQueuedBytes + dataSize <= mMaxQueuedBytes;
+        } );
+        mQueuedBytes += dataSize;
+        mRequests.push_back( std::move( request ) );
+    }
+    mStateChanged.notify_all();
+}
+
+/*!
+ * \brief Submit data to be appended to the most recently submitted document.
+ * \param aData Data to append.
+ * \param aLocation XPath of the location to add the data.
+ */
+void XMLDBAsyncWriter::submitAppend( const string& aData, const string& aLocation ) {
+    WriteRequest request;
+    request.mType = WriteRequest::APPEND;
+    request.mData = aData;
+    request.mLocation = aLocation;
+    {
+        lock_guard<mutex> lock( mMutex );
+        mRequests.push_back( std::move( request ) );
+    }
+    mStateChanged.notify_all();
+}
+
+/*!
+ * \brief Submit a request to finalize and close the database once all previously
+ *        submitted data has been written.
+ */
+void XMLDBAsyncWriter::submitFinalize() {
+    WriteRequest request;
+    request.mType = WriteRequest::FINALIZE;
+    {
+        lock_guard<mutex> lock( mMutex );
+        mRequests.push_back( std::move( request ) );
+    }
+    mStateChanged.notify_all();
+}
+
+/*!
+ * \brief Block until all submitted requests have been processed.
+ * \return Whether all of the requests processed so far succeeded.
+ */
+bool XMLDBAsyncWriter::waitForCompletion() {
+    unique_lock<mutex> lock( mMutex );
+    mStateChanged.wait( lock, [this] { return mRequests.empty() && !mIsBusy; } );
+    return !mHasFailed;
+}
+
+/*!
+ * \brief The body of the background thread which processes requests in order
+ *        until asked to exit.
+ * \details Any requests still pending when asked to exit will be completed first.
+ *          Note all interaction with Java happens from this thread and it must
+ *          therefore be attached to, and detached from, the Java VM.
+ */
+void XMLDBAsyncWriter::processRequests() {
+    // The outputter which is sending data to the currently open document.
+    auto_ptr<XMLDBOutputter> currWriter;
+    while( true ) {
+        WriteRequest currRequest;
+        {
+            unique_lock<mutex> lock( mMutex );
+            mStateChanged.wait( lock, [this] { return mShouldExit || !mRequests.empty(); } );
+            if( mRequests.empty() ) {
+                // Only exit once all requests have been processed.
+                break;
+            }
+            currRequest = std::move( mRequests.front() );
+            mRequests.pop_front();
+            mIsBusy = true;
+        }
+
+        const size_t dataSize = currRequest.mType == WriteRequest::DOCUMENT ? currRequest.mData.size() : 0;
+        bool success = true;
+        switch( currRequest.mType ) {
+            case WriteRequest::DOCUMENT:
+                // Close out any previous document which was not explicitly finalized.
+                if( currWriter.get() ) {
+                    currWriter->finalizeAndClose();
+                }
+                currWriter.reset( new XMLDBOutputter( currRequest.mContainerName, currRequest.mDocName ) );
+#if( __HAVE_JAVA__ )
+                // An error message will have been printed if the database could
+                // not be opened.
+                success = currWriter->mJNIContainer.get() != 0;
+#endif
+                currWriter->mBuffer.write( currRequest.mData.data(), currRequest.mData.size() );
+                currWriter->finish();
+                break;
+            case WriteRequest::APPEND:
+                success = currWriter.get() && currWriter->appendData( currRequest.mData, currRequest.mLocation );
+                break;
+            case WriteRequest::FINALIZE:
+                if( currWriter.get() ) {
+                    currWriter->finalizeAndClose();
+                    currWriter.reset( 0 );
+                }
+                break;
+            default:
+                assert( false );
+        }
+        // Release the memory before signaling it is available.
+        string().swap( currRequest.mData );
+
+        {
+            lock_guard<mutex> lock( mMutex );
+            mQueuedBytes -= dataSize;
+            mHasFailed |= !success;
+            mIsBusy = false;
+        }
+        mStateChanged.notify_all();
+    }
+
+    if( currWriter.get() ) {
+        currWriter->finalizeAndClose();
+        currWriter.reset( 0 );
+    }
+    XMLDBOutputter::detachCurrentThread();
+}
@@ -125,6 +125,7 @@
 #if( !__HAVE_JAVA__ )
 #include <boost/iostreams/device/null.hpp>
 #endif
+#include <boost/iostreams/device/back_inserter.hpp>
 
 #include <ctime>
 
@@ -134,6 +135,7 @@
 #include <boost/math/tr1.hpp>
 
 #include "reporting/include/xml_db_outputter.h"
+#include "reporting/include/xml_db_async_writer.h"
 
 extern Scenario* scenario; // for modeltime
 
@@ -179,10 +181,15 @@ XMLDBOutputter::JNIContainer::~JNIContainer() {
 /*! \brief Constructor
 */
 XMLDBOutputter::XMLDBOutputter():
+mIsShard( false ),
+mIsAsync( Configuration::getInstance()->getBool( "xmldb-async-write", false, false ) ),
+mContainerName( getContainerLocation() ),
+mDocName( createContainerName( scenario->getName() ) ),
 mTabs( new Tabs ),
 mGDP( 0 )
 #if( __HAVE_JAVA__ )
-,mJNIContainer( createContainer( false ) )
+// Java will not be used directly when writing asynchronously.
+,mJNIContainer( mIsAsync ? 0 : createContainer( false, mContainerName, mDocName ).release() )
 #endif
 {
 #if( DEBUG_XML_DB )
@@ -193,6 +200,59 @@ mGDP( 0 )
     mBuffer.push( teeDebugFilter );
 #endif
 
+    if( mIsAsync ) {
+        // Snapshot the results into memory to be written later.
+        mBuffer.push( boost::iostreams::back_inserter( mBufferedData ) );
+        return;
+    }
+
+#if( __HAVE_JAVA__ )
+    // Set Java as the sink of data for mBuffer.
+    SendToJavaIOSink sendToJavaSink( mJNIContainer.get() );
+    mBuffer.push( sendToJavaSink );
+#else
+    mBuffer.push( null_sink() );
+#endif
+}
+
+/*!
+ * \brief Constructor for a region shard.
+ * \details A shard does not communicate with Java at all and instead writes
+ *          all of its XML into mBufferedData so that it can be safely used from
+ *          any thread.
+ * \param aTabs The current indentation of the parent outputter.
+ */
+XMLDBOutputter::XMLDBOutputter( const Tabs& aTabs ):
+mIsShard( true ),
+mIsAsync( false ),
+mTabs( new Tabs( aTabs ) ),
+mGDP( 0 )
+#if( __HAVE_JAVA__ )
+,mJNIContainer( 0 )
+#endif
+{
+    mBuffer.push( boost::iostreams::back_inserter( mBufferedData ) );
+}
+
+/*!
+ * \brief Constructor used by the XMLDBAsyncWriter to write a previously generated
+ *        snapshot to the database.
+ * \details The container and document names are given explicitly since the
+ *          scenario which generated the snapshot may no longer exist.
+ * \param aContainerName The location of the database.
+ * \param aDocName The unique name of the document to create.
+ */
+XMLDBOutputter::XMLDBOutputter( const string& aContainerName, const string& aDocName ):
+mIsShard( false ),
+mIsAsync( false ),
+mContainerName( aContainerName ),
+mDocName( aDocName ),
+mTabs( new Tabs ),
+mGDP( 0 )
+#if( __HAVE_JAVA__ )
+,mJNIContainer( createContainer( false, mContainerName, mDocName ) )
+#endif
+{
 #if( __HAVE_JAVA__ )
     // Set Java as the sink of data for mBuffer.
     SendToJavaIOSink sendToJavaSink( mJNIContainer.get() );
@@ -223,7 +283,7 @@ XMLDBOutputter::~XMLDBOutputter(){
  */
 bool XMLDBOutputter::checkJavaWorking() {
 #if( __HAVE_JAVA__ )
-    auto_ptr<JNIContainer> testContainer = createContainer( true );
+    auto_ptr<JNIContainer> testContainer = createContainer( true, "", "" );
     // if we get back a null container then some error occured
     // createContainer would have already print any error messages.
     return testContainer.get();
@@ -243,6 +303,14 @@ void XMLDBOutputter::finish() const {
     // Close mBuffer so that no more data can be written.
     close( mBuffer, ios_base::out );
 
+    if( mIsAsync ) {
+        // Hand the snapshot off to be written in the background.  Note this may
+        // block if too much data is already waiting to be written.
+        XMLDBAsyncWriter::getInstance()->submitDocument( mContainerName, mDocName, std::move( mBufferedData ) );
+        mBufferedData.clear();
+        return;
+    }
+
 #if( __HAVE_JAVA__ )
     if( !mJNIContainer.get() ) {
         // Failed to start Java, just return as an appropriate error message would
@@ -272,6 +340,11 @@ void XMLDBOutputter::finish() const {
  *          It may potentially run queries if configured then close the database.
  */
 void XMLDBOutputter::finalizeAndClose() {
+    if( mIsAsync ) {
+        // The database will be closed once all of the data has been written.
+        XMLDBAsyncWriter::getInstance()->submitFinalize();
+        return;
+    }
 #if( __HAVE_JAVA__ )
     // Call finalizeAndClose on the XMLDBDriver if it was successfully opened in the first place.
     if( mJNIContainer.get() ) {
@@ -293,17 +366,60 @@ void XMLDBOutputter::finalizeAndClose() {
 #endif
 }
 
+/*!
+ * \brief Whether the regions should be written concurrently.
+ * \details Sharding is only useful when the model has been built with parallel
+ *          support and may be disabled with the "sharded-region-output"
+ *          configuration flag.  A shard will never shard further.
+ * \return True if World should visit regions using region shards.
+ */
+bool XMLDBOutputter::shouldShardRegions() const {
+#if GCAM_PARALLEL_ENABLED
+    return !mIsShard && Configuration::getInstance()->getBool( "sharded-region-output", true, false );
+#else
+    return false;
+#endif
+}
+
+/*!
+ * \brief Create an outputter which will buffer the XML for a single region.
+ * \return A new region shard which the caller is responsible for deleting.
+ */
+IVisitor* XMLDBOutputter::createRegionShard() const {
+    return new XMLDBOutputter( *mTabs );
+}
+
+/*!
+ * \brief Forward the XML written by a region shard to the database.
+ * \details This must be called from the thread that created this outputter
+ *          since the data will be sent on to Java.
+ * \param aShard A region shard previously created by createRegionShard.
+ */
+void XMLDBOutputter::mergeRegionShard( IVisitor* aShard ) {
+    XMLDBOutputter* shard = static_cast<XMLDBOutputter*>( aShard );
+    assert( shard->mIsShard );
+    // Make sure all data has been flushed into the shard's string.
+    close( shard->mBuffer, ios_base::out );
+    mBuffer.write( shard->mBufferedData.data(), shard->mBufferedData.size() );
+    shard->mBufferedData.clear();
+}
+
 #if( __HAVE_JAVA__ )
 /*!
  * \brief Create an initialized Java environment.
  * \param aTestingOnly A flag if set indicates we don't want to actually start the
  *                     process for writing, instead are only interested if all of
  *                     the Java machinery is in place to successfully write to the DB.
+ * \param aContainerName The location of the database.
+ * \param aDocName The unique name of the document to create.
  * \return An initialized Java environment with the Write DB class loaded and
  *         ready to accept data to write/alter to the database.  If an error occurs
  *         a null container will be returned.
  */
-auto_ptr<XMLDBOutputter::JNIContainer> XMLDBOutputter::createContainer( const bool aTestingOnly ) {
+auto_ptr<XMLDBOutputter::JNIContainer> XMLDBOutputter::createContainer( const bool aTestingOnly,
+                                                                        const string& aContainerName,
+                                                                        const string& aDocName )
+{
     // Create a Java instance.
     auto_ptr<JNIContainer> jniContainer( new JNIContainer );
 
@@ -381,19 +497,9 @@ auto_ptr<XMLDBOutputter::JNIContainer> XMLDBOutputter::createContainer( const bo
         return jniContainer;
     }
 
-    // Get the location to open the environment.
-    string xmldbContainerName = conf->getFile( "xmldb-location", "database_basexdb" );
-    if( conf->shouldAppendScnToFile( "xmldb-location") ) {
-        // note that util::appendScenarioToFileName searches for a '.' between which to insert
-        // the scenario name however a '.' is not a valid character in a BaseX DB name so we
-        // will just append it to the end.
-        xmldbContainerName = xmldbContainerName.append( scenario->getName() );
-    }
-    const string docName = createContainerName( scenario->getName() );
-
     // Convert the C++ string to a Java String so that they can be passed to the constructor.
-    jstring jXMLDBContainerName = jniContainer->mJavaEnv->NewStringUTF( xmldbContainerName.c_str() );
-    jstring jDocName = jniContainer->mJavaEnv->NewStringUTF( docName.c_str() );
+    jstring jXMLDBContainerName = jniContainer->mJavaEnv->NewStringUTF( aContainerName.c_str() );
+    jstring jDocName = jniContainer->mJavaEnv->NewStringUTF( aDocName.c_str() );
 
     // Call the constructor to get an instance of writeDBClassName.
     jniContainer->mWriteDBInstance = jniContainer->mJavaEnv->NewGlobalRef(
@@ -410,6 +516,35 @@ auto_ptr<XMLDBOutputter::JNIContainer> XMLDBOutputter::createContainer( const bo
 }
 #endif
 
+/*!
+ * \brief Get the location of the database to write to for the current scenario.
+ * \return The database location.
+ */
+const string XMLDBOutputter::getContainerLocation() {
+    const Configuration* conf = Configuration::getInstance();
+    string xmldbContainerName = conf->getFile( "xmldb-location", "database_basexdb" );
+    if( conf->shouldAppendScnToFile( "xmldb-location") ) {
+        // note that util::appendScenarioToFileName searches for a '.' between which to insert
+        // the scenario name however a '.' is not a valid character in a BaseX DB name so we
+        // will just append it to the end.
+        xmldbContainerName = xmldbContainerName.append( scenario->getName() );
+    }
+    return xmldbContainerName;
+}
+
+/*!
+ * \brief Detach the calling thread from the Java VM.
+ * \details Threads other than the main thread which interacted with Java must
+ *          call this before they exit.
+ */
+void XMLDBOutputter::detachCurrentThread() {
+#if( __HAVE_JAVA__ )
+    if( JNIContainer::mJavaVM ) {
+        JNIContainer::mJavaVM->DetachCurrentThread();
+    }
+#endif
+}
+
 /*! \brief Create a unique name for the container given a scenario name.
 * \param aScenarioName Name of the scenario.
 * \return A unique container name.
@@ -445,6 +580,13 @@ bool XMLDBOutputter::appendData( const string& aData, const string& aLocation )
         return false;
     }
 
+    if( mIsAsync ) {
+        // The data will be appended once the document has been written, wait
+        // for that to happen so that the result can be reported.
+        XMLDBAsyncWriter::getInstance()->submitAppend( aData, aLocation );
+        return XMLDBAsyncWriter::getInstance()->waitForCompletion();
+    }
+
 #if( __HAVE_JAVA__ )
     // Check if creating the container failed.
     if( !mJNIContainer.get() ){
@@ -109,6 +109,8 @@ public:
     virtual void calc( const int aPeriod );
 
     virtual std::string getDescription() const;
+    
+    virtual const void* getCalcObject() const;
 
 private:
     //! A weak reference to the sector that will do the work
@@ -74,6 +74,7 @@ class ILandAllocator;
 class IndirectEmissionsCalculator;
 class AGHG;
 class IDiscreteChoice;
+class ShareWeightCalibrationPlan;
 
 // Need to forward declare the subclasses as well.
 class SupplySector;
@@ -105,6 +106,7 @@ class Sector: public IVisitable,
     friend class SGMGenTable;
     friend class XMLDBOutputter;
     friend class CalibrateShareWeightVisitor;
+    friend class ShareWeightCalibrationPlan;
 protected:
     
     DEFINE_DATA(
@@ -158,6 +160,10 @@ protected:
     typedef std::vector<object_meta_info_type> object_meta_info_vector_type;
     object_meta_info_vector_type mObjectMetaInfo; //!< Vector of object meta info to pass to mSectorInfo
 
+    //! The share weight calibration for the current period if it is a
+    //! calibration period, built during initCalc.
+    std::auto_ptr<ShareWeightCalibrationPlan> mCalibrationPlan;
+
     virtual void toInputXMLDerived( std::ostream& aOut, Tabs* aTabs ) const = 0;
     virtual void toDebugXMLDerived( const int period, std::ostream& aOut, Tabs* aTabs ) const = 0;
     virtual bool XMLDerivedClassParse( const std::string& nodeName, const xercesc::DOMNode* curr ) = 0;
@@ -190,6 +196,8 @@ public:
 
     bool isAllCalibrated( const int period, double calAccuracy, const bool printWarnings ) const;
 
+    bool calibrateShareWeights( const GDP* aGDP, const int aPeriod );
+
     virtual void supply( const GDP* aGDP,
                          const int aPeriod ) = 0;
 
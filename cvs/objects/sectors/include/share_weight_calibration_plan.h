@@ -0,0 +1,152 @@
+#ifndef _SHARE_WEIGHT_CALIBRATION_PLAN_H_
+#define _SHARE_WEIGHT_CALIBRATION_PLAN_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file share_weight_calibration_plan.h
+ * \ingroup Objects
+ * \brief ShareWeightCalibrationPlan class header file.
+ */
+
+#include <vector>
+#include <boost/core/noncopyable.hpp>
+
+class Sector;
+class Subsector;
+class ITechnology;
+class GDP;
+
+/*! 
+ * \ingroup Objects
+ * \brief The share weight calibration of a single sector for a single period
+ *        precompiled into flat lists of targets.
+ * \details Performs the same calibration as the CalibrateShareWeightVisitor,
+ *          see it for details of the methodology.  Everything which does not
+ *          change during a period's solve, the calibration values, the anchor
+ *          subsector and technologies, which children participate, and the
+ *          fuel preference elasticities, is found once when the plan is built
+ *          during initCalc.  The plan holds direct pointers to the subsectors
+ *          and new vintage technologies so that applying it each time the
+ *          sector prices are calculated only needs to update costs and share
+ *          weights rather than traverse the sector with a visitor.
+ *
+ *          Warnings about inconsistent calibration values are written when the
+ *          plan is built rather than on each application.
+ * \sa CalibrateShareWeightVisitor
+ */
+class ShareWeightCalibrationPlan : private boost::noncopyable {
+public:
+    ShareWeightCalibrationPlan( const Sector* aSector, const int aPeriod );
+
+    //! The period this plan was built for.
+    int getPeriod() const {
+        return mPeriod;
+    }
+
+    void apply( const GDP* aGDP ) const;
+
+private:
+    //! A technology which may have its share weight calibrated.
+    struct TechnologyTarget {
+        //! The new vintage technology for the period.
+        ITechnology* mTechnology;
+
+        //! The calibration output or -1 if it is not calibrated.
+        double mCalOutput;
+
+        //! The fuel preference elasticity.
+        double mFuelPrefElasticity;
+    };
+
+    //! A subsector which may have its share weight calibrated along with the
+    //! technologies it contains.
+    struct SubsectorTarget {
+        //! The subsector.
+        Subsector* mSubsector;
+
+        //! The total calibration output of the subsector.
+        double mCalOutput;
+
+        //! The fuel preference elasticity.
+        double mFuelPrefElasticity;
+
+        //! The technologies contained in the subsector.
+        std::vector<TechnologyTarget> mTechnologies;
+
+        //! Index into mTechnologies of the technology to anchor share weights to.
+        int mAnchorIndex;
+
+        //! The sum of calibration outputs of all calibrated technologies.
+        double mTotalCalValue;
+
+        //! Whether any technology had a calibration value.
+        bool mHasCalValues;
+
+        //! The number of calibrated technologies.
+        int mNumCalTechnologies;
+    };
+
+    //! The sector being calibrated.
+    const Sector* mSector;
+
+    //! The period this plan was built for.
+    const int mPeriod;
+
+    //! The subsectors contained in the sector.
+    std::vector<SubsectorTarget> mSubsectors;
+
+    //! Index into mSubsectors of the subsector to anchor share weights to.
+    int mAnchorIndex;
+
+    //! The sum of calibration outputs of all calibrated subsectors.
+    double mTotalCalValue;
+
+    //! Whether any subsector had a calibration value.
+    bool mHasCalValues;
+
+    //! The number of calibrated subsectors.
+    int mNumCalSubsectors;
+
+    void initSubsector( SubsectorTarget& aTarget ) const;
+
+    void applySubsector( const SubsectorTarget& aTarget, const GDP* aGDP ) const;
+
+    void applySector( const GDP* aGDP ) const;
+};
+
+#endif // _SHARE_WEIGHT_CALIBRATION_PLAN_H_
@@ -59,6 +59,10 @@
 #include "util/base/include/time_vector.h"
 #include "util/base/include/data_definition_util.h"
 
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
 // Forward declarations
 class Summary;
 class ITechnologyContainer;
@@ -77,6 +81,7 @@ class Demographics;
 class IndirectEmissionsCalculator;
 class InterpolationRule;
 class IDiscreteChoice;
+class ITechnology;
 
 // Need to forward declare the subclasses as well.
 class TranSubsector;
@@ -109,6 +114,7 @@ class Subsector: public INamed,
     // be necessary
     friend class SetShareWeightVisitor;
     friend class CalibrateShareWeightVisitor;
+    friend class ShareWeightCalibrationPlan;
 private:
     void clear();
     void clearInterpolationRules();
@@ -167,6 +173,67 @@ protected:
 
     virtual void interpolateShareWeights( const int aPeriod );
     std::map<std::string,int> baseTechNameMap; //!< Map of base technology name to integer position in vector. 
+
+    /*!
+     * \brief A precompiled layout of the technology share calculation for a
+     *        single period.
+     * \details The share weights and costs of the technologies whose shares
+     *          are the standard discrete choice share are gathered directly
+     *          from their values into flat buffers so that their shares can be
+     *          calculated in a single batched call to the discrete choice
+     *          function.  The values are read each time as they may change
+     *          during the period.  All other technologies are evaluated
+     *          individually.
+     */
+    struct TechShareKernel {
+        TechShareKernel():mPeriod( -1 ) {}
+
+        //! The period for which the kernel was built, -1 if not built.
+        int mPeriod;
+
+        //! Indices into mTechContainers of the standard share technologies.
+        std::vector<unsigned int> mStandardIndices;
+
+        //! The share weights of the standard share technologies.
+        std::vector<const Value*> mShareWeights;
+
+        //! The costs in mPeriod of the standard share technologies.
+        std::vector<const Value*> mCosts;
+
+        //! Positions in mStandardIndices of the technologies which may have a
+        //! fuel preference elasticity.
+        std::vector<unsigned int> mFuelPrefPositions;
+
+        //! The technologies at mFuelPrefPositions.
+        std::vector<const ITechnology*> mFuelPrefTechs;
+
+        //! Indices into mTechContainers of all other technologies.
+        std::vector<unsigned int> mOtherIndices;
+
+        //! Buffers which the values are gathered into and shares calculated in.
+        struct Buffers {
+            void resize( const size_t aSize ) {
+                mShareWeights.resize( aSize );
+                mCosts.resize( aSize );
+                mLogShares.resize( aSize );
+            }
+            std::vector<double> mShareWeights;
+            std::vector<double> mCosts;
+            std::vector<double> mLogShares;
+        };
+
+        //! The buffers, per thread as shares may be calculated concurrently.
+#if GCAM_PARALLEL_ENABLED
+        mutable tbb::enumerable_thread_specific<Buffers> mBuffers;
+#else
+        mutable Buffers mBuffers;
+#endif
+    };
+
+    //! The compiled technology share calculation for the current period.
+    TechShareKernel mTechShareKernel;
+
+    void compileTechShareKernel( const int aPeriod );
     typedef std::vector<BaseTechnology*>::const_iterator CBaseTechIterator;
     typedef std::vector<BaseTechnology*>::iterator BaseTechIterator;
 
@@ -175,3 +175,8 @@ string CalcFixedOutputActivity::getDescription() const {
     return mSector->mRegionName + " " + mSector->getName() + "-fixed-output";
 }
 
+const void* CalcFixedOutputActivity::getCalcObject() const {
+    // Identify the sector the same way as its sector activity does.
+    return static_cast<const Sector*>( mSector );
+}
+
@@ -72,6 +72,7 @@
 #include "functions/include/idiscrete_choice.hpp"
 #include "functions/include/discrete_choice_factory.hpp"
 #include "containers/include/market_dependency_finder.h"
+#include "sectors/include/share_weight_calibration_plan.h"
 
 using namespace std;
 using namespace xercesc;
@@ -368,6 +369,34 @@ void Sector::initCalc( NationalAccount* aNationalAccount,
     for ( unsigned int i = 0; i < mSubsectors.size(); ++i ){
         mSubsectors[ i ]->initCalc( aNationalAccount, aDemographics, 0, aPeriod );
     }
+
+    // Build the share weight calibration for this period now that the calibration
+    // values are set so that it does not need to be rediscovered each time prices
+    // are calculated.
+    static const bool calibrationActive = Configuration::getInstance()->getBool( "CalibrationActive" );
+    if( calibrationActive && aPeriod <= scenario->getModeltime()->getFinalCalibrationPeriod() ) {
+        mCalibrationPlan.reset( new ShareWeightCalibrationPlan( this, aPeriod ) );
+    }
+    else {
+        mCalibrationPlan.reset();
+    }
+}
+
+/*!
+ * \brief Calibrate the subsector and technology share weights to reproduce the
+ *        calibration values at the current prices.
+ * \details Uses the calibration plan built during initCalc.
+ * \param aGDP The regional GDP.
+ * \param aPeriod Model period.
+ * \return Whether a calibration plan was available for aPeriod, if not the
+ *         caller must calibrate by other means.
+ */
+bool Sector::calibrateShareWeights( const GDP* aGDP, const int aPeriod ) {
+    if( !mCalibrationPlan.get() || mCalibrationPlan->getPeriod() != aPeriod ) {
+        return false;
+    }
+    mCalibrationPlan->apply( aGDP );
+    return true;
 }
 
 /*! \brief Test to see if calibration worked for this sector
@@ -0,0 +1,293 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file share_weight_calibration_plan.cpp
+ * \ingroup Objects
+ * \brief ShareWeightCalibrationPlan class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+#include <boost/math/tr1.hpp>
+
+#include "sectors/include/share_weight_calibration_plan.h"
+#include "technologies/include/technology_container.h"
+#include "technologies/include/itechnology.h"
+#include "sectors/include/subsector.h"
+#include "sectors/include/sector.h"
+#include "containers/include/gdp.h"
+#include "util/logger/include/ilogger.h"
+#include "functions/include/idiscrete_choice.hpp"
+
+using namespace std;
+
+/*!
+ * \brief Constructor which builds the plan.
+ * \param aSector The sector to calibrate which must have completed initCalc
+ *        for aPeriod.
+ * \param aPeriod The period to calibrate.
+ */
+ShareWeightCalibrationPlan::ShareWeightCalibrationPlan( const Sector* aSector, const int aPeriod ):
+mSector( aSector ),
+mPeriod( aPeriod ),
+mAnchorIndex( -1 ),
+mTotalCalValue( 0 ),
+mHasCalValues( false ),
+mNumCalSubsectors( 0 )
+{
+    mSubsectors.resize( aSector->mSubsectors.size() );
+    double maxCalValue = 0;
+    for( int subsectorIndex = 0; subsectorIndex < mSubsectors.size(); ++subsectorIndex ) {
+        SubsectorTarget& target = mSubsectors[ subsectorIndex ];
+        Subsector* currSubsector = aSector->mSubsectors[ subsectorIndex ];
+        target.mSubsector = currSubsector;
+        target.mCalOutput = currSubsector->getTotalCalOutputs( aPeriod );
+        target.mFuelPrefElasticity = currSubsector->mFuelPrefElasticity[ aPeriod ];
+        initSubsector( target );
+
+        double currCalValue = target.mCalOutput;
+        bool isAllFixed = currSubsector->containsOnlyFixedOutputTechnologies( aPeriod )
+            || currSubsector->mShareWeights[ aPeriod ] == 0;
+
+        // check if the subsector is calibrated
+        if( mHasCalValues && currCalValue == 0 && !isAllFixed ) {
+            // warn that we mixed calibrated and variable technologies
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            ILogger& calibrationLog = ILogger::getLogger( "calibration_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            calibrationLog.setLevel( ILogger::WARNING );
+            mainLog << "Mixed calibrated and variable subsectors or read a zero calibration value in Region: "
+                << aSector->mRegionName << " in sector: " << aSector->getName()
+                << " for Subsector: " << currSubsector->getName() << endl;
+            calibrationLog << "Mixed calibrated and variable subsectors or read a zero calibration value in Region: "
+                << aSector->mRegionName << " in sector: " << aSector->getName()
+                << " for Subsector: " << currSubsector->getName() << endl;
+        }
+        else if( currCalValue > 0 ) {
+            mHasCalValues = true;
+        }
+
+        // If the calibrated value > 0 then increase the number of subsectors to calibrate
+        // and include it in the total sum.
+        if( currCalValue > 0 ) {
+            ++mNumCalSubsectors;
+            mTotalCalValue += currCalValue;
+        }
+
+        // attempt to locate the largest subsector
+        if( currCalValue > maxCalValue ) {
+            maxCalValue = currCalValue;
+            mAnchorIndex = subsectorIndex;
+        }
+    }
+}
+
+/*!
+ * \brief Find the new vintage technologies of a subsector and their
+ *        calibration values.
+ * \param aTarget The subsector target to fill in, mSubsector must be set.
+ */
+void ShareWeightCalibrationPlan::initSubsector( SubsectorTarget& aTarget ) const {
+    const bool hasRequired = false;
+    const string requiredName = "";
+    const Subsector* subsector = aTarget.mSubsector;
+    aTarget.mAnchorIndex = -1;
+    aTarget.mTotalCalValue = 0;
+    aTarget.mHasCalValues = false;
+    aTarget.mNumCalTechnologies = 0;
+    aTarget.mTechnologies.resize( subsector->mTechContainers.size() );
+    double maxCalValue = -1;
+    for( int techIndex = 0; techIndex < aTarget.mTechnologies.size(); ++techIndex ) {
+        TechnologyTarget& techTarget = aTarget.mTechnologies[ techIndex ];
+        ITechnology* currTech = subsector->mTechContainers[ techIndex ]->getNewVintageTechnology( mPeriod );
+        techTarget.mTechnology = currTech;
+        techTarget.mCalOutput = currTech->getCalibrationOutput( hasRequired, requiredName, mPeriod );
+        techTarget.mFuelPrefElasticity = currTech->calcFuelPrefElasticity( mPeriod );
+
+        double currCalValue = techTarget.mCalOutput;
+        bool isAvailable = currTech->isAvailable( mPeriod );
+
+        // check if we have calibrated technologies
+        if( aTarget.mHasCalValues && currCalValue == -1 && isAvailable ) {
+            // log that we have inconsistent calibrated and variable technologies
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            ILogger& calibrationLog = ILogger::getLogger( "calibration_log" );
+            calibrationLog.setLevel( ILogger::WARNING );
+            mainLog << "Mixed calibrated and variable subsectors in Region: " << mSector->mRegionName
+                << " in sector: " << mSector->getName()
+                << " for technology: " << currTech->getName()  << endl;
+            calibrationLog << "Mixed calibrated and variable subsectors in Region: " << mSector->mRegionName
+                << " in sector: " << mSector->getName()
+                << " for technology: " << currTech->getName()  << endl;
+        }
+        else if( isAvailable && currCalValue != -1 ) {
+            aTarget.mHasCalValues = true;
+        }
+
+        // If the calibrated value > 0 then increase the number of technologies to calibrate
+        // and include it in the total sum.
+        if( currCalValue > 0 ) {
+            ++aTarget.mNumCalTechnologies;
+            aTarget.mTotalCalValue += currCalValue;
+        }
+
+        // attempt to locate the largest technology
+        if( currCalValue > maxCalValue ) {
+            maxCalValue = currCalValue;
+            aTarget.mAnchorIndex = techIndex;
+        }
+    }
+}
+
+/*!
+ * \brief Calibrate the share weights of the sector at the current prices.
+ * \details The technologies in each subsector are calibrated first since the
+ *          subsector prices depend on them.
+ * \param aGDP The regional GDP.
+ */
+void ShareWeightCalibrationPlan::apply( const GDP* aGDP ) const {
+    for( vector<SubsectorTarget>::const_iterator it = mSubsectors.begin(); it != mSubsectors.end(); ++it ) {
+        applySubsector( *it, aGDP );
+    }
+    applySector( aGDP );
+}
+
+/*!
+ * \brief Update technology costs and calibrate technology share weights for a
+ *        single subsector.
+ * \param aTarget The subsector to calibrate.
+ * \param aGDP The regional GDP.
+ */
+void ShareWeightCalibrationPlan::applySubsector( const SubsectorTarget& aTarget, const GDP* aGDP ) const {
+    const vector<TechnologyTarget>& techs = aTarget.mTechnologies;
+
+    // Make sure that the technologies have calculated their costs.
+    for( vector<TechnologyTarget>::const_iterator it = techs.begin(); it != techs.end(); ++it ) {
+        it->mTechnology->calcCost( mSector->mRegionName, mSector->getName(), mPeriod );
+    }
+
+    // The base cost is equal to the highest cost technology that has a share if we
+    // have calibration data.  Otherwise, it is equal to the highest cost technology
+    // that has a valid cost.
+    double baseCost = 0;
+    for( vector<TechnologyTarget>::const_iterator it = techs.begin(); it != techs.end(); ++it ) {
+        double currCost = it->mTechnology->getCost( mPeriod );
+        if( !boost::math::isnan( currCost ) && currCost > baseCost &&
+            ( ( aTarget.mHasCalValues && it->mCalOutput > 0 ) || !aTarget.mHasCalValues ) )
+        {
+            baseCost = currCost;
+        }
+    }
+    // In the case where there is only one technology we will reset the base-price
+    // to one as the sharing should not matter.
+    if( baseCost == 0 && techs.size() == 1 ) {
+        baseCost = 1;
+    }
+    aTarget.mSubsector->mDiscreteChoiceModel->setBaseCost( baseCost, aTarget.mSubsector->getName() );
+
+    // do calibration if we have cal values and there are more than one technologies in this nest
+    if( aTarget.mHasCalValues && aTarget.mNumCalTechnologies > 1 ) {
+        // we should have found a technology to have share weights anchored by
+        assert( aTarget.mAnchorIndex != -1 );
+        const TechnologyTarget& anchor = techs[ aTarget.mAnchorIndex ];
+        const double scaledGdpPerCapita = aGDP->getBestScaledGDPperCap( mPeriod );
+        const double anchorPrice = anchor.mTechnology->getCost( mPeriod );
+        const double anchorShare = ( anchor.mCalOutput / aTarget.mTotalCalValue )
+            / pow( scaledGdpPerCapita, anchor.mFuelPrefElasticity );
+
+        for( vector<TechnologyTarget>::const_iterator it = techs.begin(); it != techs.end(); ++it ) {
+            double currShare = ( it->mCalOutput / aTarget.mTotalCalValue )
+                / pow( scaledGdpPerCapita, it->mFuelPrefElasticity );
+
+            // only set share weights for valid technologies
+            if( currShare > 0 ) {
+                double currPrice = it->mTechnology->getCost( mPeriod );
+                double currShareWeight = aTarget.mSubsector->mDiscreteChoiceModel->calcShareWeight( currShare, currPrice,
+                    anchorShare, anchorPrice, mPeriod );
+                it->mTechnology->setShareWeight( currShareWeight );
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Calibrate the subsector share weights.
+ * \param aGDP The regional GDP.
+ */
+void ShareWeightCalibrationPlan::applySector( const GDP* aGDP ) const {
+    // The base cost is equal to the highest cost subsector that has a share if we
+    // have calibration data.  Otherwise, it is equal to the highest cost subsector
+    // that has a valid cost.
+    double baseCost = 0;
+    for( vector<SubsectorTarget>::const_iterator it = mSubsectors.begin(); it != mSubsectors.end(); ++it ) {
+        double currCost = it->mSubsector->getPrice( aGDP, mPeriod );
+        if( !boost::math::isnan( currCost ) && currCost > baseCost &&
+            ( ( mHasCalValues && it->mCalOutput > 0 ) || !mHasCalValues ) )
+        {
+            baseCost = currCost;
+        }
+    }
+    // In the case where there is only one subsector we will reset the base-price
+    // to one as the sharing should not matter.
+    if( baseCost == 0 && mSubsectors.size() == 1 ) {
+        baseCost = 1;
+    }
+    mSector->mDiscreteChoiceModel->setBaseCost( baseCost, mSector->getName() );
+
+    // do calibration if we have cal values and there are more than one subsector in this nest
+    if( mHasCalValues && mNumCalSubsectors > 1 ) {
+        // we should have found a subsector to have share weights anchored
+        assert( mAnchorIndex != -1 );
+        const SubsectorTarget& anchor = mSubsectors[ mAnchorIndex ];
+        const double scaledGdpPerCapita = aGDP->getBestScaledGDPperCap( mPeriod );
+        const double anchorPrice = anchor.mSubsector->getPrice( aGDP, mPeriod );
+        const double anchorShare = ( anchor.mCalOutput / mTotalCalValue )
+            / pow( scaledGdpPerCapita, anchor.mFuelPrefElasticity );
+        assert( anchorShare > 0 );
+
+        for( vector<SubsectorTarget>::const_iterator it = mSubsectors.begin(); it != mSubsectors.end(); ++it ) {
+            double currShare = ( it->mCalOutput / mTotalCalValue )
+                / pow( scaledGdpPerCapita, it->mFuelPrefElasticity );
+
+            // only set the share weight for valid subsectors
+            if( currShare > 0 ) {
+                double currPrice = it->mSubsector->getPrice( aGDP, mPeriod );
+                double currShareWeight = mSector->mDiscreteChoiceModel->calcShareWeight( currShare, currPrice,
+                    anchorShare, anchorPrice, mPeriod );
+                it->mSubsector->mShareWeights[ mPeriod ] = currShareWeight;
+            }
+        }
+    }
+}
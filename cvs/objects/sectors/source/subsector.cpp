@@ -537,6 +537,61 @@ void Subsector::initCalc( NationalAccount* aNationalAccount,
 
     // Apply share weight interpolation rules and fill in missing share weights.
     interpolateShareWeights( aPeriod );
+
+    compileTechShareKernel( aPeriod );
+}
+
+/*!
+ * \brief Precompile the technology share calculation for the given period.
+ * \details Classifies the new vintage technologies by whether they use the
+ *          standard discrete choice share and records where to gather their
+ *          share weights and costs from so that calcTechShares can evaluate
+ *          them in a single batched call.  The classification only depends on
+ *          the production state which is fixed in initCalc.  The kernel is
+ *          not built if compiled-tech-shares is disabled in the configuration.
+ * \param aPeriod Model period.
+ */
+void Subsector::compileTechShareKernel( const int aPeriod ) {
+    TechShareKernel& kernel = mTechShareKernel;
+    kernel.mPeriod = -1;
+    kernel.mStandardIndices.clear();
+    kernel.mShareWeights.clear();
+    kernel.mCosts.clear();
+    kernel.mFuelPrefPositions.clear();
+    kernel.mFuelPrefTechs.clear();
+    kernel.mOtherIndices.clear();
+
+    if( !Configuration::getInstance()->getBool( "compiled-tech-shares", false ) ) {
+        return;
+    }
+
+    for( unsigned int i = 0; i < mTechContainers.size(); ++i ) {
+        const ITechnology* tech = mTechContainers[ i ]->getNewVintageTechnology( aPeriod );
+        const Value* shareWeight = 0;
+        const Value* cost = 0;
+        bool hasFuelPrefElasticity = false;
+        if( tech->getStandardShareValues( aPeriod, shareWeight, cost, hasFuelPrefElasticity ) ) {
+            if( hasFuelPrefElasticity ) {
+                kernel.mFuelPrefPositions.push_back( kernel.mStandardIndices.size() );
+                kernel.mFuelPrefTechs.push_back( tech );
+            }
+            kernel.mStandardIndices.push_back( i );
+            kernel.mShareWeights.push_back( shareWeight );
+            kernel.mCosts.push_back( cost );
+        }
+        else {
+            kernel.mOtherIndices.push_back( i );
+        }
+    }
+
+    // Size the buffers now so that calculating shares does not allocate.  When
+    // running in parallel each thread sizes its own the first time it is used.
+#if GCAM_PARALLEL_ENABLED
+    kernel.mBuffers.clear();
+#else
+    kernel.mBuffers.resize( kernel.mStandardIndices.size() );
+#endif
+    kernel.mPeriod = aPeriod;
 }
 
 /*! \brief Returns the subsector price.
@@ -636,6 +691,59 @@ double Subsector::getAverageFuelPrice( const GDP* aGDP, const int aPeriod ) cons
 const vector<double> Subsector::calcTechShares( const GDP* aGDP, const int aPeriod ) const {
     vector<double> logTechShares ( mTechContainers.size() ); 
 
+    if( mTechShareKernel.mPeriod == aPeriod ) {
+        // Gather the share weights and costs of the standard technologies and
+        // calculate their shares together.
+        const TechShareKernel& kernel = mTechShareKernel;
+        const size_t numStandard = kernel.mStandardIndices.size();
+#if GCAM_PARALLEL_ENABLED
+        TechShareKernel::Buffers& buffers = kernel.mBuffers.local();
+        if( buffers.mLogShares.size() != numStandard ) {
+            buffers.resize( numStandard );
+        }
+#else
+        TechShareKernel::Buffers& buffers = kernel.mBuffers;
+#endif
+        for( size_t i = 0; i < numStandard; ++i ) {
+            buffers.mShareWeights[ i ] = kernel.mShareWeights[ i ]->get();
+            buffers.mCosts[ i ] = kernel.mCosts[ i ]->get();
+        }
+        mDiscreteChoiceModel->calcUnnormalizedShares( buffers.mShareWeights, buffers.mCosts, aPeriod,
+                                                      buffers.mLogShares );
+
+        double logScaledGdpPerCapita = 0;
+        bool haveGdpPerCapita = false;
+        for( size_t i = 0; i < kernel.mFuelPrefTechs.size(); ++i ) {
+            double fuelPrefElasticity = kernel.mFuelPrefTechs[ i ]->calcFuelPrefElasticity( aPeriod );
+            if( fuelPrefElasticity != 0 ) {
+                if( !haveGdpPerCapita ) {
+                    double scaledGdpPerCapita = aGDP->getBestScaledGDPperCap( aPeriod );
+                    assert( scaledGdpPerCapita > 0.0 );
+                    logScaledGdpPerCapita = log( scaledGdpPerCapita );
+                    haveGdpPerCapita = true;
+                }
+                buffers.mLogShares[ kernel.mFuelPrefPositions[ i ] ] += fuelPrefElasticity * logScaledGdpPerCapita;
+            }
+        }
+
+        for( size_t i = 0; i < numStandard; ++i ) {
+            assert( util::isValidNumber( buffers.mLogShares[ i ] ) ||
+                    buffers.mLogShares[ i ] == -numeric_limits<double>::infinity() );
+            logTechShares[ kernel.mStandardIndices[ i ] ] = buffers.mLogShares[ i ];
+        }
+
+        for( size_t i = 0; i < kernel.mOtherIndices.size(); ++i ) {
+            const unsigned int techIndex = kernel.mOtherIndices[ i ];
+            double lts = mTechContainers[ techIndex ]->getNewVintageTechnology( aPeriod )->
+                calcShare( mDiscreteChoiceModel, aGDP, aPeriod );
+            assert( util::isValidNumber( lts ) || lts == -numeric_limits<double>::infinity() );
+            logTechShares[ techIndex ] = lts;
+        }
+
+        SectorUtils::normalizeLogShares( logTechShares );
+        return logTechShares;
+    }
+
     for( unsigned int i = 0; i < mTechContainers.size(); ++i ){
         // determine shares based on Technology costs
         double lts = mTechContainers[ i ]->getNewVintageTechnology( aPeriod )->
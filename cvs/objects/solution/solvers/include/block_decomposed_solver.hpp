@@ -0,0 +1,151 @@
+#ifndef BLOCK_DECOMPOSED_SOLVER_HPP_
+#define BLOCK_DECOMPOSED_SOLVER_HPP_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+
+
+/*!
+ * \file block_decomposed_solver.hpp
+ * \ingroup objects
+ * \brief Header file for the block-decomposed solver component
+ */
+
+#include <string>
+#include <vector>
+#include <boost/numeric/ublas/matrix.hpp>
+#include "solution/util/include/solvable_nr_solution_info_filter.h"
+#include "solution/util/include/edfun.hpp"
+#include "parallel/include/bitvector.hpp"
+
+#define UBLAS boost::numeric::ublas
+
+class CalcCounter; 
+class Marketplace;
+class World;
+class SolutionInfoSet;
+
+/*!
+ * \ingroup Objects 
+ * \brief A SolverComponent which solves the markets block by block along
+ *        the structure of their dependencies.
+ * \details A partial derivative Jacobian is used to find which markets'
+ *          prices affect which markets' excess demands.  The strongly
+ *          connected components of that graph, found with Tarjan's algorithm
+ *          as in MarketDependencyFinder, become the blocks and are ordered
+ *          by level along the condensation DAG so that each block only
+ *          depends on blocks in earlier levels.
+ *
+ *          The levels are solved in order, upstream first.  Each block is
+ *          solved with a small Broyden iteration, starting from its diagonal
+ *          block of the Jacobian, while the prices of every other market are
+ *          held fixed.  The blocks within a level do not affect each other,
+ *          so they are solved concurrently, each in the "scratch" state of
+ *          the thread running it and recalculating only the activities that
+ *          depend on its markets.  After each level the model is calculated
+ *          once with the new prices.  Couplings weaker than the coupling
+ *          tolerance are ignored when finding the blocks, so the levels are
+ *          repeated in an outer iteration, re-solving only the blocks which
+ *          are no longer solved, until every market is solved.
+ */
+class BlockDecomposedSolver: public SolverComponent {
+public:
+    BlockDecomposedSolver( Marketplace* mktplc, World* world, CalcCounter* ccounter, int itmax=30,
+                           double ftol=1.0e-7 ) : SolverComponent(mktplc,world,ccounter),
+                                                  mMaxIter(itmax), mFTOL(ftol), mLogPricep(true),
+                                                  mMaxCouplingIter(10), mCouplingTolerance(1.0e-3) {}
+    virtual ~BlockDecomposedSolver() {}
+    
+    // SolverComponent methods
+    virtual void init() {
+        if(!mSolutionInfoFilter.get())
+            mSolutionInfoFilter.reset(new SolvableNRSolutionInfoFilter());
+    }
+    virtual ReturnCode solve( SolutionInfoSet& aSolutionSet, const int aPeriod );
+    virtual const std::string& getXMLName() const {return SOLVER_NAME;}
+    
+    // IParsable methods
+    virtual bool XMLParse( const xercesc::DOMNode* aNode );
+
+    static const std::string & getXMLNameStatic(void) {return SOLVER_NAME;}
+  
+protected:
+    //! A strongly connected block of markets.
+    struct MarketBlock {
+        //! Indices of the markets in the block.
+        std::vector<int> mMarkets;
+
+        //! The activities which depend on any price in the block.
+        bitvector mActivities;
+
+        //! Position of the block along the condensation DAG, upstream blocks first.
+        int mLevel;
+    };
+
+    void findBlocks(const UBLAS::matrix<double> &J, const std::vector<SolutionInfo> &aMarkets);
+
+    void findStronglyConnected(int aMarket, const std::vector<std::vector<int> > &aOutEdges,
+                               int &aMaxIndex, std::vector<int> &aIndex, std::vector<int> &aLowLink,
+                               std::vector<int> &aHasVisited, std::vector<bool> &aIsVisiting,
+                               std::vector<std::vector<int> > &aComponents) const;
+
+    bool solveBlock(LogEDFun &F, const MarketBlock &aBlock, const UBLAS::matrix<double> &J,
+                    const UBLAS::vector<double> &x, UBLAS::vector<double> &xnew, int &neval) const;
+
+    //! Max Broyden iterations for each block
+    unsigned int mMaxIter;
+  
+    //! Tolerance for convergence test in root-finding algorithm. 
+    double mFTOL;
+  
+    //! A filter which will be used to determine which SolutionInfos with solver component
+    //! will work on.
+    std::auto_ptr<ISolutionInfoFilter> mSolutionInfoFilter;
+
+    bool mLogPricep;              //<! flag indicating whether we should work in price or log-price 
+
+    //! Max passes over the levels to resolve couplings between blocks.
+    unsigned int mMaxCouplingIter;
+
+    //! Min |J_ij| relative to the largest entry in row i for market j to affect market i.
+    double mCouplingTolerance;
+
+    //! The blocks, in order of level.
+    std::vector<MarketBlock> mBlocks;
+
+private:
+    static std::string SOLVER_NAME;
+};
+
+#undef UBLAS
+
+#endif // BLOCK_DECOMPOSED_SOLVER_HPP_
@@ -0,0 +1,188 @@
+#ifndef LOG_NEWTON_KRYLOV_HPP_
+#define LOG_NEWTON_KRYLOV_HPP_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*!
+ * \file log_newton_krylov.hpp
+ * \ingroup objects
+ * \brief Header file for the log Jacobian-free Newton-Krylov solver component
+ */
+
+#include <string>
+#include <vector>
+#include <boost/numeric/ublas/matrix.hpp>
+#include "solution/util/include/solvable_nr_solution_info_filter.h"
+#include "solution/util/include/edfun.hpp"
+
+#define UBLAS boost::numeric::ublas
+
+class CalcCounter; 
+class Marketplace;
+class World;
+class SolutionInfoSet;
+
+/*!
+ * \ingroup Objects 
+ * \brief A SolverComponent based on the Jacobian-free Newton-Krylov
+ *        algorithm, using logarithmic values.
+ * \details Each Newton step is found with restarted GMRES.  GMRES only needs
+ *          the product of the Jacobian with a vector, which is approximated
+ *          by a directional finite difference of the excess demand function.
+ *          Each product costs a single model evaluation, which uses the
+ *          parallel flow graph when GCAM_PARALLEL_ENABLED, so a step costs
+ *          as many evaluations as Krylov iterations rather than one per
+ *          market.  The step is then taken with the same backtracking line
+ *          search used by LogNRbt.
+ *
+ *          GMRES is right-preconditioned with a block-diagonal approximation
+ *          of the Jacobian.  Markets are grouped into blocks once per solve
+ *          from the market dependencies: two markets are placed in the same
+ *          block when their prices affect largely the same activities.  Only
+ *          the derivatives within each block are calculated, and blocks which
+ *          share no dependent activities are perturbed together, so a refresh
+ *          costs as many partial evaluations as the largest block in each
+ *          such group rather than one per market.  The preconditioner is
+ *          refreshed every few iterations, or when GMRES fails to make
+ *          progress with a stale one.
+ */
+class LogNewtonKrylov: public SolverComponent {
+public:
+    LogNewtonKrylov( Marketplace* mktplc, World* world, CalcCounter* ccounter, int itmax=100,
+                     double ftol=1.0e-7 ) : SolverComponent(mktplc,world,ccounter),
+                                            mMaxIter(itmax), mFTOL(ftol), mLogPricep(true),
+                                            mKrylovDim(30), mMaxKrylovIter(100), mForcingTerm(0.1),
+                                            mMaxBlockSize(10), mBlockCoupling(0.1), mPreconditionerRefresh(5) {}
+    virtual ~LogNewtonKrylov() {}
+    
+    // SolverComponent methods
+    virtual void init() {
+        if(!mSolutionInfoFilter.get())
+            mSolutionInfoFilter.reset(new SolvableNRSolutionInfoFilter());
+    }
+    virtual ReturnCode solve( SolutionInfoSet& aSolutionSet, const int aPeriod );
+    virtual const std::string& getXMLName() const {return SOLVER_NAME;}
+    
+    // IParsable methods
+    virtual bool XMLParse( const xercesc::DOMNode* aNode );
+
+    static const std::string & getXMLNameStatic(void) {return SOLVER_NAME;}
+  
+protected:
+    //! LU factorization of a single diagonal block of the Jacobian.
+    struct PreconditionerBlock {
+        //! Indices of the markets in the block.
+        std::vector<int> mMarkets;
+
+        //! LU factors of the block, or the inverse diagonal if it was singular.
+        UBLAS::matrix<double> mLU;
+
+        //! Pivots of the LU factorization.
+        std::vector<size_t> mPivots;
+
+        //! Whether the block could not be factored and falls back to its diagonal.
+        bool mIsDiagonal;
+    };
+
+    int nksolve(LogEDFun &F, UBLAS::vector<double> &x,
+                UBLAS::vector<double> &fx, int &neval);
+
+    int gmres(VecFVec<double,double> &F, const UBLAS::vector<double> &x,
+              const UBLAS::vector<double> &fx, UBLAS::vector<double> &dx,
+              UBLAS::vector<double> &Jdx, int &neval);
+
+    void jacobianProduct(VecFVec<double,double> &F, const UBLAS::vector<double> &x,
+                         const UBLAS::vector<double> &fx, const UBLAS::vector<double> &v,
+                         UBLAS::vector<double> &Jv);
+
+    void findBlocks(const std::vector<SolutionInfo> &aMarkets);
+
+    void buildPreconditioner(LogEDFun &F, const UBLAS::vector<double> &x,
+                             UBLAS::vector<double> &fx, int &neval);
+
+    void applyPreconditioner(const UBLAS::vector<double> &v, UBLAS::vector<double> &z) const;
+
+    //! Max iterations for the Newton algorithm 
+    unsigned int mMaxIter;
+  
+    //! Tolerance for convergence test in root-finding algorithm. 
+    double mFTOL;
+  
+    //! A filter which will be used to determine which SolutionInfos with solver component
+    //! will work on.
+    std::auto_ptr<ISolutionInfoFilter> mSolutionInfoFilter;
+
+    bool mLogPricep;              //<! flag indicating whether we should work in price or log-price 
+
+    //! Number of Krylov vectors kept before GMRES restarts.
+    unsigned int mKrylovDim;
+
+    //! Max total GMRES iterations per Newton step.
+    unsigned int mMaxKrylovIter;
+
+    //! Relative residual GMRES must reach for the Newton step.
+    double mForcingTerm;
+
+    //! Max number of markets in a preconditioner block.
+    unsigned int mMaxBlockSize;
+
+    //! Min fraction of the activities affected by either of two markets which
+    //! are affected by both for the markets to share a block.
+    double mBlockCoupling;
+
+    //! Number of Newton iterations between preconditioner refreshes.
+    unsigned int mPreconditionerRefresh;
+
+    //! The current block-diagonal preconditioner.
+    std::vector<PreconditionerBlock> mBlocks;
+
+    //! Groups of blocks, by index into mBlocks, which share no dependent
+    //! activities and so can be perturbed together.  The largest block of
+    //! each group is first.
+    std::vector<std::vector<int> > mProbeGroups;
+
+    //! The activities, by global ordering, which depend on the markets of
+    //! each group in mProbeGroups.
+    std::vector<bitvector> mProbeActivities;
+
+private:
+    static std::string SOLVER_NAME;
+};
+
+#undef UBLAS
+
+#endif // LOG_NEWTON_KRYLOV_HPP_
@@ -46,6 +46,8 @@
  */
 
 #include <string>
+#include <vector>
+#include <map>
 #include <boost/numeric/ublas/matrix.hpp>
 #include "solution/util/include/solvable_nr_solution_info_filter.h"
 #include "solution/util/include/edfun.hpp"
@@ -83,7 +85,9 @@ public:
   LogBroyden(Marketplace *mktplc, World *world, CalcCounter *ccounter, int itmax=250,
              double ftol=1.0e-4) :
       SolverComponent(mktplc,world,ccounter), mMaxIter( itmax ), mFTOL( ftol ),
-      mLogPricep( true ) {}
+      mLogPricep( true ), mReuseJacobian( false ), mJacobianReuseTol( 0.5 ),
+      mContinuationForecast( false ), mContinuationMaxStep( 0.5 ),
+      mLastForecastPeriod( -1 ) {}
   virtual ~LogBroyden() {}
 
   // SolverComponent methods
@@ -107,6 +111,18 @@ protected:
   void reportVec(const std::string &aname, const UBLAS::vector<double> &av, const std::vector<int> &amktids,
                  const std::vector<bool> &aissolvable);
   void reportPSD(UBLAS::vector<double> &arptvec, const std::vector<int> &amktids, const std::vector<bool> &aissolvable);
+  //! Load the initial Jacobian from the solver warm start store.
+  bool loadWarmStartJacobian(const LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period, UBMATRIX &J) const;
+  //! Save the final Jacobian to the solver warm start store.
+  void saveWarmStartJacobian(const LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period, const UBMATRIX &J) const;
+  //! Seed the initial Jacobian from a previously saved solution, validated by a secant test.
+  bool reuseJacobian(LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period,
+                     const UBLAS::vector<double> &x, UBLAS::vector<double> &fx, UBMATRIX &J);
+  //! Move the initial guess to a first-order continuation estimate of the new equilibrium.
+  bool continuationForecast(LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period,
+                            UBLAS::vector<double> &x, UBLAS::vector<double> &fx);
+  //! Save the final Jacobian for reuse in subsequent solves.
+  void saveJacobian(const LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period, const UBMATRIX &J);
 
   //! Maximum number of main-loop iterations for the root-finding algorithm
   unsigned int mMaxIter;
@@ -125,6 +141,22 @@ protected:
 
   bool mLogPricep;              //<! flag indicating whether we should work in price or log-price
 
+  bool mReuseJacobian;          //<! flag indicating whether to seed the Jacobian from previous solutions
+  double mJacobianReuseTol;     //<! max relative error in the secant test to accept a reused column
+
+  bool mContinuationForecast;   //<! flag indicating whether to start each period from a continuation step
+  double mContinuationMaxStep;  //<! max step in any market, relative to its scaled input, for the continuation step
+  int mLastForecastPeriod;      //<! period of the last continuation step, so it is made once per period
+
+  //! A Jacobian saved at the end of a successful solve, unscaled and by market name.
+  struct SavedJacobian {
+    std::vector<std::string> mMarketNames;
+    std::vector<double> mJacobian;
+  };
+  //! Jacobians from previous solves, keyed by period.  These are kept when
+  //! either reusing Jacobians or making continuation forecasts.
+  std::map<int, SavedJacobian> mSavedJacobians;
+
   // These next two have to be class variables because we sometimes
   // have multiple logbroyden solvers operating.
   static int mLastPer;                 //<! used to detect when the period has changed, so we can reset mPerIter.
@@ -0,0 +1,519 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file block_decomposed_solver.cpp
+* \ingroup objects
+* \brief BlockDecomposedSolver class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <string>
+#include <algorithm>
+#include <math.h>
+#include <xercesc/dom/DOMNode.hpp>
+#include <xercesc/dom/DOMNodeList.hpp>
+
+#include "solution/solvers/include/solver_component.h"
+#include "solution/solvers/include/block_decomposed_solver.hpp"
+#include "solution/util/include/calc_counter.h"
+#include "marketplace/include/marketplace.h"
+#include "containers/include/world.h"
+#include "containers/include/scenario.h"
+#include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solution_info.h"
+#include "util/base/include/util.h"
+#include "util/base/include/manage_state_variables.hpp"
+#include "util/logger/include/ilogger.h"
+#include "util/base/include/xml_helper.h"
+#include "solution/util/include/solution_info_filter_factory.h"
+#include "solution/util/include/solvable_nr_solution_info_filter.h"
+
+#include "solution/util/include/fdjac.hpp" 
+#include "solution/util/include/edfun.hpp"
+#include "solution/util/include/ublas-helpers.hpp"
+
+#include <boost/numeric/ublas/lu.hpp>
+
+#include "util/base/include/timer.h"
+
+using namespace std;
+using namespace xercesc;
+
+extern Scenario* scenario;
+
+std::string BlockDecomposedSolver::SOLVER_NAME = "block-decomposed-solver-component";
+
+#define UBMATRIX boost::numeric::ublas::matrix<double>
+#define UBVECTOR boost::numeric::ublas::vector<double>
+
+namespace {
+  // helper functions for the std::transform algorithm
+  double SI2lgprice (const SolutionInfo &si) {return log(si.getPrice());}
+  double SI2price (const SolutionInfo &si) {return si.getPrice();}
+
+  // largest absolute excess demand over the given markets
+  double maxResidual(const UBVECTOR &fx, const vector<int> &aMarkets) {
+    double maxval = 0.0;
+    for(size_t i=0; i<aMarkets.size(); ++i) {
+      maxval = std::max(maxval, fabs(fx[aMarkets[i]]));
+    }
+    return maxval;
+  }
+}
+
+bool BlockDecomposedSolver::XMLParse( const DOMNode* aNode ) {
+    // assume we were passed a valid node.
+    assert( aNode );
+    
+    // get the children of the node.
+    DOMNodeList* nodeList = aNode->getChildNodes();
+    
+    // loop through the children
+    for ( unsigned int i = 0; i < nodeList->getLength(); ++i ){
+        DOMNode* curr = nodeList->item( i );
+        string nodeName = XMLHelper<string>::safeTranscode( curr->getNodeName() );
+        
+        if( nodeName == "#text" ) {
+            continue;
+        }
+        else if( nodeName == "max-iterations" ) {
+            mMaxIter = XMLHelper<unsigned int>::getValue( curr );
+        }
+        else if( nodeName == "ftol" ) {
+            mFTOL = XMLHelper<double>::getValue(curr);
+        }
+        else if( nodeName == "max-coupling-iterations" ) {
+            mMaxCouplingIter = std::max( XMLHelper<unsigned int>::getValue( curr ), 1u );
+        }
+        else if( nodeName == "coupling-tolerance" ) {
+            mCouplingTolerance = XMLHelper<double>::getValue( curr );
+        }
+        else if( nodeName == "solution-info-filter" ) {
+            mSolutionInfoFilter.reset(
+                SolutionInfoFilterFactory::createSolutionInfoFilterFromString( XMLHelper<string>::getValue( curr ) ) );
+        }
+        else if(nodeName == "linear-price") {
+          mLogPricep = false;
+        }
+        else if(nodeName == "log-price") {
+          mLogPricep = true;    // not strictly necessary, as this is the default.
+        } 
+        else if( SolutionInfoFilterFactory::hasSolutionInfoFilter( nodeName ) ) {
+            mSolutionInfoFilter.reset( SolutionInfoFilterFactory::createAndParseSolutionInfoFilter( nodeName, curr ) );
+        }
+        else {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Unrecognized text string: " << nodeName << " found while parsing "
+                << getXMLName() << "." << endl;
+        }
+    }
+    return true;
+}
+
+/*! \brief Block-decomposed solver in log-log space
+ * \details Finds the blocks of strongly connected markets from a partial
+ *          derivative Jacobian and then solves them level by level, see the
+ *          class documentation.  Like LogNRbt the solution is performed in
+ *          log-log space.
+ * \param solnset An initial set of SolutionInfo objects representing all markets which can be filtered.
+ * \param period Model period.
+ * \return A status code to indicate if the algorithm was successful or not.
+ */
+SolverComponent::ReturnCode BlockDecomposedSolver::solve( SolutionInfoSet& solnset, int period ) {
+    ReturnCode code = SolverComponent::ORIGINAL_STATE;
+
+    // If all markets are solved, then return with success code.
+    if( solnset.isAllSolved() ){
+        return code = SolverComponent::SUCCESS;
+    }
+
+    startMethod();
+    
+    // Update the solution vector for the correct markets to solve.
+    // Need to update solvable status before starting solution (Ignore return code)
+    solnset.updateSolvable( mSolutionInfoFilter.get() );
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::NOTICE );
+    solverLog << "Beginning block-decomposed solution for period " << period
+              << ". Solving " << solnset.getNumSolvable() << " markets.\n";
+    
+    size_t nsolv = solnset.getNumSolvable(); 
+    if( nsolv == 0 ){
+        solverLog << "No markets were assigned to this solver.  Exiting." << endl;
+        return SUCCESS;
+    }
+
+    Timer& solverTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::SOLVER );
+    solverTimer.start();
+    
+    UBVECTOR x(nsolv), fx(nsolv);
+    int neval = 0;
+
+    // set our initial x from the solutionInfoSet
+    std::vector<SolutionInfo> smkts(solnset.getSolvableSet());
+    if(mLogPricep)
+      std::transform(smkts.begin(), smkts.end(), x.begin(), SI2lgprice);
+    else
+      std::transform(smkts.begin(), smkts.end(), x.begin(), SI2price);
+
+    // This is the closure that will evaluate the ED function
+    LogEDFun F(solnset, world, marketplace, period, mLogPricep); 
+
+    // scale the initial guess for use in F
+    F.scaleInitInputs(x);
+    
+    // Call F(x), store the result in fx
+    F(x,fx);
+    ++neval;
+
+    vector<int> allMarkets(nsolv);
+    for(size_t i=0; i<nsolv; ++i) {
+      allMarkets[i] = i;
+    }
+    double maxval = maxResidual(fx, allMarkets);
+    if(maxval > mFTOL) {
+      // The blocks are found from the Jacobian at the initial point, whose
+      // diagonal blocks also start each block's Broyden iteration.
+      UBMATRIX J(nsolv, nsolv);
+      fdjac(F, x, fx, J);
+      neval += nsolv;
+      F.partial(-1);
+      findBlocks(J, smkts);
+
+      ManageStateVariables* stateManager = scenario->getManageStateVariables();
+      UBVECTOR xnew(x);
+      vector<int> blockEvals(mBlocks.size(), 0);
+      vector<char> blockSolved(mBlocks.size(), 0);
+      for(unsigned int iter=0; iter<mMaxCouplingIter && maxval > mFTOL; ++iter) {
+        size_t levelStart = 0;
+        while(levelStart < mBlocks.size()) {
+          // Only the blocks which are not already solved need to be solved
+          // again, which on later passes is typically only a few.
+          size_t levelEnd = levelStart;
+          vector<int> blocks;
+          while(levelEnd < mBlocks.size() && mBlocks[levelEnd].mLevel == mBlocks[levelStart].mLevel) {
+            if(maxResidual(fx, mBlocks[levelEnd].mMarkets) > mFTOL) {
+              blocks.push_back(levelEnd);
+            }
+            else {
+              blockSolved[levelEnd] = 1;
+            }
+            ++levelEnd;
+          }
+          levelStart = levelEnd;
+          if(blocks.empty()) {
+            continue;
+          }
+
+          auto solveOne = [&]( const int aBlock ) {
+            blockSolved[aBlock] = solveBlock(F, mBlocks[aBlock], J, x, xnew, blockEvals[aBlock]);
+          };
+          stateManager->setPartialDeriv(true);
+#if !GCAM_PARALLEL_ENABLED
+          for(size_t i=0; i<blocks.size(); ++i) {
+            solveOne(blocks[i]);
+          }
+#else
+          vector<int> blockNodes(blocks.size());
+          for(size_t i=0; i<blocks.size(); ++i) {
+            blockNodes[i] = F.partialAffinity(mBlocks[blocks[i]].mMarkets.front());
+          }
+          stateManager->parallelForEachByNode(blocks, blockNodes, solveOne);
+#endif
+          // Bring the "base" state up to date with the new prices so that the
+          // downstream blocks start from them.
+          F.partial(-1);
+          x = xnew;
+          F(x,fx);
+          ++neval;
+        }
+        maxval = maxResidual(fx, allMarkets);
+        solverLog << "Coupling iteration " << iter << ": maxval= " << maxval
+                  << "\tunsolved blocks= " << std::count(blockSolved.begin(), blockSolved.end(), 0) << "\n";
+      }
+      for(size_t i=0; i<blockEvals.size(); ++i) {
+        neval += blockEvals[i];
+      }
+    }
+
+    solverTimer.stop();
+
+    solverLog.setLevel(ILogger::NOTICE);
+    solverLog << "Block-decomposed solver:  neval= " << neval << "\nResult:  ";
+    if(maxval <= mFTOL) {
+        solverLog << "Block-decomposed solution success.\n";
+        code = SUCCESS;
+    }
+    else {
+        code = FAILURE_ITER_MAX_REACHED;
+        solverLog << "Block-decomposed solution failed: Coupling iteration max reached.\n";
+    }
+    if(!solnset.isAllSolved()) {
+        solverLog << "The following markets were not solved:\n";
+        solnset.printUnsolved(solverLog);
+    }
+
+    solverLog << endl;
+
+    const SolutionInfo* maxred = solnset.getWorstSolutionInfo();
+    addIteration(maxred->getName(), maxred->getRelativeED());
+    return code;
+}
+
+/*!
+ * \brief Find the blocks of strongly connected markets and order them along
+ *        the condensation DAG.
+ * \details Market j affects market i when |J(i,j)| is at least
+ *          mCouplingTolerance times the largest entry in row i.  Each block
+ *          is then given a level one greater than any block affecting it.
+ * \param J The Jacobian.
+ * \param aMarkets The markets being solved.
+ */
+void BlockDecomposedSolver::findBlocks(const UBMATRIX &J, const vector<SolutionInfo> &aMarkets)
+{
+  ILogger &solverLog = ILogger::getLogger("solver_log");
+  const int n = J.size1();
+
+  vector<vector<int> > outEdges(n);
+  for(int i=0; i<n; ++i) {
+    double rowMax = 0.0;
+    for(int j=0; j<n; ++j) {
+      rowMax = std::max(rowMax, fabs(J(i,j)));
+    }
+    for(int j=0; j<n; ++j) {
+      if(j != i && rowMax > 0.0 && fabs(J(i,j)) >= mCouplingTolerance * rowMax) {
+        outEdges[j].push_back(i);
+      }
+    }
+  }
+
+  // Tarjan's algorithm finds the components downstream first.
+  vector<int> index(n, -1), lowLink(n, -1), hasVisited;
+  vector<bool> isVisiting(n, false);
+  vector<vector<int> > components;
+  int maxIndex = 0;
+  for(int i=0; i<n; ++i) {
+    if(index[i] == -1) {
+      findStronglyConnected(i, outEdges, maxIndex, index, lowLink, hasVisited, isVisiting, components);
+    }
+  }
+  reverse(components.begin(), components.end());
+
+  vector<int> componentOf(n);
+  for(size_t c=0; c<components.size(); ++c) {
+    for(size_t k=0; k<components[c].size(); ++k) {
+      componentOf[components[c][k]] = c;
+    }
+  }
+  vector<int> level(components.size(), 0);
+  for(size_t c=0; c<components.size(); ++c) {
+    for(size_t k=0; k<components[c].size(); ++k) {
+      const vector<int> &edges = outEdges[components[c][k]];
+      for(size_t e=0; e<edges.size(); ++e) {
+        int downstream = componentOf[edges[e]];
+        if(downstream != static_cast<int>(c)) {
+          level[downstream] = std::max(level[downstream], level[c] + 1);
+        }
+      }
+    }
+  }
+
+  mBlocks.clear();
+  mBlocks.resize(components.size());
+  size_t maxBlockSize = 0;
+  for(size_t c=0; c<components.size(); ++c) {
+    MarketBlock &block = mBlocks[c];
+    block.mMarkets = components[c];
+    sort(block.mMarkets.begin(), block.mMarkets.end());
+    block.mActivities = aMarkets[block.mMarkets.front()].getDependencies();
+    for(size_t k=1; k<block.mMarkets.size(); ++k) {
+      block.mActivities.setunion(aMarkets[block.mMarkets[k]].getDependencies());
+    }
+    block.mLevel = level[c];
+    maxBlockSize = std::max(maxBlockSize, block.mMarkets.size());
+  }
+  // The components are in topological order so sorting by level keeps every
+  // block after the blocks which affect it.
+  stable_sort(mBlocks.begin(), mBlocks.end(),
+              [](const MarketBlock &a, const MarketBlock &b) {return a.mLevel < b.mLevel;});
+
+  solverLog << "Markets form " << mBlocks.size() << " blocks in "
+            << (mBlocks.empty() ? 0 : mBlocks.back().mLevel + 1)
+            << " levels, the largest with " << maxBlockSize << " markets.\n";
+}
+
+/*!
+ * \brief A helper method to find the strongly connected components of the
+ *        market graph using Tarjan's algorithm.
+ * \details As in MarketDependencyFinder::findStronglyConnected, however each
+ *          component is kept.  A component is added after every component
+ *          reachable from it.
+ * \param aMarket The market to visit.
+ * \param aOutEdges The markets affected by each market.
+ * \param aMaxIndex The next index to assign.
+ * \param aIndex The order in which each market was visited, -1 if not yet.
+ * \param aLowLink The lowest index reachable from each market.
+ * \param aHasVisited The current search path.
+ * \param aIsVisiting Whether each market is in the current search path.
+ * \param aComponents The components found so far.
+ */
+void BlockDecomposedSolver::findStronglyConnected(int aMarket, const vector<vector<int> > &aOutEdges,
+                                                  int &aMaxIndex, vector<int> &aIndex, vector<int> &aLowLink,
+                                                  vector<int> &aHasVisited, vector<bool> &aIsVisiting,
+                                                  vector<vector<int> > &aComponents) const
+{
+  aIndex[aMarket] = aLowLink[aMarket] = aMaxIndex++;
+  aHasVisited.push_back(aMarket);
+  aIsVisiting[aMarket] = true;
+
+  const vector<int> &edges = aOutEdges[aMarket];
+  for(size_t e=0; e<edges.size(); ++e) {
+    int next = edges[e];
+    if(aIndex[next] == -1) {
+      // This successor has not been processed recurse on it.
+      findStronglyConnected(next, aOutEdges, aMaxIndex, aIndex, aLowLink, aHasVisited, aIsVisiting, aComponents);
+      aLowLink[aMarket] = std::min(aLowLink[aMarket], aLowLink[next]);
+    }
+    else if(aIsVisiting[next]) {
+      // This successor is in the path thus we have found a cycle.
+      aLowLink[aMarket] = std::min(aLowLink[aMarket], aIndex[next]);
+    }
+  }
+
+  if(aIndex[aMarket] == aLowLink[aMarket]) {
+    aComponents.push_back(vector<int>());
+    int member;
+    do {
+      member = aHasVisited.back();
+      aHasVisited.pop_back();
+      aIsVisiting[member] = false;
+      aComponents.back().push_back(member);
+    } while(member != aMarket);
+  }
+}
+
+/*!
+ * \brief Solve a single block with every other price held fixed.
+ * \details Uses Broyden's method starting from the block's diagonal block of
+ *          J with a backtracking step.  Each evaluation is in the calling
+ *          thread's "scratch" state and only recalculates the activities which
+ *          depend on the block, so blocks may be solved concurrently.  Nothing
+ *          is logged as this may be running concurrently.
+ * \param F The excess demand function.
+ * \param aBlock The block to solve.
+ * \param J The Jacobian of all the markets.
+ * \param x The current point, which the "base" state is at.
+ * \param xnew The point to update with the block's solution.
+ * \param neval Running total of function evaluations for this block.
+ * \return Whether the block was solved.
+ */
+bool BlockDecomposedSolver::solveBlock(LogEDFun &F, const MarketBlock &aBlock, const UBMATRIX &J,
+                                       const UBVECTOR &x, UBVECTOR &xnew, int &neval) const
+{
+  using boost::numeric::ublas::inner_prod;
+  using boost::numeric::ublas::outer_prod;
+  using boost::numeric::ublas::permutation_matrix;
+  using boost::numeric::ublas::lu_factorize;
+  using boost::numeric::ublas::lu_substitute;
+  const vector<int> &markets = aBlock.mMarkets;
+  const size_t m = markets.size();
+
+  UBMATRIX B(m, m);
+  for(size_t i=0; i<m; ++i) {
+    for(size_t j=0; j<m; ++j) {
+      B(i,j) = J(markets[i], markets[j]);
+    }
+  }
+
+  UBVECTOR xx(x), fxx(x.size());
+  UBVECTOR fb(m), dx(m), fbnew(m), s(m), y(m);
+  F.scratchEval(xx, fxx, aBlock.mActivities);
+  ++neval;
+  for(size_t i=0; i<m; ++i) {
+    fb[i] = fxx[markets[i]];
+  }
+  double f0 = inner_prod(fb, fb);
+
+  bool solved = maxResidual(fxx, markets) <= mFTOL;
+  for(unsigned int iter=0; iter<mMaxIter && !solved; ++iter) {
+    // Solve B dx = -fb
+    UBMATRIX LU(B);
+    permutation_matrix<size_t> pm(m);
+    if(lu_factorize(LU, pm) != 0) {
+      break;
+    }
+    dx = -fb;
+    lu_substitute(LU, pm, dx);
+
+    // Backtrack until the block's residual decreases.
+    double lambda = 1.0;
+    double fnew = f0;
+    for(int trial=0; trial<10; ++trial, lambda *= 0.5) {
+      for(size_t i=0; i<m; ++i) {
+        xx[markets[i]] = xnew[markets[i]] + lambda * dx[i];
+      }
+      F.scratchEval(xx, fxx, aBlock.mActivities);
+      ++neval;
+      for(size_t i=0; i<m; ++i) {
+        fbnew[i] = fxx[markets[i]];
+      }
+      fnew = inner_prod(fbnew, fbnew);
+      if(fnew < f0) {
+        break;
+      }
+    }
+    if(fnew >= f0) {
+      break;
+    }
+
+    // Broyden update of the block Jacobian
+    s = lambda * dx;
+    y = fbnew - fb;
+    double ss = inner_prod(s, s);
+    if(ss > 0.0) {
+      B += outer_prod(y - prod(B, s), s) / ss;
+    }
+
+    for(size_t i=0; i<m; ++i) {
+      xnew[markets[i]] = xx[markets[i]];
+    }
+    fb = fbnew;
+    f0 = fnew;
+    solved = maxResidual(fxx, markets) <= mFTOL;
+  }
+
+  return solved;
+}
@@ -0,0 +1,753 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+* \file log_newton_krylov.cpp
+* \ingroup objects
+* \brief LogNewtonKrylov (Log Jacobian-free Newton-Krylov) class source file.
+*/
+
+#include "util/base/include/definitions.h"
+#include <string>
+#include <algorithm>
+#include <math.h>
+#include <xercesc/dom/DOMNode.hpp>
+#include <xercesc/dom/DOMNodeList.hpp>
+
+#include "solution/solvers/include/solver_component.h"
+#include "solution/solvers/include/log_newton_krylov.hpp"
+#include "solution/util/include/calc_counter.h"
+#include "marketplace/include/marketplace.h"
+#include "containers/include/world.h"
+#include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solution_info.h"
+#include "util/base/include/util.h"
+#include "util/logger/include/ilogger.h"
+#include "util/base/include/xml_helper.h"
+#include "solution/util/include/solution_info_filter_factory.h"
+#include "solution/util/include/solvable_nr_solution_info_filter.h"
+
+#include "solution/util/include/functor-subs.hpp"
+#include "solution/util/include/linesearch.hpp"
+#include "solution/util/include/edfun.hpp"
+#include "solution/util/include/ublas-helpers.hpp"
+
+#include <boost/numeric/ublas/operation.hpp>
+#include <boost/numeric/ublas/lu.hpp>
+
+#include "util/base/include/timer.h"
+#include "solution/util/include/solver_telemetry.h"
+#include "containers/include/scenario.h"
+#include "util/base/include/manage_state_variables.hpp"
+
+using namespace std;
+using namespace xercesc;
+
+extern Scenario* scenario;
+
+std::string LogNewtonKrylov::SOLVER_NAME = "log-newton-krylov-solver-component";
+
+#define UBMATRIX boost::numeric::ublas::matrix<double>
+#define UBVECTOR boost::numeric::ublas::vector<double>
+
+namespace {
+  // helper functions for the std::transform algorithm
+  double SI2lgprice (const SolutionInfo &si) {return log(si.getPrice());}
+  double SI2price (const SolutionInfo &si) {return si.getPrice();}
+
+  // find the representative of a market's block (with path halving)
+  int findBlock(vector<int> &parent, int i) {
+    while(parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+}
+
+bool LogNewtonKrylov::XMLParse( const DOMNode* aNode ) {
+    // assume we were passed a valid node.
+    assert( aNode );
+    
+    // get the children of the node.
+    DOMNodeList* nodeList = aNode->getChildNodes();
+    
+    // loop through the children
+    for ( unsigned int i = 0; i < nodeList->getLength(); ++i ){
+        DOMNode* curr = nodeList->item( i );
+        string nodeName = XMLHelper<string>::safeTranscode( curr->getNodeName() );
+        
+        if( nodeName == "#text" ) {
+            continue;
+        }
+        else if( nodeName == "max-iterations" ) {
+            mMaxIter = XMLHelper<unsigned int>::getValue( curr );
+        }
+        else if( nodeName == "ftol" ) {
+            mFTOL = XMLHelper<double>::getValue(curr);
+        }
+        else if( nodeName == "krylov-dim" ) {
+            mKrylovDim = std::max( XMLHelper<unsigned int>::getValue( curr ), 1u );
+        }
+        else if( nodeName == "max-krylov-iterations" ) {
+            mMaxKrylovIter = std::max( XMLHelper<unsigned int>::getValue( curr ), 1u );
+        }
+        else if( nodeName == "forcing-term" ) {
+            mForcingTerm = XMLHelper<double>::getValue( curr );
+        }
+        else if( nodeName == "max-block-size" ) {
+            mMaxBlockSize = std::max( XMLHelper<unsigned int>::getValue( curr ), 1u );
+        }
+        else if( nodeName == "block-coupling" ) {
+            mBlockCoupling = XMLHelper<double>::getValue( curr );
+        }
+        else if( nodeName == "preconditioner-refresh" ) {
+            mPreconditionerRefresh = std::max( XMLHelper<unsigned int>::getValue( curr ), 1u );
+        }
+        else if( nodeName == "solution-info-filter" ) {
+            mSolutionInfoFilter.reset(
+                SolutionInfoFilterFactory::createSolutionInfoFilterFromString( XMLHelper<string>::getValue( curr ) ) );
+        }
+        else if(nodeName == "linear-price") {
+          mLogPricep = false;
+        }
+        else if(nodeName == "log-price") {
+          mLogPricep = true;    // not strictly necessary, as this is the default.
+        } 
+        else if( SolutionInfoFilterFactory::hasSolutionInfoFilter( nodeName ) ) {
+            mSolutionInfoFilter.reset( SolutionInfoFilterFactory::createAndParseSolutionInfoFilter( nodeName, curr ) );
+        }
+        else {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Unrecognized text string: " << nodeName << " found while parsing "
+                << getXMLName() << "." << endl;
+        }
+    }
+    return true;
+}
+
+/*! \brief Jacobian-free Newton-Krylov solver in log-log space
+ * \details Attempts to solve the selected markets using a Newton method whose
+ *          steps are found by GMRES without forming the Jacobian.  Like
+ *          LogNRbt the solution is performed in log-log space.  Most of the
+ *          work is done by nksolve(), while this function sets up the
+ *          structures necessary to call it.
+ * \param solnset An initial set of SolutionInfo objects representing all markets which can be filtered.
+ * \param period Model period.
+ * \return A status code to indicate if the algorithm was successful or not.
+ */
+SolverComponent::ReturnCode LogNewtonKrylov::solve( SolutionInfoSet& solnset, int period ) {
+    ReturnCode code = SolverComponent::ORIGINAL_STATE;
+
+    // If all markets are solved, then return with success code.
+    if( solnset.isAllSolved() ){
+        return code = SolverComponent::SUCCESS;
+    }
+
+    startMethod();
+    
+    // Update the solution vector for the correct markets to solve.
+    // Need to update solvable status before starting solution (Ignore return code)
+    solnset.updateSolvable( mSolutionInfoFilter.get() );
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::NOTICE );
+    solverLog << "Beginning Newton-Krylov solution for period " << period
+              << ". Solving " << solnset.getNumSolvable() << " markets.\n";
+    
+    size_t nsolv = solnset.getNumSolvable(); 
+    if( nsolv == 0 ){
+        solverLog << "No markets were assigned to this solver.  Exiting." << endl;
+        return SUCCESS;
+    }
+
+    Timer& solverTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::SOLVER );
+    solverTimer.start();
+    
+    UBVECTOR x(nsolv), fx(nsolv);
+    int neval = 0;
+
+    // set our initial x from the solutionInfoSet
+    std::vector<SolutionInfo> smkts(solnset.getSolvableSet());
+    if(mLogPricep)
+      std::transform(smkts.begin(), smkts.end(), x.begin(), SI2lgprice);
+    else
+      std::transform(smkts.begin(), smkts.end(), x.begin(), SI2price);
+
+    // This is the closure that will evaluate the ED function
+    LogEDFun F(solnset, world, marketplace, period, mLogPricep); 
+
+    // scale the initial guess for use in F
+    F.scaleInitInputs(x);
+    
+    // Call F(x), store the result in fx
+    F(x,fx);
+    ++neval;
+
+    solverLog.setLevel(ILogger::DEBUG);
+    solverLog << "Initial guess:\n" << x << "\nInitial F(x):\n" << fx << "\n";
+
+    // The market set may have changed since the last call so the
+    // preconditioner blocks are found again.
+    findBlocks(smkts);
+    int nkstatus = nksolve(F, x, fx, neval);
+
+    solverTimer.stop();
+
+    solverLog.setLevel(ILogger::NOTICE);
+    solverLog << "Newton-Krylov solver:  neval= " << neval << "\nResult:  ";
+    if(nkstatus == 0) {
+        solverLog << "NK solution success.\n";
+        code = SUCCESS;
+    }
+    else if(nkstatus == -1) {
+        code = FAILURE_ITER_MAX_REACHED;
+        solverLog << "NK solution failed: Iteration max reached.\n";
+    }
+    else if(nkstatus == -2) {
+        code = FAILURE_POOR_PROGRESS;
+        solverLog << "NK solution failed:  GMRES could not find a descent direction.\n";
+    }
+    else {
+        code = FAILURE_UNKNOWN;
+        solverLog << "NK solution failed for unknown reason.\n";
+    }
+    if(!solnset.isAllSolved()) {
+        solverLog << "The following markets were not solved:\n";
+        solnset.printUnsolved(solverLog);
+    }
+
+    solverLog << endl;
+
+    const SolutionInfo* maxred = solnset.getWorstSolutionInfo();
+    addIteration(maxred->getName(), maxred->getRelativeED());
+    return code;
+}
+
+/*!
+ * \brief Run the Newton iterations.
+ * \param F The excess demand function.
+ * \param x The initial guess on input, the final point on output.
+ * \param fx F(x), which must have been the last evaluation of F.
+ * \param neval Running total of function evaluations.
+ * \return 0 on success, -1 if the iteration limit was reached, -2 if no descent
+ *         direction could be found, -4 if the line search failed.
+ */
+int LogNewtonKrylov::nksolve(LogEDFun &F, UBVECTOR &x, UBVECTOR &fx, int &neval)
+{
+  using boost::numeric::ublas::inner_prod;
+  ILogger &solverLog = ILogger::getLogger("solver_log");
+  solverLog.setLevel(ILogger::DEBUG);
+  SolverTelemetry& telemetry = SolverTelemetry::getInstance();
+
+  const double FTINY = mFTOL*mFTOL;
+  UBVECTOR dx(F.narg());
+  UBVECTOR Jdx(F.nrtn());
+  UBVECTOR xnew(F.narg());
+  UBVECTOR gx(F.narg());
+  assert(F.nrtn() == F.narg());
+
+  // We create a functor that computes f(x) = F(x)*F(x).  It also
+  // stores the value of F that it produces as an intermediate.
+  FdotF<double,double> fnorm(F);
+  double f0 = inner_prod(fx,fx);
+  if(f0 < FTINY)
+    // Guard against F=0 since it can cause a NaN in our solver.
+    return 0;
+
+  unsigned int lastRefresh = 0;
+  bool needRefresh = true;
+  for(unsigned int iter=0; iter<mMaxIter; ++iter) {
+    solverLog << "NK iter= " << iter << "\tneval= " << neval << "\n";
+    bool freshPreconditioner = false;
+    if(needRefresh || iter - lastRefresh >= mPreconditionerRefresh) {
+      buildPreconditioner(F, x, fx, neval);
+      lastRefresh = iter;
+      needRefresh = false;
+      freshPreconditioner = true;
+    }
+
+    int gmresStatus = gmres(F, x, fx, dx, Jdx, neval);
+
+    // The line search only needs the directional derivative of F*F
+    // along dx, which is fx^T J dx.  GMRES gives us J dx directly, so
+    // we construct a gradient that is exact along dx.
+    double g0dx = inner_prod(fx, Jdx);
+    double dxdx = inner_prod(dx, dx);
+    solverLog << "GMRES status= " << gmresStatus << "\tg0dx= " << g0dx << "\n";
+    if(g0dx >= 0.0 || dxdx == 0.0) {
+      if(freshPreconditioner) {
+        return -2;
+      }
+      // A stale preconditioner may have stalled GMRES; try again with a new one.
+      needRefresh = true;
+      continue;
+    }
+    gx = (g0dx / dxdx) * dx;
+
+    // Jacobian products leave the model at a perturbed point, so
+    // every line search trial is a full evaluation.
+    double fnew;
+    const int nevalStart = neval;
+    int lserr = linesearch(fnorm, x, f0, gx, dx, xnew, fnew, neval);
+    telemetry.addLineSearchEvals( neval - nevalStart );
+
+    if(lserr != 0) {
+      // Make a relaxed convergence test and return if we have a
+      // "close enough" solution, as LogNRbt does.
+      double msf = f0/fx.size();
+      if(msf < mFTOL)
+        return 0;
+
+      if(freshPreconditioner) {
+        solverLog << "linesearch failure\n";
+        return -4;
+      }
+      // The inexact step may have been poor due to a stale
+      // preconditioner.  The line search left the model at a trial
+      // point, which the refresh will reset.
+      needRefresh = true;
+      continue;
+    }
+
+    solverLog << "################Return from linesearch\nfold= " << f0 << "\tfnew= " << fnew
+              << "\n";
+    f0 = fnew;
+    x  = xnew;
+    fnorm.lastF(fx);            // get the last value of big-F
+
+    // test for convergence
+    double maxval = 0.0;
+    for(size_t i=0; i<fx.size(); ++i) {
+      maxval = std::max(maxval, fabs(fx[i]));
+    }
+
+    solverLog << "Convergence test maxval: " << maxval << "\n";
+    if(maxval <= mFTOL) {
+      solverLog << "Solution successful.\n";
+      return 0;                 // SUCCESS 
+    }
+  }
+
+  solverLog << "\n****************Maximum solver iterations exceeded.\nlastx: " << x
+            << "\nlastF: " << fx << "\n";
+  return -1;
+}
+
+/*!
+ * \brief Approximately solve J dx = -fx using right-preconditioned restarted
+ *        GMRES.
+ * \details Stops once the residual has been reduced by mForcingTerm, GMRES
+ *          stagnates, or mMaxKrylovIter Jacobian products have been used.  Each
+ *          Jacobian product is kept so that J dx is returned without an
+ *          additional evaluation.
+ * \param F The excess demand function.
+ * \param x The current point.
+ * \param fx F(x).
+ * \param dx The Newton step.
+ * \param Jdx The product of the Jacobian and dx.
+ * \param neval Running total of function evaluations.
+ * \return 0 if the residual target was reached, 1 otherwise.
+ */
+int LogNewtonKrylov::gmres(VecFVec<double,double> &F, const UBVECTOR &x, const UBVECTOR &fx,
+                           UBVECTOR &dx, UBVECTOR &Jdx, int &neval)
+{
+  using boost::numeric::ublas::inner_prod;
+  using boost::numeric::ublas::norm_2;
+  using boost::numeric::ublas::zero_vector;
+  const size_t n = fx.size();
+  const size_t m = std::min<size_t>(mKrylovDim, n);
+
+  dx = zero_vector<double>(n);
+  Jdx = zero_vector<double>(n);
+  const double target = mForcingTerm * norm_2(fx);
+  double lastBeta = 0.0;
+  unsigned int its = 0;
+
+  vector<UBVECTOR> V(m+1, UBVECTOR(n)), Z(m, UBVECTOR(n)), AZ(m, UBVECTOR(n));
+  UBMATRIX H(m+1, m);
+  UBVECTOR cs(m), sn(m), g(m+1), y(m);
+  UBVECTOR w(n);
+
+  while(its < mMaxKrylovIter) {
+    UBVECTOR r = -fx - Jdx;
+    double beta = norm_2(r);
+    if(beta <= target) {
+      return 0;
+    }
+    if(its > 0 && beta >= 0.999 * lastBeta) {
+      // restarting is no longer making progress
+      return 1;
+    }
+    lastBeta = beta;
+
+    H.clear();
+    g.clear();
+    g[0] = beta;
+    V[0] = r / beta;
+    size_t k = 0;
+    while(k < m && its < mMaxKrylovIter) {
+      applyPreconditioner(V[k], Z[k]);
+      jacobianProduct(F, x, fx, Z[k], AZ[k]);
+      ++neval;
+      ++its;
+
+      // modified Gram-Schmidt orthogonalization against the basis
+      w = AZ[k];
+      for(size_t i=0; i<=k; ++i) {
+        H(i,k) = inner_prod(w, V[i]);
+        w -= H(i,k) * V[i];
+      }
+      H(k+1,k) = norm_2(w);
+      const bool breakdown = H(k+1,k) == 0.0;
+      if(!breakdown) {
+        V[k+1] = w / H(k+1,k);
+      }
+
+      // reduce the Hessenberg matrix to triangular form with Givens rotations
+      for(size_t i=0; i<k; ++i) {
+        double temp = cs[i]*H(i,k) + sn[i]*H(i+1,k);
+        H(i+1,k) = -sn[i]*H(i,k) + cs[i]*H(i+1,k);
+        H(i,k) = temp;
+      }
+      double denom = sqrt(H(k,k)*H(k,k) + H(k+1,k)*H(k+1,k));
+      if(denom == 0.0) {
+        cs[k] = 1.0;
+        sn[k] = 0.0;
+      }
+      else {
+        cs[k] = H(k,k) / denom;
+        sn[k] = H(k+1,k) / denom;
+      }
+      H(k,k) = denom;
+      H(k+1,k) = 0.0;
+      g[k+1] = -sn[k]*g[k];
+      g[k] = cs[k]*g[k];
+      ++k;
+
+      if(fabs(g[k]) <= target || breakdown) {
+        break;
+      }
+    }
+
+    // solve the triangular system and update the step
+    for(size_t i=k; i-- > 0;) {
+      double sum = g[i];
+      for(size_t j=i+1; j<k; ++j) {
+        sum -= H(i,j)*y[j];
+      }
+      y[i] = H(i,i) != 0.0 ? sum / H(i,i) : 0.0;
+    }
+    for(size_t i=0; i<k; ++i) {
+      dx += y[i] * Z[i];
+      Jdx += y[i] * AZ[i];
+    }
+  }
+
+  return norm_2(-fx - Jdx) <= target ? 0 : 1;
+}
+
+/*!
+ * \brief Approximate the product of the Jacobian and a vector by a
+ *        directional finite difference.
+ * \details The step is sized so that the largest change in any input matches
+ *          the step fdjac takes for a single column.  This is a full model
+ *          evaluation, so it leaves the model at the perturbed point.
+ * \param F The excess demand function.
+ * \param x The current point.
+ * \param fx F(x).
+ * \param v The direction.
+ * \param Jv The product of the Jacobian and v.
+ */
+void LogNewtonKrylov::jacobianProduct(VecFVec<double,double> &F, const UBVECTOR &x,
+                                      const UBVECTOR &fx, const UBVECTOR &v, UBVECTOR &Jv)
+{
+  using boost::numeric::ublas::norm_inf;
+  const double heps = 1.0e-6;
+  double vmax = norm_inf(v);
+  if(vmax == 0.0) {
+    Jv = boost::numeric::ublas::zero_vector<double>(fx.size());
+    return;
+  }
+  double h = heps * (norm_inf(x) + 1.0) / vmax;
+  UBVECTOR xx = x + h*v;
+  UBVECTOR fxx(fx.size());
+  F(xx, fxx);
+  Jv = (fxx - fx) / h;
+}
+
+/*!
+ * \brief Group the markets into the blocks of the preconditioner.
+ * \details Two markets are coupled by the fraction of the activities affected
+ *          by either of their prices which are affected by both, since only
+ *          those activities can carry a change in one market's price to the
+ *          other's excess demand.  Markets are merged into blocks, strongest
+ *          coupling first, up to mMaxBlockSize markets per block.  The blocks
+ *          are then greedily grouped so that no two blocks in a group affect
+ *          any of the same activities.
+ * \param aMarkets The markets being solved.
+ */
+void LogNewtonKrylov::findBlocks(const vector<SolutionInfo> &aMarkets)
+{
+  ILogger &solverLog = ILogger::getLogger("solver_log");
+  const int n = aMarkets.size();
+
+  // find the coupled pairs of markets
+  typedef pair<double, pair<int, int> > Coupling;
+  vector<Coupling> couplings;
+  if(mMaxBlockSize > 1) {
+    vector<unsigned int> numDependencies(n);
+    for(int i=0; i<n; ++i) {
+      numDependencies[i] = aMarkets[i].getDependencies().count();
+    }
+    for(int i=0; i<n; ++i) {
+      for(int j=i+1; j<n; ++j) {
+        unsigned int shared = setintersection(aMarkets[i].getDependencies(),
+                                              aMarkets[j].getDependencies()).count();
+        unsigned int total = numDependencies[i] + numDependencies[j] - shared;
+        if(shared > 0 && shared >= mBlockCoupling * total) {
+          couplings.push_back(Coupling(double(shared) / double(total), make_pair(i, j)));
+        }
+      }
+    }
+  }
+  sort(couplings.rbegin(), couplings.rend());
+
+  // merge the markets into blocks
+  vector<int> parent(n), size(n, 1);
+  for(int i=0; i<n; ++i) {
+    parent[i] = i;
+  }
+  for(vector<Coupling>::const_iterator it = couplings.begin(); it != couplings.end(); ++it) {
+    int a = findBlock(parent, it->second.first);
+    int b = findBlock(parent, it->second.second);
+    if(a != b && static_cast<unsigned int>(size[a] + size[b]) <= mMaxBlockSize) {
+      parent[b] = a;
+      size[a] += size[b];
+    }
+  }
+  vector<int> blockIndex(n, -1);
+  mBlocks.clear();
+  for(int i=0; i<n; ++i) {
+    int root = findBlock(parent, i);
+    if(blockIndex[root] < 0) {
+      blockIndex[root] = mBlocks.size();
+      mBlocks.push_back(PreconditionerBlock());
+    }
+    mBlocks[blockIndex[root]].mMarkets.push_back(i);
+  }
+
+  // group the blocks, largest first, with the first group they do not
+  // share any activities with
+  vector<int> order(mBlocks.size());
+  for(size_t b=0; b<order.size(); ++b) {
+    order[b] = b;
+  }
+  stable_sort(order.begin(), order.end(), [this](const int a, const int b) {
+      return mBlocks[a].mMarkets.size() > mBlocks[b].mMarkets.size();
+  });
+  mProbeGroups.clear();
+  mProbeActivities.clear();
+  size_t numProbes = 0;
+  for(size_t b=0; b<order.size(); ++b) {
+    const vector<int> &markets = mBlocks[order[b]].mMarkets;
+    bitvector activities(aMarkets[markets.front()].getDependencies());
+    for(size_t k=1; k<markets.size(); ++k) {
+      activities.setunion(aMarkets[markets[k]].getDependencies());
+    }
+    size_t group = 0;
+    while(group < mProbeGroups.size() && !setintersection(mProbeActivities[group], activities).empty()) {
+      ++group;
+    }
+    if(group == mProbeGroups.size()) {
+      mProbeGroups.push_back(vector<int>());
+      mProbeActivities.push_back(activities);
+      numProbes += markets.size();
+    }
+    else {
+      mProbeActivities[group].setunion(activities);
+    }
+    mProbeGroups[group].push_back(order[b]);
+  }
+
+  solverLog << "Preconditioner: " << mBlocks.size() << " blocks for " << n << " markets in "
+            << mProbeGroups.size() << " groups, " << numProbes << " evaluations per refresh.\n";
+}
+
+/*!
+ * \brief Build the block-diagonal preconditioner at x.
+ * \details Only the derivatives within each block are calculated.  Each
+ *          evaluation perturbs one market of every block in a group at once
+ *          and recalculates only the activities which depend on the group.
+ *          Since the blocks in a group affect none of the same activities the
+ *          change in each block's excess demands is due to its own market.
+ *          The evaluations are independent and are run concurrently.  Blocks
+ *          which cannot be factored fall back to their diagonal.
+ * \param F The excess demand function.
+ * \param x The current point.
+ * \param fx F(x), recalculated to reset the base state.
+ * \param neval Running total of function evaluations.
+ */
+void LogNewtonKrylov::buildPreconditioner(LogEDFun &F, const UBVECTOR &x,
+                                          UBVECTOR &fx, int &neval)
+{
+  using boost::numeric::ublas::permutation_matrix;
+  using boost::numeric::ublas::lu_factorize;
+  ILogger &solverLog = ILogger::getLogger("solver_log");
+  const int n = x.size();
+  const double heps = 1.0e-6;
+  const double TINY = 1.0e-6;
+
+  // The perturbations are taken relative to the base state, which the
+  // Jacobian products and line search trials may have moved.
+  F.partial(-1);
+  F(x, fx);
+  ++neval;
+
+  for(vector<PreconditionerBlock>::iterator block = mBlocks.begin(); block != mBlocks.end(); ++block) {
+    const size_t bsize = block->mMarkets.size();
+    block->mLU.resize(bsize, bsize, false);
+  }
+
+  // One evaluation for each position up to the size of the largest block in
+  // each group.
+  vector<pair<int, size_t> > probes;
+  for(size_t group = 0; group < mProbeGroups.size(); ++group) {
+    for(size_t k=0; k<mBlocks[mProbeGroups[group].front()].mMarkets.size(); ++k) {
+      probes.push_back(make_pair(group, k));
+    }
+  }
+
+  Timer& jacTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JACOBIAN );
+  jacTimer.start();
+  auto probeOne = [&]( const int aProbe ) {
+    const vector<int> &group = mProbeGroups[probes[aProbe].first];
+    const size_t k = probes[aProbe].second;
+    UBVECTOR xx(x), fxx(n);
+    vector<double> h(group.size(), 0.0);
+    for(size_t b=0; b<group.size(); ++b) {
+      const vector<int> &markets = mBlocks[group[b]].mMarkets;
+      if(k < markets.size()) {
+        const int j = markets[k];
+        xx[j] = x[j] + heps * (fabs(x[j]) + TINY);
+        h[b] = xx[j] - x[j];
+      }
+    }
+    F.scratchEval(xx, fxx, mProbeActivities[probes[aProbe].first]);
+    for(size_t b=0; b<group.size(); ++b) {
+      if(h[b] == 0.0) {
+        continue;
+      }
+      PreconditionerBlock &block = mBlocks[group[b]];
+      for(size_t i=0; i<block.mMarkets.size(); ++i) {
+        block.mLU(i,k) = (fxx[block.mMarkets[i]] - fx[block.mMarkets[i]]) / h[b];
+      }
+    }
+  };
+  scenario->getManageStateVariables()->setPartialDeriv(true);
+#if !GCAM_PARALLEL_ENABLED
+  for(size_t i=0; i<probes.size(); ++i) {
+    probeOne(i);
+  }
+#else
+  vector<int> probeIndices(probes.size());
+  vector<int> probeNodes(probes.size());
+  for(size_t i=0; i<probes.size(); ++i) {
+    probeIndices[i] = i;
+    probeNodes[i] = F.partialAffinity(mBlocks[mProbeGroups[probes[i].first].front()].mMarkets[probes[i].second]);
+  }
+  scenario->getManageStateVariables()->parallelForEachByNode(probeIndices, probeNodes, probeOne);
+#endif
+  F.partial(-1);
+  jacTimer.stop();
+  neval += probes.size();
+
+  Timer& linearSolveTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::LINEAR_SOLVE );
+  linearSolveTimer.start();
+
+  // factor each block
+  int numDiagonal = 0;
+  for(vector<PreconditionerBlock>::iterator block = mBlocks.begin(); block != mBlocks.end(); ++block) {
+    const size_t bsize = block->mMarkets.size();
+    UBMATRIX J(block->mLU);
+    permutation_matrix<size_t> pm(bsize);
+    block->mIsDiagonal = lu_factorize(block->mLU, pm) != 0;
+    if(block->mIsDiagonal) {
+      // Fall back to the inverse diagonal, leaving markets with no own
+      // price response unscaled.
+      ++numDiagonal;
+      block->mLU.clear();
+      for(size_t i=0; i<bsize; ++i) {
+        block->mLU(i,i) = J(i,i) != 0.0 ? 1.0 / J(i,i) : 1.0;
+      }
+    }
+    block->mPivots.assign(pm.begin(), pm.end());
+  }
+  linearSolveTimer.stop();
+
+  solverLog << "Preconditioner refreshed with " << probes.size() << " evaluations, "
+            << numDiagonal << " singular blocks use their diagonal.\n";
+}
+
+/*!
+ * \brief Apply the inverse of the block-diagonal preconditioner.
+ * \param v The vector to precondition.
+ * \param z The preconditioned vector.
+ */
+void LogNewtonKrylov::applyPreconditioner(const UBVECTOR &v, UBVECTOR &z) const
+{
+  using boost::numeric::ublas::permutation_matrix;
+  using boost::numeric::ublas::lu_substitute;
+  z.resize(v.size(), false);
+  for(vector<PreconditionerBlock>::const_iterator block = mBlocks.begin(); block != mBlocks.end(); ++block) {
+    const size_t bsize = block->mMarkets.size();
+    UBVECTOR b(bsize);
+    for(size_t i=0; i<bsize; ++i) {
+      b[i] = v[block->mMarkets[i]];
+    }
+    if(block->mIsDiagonal) {
+      for(size_t i=0; i<bsize; ++i) {
+        b[i] *= block->mLU(i,i);
+      }
+    }
+    else {
+      permutation_matrix<size_t> pm(bsize);
+      std::copy(block->mPivots.begin(), block->mPivots.end(), pm.begin());
+      lu_substitute(block->mLU, pm, b);
+    }
+    for(size_t i=0; i<bsize; ++i) {
+      z[block->mMarkets[i]] = b[i];
+    }
+  }
+}
@@ -68,6 +68,7 @@
 #include "solution/util/include/ublas-helpers.hpp"
 #include "util/base/include/fltcmp.hpp"
 #include "solution/util/include/jacobian-precondition.hpp"
+#include "solution/util/include/solver_warm_start_store.h"
 
 #if USE_LAPACK
 #include <boost/numeric/bindings/traits/ublas_vector.hpp>
@@ -75,12 +76,14 @@
 #include <boost/numeric/ublas/operation.hpp>
 #include <boost/numeric/bindings/lapack/gesvd.hpp>
 #include "solution/util/include/svd_invert_solve.hpp"
+#include <boost/numeric/ublas/lu.hpp>
 #else
 #include <boost/numeric/ublas/operation.hpp>
 #include <boost/numeric/ublas/lu.hpp>
 #endif 
 
 #include "util/base/include/timer.h"
+#include "solution/util/include/solver_telemetry.h"
 
 using namespace xercesc;
 
@@ -105,6 +108,16 @@ namespace {
   // read-only accessor for solutionInfoSet (used to prepare log outputs)
   const SolutionInfoSet *cSolInfo=0;
 
+  // collect the names of a set of markets
+  std::vector<std::string> getMarketNames(const std::vector<SolutionInfo> &asmkts)
+  {
+    std::vector<std::string> mktnames(asmkts.size());
+    for(size_t i=0; i<asmkts.size(); ++i) {
+      mktnames[i] = asmkts[i].getName();
+    }
+    return mktnames;
+  }
+
   // utility function for finding the minimimum and maximum absolute
   // value entries in a vector.
   void locate_vector_minmax(const UBVECTOR &v, double &vmax, double &vmin, int &imax, int &imin)
@@ -159,6 +172,18 @@ bool LogBroyden::XMLParse( const DOMNode* aNode ) {
         else if(nodeName == "log-price") {
           mLogPricep = true;    // not strictly necessary, as this is the default.
         }
+        else if(nodeName == "reuse-jacobian") {
+          mReuseJacobian = true;
+        }
+        else if(nodeName == "jacobian-reuse-tol") {
+          mJacobianReuseTol = XMLHelper<double>::getValue( curr );
+        }
+        else if(nodeName == "continuation-forecast") {
+          mContinuationForecast = true;
+        }
+        else if(nodeName == "continuation-max-step") {
+          mContinuationMaxStep = XMLHelper<double>::getValue( curr );
+        }
         else if( SolutionInfoFilterFactory::hasSolutionInfoFilter( nodeName ) ) {
             mSolutionInfoFilter.reset( SolutionInfoFilterFactory::createAndParseSolutionInfoFilter( nodeName, curr ) );
         }
@@ -290,10 +315,20 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
     solverLog << "Initial guess:\n" << x << "\nInitial F( x ):\n" << fx << "\n";
     solnset.printMarketInfo("Broyden-initial", calcCounter->getPeriodCount(), singleLog);
 
+    if(continuationForecast(F, smkts, period, x, fx)) {
+      solverLog << "Continuation guess:\n" << x << "\nContinuation F( x ):\n" << fx << "\n";
+      solnset.printMarketInfo("Broyden-continuation", calcCounter->getPeriodCount(), singleLog);
+    }
+
     // Precondition the x values to avoid singular columns in the Jacobian
     solverLog.setLevel(ILogger::DEBUG);
     UBMATRIX J(F.narg(), F.nrtn());
-    fdjac(F, x, fx, J, true);
+    if(loadWarmStartJacobian(F, smkts, period, J)) {
+      solverLog << "Initial jacobian taken from the solver warm start store.\n";
+    }
+    else if(!reuseJacobian(F, smkts, period, x, fx, J)) {
+      fdjac(F, x, fx, J, true);
+    }
 
     solverLog << ">>>> Main loop jacobian called.\n";
     int pcfail = jacobian_precondition(x, fx, J, F, &solverLog, mLogPricep);
@@ -320,6 +355,8 @@ SolverComponent::ReturnCode LogBroyden::solve(SolutionInfoSet &solnset, int peri
     if(bstatus == 0) {
         solverLog << "Broyden solution success.\n";
         code = SUCCESS;
+        saveWarmStartJacobian(F, smkts, period, J);
+        saveJacobian(F, smkts, period, J);
     }
     else if(bstatus == -1) {
         code = FAILURE_ITER_MAX_REACHED;
@@ -387,6 +424,8 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
 #endif
 
   UBMATRIX Btmp(nrow, ncol);
+  Timer& linearSolveTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::LINEAR_SOLVE );
+  SolverTelemetry& telemetry = SolverTelemetry::getInstance();
   ILogger &solverLog = ILogger::getLogger("solver_log");
   ILogger& worstMarketLog = ILogger::getLogger( "worst_market_log" );
   worstMarketLog.setLevel( ILogger::DEBUG );
@@ -484,9 +523,11 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
 
     Btmp = B;                   // save the jacobian approximant
 #if USE_LAPACK /* Solve using SVD */
+    linearSolveTimer.start();
     int ierr = boost::numeric::bindings::lapack::gesvd('O','A','A', // control parameters
                                                        B,           // input matrix
                                                        Ssv,Usv,VTsv); // outputs
+    linearSolveTimer.stop();
     if(ierr>0) {
       // svd failed.  It's not even clear under what circumstances
       // this can happen
@@ -498,7 +539,9 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     // At this point, U, S, and VT contain the SVD of the original Jacobian
     solverLog.setLevel(ILogger::DEBUG);
     dx = -1.0*fx; 
+    linearSolveTimer.start();
     int nsing = svdInvertSolve(Usv,Ssv,VTsv,dx, solverLog);
+    linearSolveTimer.stop();
 
     solverLog << "\nIteration " << iter << "\nf0= " << f0
               << "\tnsing= " << nsing
@@ -513,7 +556,9 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
       for(size_t i=0; i<p.size(); ++i) {
         p[i] = i;
       }
+      linearSolveTimer.start();
       int sing = lu_factorize(B,p);
+      linearSolveTimer.stop();
       if(sing>0) {
         int fail=1;
         B = Btmp;           // restore Jacobian
@@ -544,6 +589,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     
     // J now holds the L-U decomposition of the Jacobian.  Attempt backsubstitution
     dx = -1.0*fx;
+    linearSolveTimer.start();
     try {
       lu_substitute(B,p,dx);    // solve dx = J^-1 F
     }
@@ -553,6 +599,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
       // muddle through to a solution.  If not, then it will
       // eventually stop with a genuinely singular matrix.
     }
+    linearSolveTimer.stop();
     solverLog << "dx: " << dx << "\n"; 
 #endif /* USE_LAPACK */
 
@@ -562,7 +609,9 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
     // dx now holds the newton step.  Execute the line search along
     // that direction.
     double fnew;
+    const int nevalStart = neval;
     int lserr = linesearch(fnorm,x,f0,gx,dx, xnew,fnew, neval, &solverLog);
+    telemetry.addLineSearchEvals( neval - nevalStart );
 
     if(lserr != 0) {
       // line search failed.  There are a couple of things that could
@@ -596,6 +645,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
       if(msf < mFTOL) {
         // basically, we're letting ourselves converge to the sqrt of
         // our intended tolerance.
+        B = Btmp;               // leave the caller with the (unfactored) jacobian
         return 0;
       }
 
@@ -653,6 +703,7 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
       solverLog << "Solution successful.\n";
       x = xnew;
       fx = fxnew;
+      B = Btmp;                 // leave the caller with the (unfactored) jacobian
       return 0;                 // SUCCESS 
     }
 
@@ -740,6 +791,373 @@ int LogBroyden::bsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx,
   return -1;
 }
 
+/*!
+ * \brief Fill in the initial Jacobian using the solver warm start store.
+ * \details The store keeps Jacobians unscaled and by market name, so we remap
+ *          them to the current solvable markets and apply the current scaling.
+ * \param F The ED function, used for its scale factors
+ * \param asmkts The solvable markets in the order of the Jacobian
+ * \param period The current model period
+ * \param J The Jacobian to fill in
+ * \return True if J was filled in, false if it must be calculated.
+ */
+bool LogBroyden::loadWarmStartJacobian(const LogEDFun &F, const std::vector<SolutionInfo> &asmkts,
+                                       int period, UBMATRIX &J) const
+{
+    const SolverWarmStartStore& warmStartStore = SolverWarmStartStore::getInstance();
+    if(!warmStartStore.isEnabled()) {
+        return false;
+    }
+
+    size_t n = asmkts.size();
+    std::vector<double> rawJ;
+    if(!warmStartStore.getJacobian(period, getMarketNames(asmkts), mLogPricep, rawJ)) {
+        return false;
+    }
+
+    const UBVECTOR &xscl = F.getInputScale();
+    const UBVECTOR &fxscl = F.getOutputScale();
+    for(size_t i=0; i<n; ++i) {
+        for(size_t j=0; j<n; ++j) {
+            J(i,j) = rawJ[i*n+j] * fxscl[i] * xscl[j];
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Store the final Jacobian in the solver warm start store.
+ * \param F The ED function, used for its scale factors
+ * \param asmkts The solvable markets in the order of the Jacobian
+ * \param period The current model period
+ * \param J The (unfactored) Jacobian at the solution
+ */
+void LogBroyden::saveWarmStartJacobian(const LogEDFun &F, const std::vector<SolutionInfo> &asmkts,
+                                       int period, const UBMATRIX &J) const
+{
+    SolverWarmStartStore& warmStartStore = SolverWarmStartStore::getInstance();
+    if(!warmStartStore.isEnabled()) {
+        return;
+    }
+
+    size_t n = asmkts.size();
+    const UBVECTOR &xscl = F.getInputScale();
+    const UBVECTOR &fxscl = F.getOutputScale();
+    std::vector<double> rawJ(n*n);
+    for(size_t i=0; i<n; ++i) {
+        for(size_t j=0; j<n; ++j) {
+            rawJ[i*n+j] = J(i,j) / (fxscl[i] * xscl[j]);
+        }
+    }
+    warmStartStore.recordJacobian(period, getMarketNames(asmkts), mLogPricep, rawJ);
+}
+
+/*!
+ * \brief Seed the initial Jacobian from a Jacobian saved at the end of a
+ *        previous solve.
+ * \details Computing a finite difference Jacobian from scratch costs one
+ *          partial model evaluation per solvable market, but the structure of
+ *          the Jacobian changes little between periods (or between trials of the
+ *          same period).  We use the saved Jacobian from the same period if we
+ *          have one, otherwise the one from the most recent earlier period, and
+ *          remap it onto the current solvable markets.  Note that the markets are
+ *          matched by name since the market IDs given by getMarketIDs() are
+ *          renumbered each period.
+ *
+ *          The reused columns are validated by a secant test: we take a single
+ *          small step in all of the reused prices at once and compare the
+ *          resulting change in F to the change predicted by the seeded Jacobian.
+ *          Any market whose excess demand was poorly predicted, along with any
+ *          market that is new to the solvable set, has its column recalculated
+ *          by finite difference.  Rows for new markets retain zero off-diagonal
+ *          terms in the reused columns.  Finally a Broyden update is applied
+ *          with the secant pair so that it is consistent with the trial step.
+ * \param F The ED function
+ * \param asmkts The solvable markets in the order of the Jacobian
+ * \param period The current model period
+ * \param x The current (scaled) inputs
+ * \param fx F(x); on return will again be F(x) with the model state at x
+ * \param J The Jacobian to fill in
+ * \return True if J was filled in, false if it must be calculated.
+ */
+bool LogBroyden::reuseJacobian(LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period,
+                               const UBVECTOR &x, UBVECTOR &fx, UBMATRIX &J)
+{
+    using boost::numeric::ublas::prod;
+    using boost::numeric::ublas::inner_prod;
+    using boost::numeric::ublas::outer_prod;
+    using boost::numeric::ublas::norm_inf;
+
+    if(!mReuseJacobian || mSavedJacobians.empty()) {
+        return false;
+    }
+
+    // Prefer a Jacobian from this period, e.g. from a previous trial run,
+    // otherwise use the latest one prior to this period.
+    std::map<int, SavedJacobian>::const_iterator saved = mSavedJacobians.find(period);
+    if(saved == mSavedJacobians.end()) {
+        saved = mSavedJacobians.lower_bound(period);
+        if(saved == mSavedJacobians.begin()) {
+            return false;
+        }
+        --saved;
+    }
+
+    const std::vector<std::string> &savedNames = saved->second.mMarketNames;
+    const std::vector<double> &savedJ = saved->second.mJacobian;
+    std::map<std::string, int> savedIndex;
+    for(size_t i=0; i<savedNames.size(); ++i) {
+        savedIndex[savedNames[i]] = i;
+    }
+
+    size_t n = asmkts.size();
+    size_t ns = savedNames.size();
+    std::vector<int> remap(n, -1);
+    std::vector<int> recalcCols;
+    for(size_t i=0; i<n; ++i) {
+        std::map<std::string, int>::const_iterator found = savedIndex.find(asmkts[i].getName());
+        if(found != savedIndex.end()) {
+            remap[i] = found->second;
+        }
+        else {
+            recalcCols.push_back(i);
+        }
+    }
+    if(recalcCols.size() == n) {
+        // nothing in common
+        return false;
+    }
+    const size_t numNew = recalcCols.size();
+
+    // Seed J, converting from the unscaled saved Jacobian using the current scale factors.
+    const UBVECTOR &xscl = F.getInputScale();
+    const UBVECTOR &fxscl = F.getOutputScale();
+    for(size_t i=0; i<n; ++i) {
+        for(size_t j=0; j<n; ++j) {
+            J(i,j) = (remap[i] >= 0 && remap[j] >= 0) ?
+                savedJ[remap[i]*ns+remap[j]] * fxscl[i] * xscl[j] : 0.0;
+        }
+    }
+
+    // Secant test: perturb all of the reused columns at once (alternating the
+    // direction to avoid systematically reinforcing cross effects) and compare.
+    const double PROBE = 1.0e-3;
+    UBVECTOR d(n);
+    for(size_t j=0; j<n; ++j) {
+        d[j] = remap[j] >= 0 ? PROBE * (fabs(x[j]) + 1.0) * (j % 2 == 0 ? 1.0 : -1.0) : 0.0;
+    }
+    UBVECTOR xprobe(x + d);
+    UBVECTOR fxprobe(n);
+    F(xprobe, fxprobe);
+    UBVECTOR actual(fxprobe - fx);
+    UBVECTOR predicted(prod(J, d));
+    const double errfloor = 1.0e-3 * norm_inf(actual) + util::getTinyNumber();
+    for(size_t i=0; i<n; ++i) {
+        if(remap[i] >= 0) {
+            double err = fabs(actual[i] - predicted[i]) /
+                std::max(std::max(fabs(actual[i]), fabs(predicted[i])), errfloor);
+            if(err > mJacobianReuseTol) {
+                // A market's own price typically dominates its excess demand
+                // so recalculate that column.
+                recalcCols.push_back(i);
+            }
+        }
+    }
+
+    // Restore the model state to x, which is required as the base state for
+    // the partial derivatives.
+    F(x, fx);
+
+    if(!recalcCols.empty()) {
+        fdjac_cols(F, x, fx, recalcCols, J, true);
+    }
+
+    // Make J consistent with the secant pair from the trial step.
+    UBVECTOR resid(actual - prod(J, d));
+    J += outer_prod(resid, d) / inner_prod(d, d);
+
+    ILogger &solverLog = ILogger::getLogger("solver_log");
+    solverLog.setLevel(ILogger::NOTICE);
+    solverLog << "Reused jacobian from period " << saved->first << ":  "
+              << numNew << " new markets, " << (recalcCols.size() - numNew)
+              << " columns failed the secant test, " << (n - recalcCols.size())
+              << " of " << n << " columns reused.\n";
+    solverLog.setLevel(ILogger::DEBUG);
+    return true;
+}
+
+/*!
+ * \brief Move the initial guess for a new period to a first-order continuation
+ *        estimate of its equilibrium.
+ * \details The initial guess is the previous period's equilibrium carried
+ *          forward by Marketplace::init_to_last, so F(x) measures how far the
+ *          changes in the exogenous drivers between the periods (GDP,
+ *          population, policy paths, etc.) have moved the excess demands.  The
+ *          Jacobian converged at the end of the previous period's solve maps
+ *          that residual to the change in prices which would offset it to first
+ *          order, the same as a Newton step but without having to calculate a
+ *          new Jacobian.
+ *
+ *          Only markets which were solved in the previous period take part;
+ *          markets new to the solvable set keep their initial prices.  The step
+ *          is limited to mContinuationMaxStep relative to the scaled inputs and
+ *          accepted only if it reduces F . F, trying a half step if the full one
+ *          does not.  This costs one or two model evaluations, far fewer than
+ *          the iterations the solver would otherwise spend recovering from the
+ *          carried forward prices.
+ *
+ *          The solver components may be invoked several times within a period,
+ *          and only the first invocation starts from the carried forward
+ *          prices, so the forecast is attempted at most once per period.
+ * \param F The ED function
+ * \param asmkts The solvable markets in the order of x
+ * \param period The current model period
+ * \param x The current (scaled) inputs; on return the accepted inputs
+ * \param fx F(x); on return F(x) at the returned x with the model state at x
+ * \return True if the continuation step was accepted.
+ */
+bool LogBroyden::continuationForecast(LogEDFun &F, const std::vector<SolutionInfo> &asmkts, int period,
+                                      UBVECTOR &x, UBVECTOR &fx)
+{
+    using boost::numeric::ublas::permutation_matrix;
+    using boost::numeric::ublas::lu_factorize;
+    using boost::numeric::ublas::lu_substitute;
+    using boost::numeric::ublas::inner_prod;
+
+    if(!mContinuationForecast || period == mLastForecastPeriod) {
+        return false;
+    }
+    mLastForecastPeriod = period;
+    // A Jacobian saved for this period means this is a repeated solve, such
+    // as a target finder trial, which already starts near its solution.
+    if(mSavedJacobians.empty() || mSavedJacobians.find(period) != mSavedJacobians.end()) {
+        return false;
+    }
+    std::map<int, SavedJacobian>::const_iterator saved = mSavedJacobians.lower_bound(period);
+    if(saved == mSavedJacobians.begin()) {
+        return false;
+    }
+    --saved;
+
+    const std::vector<std::string> &savedNames = saved->second.mMarketNames;
+    const std::vector<double> &savedJ = saved->second.mJacobian;
+    std::map<std::string, int> savedIndex;
+    for(size_t i=0; i<savedNames.size(); ++i) {
+        savedIndex[savedNames[i]] = i;
+    }
+
+    // The markets in common, by index into x and into the saved Jacobian.
+    std::vector<int> common;
+    std::vector<int> remap;
+    for(size_t i=0; i<asmkts.size(); ++i) {
+        std::map<std::string, int>::const_iterator found = savedIndex.find(asmkts[i].getName());
+        if(found != savedIndex.end()) {
+            common.push_back(i);
+            remap.push_back(found->second);
+        }
+    }
+    const size_t nc = common.size();
+    if(nc == 0) {
+        return false;
+    }
+
+    // Solve J_cc . dx_c = -F_c using the current scale factors.
+    const size_t ns = savedNames.size();
+    const UBVECTOR &xscl = F.getInputScale();
+    const UBVECTOR &fxscl = F.getOutputScale();
+    boost::numeric::ublas::matrix<double> Jc(nc, nc);
+    UBVECTOR dxc(nc);
+    for(size_t i=0; i<nc; ++i) {
+        for(size_t j=0; j<nc; ++j) {
+            Jc(i,j) = savedJ[remap[i]*ns+remap[j]] * fxscl[common[i]] * xscl[common[j]];
+        }
+        dxc[i] = -fx[common[i]];
+    }
+    permutation_matrix<size_t> p(nc);
+    if(lu_factorize(Jc, p) != 0) {
+        return false;
+    }
+    try {
+        lu_substitute(Jc, p, dxc);
+    }
+    catch (const boost::numeric::ublas::internal_logic &err) {
+        return false;
+    }
+
+    // Limit the step so that an ill-conditioned Jacobian can not send prices
+    // far away from the carried forward ones.
+    double stepScale = 1.0;
+    for(size_t i=0; i<nc; ++i) {
+        const double maxStep = mContinuationMaxStep * (fabs(x[common[i]]) + 1.0);
+        if(!util::isValidNumber(dxc[i])) {
+            return false;
+        }
+        if(fabs(dxc[i]) * stepScale > maxStep) {
+            stepScale = maxStep / fabs(dxc[i]);
+        }
+    }
+    UBVECTOR dx(x.size());
+    dx.clear();
+    for(size_t i=0; i<nc; ++i) {
+        dx[common[i]] = stepScale * dxc[i];
+    }
+
+    ILogger &solverLog = ILogger::getLogger("solver_log");
+    solverLog.setLevel(ILogger::NOTICE);
+    const double f0 = inner_prod(fx, fx);
+    UBVECTOR xnew(x.size());
+    UBVECTOR fxnew(x.size());
+    for(int trial = 0; trial < 2; ++trial) {
+        xnew = x + dx;
+        F(xnew, fxnew);
+        const double fnew = inner_prod(fxnew, fxnew);
+        if(util::isValidNumber(fnew) && fnew < f0) {
+            solverLog << "Continuation forecast from period " << saved->first << " Jacobian accepted:  "
+                      << nc << " of " << x.size() << " markets, F.F reduced from " << f0
+                      << " to " << fnew << ".\n";
+            solverLog.setLevel(ILogger::DEBUG);
+            x = xnew;
+            fx = fxnew;
+            return true;
+        }
+        dx *= 0.5;
+    }
+
+    solverLog << "Continuation forecast from period " << saved->first
+              << " Jacobian rejected, did not reduce F.F.\n";
+    solverLog.setLevel(ILogger::DEBUG);
+    // Restore the model state to x.
+    F(x, fx);
+    return false;
+}
+
+/*!
+ * \brief Save the final Jacobian so that it can be reused by subsequent solves.
+ * \param F The ED function, used for its scale factors
+ * \param asmkts The solvable markets in the order of the Jacobian
+ * \param period The current model period
+ * \param J The (unfactored) Jacobian at the solution
+ */
+void LogBroyden::saveJacobian(const LogEDFun &F, const std::vector<SolutionInfo> &asmkts,
+                              int period, const UBMATRIX &J)
+{
+    if(!mReuseJacobian && !mContinuationForecast) {
+        return;
+    }
+
+    size_t n = asmkts.size();
+    const UBVECTOR &xscl = F.getInputScale();
+    const UBVECTOR &fxscl = F.getOutputScale();
+    SavedJacobian &saved = mSavedJacobians[period];
+    saved.mMarketNames = getMarketNames(asmkts);
+    saved.mJacobian.resize(n*n);
+    for(size_t i=0; i<n; ++i) {
+        for(size_t j=0; j<n; ++j) {
+            saved.mJacobian[i*n+j] = J(i,j) / (fxscl[i] * xscl[j]);
+        }
+    }
+}
+
 /*! \brief Write a vector into the solver data log
  *
  *  \details We write the solver data log in "long" format; i.e., with
@@ -79,6 +79,7 @@
 #endif
 
 #include "util/base/include/timer.h"
+#include "solution/util/include/solver_telemetry.h"
 
 using namespace std;
 using namespace xercesc;
@@ -271,6 +272,9 @@ SolverComponent::ReturnCode LogNRbt::solve( SolutionInfoSet& solnset, int period
     }
 
     solverLog << endl;
+
+    const SolutionInfo* maxred = solnset.getWorstSolutionInfo();
+    addIteration(maxred->getName(), maxred->getRelativeED());
     return code;
 }
 
@@ -296,7 +300,8 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
   permutation_matrix<int> p(F.narg()); // permutation vector for pivoting in L-U decomposition
 #endif
   UBMATRIX Jtmp(nrow, ncol);
-  
+  Timer& linearSolveTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::LINEAR_SOLVE );
+  SolverTelemetry& telemetry = SolverTelemetry::getInstance();
 
   ILogger &solverLog = ILogger::getLogger("solver_log");
 
@@ -342,10 +347,12 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
     Jtmp = J;                   // save the Jacobian, since gesvd destroys it.
 
 #if USE_LAPACK
+    linearSolveTimer.start();
     int ierr =
       boost::numeric::bindings::lapack::gesvd('O','A','A', // control parameters
                                               J,           // input matrix
                                               Ssv,Usv,VTsv); // output matrices
+    linearSolveTimer.stop();
     if(ierr != 0) {
       // svd failed.  It's not even clear under what circumstances
       // this can happen
@@ -357,7 +364,9 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
     // At this point, U, S, and VT contain the SVD of the original Jacobian
     solverLog.setLevel(ILogger::DEBUG);
     dx = -1.0*fx; 
+    linearSolveTimer.start();
     int nsing = svdInvertSolve(Usv,Ssv,VTsv,dx, solverLog);
+    linearSolveTimer.stop();
     
     solverLog.setLevel(ILogger::DEBUG);
     solverLog << "\n****************Iteration " << iter << "\nf0= " << f0
@@ -380,9 +389,11 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
         axpy_prod(fx,J,gx);         // compute the gradient of F*F (= fx^T * J == J^T * fx)
         
         // re-solve for dx using the new Jacobian
+        linearSolveTimer.start();
         ierr = boost::numeric::bindings::lapack::gesvd('O','A','A', // control parameters
                                                        J,           // input matrix
                                                        Ssv,Usv,VTsv); // output matrices
+        linearSolveTimer.stop();
         if(ierr)
           return nsing;
         dx = -1.0*fx;
@@ -401,7 +412,9 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
        a second time, we bail out */
     do {
       for(size_t i=0; i<p.size(); ++i) p[i] = i;
+      linearSolveTimer.start();
       int sing = lu_factorize(J,p);
+      linearSolveTimer.stop();
       if(sing>0) {
         int fail=1;
         if(itrial == 0)
@@ -421,6 +434,7 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
     
     // J now holds the L-U decomposition of the Jacobian.  Attempt backsubstitution
     dx = -1.0*fx;
+    linearSolveTimer.start();
     try {
       lu_substitute(J,p,dx);    // solve dx = J^-1 F
     }
@@ -430,12 +444,15 @@ int LogNRbt::nrsolve(VecFVec<double,double> &F, UBVECTOR &x, UBVECTOR &fx, UBMAT
       // muddle through to a solution.  If not, then it will
       // eventually stop with a genuinely singular matrix.
     }
+    linearSolveTimer.stop();
 #endif /* USE_LAPACK */
     
     // dx now holds the newton step.  Execute the line search along
     // that direction.
     double fnew;
+    const int nevalStart = neval;
     int lserr = linesearch(fnorm,x,f0,gx,dx, xnew,fnew, neval);
+    telemetry.addLineSearchEvals( neval - nevalStart );
 
     if(lserr != 0) {
       // line search failed.  This means that the descent direction
@@ -45,6 +45,7 @@
 
 #include "solution/solvers/include/solver_component.h"
 #include "solution/util/include/calc_counter.h"
+#include "solution/util/include/solver_telemetry.h"
 
 using namespace std;
 
@@ -69,6 +70,7 @@ SolverComponent::IterationInfo::IterationInfo( const std::string& aName, const d
 //! Add a solution iteration to the stack.
 void SolverComponent::addIteration( const std::string& aSolName, const double aRED ){
     mPastIters.push_back( IterationInfo( aSolName, aRED ) );
+    SolverTelemetry::getInstance().addIteration( aSolName, aRED );
 }
 
 //! Check for improvement over the last n iterations
@@ -97,6 +99,7 @@ bool SolverComponent::isImproving( const unsigned int aNumIter ) const {
 void SolverComponent::startMethod(){
     // Set the current calculation method.  
     calcCounter->setCurrentMethod( getXMLName() );
+    SolverTelemetry::getInstance().startComponent( getXMLName() );
     // Clear the stack.
     mPastIters.clear();
 }
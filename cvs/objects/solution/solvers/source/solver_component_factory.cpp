@@ -56,6 +56,8 @@
 #include "solution/solvers/include/lognrbt.hpp"
 #include "solution/solvers/include/logbroyden.hpp"
 #include "solution/solvers/include/preconditioner.hpp"
+#include "solution/solvers/include/log_newton_krylov.hpp"
+#include "solution/solvers/include/block_decomposed_solver.hpp"
 
 using namespace std;
 using namespace xercesc;
@@ -77,7 +79,9 @@ bool SolverComponentFactory::hasSolverComponent( const string& aXMLName ) {
         || BisectPolicy::getXMLNameStatic() == aXMLName
         || LogNRbt::getXMLNameStatic() == aXMLName
         || LogBroyden::getXMLNameStatic() == aXMLName
-        || Preconditioner::getXMLNameStatic() == aXMLName;
+        || Preconditioner::getXMLNameStatic() == aXMLName
+        || LogNewtonKrylov::getXMLNameStatic() == aXMLName
+        || BlockDecomposedSolver::getXMLNameStatic() == aXMLName;
 }
 
 /*!
@@ -132,6 +136,12 @@ SolverComponentFactory::createAndParseSolverComponent( const string& aXMLName,
     else if( Preconditioner::getXMLNameStatic() == aXMLName ) {
         retSolverComponent = new Preconditioner( aMarketplace, aWorld, aCalcCounter );
     }
+    else if( LogNewtonKrylov::getXMLNameStatic() == aXMLName ) {
+        retSolverComponent = new LogNewtonKrylov( aMarketplace, aWorld, aCalcCounter );
+    }
+    else if( BlockDecomposedSolver::getXMLNameStatic() == aXMLName ) {
+        retSolverComponent = new BlockDecomposedSolver( aMarketplace, aWorld, aCalcCounter );
+    }
     else {
         // this must mean createAndParseSolverComponent and hasSolverComponent
         // are out of sync with known solver components
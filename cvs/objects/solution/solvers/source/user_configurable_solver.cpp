@@ -50,6 +50,8 @@
 #include "solution/solvers/include/solver_component.h"
 #include "solution/solvers/include/solver_component_factory.h"
 #include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solver_warm_start_store.h"
+#include "solution/util/include/solver_telemetry.h"
 #include "util/base/include/configuration.h"
 #include "util/logger/include/ilogger.h"
 #include "solution/util/include/calc_counter.h"
@@ -207,6 +209,15 @@ bool UserConfigurableSolver::solve( const int aPeriod, const SolutionInfoParamPa
     for( SolverComponentIterator it = mSolverComponents.begin(); it != mSolverComponents.end(); ++it ) {
         (*it)->init();
     }
+
+    SolverTelemetry& telemetry = SolverTelemetry::getInstance();
+    telemetry.startSolve( aPeriod );
+
+    // Start from the nearest previously stored solution if one is available.
+    SolverWarmStartStore& warmStartStore = SolverWarmStartStore::getInstance();
+    if( warmStartStore.isEnabled() ) {
+        warmStartStore.applyPrices( aPeriod, solution_set );
+    }
     
     // Loop is done at least once.
     do {
@@ -226,6 +237,7 @@ bool UserConfigurableSolver::solve( const int aPeriod, const SolutionInfoParamPa
         // Determine if the model has solved. 
     } while ( !solution_set.isAllSolved() &&
               mCalcCounter->getPeriodCount() < mMaxModelCalcs );
+    telemetry.endSolve( solution_set.isAllSolved() );
     
     if( conf->getBool( "CalibrationActive" )
             && !world->isAllCalibrated( aPeriod, mCalibrationTolerance, true ) ) {
@@ -236,6 +248,9 @@ bool UserConfigurableSolver::solve( const int aPeriod, const SolutionInfoParamPa
     
     // Determine whether the solver was successful at solving the model.
     if( solution_set.isAllSolved() ){
+        if( warmStartStore.isEnabled() ) {
+            warmStartStore.recordPrices( aPeriod, solution_set );
+        }
         mainLog.setLevel( ILogger::NOTICE );
         mainLog << "Model solved normally. Iterations period "<< aPeriod << ": "
         << mCalcCounter->getPeriodCount() << ". Total iterations: "
@@ -48,6 +48,7 @@
 #include "containers/include/world.h"
 #include "solution/util/include/solution_info_set.h"
 #include "solution/util/include/functor.hpp"
+#include "parallel/include/bitvector.hpp"
 
 #define UBVECTOR boost::numeric::ublas::vector
 
@@ -97,6 +98,9 @@ class LogEDFun : public VecFVec<double,double>
 
   // diagnostic variables
   std::vector<double> mstate;
+
+  //! Calculation mask with every activity set, used for SCRATCH_EVAL.
+  bitvector mAllNodes;
 public:
   LogEDFun(SolutionInfoSet &sisin, World *w, Marketplace *m, int per, bool aLogPricep=true);
   
@@ -104,16 +108,31 @@ public:
   virtual void operator()(const UBVECTOR<double> &x, UBVECTOR<double> &fx, const int partj=-1);
   virtual void partial(int ip);
   virtual double partialSize(int ip) const;
+  virtual int partialAffinity(int ip) const;
+  void scratchEval(const UBVECTOR<double> &x, UBVECTOR<double> &fx, const bitvector &aActivities);
   void scaleInitInputs(UBVECTOR<double> &ax);
+  //! Scale factors applied to the inputs (x = x_scaled * xscl)
+  const UBVECTOR<double> &getInputScale() const {return mxscl;}
+  //! Scale factors applied to the outputs (fx_scaled = fx * fxscl)
+  const UBVECTOR<double> &getOutputScale() const {return mfxscl;}
 
   // Constants to protect against overflow: 
   static const double PMAX;            //!< Greatest allowable price
   static const double ARGMAX;          //!< log of greatest allowable price
 
+  //! Pass as the partial index to evaluate a complete price vector in the
+  //! calling thread's scratch state, leaving the base state untouched.  This
+  //! allows independent price vectors to be evaluated concurrently.
+  static const int SCRATCH_EVAL;
+
 protected:
   // scale factors for input and output
   UBVECTOR<double> mxscl;
   UBVECTOR<double> mfxscl;
+
+private:
+  void evaluate(const UBVECTOR<double> &x, UBVECTOR<double> &fx, const int partj,
+                const bitvector &affectedNodes);
     
 };  
 
@@ -50,6 +50,7 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include "functor.hpp"
 #include <iostream>
+#include <vector>
 #include "solution/util/include/ublas-helpers.hpp"
 
 #define UBLAS boost::numeric::ublas
@@ -156,16 +157,55 @@ void fdjac(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
     jacol(F, x, fx, j, J, usepartial, diagnostic);
   }
 #else
-    tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
-    tbb::task_group tg;
-    threadPool.execute([&](){
-        tg.run([&](){
-            tbb::parallel_for_each( x, [&]( const FTYPE& j ) {
-                jacol(F, x, fx, (&j - &x[0]), J, usepartial, 0/*diagnostic*/);
-            });
-        });
+    // Run each column on the NUMA node of its market's region when enabled.
+    std::vector<int> cols(x.size());
+    std::vector<int> colNodes(x.size());
+    for(size_t j=0; j<x.size(); ++j) {
+      cols[j] = j;
+      colNodes[j] = F.partialAffinity(j);
+    }
+    scenario->getManageStateVariables()->parallelForEachByNode( cols, colNodes, [&]( const int j ) {
+        jacol(F, x, fx, j, J, usepartial, 0/*diagnostic*/);
+    });
+#endif
+    if(usepartial) { F.partial(-1); }
+
+  jacTimer.stop();
+}
+
+/*!
+ * Compute a subset of the columns of the Jacobian of F at point x.
+ * The remaining columns of J are left untouched.  This is useful when
+ * the rest of the Jacobian is already known, for instance when it has
+ * been carried over from a previous solution.
+ * \param[in] F: The function to have its Jacobian calculated
+ * \param[in] x: The point at which to calculate the Jacobian
+ * \param[in] fx: F(x)
+ * \param[in] cols: The indices of the columns to calculate
+ * \param[in,out] J: The Jacobian of F
+ * \param[in] usepartial: (optional) use partial model evaluation for partial derivatives
+ */
+template<class FTYPE, class MTRAIT>
+void fdjac_cols(VecFVec<FTYPE,FTYPE> &F, const UBLAS::vector<FTYPE> &x,
+                const UBLAS::vector<FTYPE> &fx, const std::vector<int> &cols,
+                UBLAS::matrix<FTYPE,MTRAIT> &J, bool usepartial=true)
+{
+  Timer& jacTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::JACOBIAN );
+  jacTimer.start();
+    if(usepartial) { scenario->getManageStateVariables()->setPartialDeriv(true); }
+
+#if !GCAM_PARALLEL_ENABLED
+  for(size_t i=0; i<cols.size(); ++i) {
+    jacol(F, x, fx, cols[i], J, usepartial);
+  }
+#else
+    std::vector<int> colNodes(cols.size());
+    for(size_t i=0; i<cols.size(); ++i) {
+      colNodes[i] = F.partialAffinity(cols[i]);
+    }
+    scenario->getManageStateVariables()->parallelForEachByNode( cols, colNodes, [&]( const int j ) {
+        jacol(F, x, fx, j, J, usepartial, 0/*diagnostic*/);
     });
-    threadPool.execute([&tg](){ tg.wait(); });
 #endif
     if(usepartial) { F.partial(-1); }
 
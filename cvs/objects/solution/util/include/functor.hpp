@@ -110,6 +110,15 @@ public:
    * derivative.
    */
   virtual double partialSize(int ip) const {return 1.0;}
+  /*!
+   * Returns an implementation-defined locality group, such as the
+   * NUMA node owning most of the data a partial derivative touches,
+   * or -1 if there is none.
+   *
+   * Partial derivatives in the same group can be scheduled together
+   * to keep their memory accesses local.
+   */
+  virtual int partialAffinity(int ip) const {return -1;}
   /*!
    * Turns on implementation-defined diagnostics (default is no-op)
    */
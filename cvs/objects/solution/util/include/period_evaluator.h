@@ -0,0 +1,129 @@
+#ifndef _PERIOD_EVALUATOR_H_
+#define _PERIOD_EVALUATOR_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file period_evaluator.h
+ * \ingroup Solution
+ * \brief PeriodEvaluator class header file.
+ */
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <boost/core/noncopyable.hpp>
+#include "solution/util/include/solution_info_set.h"
+
+class Scenario;
+class LogEDFun;
+
+/*!
+ * \ingroup Solution
+ * \brief Evaluates the excess demands of a single model period for arbitrary
+ *        price vectors.
+ * \details The evaluator prepares a period the same way Scenario::run does
+ *          before solving it and then answers excess demand queries for the
+ *          solvable markets of that period without solving.  Any invalid
+ *          earlier periods are calculated first.  This allows external
+ *          optimizers and emulator training to evaluate the model many times
+ *          without running whole scenarios.
+ *
+ *          A batch of price vectors is evaluated concurrently.  Each
+ *          evaluation runs in the calling thread's scratch state of the
+ *          ManageStateVariables, as partial derivatives do, so the base state
+ *          is not changed.  Jacobian columns are calculated with fdjac_cols
+ *          and returned as sparse entries.
+ *
+ *          Prices and excess demands are unscaled and ordered as
+ *          getMarketNames().  Excess demands are demand minus supply, including
+ *          the same correction below the supply lower bound which the solvers
+ *          see.
+ *
+ * \warning The model state is global, so only one evaluator may exist at a
+ *          time and the scenario must not be run while it exists.  The
+ *          evaluated period is left invalid so the next run recalculates it.
+ */
+class PeriodEvaluator : private boost::noncopyable {
+public:
+    //! A single non-zero entry of the Jacobian.
+    struct JacobianEntry {
+        //! The index of the market whose excess demand changed.
+        unsigned int mRow;
+
+        //! The index of the market whose price changed.
+        unsigned int mColumn;
+
+        //! The derivative of the excess demand with respect to the price.
+        double mValue;
+    };
+
+    PeriodEvaluator( Scenario* aScenario, const int aPeriod );
+    ~PeriodEvaluator();
+
+    int getPeriod() const;
+
+    const std::vector<std::string>& getMarketNames() const;
+
+    std::vector<double> getPrices() const;
+
+    void evaluate( const std::vector<std::vector<double> >& aPrices,
+                   std::vector<std::vector<double> >& aExcessDemands );
+
+    void evaluateJacobian( const std::vector<double>& aPrices,
+                           const std::vector<int>& aColumns,
+                           std::vector<double>& aExcessDemands,
+                           std::vector<JacobianEntry>& aJacobian );
+
+private:
+    //! The scenario being evaluated.
+    Scenario* mScenario;
+
+    //! The period being evaluated.
+    const int mPeriod;
+
+    //! The markets of the period.
+    SolutionInfoSet mSolutionSet;
+
+    //! The excess demand function of the solvable markets in linear prices.
+    std::auto_ptr<LogEDFun> mEDFun;
+
+    //! The names of the solvable markets.
+    std::vector<std::string> mMarketNames;
+};
+
+#endif // _PERIOD_EVALUATOR_H_
@@ -61,6 +61,7 @@ namespace objects {
     class Atom;
 }
 
+class bitvector;
 #if GCAM_PARALLEL_ENABLED
 class GcamFlowGraph;
 #endif
@@ -77,9 +78,9 @@ class SolutionInfo {
     }
 public:
 #if GCAM_PARALLEL_ENABLED
-    SolutionInfo( Market* linkedMarket, const std::vector<IActivity*>& aDependenicies, GcamFlowGraph* aFlowGraph );
+    SolutionInfo( Market* linkedMarket, const bitvector* aDependencies, GcamFlowGraph* aFlowGraph );
 #else
-    SolutionInfo( Market* linkedMarket, const std::vector<IActivity*>& aDependenicies );
+    SolutionInfo( Market* linkedMarket, const bitvector* aDependencies );
 #endif
     bool operator==( const SolutionInfo& rhs ) const;
     bool operator!=( const SolutionInfo& rhs ) const;
@@ -125,7 +126,8 @@ public:
     void unsetBisectedFlag();
     bool hasBisected() const;
     const std::vector<const objects::Atom*>& getContainedRegions() const;
-    const std::vector<IActivity*>& getDependencies() const;
+    const bitvector& getDependencies() const;
+    int getNumDependencies() const;
 
     double getLowerBoundSupplyPrice() const;
     double getUpperBoundSupplyPrice() const;
@@ -164,9 +166,12 @@ private:
     double EDR;     //!< excess demand for right bracket
     std::vector<double> demandElasticities; //!< demand elasticities
     std::vector<double> supplyElasticities; //!< supply elasticities
-    //! This activities which need to recalculate if this solution info adjust
-    //! prices
-    std::vector<IActivity*> mDependencies;
+    //! A weak pointer to the set of activities which need to recalculate if this
+    //! solution info adjust prices, or null if it is not solvable.
+    const bitvector* mDependencies;
+    
+    //! The number of activities in mDependencies.
+    int mNumDependencies;
 
 #if GCAM_PARALLEL_ENABLED
     //! A pointer weak pointer to a flow graph which can be used recalculate if this
@@ -113,6 +113,8 @@ public:
     void unsetBisectedFlag();
     void printUnsolved( std::ostream& out );
     void findAndPrintSD( World* aWorld, Marketplace* aMarketplace, const int aPeriod, ILogger& aLogger );
+    void printSD( const std::vector<std::string>& aMarketNames, const int aNumPoints, World* aWorld,
+                  Marketplace* aMarketplace, const int aPeriod, ILogger& aLogger );
     void printMarketInfo( const std::string& comment, const double worldCalcCount, std::ostream& out ) const;
     void printDerivatives( std::ostream& aOut ) const;
 
@@ -109,6 +109,11 @@ private:
         }
     };
 
+    static void updateBracket( SolutionInfo& aSol, const double aDefaultBracketInterval );
+
+    static bool bracketByGroup( Marketplace* aMarketplace, World* aWorld, const double aDefaultBracketInterval,
+                                const unsigned int aMaxIterations, SolutionInfoSet& aSolSet, const int aPeriod );
+
     static std::vector<double> storePrices( const SolutionInfoSet& aSolutionSet );
     static void restorePrices( SolutionInfoSet& aSolutionSet, const std::vector<double>& aPrices );
 };
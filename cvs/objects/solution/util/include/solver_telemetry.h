@@ -0,0 +1,185 @@
+#ifndef _SOLVER_TELEMETRY_H_
+#define _SOLVER_TELEMETRY_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file solver_telemetry.h
+ * \ingroup Objects
+ * \brief SolverTelemetry class header file.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <iosfwd>
+#include <boost/core/noncopyable.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/spin_mutex.h>
+#endif
+
+/*!
+ * \ingroup Objects
+ * \brief Collects solver performance statistics for each period and solver
+ *        component and writes them to a machine readable file.
+ * \details When enabled, by setting the "solver-telemetry" file to write, solver
+ *          components report into this object as they run.  Statistics are
+ *          accumulated by model period and solver component name, and include the
+ *          number of times the component was run, the number of iterations, the
+ *          number of full and partial model calculations, time spent calculating
+ *          Jacobians and in linear solves, the number of function evaluations made
+ *          in line searches, and the trajectory of the worst market by iteration.
+ *          Multiple solves of the same period, such as from target finding, are
+ *          accumulated into the same record.  The results are written as JSON by
+ *          calling write().
+ */
+class SolverTelemetry : private boost::noncopyable {
+public:
+    static SolverTelemetry& getInstance();
+
+    bool isEnabled() const;
+
+    void startSolve( const int aPeriod );
+
+    void endSolve( const bool aSolved );
+
+    void startComponent( const std::string& aComponentName );
+
+    void addIteration( const std::string& aWorstMarket, const double aRelativeED );
+
+    void addCalc( const double aFraction );
+
+    void addLineSearchEvals( const int aNumEvals );
+
+    int getNumIterations( const int aPeriod ) const;
+
+    void write() const;
+
+private:
+    SolverTelemetry();
+
+    //! A point in the worst market trajectory.
+    struct TrajectoryPoint {
+        //! The name of the market with the largest relative excess demand.
+        std::string mMarket;
+
+        //! The largest relative excess demand.
+        double mRelativeED;
+    };
+
+    //! Statistics for a single solver component in a single period.
+    struct ComponentRecord {
+        ComponentRecord();
+
+        //! Number of times the component was run.
+        int mNumRuns;
+
+        //! Number of iterations reported by the component.
+        int mNumIterations;
+
+        //! Number of full model calculations.
+        int mNumFullCalcs;
+
+        //! Number of partial model calculations.
+        int mNumPartialCalcs;
+
+        //! Partial model calculations weighted by the fraction of the model calculated.
+        double mPartialCalcFraction;
+
+        //! Time in seconds spent calculating Jacobians.
+        double mJacobianTime;
+
+        //! Time in seconds spent in linear solves.
+        double mLinearSolveTime;
+
+        //! Number of function evaluations made in line searches.
+        int mNumLineSearchEvals;
+
+        //! The worst market by iteration.
+        std::vector<TrajectoryPoint> mTrajectory;
+    };
+
+    //! Statistics for a single period.
+    struct PeriodRecord {
+        PeriodRecord();
+
+        //! Number of times the period was solved.
+        int mNumSolves;
+
+        //! Number of those solves which were successful.
+        int mNumSolved;
+
+        //! Component records by component name, in the order first used.
+        std::list<std::pair<std::string, ComponentRecord> > mComponents;
+
+        ComponentRecord& getComponent( const std::string& aComponentName );
+    };
+
+    void finishComponent();
+
+    static void writeString( std::ostream& aOut, const std::string& aValue );
+
+    //! Whether telemetry is being collected.
+    const bool mIsEnabled;
+
+    //! The file to write the results to.
+    std::string mFileName;
+
+    //! Records by period.
+    std::map<int, PeriodRecord> mPeriods;
+
+    //! The period currently being solved or -1 if not solving.
+    int mCurrPeriod;
+
+    //! The component currently running or null if none.
+    ComponentRecord* mCurrComponent;
+
+    //! The Jacobian timer total when the current component started.
+    double mJacobianTimeStart;
+
+    //! The linear solve timer total when the current component started.
+    double mLinearSolveTimeStart;
+
+#if GCAM_PARALLEL_ENABLED
+    //! Lock to protect calc counts which may be reported from multiple threads.
+    tbb::spin_mutex mMutex;
+#endif
+};
+
+#endif // _SOLVER_TELEMETRY_H_
@@ -0,0 +1,161 @@
+#ifndef _SOLVER_WARM_START_STORE_H_
+#define _SOLVER_WARM_START_STORE_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file solver_warm_start_store.h
+ * \ingroup Objects
+ * \brief SolverWarmStartStore class header file.
+ */
+
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <iosfwd>
+#include <boost/core/noncopyable.hpp>
+
+class SolutionInfoSet;
+
+/*!
+ * \ingroup Objects
+ * \brief A persistent store of solved prices and Jacobians which can be used to
+ *        warm start the solver.
+ * \details Batch runs, target finding trials, and cost curve runs solve nearly
+ *          identical problems over and over again.  When enabled, by setting the
+ *          "solver-warm-start-db" file to write, this store records for each
+ *          period the solved prices and the last Jacobian used by LogBroyden.
+ *          Records are keyed by the set of scenario components that were read in,
+ *          the model period, and a "policy signature" which is the set of prices
+ *          of markets which were not being solved when the solver started the
+ *          period (which notably includes any fixed taxes or constraints).
+ *
+ *          At the start of a solve the record with the same scenario components
+ *          and period with the nearest policy signature is selected and used to
+ *          set the initial prices for all solver components.  LogBroyden will also
+ *          use the selected record's Jacobian instead of calculating one when it
+ *          covers all of the markets being solved.
+ *
+ *          Jacobians are stored unscaled and keyed by market name so that they can
+ *          be remapped onto a solution set which may differ in order or scaling.
+ *          The store is read from the "solver-warm-start-db" file when first used
+ *          and written back out by calling save().
+ */
+class SolverWarmStartStore : private boost::noncopyable {
+public:
+    static SolverWarmStartStore& getInstance();
+
+    bool isEnabled() const;
+
+    void setScenarioComponents( const std::list<std::string>& aScenComponents );
+
+    bool applyPrices( const int aPeriod, SolutionInfoSet& aSolutionSet );
+
+    void recordPrices( const int aPeriod, const SolutionInfoSet& aSolutionSet );
+
+    bool getJacobian( const int aPeriod, const std::vector<std::string>& aMarketNames,
+                      const bool aLogPrice, std::vector<double>& aJacobian ) const;
+
+    void recordJacobian( const int aPeriod, const std::vector<std::string>& aMarketNames,
+                         const bool aLogPrice, const std::vector<double>& aJacobian );
+
+    void save() const;
+
+private:
+    SolverWarmStartStore();
+
+    //! A single solved period.
+    struct WarmStartEntry {
+        WarmStartEntry();
+
+        //! The scenario components which were used.
+        std::string mScenarioKey;
+
+        //! The model period.
+        int mPeriod;
+
+        //! Prices of markets which were not solved, by market name, at the start
+        //! of the solve.
+        std::map<std::string, double> mPolicySignature;
+
+        //! Solved prices by market name.
+        std::map<std::string, double> mPrices;
+
+        //! Whether the Jacobian is in terms of log prices.
+        bool mLogPrice;
+
+        //! The market names in the order of the rows/columns of the Jacobian,
+        //! empty if no Jacobian was recorded.
+        std::vector<std::string> mJacobianMarkets;
+
+        //! The unscaled Jacobian stored in row major order.
+        std::vector<double> mJacobian;
+
+        void write( std::ostream& aOut ) const;
+        bool read( std::istream& aIn );
+    };
+
+    static double calcSignatureDistance( const std::map<std::string, double>& aLeft,
+                                         const std::map<std::string, double>& aRight );
+
+    void load();
+
+    //! Whether the store is in use.
+    const bool mIsEnabled;
+
+    //! The file to read and save the store to.
+    const std::string mFileName;
+
+    //! The maximum number of records to keep for each scenario and period.
+    const int mMaxEntriesPerPeriod;
+
+    //! The key identifying the current set of scenario components.
+    std::string mScenarioKey;
+
+    //! All stored records in the order they were added.
+    std::list<WarmStartEntry> mEntries;
+
+    //! The record being built up for the period currently being solved.
+    WarmStartEntry mPendingEntry;
+
+    //! The record selected for use in the period currently being solved, or
+    //! null if none was available.
+    const WarmStartEntry* mSelectedEntry;
+};
+
+#endif // _SOLVER_WARM_START_STORE_H_
@@ -45,6 +45,7 @@
 
 #include "util/base/include/util.h"
 #include "solution/util/include/calc_counter.h"
+#include "solution/util/include/solver_telemetry.h"
 
 using namespace std;
 
@@ -91,6 +92,7 @@ void CalcCounter::incrementCount( const double additional ){
 #if GCAM_PARALLEL_ENABLED
     mCounterLock.unlock();
 #endif
+    SolverTelemetry::getInstance().addCalc( additional );
 }
 
 /*! \brief Set the name of the method currently being used to solve.
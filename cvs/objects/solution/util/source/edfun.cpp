@@ -38,6 +38,7 @@
 #include "solution/util/include/edfun.hpp"
 #include "util/base/include/fltcmp.hpp"
 #include "containers/include/iactivity.h"
+#include "parallel/include/bitvector.hpp"
 #include "util/base/include/util.h"
 #include "util/logger/include/ilogger.h"
 #include "containers/include/scenario.h"
@@ -51,6 +52,7 @@ extern Scenario* scenario;
 
 const double LogEDFun::PMAX = 1.0e24;
 const double LogEDFun::ARGMAX = 55.262042; // log(PMAX)
+const int LogEDFun::SCRATCH_EVAL = -2;
 
 // constructor
 LogEDFun::LogEDFun(SolutionInfoSet &sisin,
@@ -58,10 +60,12 @@ LogEDFun::LogEDFun(SolutionInfoSet &sisin,
     mkts(sisin.getSolvableSet()),
     solnset(sisin),
     world(w), mktplc(m), period(per),
-    mLogPricep(aLogPricep)
+    mLogPricep(aLogPricep),
+    mAllNodes(w->getGlobalOrderingSize())
 {
     na=nr=mkts.size();
     mdiagnostic=false;
+    mAllNodes.setall();
 
     // set up the scale vectors
     mxscl.resize(na);
@@ -124,9 +128,14 @@ void LogEDFun::partial(int ip)
     Timer& edfunAnResetTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EDFUN_AN_RESET );
     edfunAnResetTimer.start();
     if(ip >= 0) {
-        // We are about to perform partial derviatives so snap back *all* state
+        // We are about to perform partial derviatives so snap back the state
         // including prices/supplies/demands to a "base" state before we perform
-        // this partial derivative
+        // this partial derivative.  Only the state that the dependent
+        // activities could read or change needs to be reset.
+        scenario->mManageStateVars->copyState(mkts[ip].getDependencies());
+    }
+    else if(ip == SCRATCH_EVAL) {
+        // A scratch evaluation calculates everything so snap back *all* state.
         scenario->mManageStateVars->copyState();
     }
     else if(ip == -1 ) {
@@ -141,10 +150,47 @@ void LogEDFun::partial(int ip)
 
 double LogEDFun::partialSize(int ip) const
 {
-  return double(mkts[ip].getDependencies().size()) / double(world->getGlobalOrderingSize());
+  return double(mkts[ip].getNumDependencies()) / double(world->getGlobalOrderingSize());
+}
+
+int LogEDFun::partialAffinity(int ip) const
+{
+#if GCAM_PARALLEL_ENABLED
+  // The NUMA node assigned to the region of the market.
+  return scenario->mManageStateVars->getRegionNode(mkts[ip].getRegionName());
+#else
+  return -1;
+#endif
 }
 
 void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, const int partj)
+{
+  // A scratch evaluation recalculates every activity.  Since only the
+  // difference from the base state is added to the markets the result
+  // is the same as a full evaluation.
+  evaluate(ax, fx, partj, partj >= 0 ? mkts[partj].getDependencies() : mAllNodes);
+}
+
+/*!
+ * \brief Evaluate a complete price vector in the calling thread's scratch
+ *        state, recalculating only the given activities.
+ * \details The activities must include every activity that depends on a
+ *          price which differs from the base state.  As with SCRATCH_EVAL the
+ *          base state is left untouched, so independent price vectors may be
+ *          evaluated concurrently.  The caller must have
+ *          turned on partial derivative mode in the state manager.
+ * \param ax The (scaled) inputs.
+ * \param fx The (scaled) outputs.
+ * \param aActivities The activities, by global ordering, to recalculate.
+ */
+void LogEDFun::scratchEval(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, const bitvector &aActivities)
+{
+  scenario->mManageStateVars->copyState(aActivities);
+  evaluate(ax, fx, SCRATCH_EVAL, aActivities);
+}
+
+void LogEDFun::evaluate(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, const int partj,
+                        const bitvector &affectedNodes)
 {
   assert(x.size() == mkts.size());
   assert(fx.size() == mkts.size());
@@ -170,7 +216,7 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
    **** point.
    ****/
   
-  if(partj < 0) {               // not a partial derivative calculation
+  if(partj < 0 && partj != SCRATCH_EVAL) { // not a partial derivative calculation
     /****
      * 1A Set the model inputs using the solutionInfo objects (full eval version)
      ****/
@@ -220,7 +266,7 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
     mktplc->mIsDerivativeCalc = true;
 
 
-    if(mdiagnostic) {
+    if(mdiagnostic && partj >= 0) {
       ILogger &solverlog = ILogger::getLogger("solver_log");
       solverlog.setLevel(ILogger::DEBUG);
 
@@ -245,6 +291,11 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
           mkts[i].setPrice(exp(x[i])); // input vector = log(price)
       }
     }
+    else if(partj == SCRATCH_EVAL) {
+      for(size_t i=0; i<x.size(); ++i) {
+        mkts[i].setPrice(x[i]); // input vector = price
+      }
+    }
     else {
         // During a partial calc only the price of the partj'th element should
         // change and the rest were reset from stored values.  In theory
@@ -256,9 +307,8 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
     /****
      * 2B Evaluate the model (partial derivative version)
      ****/
-    const std::vector<IActivity*>& affectedNodes = mkts[partj].getDependencies();
     /* \invariant At least one node is affected */
-    assert(!affectedNodes.empty());
+    assert(partj == SCRATCH_EVAL || mkts[partj].getNumDependencies() > 0);
     edfunMiscTimer.stop();
     edfunPreTimer.stop();
     Timer& evalPartTimer = TimerRegistry::getInstance().getTimer( TimerRegistry::EVAL_PART );
@@ -269,7 +319,7 @@ void LogEDFun::operator()(const UBVECTOR<double> &ax, UBVECTOR<double> &fx, cons
     world->calc(period, affectedNodes);
     evalPartTimer.stop();
 
-    if(mdiagnostic) {
+    if(mdiagnostic && partj >= 0) {
       ILogger &solverlog = ILogger::getLogger("solver_log");
       solverlog.setLevel(ILogger::DEBUG);
       
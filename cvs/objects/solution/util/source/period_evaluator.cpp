@@ -0,0 +1,260 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file period_evaluator.cpp
+ * \ingroup Solution
+ * \brief PeriodEvaluator class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <cassert>
+#include <numeric>
+#include <boost/numeric/ublas/vector.hpp>
+#include <boost/numeric/ublas/matrix.hpp>
+
+#include "solution/util/include/period_evaluator.h"
+#include "solution/util/include/edfun.hpp"
+#include "solution/util/include/fdjac.hpp"
+#include "containers/include/scenario.h"
+#include "containers/include/world.h"
+#include "marketplace/include/marketplace.h"
+#include "util/base/include/model_time.h"
+#include "util/base/include/manage_state_variables.hpp"
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+#endif
+
+using namespace std;
+
+extern Scenario* scenario;
+
+namespace {
+    // The solution tolerance and floor are not used to evaluate excess
+    // demands, use the same defaults as the solvers.
+    const double DEFAULT_SOLUTION_TOLERANCE = 0.001;
+    const double DEFAULT_SOLUTION_FLOOR = 0.0001;
+}
+
+/*!
+ * \brief Constructor which prepares the period for evaluation.
+ * \details Calculates any invalid periods before aPeriod, initializes aPeriod
+ *          and calculates the base state at the initial prices of the period.
+ * \param aScenario The scenario to evaluate, which must be the global
+ *        scenario.
+ * \param aPeriod The period to evaluate.
+ */
+PeriodEvaluator::PeriodEvaluator( Scenario* aScenario, const int aPeriod ):
+mScenario( aScenario ),
+mPeriod( aPeriod ),
+mSolutionSet( aScenario->getMarketplace() )
+{
+    /*! \pre The model state is reached through the global scenario. */
+    assert( mScenario == scenario );
+
+    // Calculate any earlier periods which are not valid.
+    bool isPreviousValid = true;
+    for( int period = 0; period < mPeriod; ++period ) {
+        isPreviousValid &= mScenario->mIsValidPeriod[ period ];
+    }
+    if( !isPreviousValid ) {
+        mScenario->run( mPeriod - 1, false );
+    }
+
+    // The evaluated period will not be solved.
+    const int maxPeriod = mScenario->getModeltime()->getmaxper();
+    for( int period = mPeriod; period < maxPeriod; ++period ) {
+        mScenario->invalidatePeriod( period );
+    }
+
+    mScenario->initPeriod( mPeriod );
+    World* world = mScenario->getWorld();
+    world->calc( mPeriod );
+
+    mSolutionSet.init( mPeriod, DEFAULT_SOLUTION_TOLERANCE, DEFAULT_SOLUTION_FLOOR,
+                       mScenario->mSolutionInfoParamParser );
+    mEDFun.reset( new LogEDFun( mSolutionSet, world, mScenario->getMarketplace(), mPeriod, false ) );
+    for( unsigned int i = 0; i < mSolutionSet.getNumSolvable(); ++i ) {
+        mMarketNames.push_back( mSolutionSet.getSolvable( i ).getName() );
+    }
+}
+
+//! Destructor which releases the state of the period.
+PeriodEvaluator::~PeriodEvaluator() {
+    mEDFun.reset();
+    delete mScenario->mManageStateVars;
+    mScenario->mManageStateVars = 0;
+}
+
+/*!
+ * \brief Get the period being evaluated.
+ * \return The period being evaluated.
+ */
+int PeriodEvaluator::getPeriod() const {
+    return mPeriod;
+}
+
+/*!
+ * \brief Get the names of the solvable markets in the order used for prices
+ *        and excess demands.
+ * \return The names of the solvable markets.
+ */
+const vector<string>& PeriodEvaluator::getMarketNames() const {
+    return mMarketNames;
+}
+
+/*!
+ * \brief Get the prices of the base state.
+ * \return The prices of the solvable markets in the base state.
+ */
+vector<double> PeriodEvaluator::getPrices() const {
+    vector<double> prices( mMarketNames.size() );
+    for( unsigned int i = 0; i < prices.size(); ++i ) {
+        prices[ i ] = mSolutionSet.getSolvable( i ).getPrice();
+    }
+    return prices;
+}
+
+/*!
+ * \brief Evaluate the excess demands for a batch of price vectors.
+ * \details Each price vector is evaluated independently in a scratch state
+ *          starting from the base state, concurrently when
+ *          GCAM_PARALLEL_ENABLED.  The base state is not changed.
+ * \param aPrices The price vectors to evaluate.
+ * \param aExcessDemands The excess demands for each price vector.
+ */
+void PeriodEvaluator::evaluate( const vector<vector<double> >& aPrices,
+                                vector<vector<double> >& aExcessDemands )
+{
+    using UBVECTOR = boost::numeric::ublas::vector<double>;
+    const size_t numMarkets = mMarketNames.size();
+    const UBVECTOR& inputScale = mEDFun->getInputScale();
+    const UBVECTOR& outputScale = mEDFun->getOutputScale();
+    aExcessDemands.assign( aPrices.size(), vector<double>( numMarkets ) );
+    if( aPrices.empty() || numMarkets == 0 ) {
+        return;
+    }
+
+    mScenario->getManageStateVariables()->setPartialDeriv( true );
+    auto evalPrices = [&]( const int aIndex ) {
+        /*! \pre A price is given for each market. */
+        assert( aPrices[ aIndex ].size() == numMarkets );
+        // Temporaries so that concurrent evaluations do not share inputs or outputs.
+        UBVECTOR x( numMarkets ), fx( numMarkets );
+        for( size_t i = 0; i < numMarkets; ++i ) {
+            x[ i ] = aPrices[ aIndex ][ i ] / inputScale[ i ];
+        }
+        mEDFun->partial( LogEDFun::SCRATCH_EVAL );
+        ( *mEDFun )( x, fx, LogEDFun::SCRATCH_EVAL );
+        for( size_t i = 0; i < numMarkets; ++i ) {
+            aExcessDemands[ aIndex ][ i ] = fx[ i ] / outputScale[ i ];
+        }
+    };
+
+    const int numEvals = static_cast<int>( aPrices.size() );
+#if !GCAM_PARALLEL_ENABLED
+    for( int i = 0; i < numEvals; ++i ) {
+        evalPrices( i );
+    }
+#else
+    tbb::task_arena& threadPool = mScenario->getManageStateVariables()->mThreadPool;
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for( 0, numEvals, evalPrices );
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+#endif
+    mEDFun->partial( -1 );
+}
+
+/*!
+ * \brief Evaluate the excess demands and a block of Jacobian columns at the
+ *        given prices.
+ * \details The base state is moved to aPrices so that the columns can be
+ *          calculated as partial derivatives.  Later calls to evaluate start
+ *          from this base state, which does not change their results.
+ * \param aPrices The prices at which to evaluate.
+ * \param aColumns The indices of the markets whose price derivatives to
+ *        calculate, all markets if empty.
+ * \param aExcessDemands The excess demands at aPrices.
+ * \param aJacobian The non-zero entries of the requested Jacobian columns.
+ */
+void PeriodEvaluator::evaluateJacobian( const vector<double>& aPrices,
+                                        const vector<int>& aColumns,
+                                        vector<double>& aExcessDemands,
+                                        vector<JacobianEntry>& aJacobian )
+{
+    using UBVECTOR = boost::numeric::ublas::vector<double>;
+    const size_t numMarkets = mMarketNames.size();
+    /*! \pre A price is given for each market. */
+    assert( aPrices.size() == numMarkets );
+    const UBVECTOR& inputScale = mEDFun->getInputScale();
+    const UBVECTOR& outputScale = mEDFun->getOutputScale();
+
+    UBVECTOR x( numMarkets ), fx( numMarkets );
+    for( size_t i = 0; i < numMarkets; ++i ) {
+        x[ i ] = aPrices[ i ] / inputScale[ i ];
+    }
+    mEDFun->partial( -1 );
+    ( *mEDFun )( x, fx );
+
+    aExcessDemands.resize( numMarkets );
+    for( size_t i = 0; i < numMarkets; ++i ) {
+        aExcessDemands[ i ] = fx[ i ] / outputScale[ i ];
+    }
+
+    vector<int> columns( aColumns );
+    if( columns.empty() ) {
+        columns.resize( numMarkets );
+        iota( columns.begin(), columns.end(), 0 );
+    }
+    boost::numeric::ublas::matrix<double> jac( numMarkets, numMarkets, 0.0 );
+    fdjac_cols( *mEDFun, x, fx, columns, jac );
+
+    aJacobian.clear();
+    for( vector<int>::const_iterator colIter = columns.begin(); colIter != columns.end(); ++colIter ) {
+        for( size_t row = 0; row < numMarkets; ++row ) {
+            if( jac( row, *colIter ) != 0.0 ) {
+                JacobianEntry entry;
+                entry.mRow = row;
+                entry.mColumn = *colIter;
+                entry.mValue = jac( row, *colIter ) / outputScale[ row ] / inputScale[ *colIter ];
+                aJacobian.push_back( entry );
+            }
+        }
+    }
+}
@@ -48,14 +48,15 @@
 #include "marketplace/include/market.h"
 #include "util/logger/include/ilogger.h"
 #include "containers/include/info.h"
+#include "parallel/include/bitvector.hpp"
 
 using namespace std;
 
 //! Constructor
 #if GCAM_PARALLEL_ENABLED
-SolutionInfo::SolutionInfo( Market* aLinkedMarket, const vector<IActivity*>& aDependencies, GcamFlowGraph* aFlowGraph )
+SolutionInfo::SolutionInfo( Market* aLinkedMarket, const bitvector* aDependencies, GcamFlowGraph* aFlowGraph )
 #else
-SolutionInfo::SolutionInfo( Market* aLinkedMarket, const vector<IActivity*>& aDependencies )
+SolutionInfo::SolutionInfo( Market* aLinkedMarket, const bitvector* aDependencies )
 #endif
 :
 bracketed( false ),
@@ -65,7 +66,8 @@ XL( 0 ),
 XR( 0 ),
 EDL( 0 ),
 EDR( 0 ),
-mDependencies( const_cast<vector<IActivity*>&>( aDependencies ) ),
+mDependencies( aDependencies ),
+mNumDependencies( aDependencies ? aDependencies->count() : 0 ),
 #if GCAM_PARALLEL_ENABLED
 mFlowGraph( aFlowGraph ),
 #endif
@@ -562,10 +564,23 @@ void SolutionInfo::printDerivatives( ostream& aOut ) const {
 /*
  * \brief Get the items which are affected by changing the price of this solution
  *        info.
- * \return A list of items to recalculate when this solution info's price changes.
+ * \return The set of items to recalculate when this solution info's price changes
+ *         as indices into the global ordering.
+ * \pre This solution info is solvable.
  */
-const vector<IActivity*>& SolutionInfo::getDependencies() const {
-    return mDependencies;
+const bitvector& SolutionInfo::getDependencies() const {
+    /*! \pre Dependencies were set. */
+    assert( mDependencies );
+    return *mDependencies;
+}
+
+/*
+ * \brief Get the number of items which are affected by changing the price of this
+ *        solution info.
+ * \return The number of items to recalculate when this solution info's price changes.
+ */
+int SolutionInfo::getNumDependencies() const {
+    return mNumDependencies;
 }
 
 /*!
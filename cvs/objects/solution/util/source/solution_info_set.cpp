@@ -95,17 +95,30 @@ void SolutionInfoSet::init( const unsigned int aPeriod, const double aDefaultSol
     // Create and initialize a SolutionInfo object for each market.
     typedef vector<Market*>::const_iterator ConstMarketIterator;
     MarketDependencyFinder* depFinder = marketplace->getDependencyFinder();
+#if GCAM_PARALLEL_ENABLED
+    // As it turns out the extra time calculating with market specific flow graphs
+    // does not typically get paid back while calculating partial derivatives since
+    // the loop over each partial derivative is already a parallel_for.  They are
+    // cheap to create from the global grain schedule however so users may enable
+    // them.  When enabled we create all of the needed graphs at once in parallel.
+    const bool useMarketFlowGraphs = Configuration::getInstance()->getBool( "parallel-market-flow-graphs", false, false );
+    if( useMarketFlowGraphs ) {
+        vector<int> solvableMarketNumbers;
+        for( ConstMarketIterator iter = marketsToSolve.begin(); iter != marketsToSolve.end(); ++iter ){
+            if( (*iter)->isSolvable() ) {
+                solvableMarketNumbers.push_back( iter - marketsToSolve.begin() );
+            }
+        }
+        depFinder->buildFlowGraphs( solvableMarketNumbers );
+    }
+#endif
     for( ConstMarketIterator iter = marketsToSolve.begin(); iter != marketsToSolve.end(); ++iter ){
         const bool isSolvable = (*iter)->isSolvable();
         const int marketNumber = iter - marketsToSolve.begin();
-        const vector<IActivity*> partialList = isSolvable ? depFinder->getOrdering( marketNumber ) : vector<IActivity*>();
+        const bitvector* partialList = isSolvable ? &depFinder->getCalcMask( marketNumber ) : 0;
 #if GCAM_PARALLEL_ENABLED
-        // TODO: As it turns out the extra time generating these graphs does not typically
-        // get paid back in terms of time saved while calculating partial derivatives.  At
-        // least in a single scenario run.  We need to come up with some methodology to figure
-        // out when it is beneficial to do this or not until then we are not generating any.
         SolutionInfo currInfo( *iter, partialList, 
-               /*isSolvable ? depFinder->getFlowGraph( marketNumber ) :*/ 0 );
+               isSolvable && useMarketFlowGraphs ? depFinder->getFlowGraph( marketNumber ) : 0 );
 #else
         SolutionInfo currInfo( *iter, partialList );
 #endif
@@ -631,14 +644,62 @@ void SolutionInfoSet::findAndPrintSD( World* aWorld, Marketplace* aMarketplace,
     sort( solvable.begin(), solvable.end(), SolutionInfo::GreaterRelativeED() );
 
     // Now determine supply and demand curves for each.
-    for ( int i = 0; i < numMarketsToFindSD; ++i ) {
+    vector<SupplyDemandCurve*> sdCurves;
+    const int numMarkets = min( numMarketsToFindSD, static_cast<int>( solvable.size() ) );
+    for ( int i = 0; i < numMarkets; ++i ) {
         // If its solved, skip it.
         if( solvable[ i ].isSolved() ){
             continue;
         }
-        SupplyDemandCurve sdCurve( i, solvable[ i ].getName() );
-        sdCurve.calculatePoints( numPointsForSD, *this, aWorld, aMarketplace, aPeriod );
-        sdCurve.print( aLogger );
+        sdCurves.push_back( new SupplyDemandCurve( i, solvable[ i ].getName() ) );
+    }
+
+    // Calculate all of the curves together so that their points may be
+    // calculated concurrently.
+    SupplyDemandCurve::calculateCurves( sdCurves, numPointsForSD, *this, aWorld, aMarketplace, aPeriod );
+    for( vector<SupplyDemandCurve*>::const_iterator curveIter = sdCurves.begin(); curveIter != sdCurves.end(); ++curveIter ) {
+        ( *curveIter )->print( aLogger );
+        delete *curveIter;
+    }
+}
+
+/*! \brief Calculate and print supply-demand curves for the given markets.
+*
+* An on demand version of findAndPrintSD which may be used as a diagnostic for any
+* set of solvable markets regardless of whether they are solved.  The points for
+* all of the curves are calculated concurrently so that sweeping many points across
+* many markets remains practical.
+*
+* \param aMarketNames The names of the markets for which to calculate curves.  Names
+*                     which are not currently solvable are skipped with a warning.
+* \param aNumPoints The number of points to calculate for each curve.
+* \param aWorld The world to use to calculate new points.
+* \param aMarketplace The marketplace to use to calculate new points.
+* \param aPeriod Period for which to print supply-demand curves.
+* \param aLogger Logger stream to print the curves to.
+*/
+void SolutionInfoSet::printSD( const vector<string>& aMarketNames, const int aNumPoints, World* aWorld,
+                               Marketplace* aMarketplace, const int aPeriod, ILogger& aLogger )
+{
+    vector<SupplyDemandCurve*> sdCurves;
+    for( vector<string>::const_iterator nameIter = aMarketNames.begin(); nameIter != aMarketNames.end(); ++nameIter ) {
+        unsigned int i = 0;
+        while( i < solvable.size() && solvable[ i ].getName() != *nameIter ) {
+            ++i;
+        }
+        if( i == solvable.size() ) {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Skipping supply-demand curve for " << *nameIter << " as it is not a solvable market." << endl;
+            continue;
+        }
+        sdCurves.push_back( new SupplyDemandCurve( i, solvable[ i ].getName() ) );
+    }
+
+    SupplyDemandCurve::calculateCurves( sdCurves, aNumPoints, *this, aWorld, aMarketplace, aPeriod );
+    for( vector<SupplyDemandCurve*>::const_iterator curveIter = sdCurves.begin(); curveIter != sdCurves.end(); ++curveIter ) {
+        ( *curveIter )->print( aLogger );
+        delete *curveIter;
     }
 }
 
@@ -62,9 +62,14 @@
 #include "util/logger/include/ilogger.h"
 #include "solution/util/include/ublas-helpers.hpp"
 #include "containers/include/iactivity.h"
+#include "containers/include/scenario.h"
+#include "util/base/include/manage_state_variables.hpp"
+#include "parallel/include/bitvector.hpp"
 
 using namespace std;
 
+extern Scenario* scenario;
+
 #define NO_REGIONAL_DERIVATIVES 0
 
 /*! \brief Calculate and return a relative excess demand.
@@ -304,9 +309,105 @@ bool SolverLibrary::luFactorizeMatrix( Matrix& aInputMatrix, PermutationMatrix&
     return lu_factorize( aInputMatrix, aPermMatrix ) != 0;
 }
 
+/*!
+ * \brief Take a single bracketing step for a market.
+ * \details Moves the brackets given the excess demand at the current price and,
+ *          if the market is not yet bracketed, moves the price further in the
+ *          direction of the solution.
+ * \param aSol The market to bracket.
+ * \param aDefaultBracketInterval The default bracket interval which may be
+ *                                overriden by the SolutionInfo.
+ */
+void SolverLibrary::updateBracket( SolutionInfo& aSol, const double aDefaultBracketInterval ) {
+    static const double LOWER_BOUND = util::getVerySmallNumber();
+    double currBracketInterval = aSol.getBracketInterval( aDefaultBracketInterval );
+    
+    // Check for special case where a resource with no supply can become "solved" during
+    // the bracketing procedure.
+    if( fabs( aSol.getSupply() ) < util::getSmallNumber() &&
+        fabs( aSol.getDemand() ) < util::getSmallNumber() )
+    {
+        aSol.setBracketed();
+    }
+    if ( !aSol.isBracketed() ) {
+        // If a market is not bracketed, then EDL and EDR have the same sign
+        // Check if ED has the same sign as EDL and EDR.
+        if ( util::sign( aSol.getED() ) == util::sign( aSol.getEDLeft() ) ) {
+            // If Supply > Demand at point X, then we want to decrease x to increase demand
+            // If ED is negative, then so are EDL and EDR
+            // So, X, XL, and XR are all greater than the solution price
+            if ( aSol.getED() < 0 ) {
+                aSol.moveRightBracketToX();
+                aSol.decreaseX( currBracketInterval, LOWER_BOUND );
+            } // END: if statement testing if ED < 0
+            // If Supply <= Demand. Price needs to increase so demand decreases
+            // If ED is positive, then so are EDL and EDR
+            // So, X, XL, and XR are all less than the solution price
+            else {
+                aSol.moveLeftBracketToX();
+                aSol.increaseX( currBracketInterval, LOWER_BOUND );
+            } // END: if statement testing if ED > 0
+        } // END: if statement testing if ED and EDL have the same sign
+        // If market is unbracketed, EDL and EDR have the same sign
+        // ED has the opposite sign of EDL and EDR
+        else {
+            // If ED < 0, then EDL > 0 and EDR > 0
+            // To bracket we just need to move XR to X
+            if ( aSol.getED() < 0 ) {
+                aSol.moveRightBracketToX();
+            } // END: if statement testing if ED < 0
+            // If ED > 0, then EDL < 0 and EDR < 0
+            // To bracket, we just need to move XL to X
+            else {
+                aSol.moveLeftBracketToX();
+            } // END: if statement testing if ED > 0
+        } // END: if statement testing if ED and EDL have opposite signs
+
+        // Check if current marketed is now bracketed
+        // If so, set bracketed to true
+        if( aSol.isCurrentlyBracketed() ){
+            aSol.setBracketed();
+        }
+
+    } // END: if statement testing if bracketed
+    // If bracketed, but left and right prices are equal
+    else if ( aSol.getBracketSize() == 0 ){
+        // If XL and XR are equal, market is not bracketed
+        // If ED, EDL and EDR all have same sign, set bracketed to false
+        if ( util::sign( aSol.getED() ) == util::sign( aSol.getEDLeft() ) ) {
+            aSol.resetBrackets();
+        }
+        // if ED < EDL, then X > XL
+        // if we move XR to X, then market will be bracketed
+        else if ( aSol.getED() < aSol.getEDLeft() ) {
+            aSol.moveRightBracketToX();
+
+            // Check if market is currently bracketed
+            // If so, set bracketed to true
+            if( aSol.isCurrentlyBracketed() ){
+                aSol.setBracketed();
+            }
+        }
+        // if ED > EDL, then X < XL
+        // if we move XL to X, then market will be bracketed
+        else {
+            aSol.moveLeftBracketToX();
+
+            // Check if market is currently bracketed
+            // If so, set bracketed to true
+            if( aSol.isCurrentlyBracketed() ){
+                aSol.setBracketed();
+            }
+        }
+    } // END: if statement testing if aSol is bracketed with XL == XR
+}
+
 /*! \brief Bracket a set of markets.
 * \details Function finds bracket interval for each market and puts this
 *          information into solution set vector
+*          When the parallel-bracketing configuration option is set, markets
+*          which do not share dependent activities are bracketed concurrently
+*          with partial calcs instead.  See bracketByGroup().
 * \author Sonny Kim, Josh Lurz, Steve Smith, Kate Calvin
 * \param aMarketplace Marketplace reference.
 * \param aWorld World reference.
@@ -324,7 +425,6 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
                              const ISolutionInfoFilter* aSolutionInfoFilter, const int aPeriod )
 {
     bool code = false;
-    static const double LOWER_BOUND = util::getVerySmallNumber();
 
     // Make sure the markets are up to date before starting.
     aMarketplace->nullSuppliesAndDemands( aPeriod );
@@ -353,6 +453,19 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
 
     ILogger& singleLog = ILogger::getLogger( "single_market_log" );
 
+    // Search the brackets of independent groups of markets concurrently with
+    // partial calcs if requested and there is more than one group.
+    if( Configuration::getInstance()->getBool( "parallel-bracketing" ) &&
+        bracketByGroup( aMarketplace, aWorld, aDefaultBracketInterval, aMaxIterations, aSolutionSet, aPeriod ) )
+    {
+        code = aSolutionSet.isAllBracketed();
+        solverLog.setLevel( ILogger::DEBUG );
+        solverLog << "Solution Info Set before leaving bracket: " << endl;
+        solverLog << aSolutionSet << endl;
+        aSolutionSet.printMarketInfo( "End Bracketing Attempt", 0, singleLog );
+        return code;
+    }
+
     // Loop is done at least once.
     unsigned int iterationCount = 1;
     do {
@@ -360,89 +473,8 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
 
         // Iterate through each market.
         for ( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); i++ ) {
-            // Fetch the current 
-            SolutionInfo& currSol = aSolutionSet.getSolvable( i );
-            double currBracketInterval = currSol.getBracketInterval( aDefaultBracketInterval );
-            
-            // Check for special case where a resource with no supply can become "solved" during
-            // the bracketing procedure.
-            if( fabs( currSol.getSupply() ) < util::getSmallNumber() &&
-                fabs( currSol.getDemand() ) < util::getSmallNumber() )
-            {
-                currSol.setBracketed();
-            }
-            if ( !currSol.isBracketed() ) {
-                // If a market is not bracketed, then EDL and EDR have the same sign
-                // Check if ED has the same sign as EDL and EDR.
-                if ( util::sign( currSol.getED() ) == util::sign( currSol.getEDLeft() ) ) {
-                    // If Supply > Demand at point X, then we want to decrease x to increase demand
-                    // If ED is negative, then so are EDL and EDR
-                    // So, X, XL, and XR are all greater than the solution price
-                    if ( currSol.getED() < 0 ) {
-                        currSol.moveRightBracketToX();
-                        currSol.decreaseX( currBracketInterval, LOWER_BOUND );
-                    } // END: if statement testing if ED < 0
-                    // If Supply <= Demand. Price needs to increase so demand decreases
-                    // If ED is positive, then so are EDL and EDR
-                    // So, X, XL, and XR are all less than the solution price
-                    else {
-                        currSol.moveLeftBracketToX();
-                        currSol.increaseX( currBracketInterval, LOWER_BOUND );
-                    } // END: if statement testing if ED > 0
-                } // END: if statement testing if ED and EDL have the same sign
-                // If market is unbracketed, EDL and EDR have the same sign
-                // ED has the opposite sign of EDL and EDR
-                else {
-                    // If ED < 0, then EDL > 0 and EDR > 0
-                    // To bracket we just need to move XR to X
-                    if ( currSol.getED() < 0 ) {
-                        currSol.moveRightBracketToX();
-                    } // END: if statement testing if ED < 0
-                    // If ED > 0, then EDL < 0 and EDR < 0
-                    // To bracket, we just need to move XL to X
-                    else {
-                        currSol.moveLeftBracketToX();
-                    } // END: if statement testing if ED > 0
-                } // END: if statement testing if ED and EDL have opposite signs
-
-                // Check if current marketed is now bracketed
-                // If so, set bracketed to true
-                if( currSol.isCurrentlyBracketed() ){
-                    currSol.setBracketed();
-                }
-
-            } // END: if statement testing if bracketed
-            // If bracketed, but left and right prices are equal
-            else if ( currSol.getBracketSize() == 0 ){
-                // If XL and XR are equal, market is not bracketed
-                // If ED, EDL and EDR all have same sign, set bracketed to false
-                if ( util::sign( currSol.getED() ) == util::sign( currSol.getEDLeft() ) ) {
-                    currSol.resetBrackets();
-                }
-                // if ED < EDL, then X > XL
-                // if we move XR to X, then market will be bracketed
-                else if ( currSol.getED() < currSol.getEDLeft() ) {
-                    currSol.moveRightBracketToX();
-
-                    // Check if market is currently bracketed
-                    // If so, set bracketed to true
-                    if( currSol.isCurrentlyBracketed() ){
-                        currSol.setBracketed();
-                    }
-                }
-                // if ED > EDL, then X < XL
-                // if we move XL to X, then market will be bracketed
-                else {
-                    currSol.moveLeftBracketToX();
-
-                    // Check if market is currently bracketed
-                    // If so, set bracketed to true
-                    if( currSol.isCurrentlyBracketed() ){
-                        currSol.setBracketed();
-                    }
-                }
-            } // END: if statement testing if currSol is bracketed with XL == XR
-        } // end for loop
+            updateBracket( aSolutionSet.getSolvable( i ), aDefaultBracketInterval );
+        }
 
         aMarketplace->nullSuppliesAndDemands( aPeriod );
 #if GCAM_PARALLEL_ENABLED
@@ -466,6 +498,137 @@ bool SolverLibrary::bracket( Marketplace* aMarketplace, World* aWorld, const dou
     return code;
 }
 
+/*!
+ * \brief Find the brackets for groups of markets which do not share any
+ *        dependent activities concurrently, using partial calcs.
+ * \details The markets which are not yet bracketed are grouped so that the
+ *          activities which need to be recalculated when any price in a group
+ *          changes do not overlap with those of any other group.  The brackets
+ *          of each group are then searched as in bracket(), each group in the
+ *          "scratch" state of the thread running it and recalculating only its
+ *          own dependent activities, while the other markets are held at their
+ *          current prices.
+ *
+ *          When every group is done the final prices are set in the "base" state
+ *          and the model is calculated once so that the markets are up to date.
+ * \param aMarketplace Marketplace reference.
+ * \param aWorld World reference.
+ * \param aDefaultBracketInterval The default bracket interval.
+ * \param aMaxIterations The maximum iterations allowed for each group.
+ * \param aSolutionSet The solution set whose solvable markets to bracket.
+ * \param aPeriod Model period
+ * \return False without doing anything if the markets form fewer than two
+ *         groups, otherwise true.
+ */
+bool SolverLibrary::bracketByGroup( Marketplace* aMarketplace, World* aWorld, const double aDefaultBracketInterval,
+                                    const unsigned int aMaxIterations, SolutionInfoSet& aSolutionSet,
+                                    const int aPeriod )
+{
+    // Merge each market into a new group along with every existing group whose
+    // dependencies overlap it, repeating as the merged dependencies grow.
+    vector<vector<unsigned int> > groupMarkets;
+    vector<bitvector> groupDependencies;
+    for( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+        const SolutionInfo& currSol = aSolutionSet.getSolvable( i );
+        if( currSol.isBracketed() ) {
+            continue;
+        }
+        vector<unsigned int> markets( 1, i );
+        bitvector dependencies( currSol.getDependencies() );
+        for( size_t group = 0; group < groupMarkets.size(); ) {
+            if( !setintersection( groupDependencies[ group ], dependencies ).empty() ) {
+                markets.insert( markets.end(), groupMarkets[ group ].begin(), groupMarkets[ group ].end() );
+                dependencies.setunion( groupDependencies[ group ] );
+                groupMarkets[ group ].swap( groupMarkets.back() );
+                groupMarkets.pop_back();
+                groupDependencies[ group ] = groupDependencies.back();
+                groupDependencies.pop_back();
+                group = 0;
+            }
+            else {
+                ++group;
+            }
+        }
+        groupMarkets.push_back( markets );
+        groupDependencies.push_back( dependencies );
+    }
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::NOTICE );
+    solverLog << "Unbracketed markets form " << groupMarkets.size() << " independent groups." << endl;
+    if( groupMarkets.size() < 2 ) {
+        return false;
+    }
+
+    ManageStateVariables* stateManager = scenario->getManageStateVariables();
+    vector<double> finalPrices( aSolutionSet.getNumSolvable() );
+    auto searchGroup = [&]( const int aGroup ) {
+        const vector<unsigned int>& markets = groupMarkets[ aGroup ];
+        const bitvector& dependencies = groupDependencies[ aGroup ];
+        vector<double> prices( markets.size() );
+        // Start from the "base" state.
+        stateManager->copyState( dependencies );
+        unsigned int iterationCount = 1;
+        bool isAllBracketed;
+        do {
+            isAllBracketed = true;
+            for( size_t i = 0; i < markets.size(); ++i ) {
+                SolutionInfo& currSol = aSolutionSet.getSolvable( markets[ i ] );
+                updateBracket( currSol, aDefaultBracketInterval );
+                isAllBracketed = isAllBracketed && currSol.isBracketed();
+                prices[ i ] = currSol.getPrice();
+            }
+            // Resetting the state resets the prices as well so they must be
+            // set again after.
+            stateManager->copyState( dependencies );
+            for( size_t i = 0; i < markets.size(); ++i ) {
+                aSolutionSet.getSolvable( markets[ i ] ).setPrice( prices[ i ] );
+            }
+            aWorld->calc( aPeriod, dependencies );
+        } while( ++iterationCount <= aMaxIterations && !isAllBracketed );
+
+        for( size_t i = 0; i < markets.size(); ++i ) {
+            finalPrices[ markets[ i ] ] = prices[ i ];
+        }
+    };
+
+    stateManager->setPartialDeriv( true );
+    aMarketplace->mIsDerivativeCalc = true;
+    const int numGroups = static_cast<int>( groupMarkets.size() );
+#if !GCAM_PARALLEL_ENABLED
+    for( int group = 0; group < numGroups; ++group ) {
+        searchGroup( group );
+    }
+#else
+    vector<int> groups( numGroups );
+    vector<int> groupNodes( numGroups );
+    for( int group = 0; group < numGroups; ++group ) {
+        groups[ group ] = group;
+        groupNodes[ group ] = stateManager->getRegionNode(
+            aSolutionSet.getSolvable( groupMarkets[ group ].front() ).getRegionName() );
+    }
+    stateManager->parallelForEachByNode( groups, groupNodes, searchGroup );
+#endif
+    aMarketplace->mIsDerivativeCalc = false;
+    stateManager->setPartialDeriv( false );
+
+    // Bring the "base" state up to date with the final prices of every group.
+    for( size_t group = 0; group < groupMarkets.size(); ++group ) {
+        for( auto market : groupMarkets[ group ] ) {
+            aSolutionSet.getSolvable( market ).setPrice( finalPrices[ market ] );
+        }
+    }
+    aMarketplace->nullSuppliesAndDemands( aPeriod );
+#if GCAM_PARALLEL_ENABLED
+    aWorld->calc( aPeriod, aWorld->getGlobalFlowGraph() );
+#else
+    aWorld->calc( aPeriod );
+#endif
+    solverLog << "Completed bracketing by group." << endl;
+    solverLog << aSolutionSet << endl;
+    return true;
+}
+
 /*
  * \brief Function finds bracket interval for a single market.
  * \author Josh Lurz
@@ -0,0 +1,328 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file solver_telemetry.cpp
+ * \ingroup Objects
+ * \brief SolverTelemetry class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <fstream>
+#include <iomanip>
+
+#include "solution/util/include/solver_telemetry.h"
+#include "util/base/include/configuration.h"
+#include "util/base/include/util.h"
+#include "util/base/include/timer.h"
+
+using namespace std;
+
+//! Constructor
+SolverTelemetry::ComponentRecord::ComponentRecord():
+mNumRuns( 0 ),
+mNumIterations( 0 ),
+mNumFullCalcs( 0 ),
+mNumPartialCalcs( 0 ),
+mPartialCalcFraction( 0 ),
+mJacobianTime( 0 ),
+mLinearSolveTime( 0 ),
+mNumLineSearchEvals( 0 )
+{
+}
+
+//! Constructor
+SolverTelemetry::PeriodRecord::PeriodRecord():
+mNumSolves( 0 ),
+mNumSolved( 0 )
+{
+}
+
+/*!
+ * \brief Get the record for the given component, creating it if necessary.
+ * \param aComponentName The solver component name.
+ * \return The record for the component in this period.
+ */
+SolverTelemetry::ComponentRecord& SolverTelemetry::PeriodRecord::getComponent( const string& aComponentName ) {
+    typedef list<pair<string, ComponentRecord> >::iterator ComponentIterator;
+    for( ComponentIterator it = mComponents.begin(); it != mComponents.end(); ++it ) {
+        if( it->first == aComponentName ) {
+            return it->second;
+        }
+    }
+    mComponents.push_back( make_pair( aComponentName, ComponentRecord() ) );
+    return mComponents.back().second;
+}
+
+//! Constructor
+SolverTelemetry::SolverTelemetry():
+mIsEnabled( Configuration::getInstance()->shouldWriteFile( "solver-telemetry", false, false ) ),
+mCurrPeriod( -1 ),
+mCurrComponent( 0 ),
+mJacobianTimeStart( 0 ),
+mLinearSolveTimeStart( 0 )
+{
+    if( mIsEnabled ) {
+        const Configuration* conf = Configuration::getInstance();
+        mFileName = conf->getFile( "solver-telemetry", "solver-telemetry.json", false );
+        if( conf->shouldAppendScnToFile( "solver-telemetry" ) ) {
+            mFileName = util::appendScenarioToFileName( mFileName );
+        }
+    }
+}
+
+/*!
+ * \brief Get the single instance of the telemetry.
+ * \return The solver telemetry.
+ */
+SolverTelemetry& SolverTelemetry::getInstance() {
+    static SolverTelemetry sInstance;
+    return sInstance;
+}
+
+/*!
+ * \brief Whether telemetry has been enabled by the user.
+ * \details Callers may use this to avoid any overhead in gathering statistics
+ *          when it is not.
+ * \return True if statistics are being collected.
+ */
+bool SolverTelemetry::isEnabled() const {
+    return mIsEnabled;
+}
+
+/*!
+ * \brief Start collecting statistics for a solve of the given period.
+ * \param aPeriod The model period being solved.
+ */
+void SolverTelemetry::startSolve( const int aPeriod ) {
+    if( !mIsEnabled ) {
+        return;
+    }
+    mCurrPeriod = aPeriod;
+    mCurrComponent = 0;
+    ++mPeriods[ aPeriod ].mNumSolves;
+}
+
+/*!
+ * \brief Stop collecting statistics for the current solve.
+ * \details Any model calculations made outside of a solve are not attributed
+ *          to a solver component.
+ * \param aSolved Whether the period solved.
+ */
+void SolverTelemetry::endSolve( const bool aSolved ) {
+    if( !mIsEnabled || mCurrPeriod == -1 ) {
+        return;
+    }
+    finishComponent();
+    if( aSolved ) {
+        ++mPeriods[ mCurrPeriod ].mNumSolved;
+    }
+    mCurrPeriod = -1;
+}
+
+/*!
+ * \brief Attribute all following statistics to the given solver component.
+ * \param aComponentName The name of the solver component which is starting.
+ */
+void SolverTelemetry::startComponent( const string& aComponentName ) {
+    if( !mIsEnabled || mCurrPeriod == -1 ) {
+        return;
+    }
+    finishComponent();
+
+    TimerRegistry& timers = TimerRegistry::getInstance();
+    mJacobianTimeStart = timers.getTimer( TimerRegistry::JACOBIAN ).getTotalTimeDifference();
+    mLinearSolveTimeStart = timers.getTimer( TimerRegistry::LINEAR_SOLVE ).getTotalTimeDifference();
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lock( mMutex );
+#endif
+    mCurrComponent = &mPeriods[ mCurrPeriod ].getComponent( aComponentName );
+    ++mCurrComponent->mNumRuns;
+}
+
+/*!
+ * \brief Add the time spent in the current component to its record and stop
+ *        attributing statistics to it.
+ */
+void SolverTelemetry::finishComponent() {
+    if( !mCurrComponent ) {
+        return;
+    }
+    TimerRegistry& timers = TimerRegistry::getInstance();
+    mCurrComponent->mJacobianTime +=
+        timers.getTimer( TimerRegistry::JACOBIAN ).getTotalTimeDifference() - mJacobianTimeStart;
+    mCurrComponent->mLinearSolveTime +=
+        timers.getTimer( TimerRegistry::LINEAR_SOLVE ).getTotalTimeDifference() - mLinearSolveTimeStart;
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lock( mMutex );
+#endif
+    mCurrComponent = 0;
+}
+
+/*!
+ * \brief Record an iteration of the current component.
+ * \param aWorstMarket The name of the market with the largest relative excess demand.
+ * \param aRelativeED The largest relative excess demand.
+ */
+void SolverTelemetry::addIteration( const string& aWorstMarket, const double aRelativeED ) {
+    if( !mCurrComponent ) {
+        return;
+    }
+    ++mCurrComponent->mNumIterations;
+    TrajectoryPoint point;
+    point.mMarket = aWorstMarket;
+    point.mRelativeED = aRelativeED;
+    mCurrComponent->mTrajectory.push_back( point );
+}
+
+/*!
+ * \brief Record a model calculation made by the current component.
+ * \param aFraction The fraction of the model which was calculated, where one
+ *                  indicates a full calculation.
+ */
+void SolverTelemetry::addCalc( const double aFraction ) {
+#if GCAM_PARALLEL_ENABLED
+    tbb::spin_mutex::scoped_lock lock( mMutex );
+#endif
+    if( !mCurrComponent ) {
+        return;
+    }
+    if( aFraction >= 1.0 ) {
+        ++mCurrComponent->mNumFullCalcs;
+    }
+    else {
+        ++mCurrComponent->mNumPartialCalcs;
+        mCurrComponent->mPartialCalcFraction += aFraction;
+    }
+}
+
+/*!
+ * \brief Record function evaluations made during a line search.
+ * \param aNumEvals The number of function evaluations.
+ */
+void SolverTelemetry::addLineSearchEvals( const int aNumEvals ) {
+    if( !mCurrComponent ) {
+        return;
+    }
+    mCurrComponent->mNumLineSearchEvals += aNumEvals;
+}
+
+/*!
+ * \brief Get the total number of iterations of all solver components in the
+ *        given period.
+ * \param aPeriod The model period.
+ * \return The number of iterations, or -1 if telemetry is not enabled or the
+ *         period has not been solved.
+ */
+int SolverTelemetry::getNumIterations( const int aPeriod ) const {
+    map<int, PeriodRecord>::const_iterator periodIt = mPeriods.find( aPeriod );
+    if( !mIsEnabled || periodIt == mPeriods.end() ) {
+        return -1;
+    }
+    int numIterations = 0;
+    const list<pair<string, ComponentRecord> >& components = periodIt->second.mComponents;
+    for( list<pair<string, ComponentRecord> >::const_iterator it = components.begin(); it != components.end(); ++it ) {
+        numIterations += it->second.mNumIterations;
+    }
+    return numIterations;
+}
+
+/*!
+ * \brief Write a string value to JSON, escaping as necessary.
+ * \param aOut The stream to write to.
+ * \param aValue The value to write.
+ */
+void SolverTelemetry::writeString( ostream& aOut, const string& aValue ) {
+    aOut << '"';
+    for( string::const_iterator it = aValue.begin(); it != aValue.end(); ++it ) {
+        if( *it == '"' || *it == '\\' ) {
+            aOut << '\\';
+        }
+        aOut << *it;
+    }
+    aOut << '"';
+}
+
+/*!
+ * \brief Write all collected statistics to the "solver-telemetry" file as JSON.
+ * \details The file contains a list of periods, each with a list of solver
+ *          components in the order they were first run.
+ */
+void SolverTelemetry::write() const {
+    if( !mIsEnabled ) {
+        return;
+    }
+    ofstream out( mFileName.c_str() );
+    util::checkIsOpen( out, mFileName );
+    out << setprecision( 10 );
+    out << "{\n  \"periods\": [";
+    for( map<int, PeriodRecord>::const_iterator periodIt = mPeriods.begin(); periodIt != mPeriods.end(); ++periodIt ) {
+        out << ( periodIt == mPeriods.begin() ? "\n" : ",\n" );
+        out << "    {\n      \"period\": " << periodIt->first
+            << ",\n      \"solves\": " << periodIt->second.mNumSolves
+            << ",\n      \"solved\": " << periodIt->second.mNumSolved
+            << ",\n      \"components\": [";
+        const list<pair<string, ComponentRecord> >& components = periodIt->second.mComponents;
+        for( list<pair<string, ComponentRecord> >::const_iterator it = components.begin(); it != components.end(); ++it ) {
+            const ComponentRecord& record = it->second;
+            out << ( it == components.begin() ? "\n" : ",\n" );
+            out << "        {\n          \"name\": ";
+            writeString( out, it->first );
+            out << ",\n          \"runs\": " << record.mNumRuns
+                << ",\n          \"iterations\": " << record.mNumIterations
+                << ",\n          \"full-calcs\": " << record.mNumFullCalcs
+                << ",\n          \"partial-calcs\": " << record.mNumPartialCalcs
+                << ",\n          \"partial-calc-fraction\": " << record.mPartialCalcFraction
+                << ",\n          \"jacobian-time\": " << record.mJacobianTime
+                << ",\n          \"linear-solve-time\": " << record.mLinearSolveTime
+                << ",\n          \"line-search-evals\": " << record.mNumLineSearchEvals
+                << ",\n          \"worst-market-trajectory\": [";
+            for( size_t i = 0; i < record.mTrajectory.size(); ++i ) {
+                out << ( i == 0 ? "\n" : ",\n" ) << "            { \"market\": ";
+                writeString( out, record.mTrajectory[ i ].mMarket );
+                out << ", \"relative-ed\": ";
+                // JSON has no representation for NaN or infinity.
+                if( util::isValidNumber( record.mTrajectory[ i ].mRelativeED ) ) {
+                    out << record.mTrajectory[ i ].mRelativeED;
+                }
+                else {
+                    out << "null";
+                }
+                out << " }";
+            }
+            out << ( record.mTrajectory.empty() ? "]" : "\n          ]" ) << "\n        }";
+        }
+        out << ( components.empty() ? "]" : "\n      ]" ) << "\n    }";
+    }
+    out << ( mPeriods.empty() ? "]" : "\n  ]" ) << "\n}\n";
+}
@@ -0,0 +1,427 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file solver_warm_start_store.cpp
+ * \ingroup Objects
+ * \brief SolverWarmStartStore class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <fstream>
+#include <cmath>
+
+#include "solution/util/include/solver_warm_start_store.h"
+#include "solution/util/include/solution_info_set.h"
+#include "solution/util/include/solution_info.h"
+#include "util/base/include/configuration.h"
+#include "util/base/include/util.h"
+#include "util/logger/include/ilogger.h"
+
+using namespace std;
+
+namespace {
+    // Helpers to read and write the store in a simple binary format.
+    void writeString( ostream& aOut, const string& aValue ) {
+        const size_t size = aValue.size();
+        aOut.write( reinterpret_cast<const char*>( &size ), sizeof( size ) );
+        aOut.write( aValue.data(), size );
+    }
+
+    bool readString( istream& aIn, string& aValue ) {
+        size_t size = 0;
+        aIn.read( reinterpret_cast<char*>( &size ), sizeof( size ) );
+        if( !aIn ) {
+            return false;
+        }
+        aValue.resize( size );
+        aIn.read( &aValue[ 0 ], size );
+        return !aIn.fail();
+    }
+
+    template<class T>
+    void writeValue( ostream& aOut, const T aValue ) {
+        aOut.write( reinterpret_cast<const char*>( &aValue ), sizeof( T ) );
+    }
+
+    template<class T>
+    bool readValue( istream& aIn, T& aValue ) {
+        aIn.read( reinterpret_cast<char*>( &aValue ), sizeof( T ) );
+        return !aIn.fail();
+    }
+
+    void writePriceMap( ostream& aOut, const map<string, double>& aPrices ) {
+        writeValue( aOut, aPrices.size() );
+        for( map<string, double>::const_iterator it = aPrices.begin(); it != aPrices.end(); ++it ) {
+            writeString( aOut, it->first );
+            writeValue( aOut, it->second );
+        }
+    }
+
+    bool readPriceMap( istream& aIn, map<string, double>& aPrices ) {
+        size_t size = 0;
+        if( !readValue( aIn, size ) ) {
+            return false;
+        }
+        for( size_t i = 0; i < size; ++i ) {
+            string name;
+            double price;
+            if( !readString( aIn, name ) || !readValue( aIn, price ) ) {
+                return false;
+            }
+            aPrices[ name ] = price;
+        }
+        return true;
+    }
+
+    //! Identifies the file format.
+    const int WARM_START_FILE_VERSION = 1;
+}
+
+SolverWarmStartStore::WarmStartEntry::WarmStartEntry():
+mPeriod( -1 ),
+mLogPrice( true )
+{
+}
+
+/*!
+ * \brief Write this record to the given binary stream.
+ * \param aOut The stream to write to.
+ */
+void SolverWarmStartStore::WarmStartEntry::write( ostream& aOut ) const {
+    writeString( aOut, mScenarioKey );
+    writeValue( aOut, mPeriod );
+    writePriceMap( aOut, mPolicySignature );
+    writePriceMap( aOut, mPrices );
+    writeValue( aOut, mLogPrice );
+    writeValue( aOut, mJacobianMarkets.size() );
+    for( size_t i = 0; i < mJacobianMarkets.size(); ++i ) {
+        writeString( aOut, mJacobianMarkets[ i ] );
+    }
+    if( !mJacobian.empty() ) {
+        aOut.write( reinterpret_cast<const char*>( &mJacobian[ 0 ] ), mJacobian.size() * sizeof( double ) );
+    }
+}
+
+/*!
+ * \brief Read this record from the given binary stream.
+ * \param aIn The stream to read from.
+ * \return Whether the record was read successfully.
+ */
+bool SolverWarmStartStore::WarmStartEntry::read( istream& aIn ) {
+    size_t numMarkets = 0;
+    if( !readString( aIn, mScenarioKey ) || !readValue( aIn, mPeriod )
+        || !readPriceMap( aIn, mPolicySignature ) || !readPriceMap( aIn, mPrices )
+        || !readValue( aIn, mLogPrice ) || !readValue( aIn, numMarkets ) )
+    {
+        return false;
+    }
+    mJacobianMarkets.resize( numMarkets );
+    for( size_t i = 0; i < numMarkets; ++i ) {
+        if( !readString( aIn, mJacobianMarkets[ i ] ) ) {
+            return false;
+        }
+    }
+    mJacobian.resize( numMarkets * numMarkets );
+    if( !mJacobian.empty() ) {
+        aIn.read( reinterpret_cast<char*>( &mJacobian[ 0 ] ), mJacobian.size() * sizeof( double ) );
+    }
+    return !aIn.fail();
+}
+
+/*!
+ * \brief Constructor which will load any previously saved records.
+ */
+SolverWarmStartStore::SolverWarmStartStore():
+mIsEnabled( Configuration::getInstance()->shouldWriteFile( "solver-warm-start-db", false, false ) ),
+mFileName( Configuration::getInstance()->getFile( "solver-warm-start-db", "solver-warm-start.dat", false ) ),
+mMaxEntriesPerPeriod( Configuration::getInstance()->getInt( "solver-warm-start-max-entries", 4, false ) ),
+mSelectedEntry( 0 )
+{
+    if( mIsEnabled ) {
+        load();
+    }
+}
+
+/*!
+ * \brief Get the single instance of the store.
+ * \return The warm start store.
+ */
+SolverWarmStartStore& SolverWarmStartStore::getInstance() {
+    static SolverWarmStartStore sInstance;
+    return sInstance;
+}
+
+/*!
+ * \brief Whether warm starting has been enabled by the user.
+ * \return True if the store is in use.
+ */
+bool SolverWarmStartStore::isEnabled() const {
+    return mIsEnabled;
+}
+
+/*!
+ * \brief Set the scenario components which the current scenario was built from.
+ * \details Records are only reused by scenarios with exactly the same components.
+ * \param aScenComponents The ordered list of scenario component files.
+ */
+void SolverWarmStartStore::setScenarioComponents( const list<string>& aScenComponents ) {
+    mScenarioKey.clear();
+    for( list<string>::const_iterator it = aScenComponents.begin(); it != aScenComponents.end(); ++it ) {
+        mScenarioKey += *it;
+        mScenarioKey += ';';
+    }
+}
+
+/*!
+ * \brief Calculate the distance between two policy signatures.
+ * \details The distance is the sum of squared relative differences in prices.
+ *          Markets which only exist in one of the signatures contribute the
+ *          maximum difference.
+ * \param aLeft A policy signature.
+ * \param aRight Another policy signature.
+ * \return The distance between the two.
+ */
+double SolverWarmStartStore::calcSignatureDistance( const map<string, double>& aLeft,
+                                                    const map<string, double>& aRight )
+{
+    double distance = 0;
+    for( map<string, double>::const_iterator it = aLeft.begin(); it != aLeft.end(); ++it ) {
+        map<string, double>::const_iterator other = aRight.find( it->first );
+        if( other == aRight.end() ) {
+            distance += 1.0;
+        }
+        else {
+            const double relDiff = ( it->second - other->second ) /
+                ( fabs( it->second ) + fabs( other->second ) + util::getTinyNumber() );
+            distance += relDiff * relDiff;
+        }
+    }
+    for( map<string, double>::const_iterator it = aRight.begin(); it != aRight.end(); ++it ) {
+        if( aLeft.find( it->first ) == aLeft.end() ) {
+            distance += 1.0;
+        }
+    }
+    return distance;
+}
+
+/*!
+ * \brief Set the initial prices of the markets to solve from the nearest stored
+ *        solution.
+ * \details This also starts recording a new record for this period and selects
+ *          the record to use for any Jacobian requests during the period.
+ * \param aPeriod The period about to be solved.
+ * \param aSolutionSet The initialized solution set.
+ * \return Whether a stored solution was found and applied.
+ */
+bool SolverWarmStartStore::applyPrices( const int aPeriod, SolutionInfoSet& aSolutionSet ) {
+    mPendingEntry = WarmStartEntry();
+    mPendingEntry.mScenarioKey = mScenarioKey;
+    mPendingEntry.mPeriod = aPeriod;
+    mSelectedEntry = 0;
+
+    vector<SolutionInfo> unsolvable = aSolutionSet.getUnsolvableSet();
+    for( size_t i = 0; i < unsolvable.size(); ++i ) {
+        mPendingEntry.mPolicySignature[ unsolvable[ i ].getName() ] = unsolvable[ i ].getPrice();
+    }
+
+    double minDistance = 0;
+    for( list<WarmStartEntry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it ) {
+        if( it->mPeriod == aPeriod && it->mScenarioKey == mScenarioKey ) {
+            const double distance = calcSignatureDistance( mPendingEntry.mPolicySignature, it->mPolicySignature );
+            if( !mSelectedEntry || distance < minDistance ) {
+                mSelectedEntry = &*it;
+                minDistance = distance;
+            }
+        }
+    }
+
+    if( !mSelectedEntry ) {
+        return false;
+    }
+
+    int numSet = 0;
+    for( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+        SolutionInfo& currInfo = aSolutionSet.getSolvable( i );
+        map<string, double>::const_iterator stored = mSelectedEntry->mPrices.find( currInfo.getName() );
+        if( stored != mSelectedEntry->mPrices.end() ) {
+            currInfo.setPrice( stored->second );
+            ++numSet;
+        }
+    }
+
+    ILogger& solverLog = ILogger::getLogger( "solver_log" );
+    solverLog.setLevel( ILogger::NOTICE );
+    solverLog << "Warm starting " << numSet << " of " << aSolutionSet.getNumSolvable()
+              << " markets from a stored solution with policy distance " << minDistance << endl;
+    return numSet > 0;
+}
+
+/*!
+ * \brief Record the solved prices for the current period.
+ * \details The record, including any Jacobian recorded during the period, is
+ *          added to the store and the oldest record for the same scenario and
+ *          period is dropped if there are too many.
+ * \param aPeriod The period which was solved.
+ * \param aSolutionSet The solved solution set.
+ */
+void SolverWarmStartStore::recordPrices( const int aPeriod, const SolutionInfoSet& aSolutionSet ) {
+    if( mPendingEntry.mPeriod != aPeriod ) {
+        return;
+    }
+    for( unsigned int i = 0; i < aSolutionSet.getNumSolvable(); ++i ) {
+        const SolutionInfo& currInfo = aSolutionSet.getSolvable( i );
+        mPendingEntry.mPrices[ currInfo.getName() ] = currInfo.getPrice();
+    }
+    mEntries.push_back( mPendingEntry );
+    mPendingEntry = WarmStartEntry();
+    mSelectedEntry = 0;
+
+    // Drop the oldest records for this scenario and period beyond the limit.
+    int numEntries = 0;
+    for( list<WarmStartEntry>::reverse_iterator it = mEntries.rbegin(); it != mEntries.rend(); ) {
+        if( it->mPeriod == aPeriod && it->mScenarioKey == mScenarioKey && ++numEntries > mMaxEntriesPerPeriod ) {
+            it = list<WarmStartEntry>::reverse_iterator( mEntries.erase( --it.base() ) );
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+/*!
+ * \brief Get the stored Jacobian for the given markets from the selected record.
+ * \param aPeriod The current period.
+ * \param aMarketNames The names of the markets for both rows and columns.
+ * \param aLogPrice Whether the Jacobian is requested in terms of log prices.
+ * \param aJacobian The unscaled Jacobian in row major order to fill in.
+ * \return True if a Jacobian covering all of the markets was available.
+ */
+bool SolverWarmStartStore::getJacobian( const int aPeriod, const vector<string>& aMarketNames,
+                                        const bool aLogPrice, vector<double>& aJacobian ) const
+{
+    if( !mSelectedEntry || mSelectedEntry->mPeriod != aPeriod || mSelectedEntry->mLogPrice != aLogPrice
+        || mSelectedEntry->mJacobianMarkets.empty() )
+    {
+        return false;
+    }
+
+    // Map each requested market to its position in the stored Jacobian.
+    const vector<string>& storedMarkets = mSelectedEntry->mJacobianMarkets;
+    map<string, size_t> storedIndex;
+    for( size_t i = 0; i < storedMarkets.size(); ++i ) {
+        storedIndex[ storedMarkets[ i ] ] = i;
+    }
+    vector<size_t> remap( aMarketNames.size() );
+    for( size_t i = 0; i < aMarketNames.size(); ++i ) {
+        map<string, size_t>::const_iterator found = storedIndex.find( aMarketNames[ i ] );
+        if( found == storedIndex.end() ) {
+            return false;
+        }
+        remap[ i ] = found->second;
+    }
+
+    const size_t storedSize = storedMarkets.size();
+    const size_t size = aMarketNames.size();
+    aJacobian.resize( size * size );
+    for( size_t i = 0; i < size; ++i ) {
+        for( size_t j = 0; j < size; ++j ) {
+            aJacobian[ i * size + j ] = mSelectedEntry->mJacobian[ remap[ i ] * storedSize + remap[ j ] ];
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Record the Jacobian for the period currently being solved.
+ * \details Only the last Jacobian recorded in a period will be kept.
+ * \param aPeriod The current period.
+ * \param aMarketNames The names of the markets for both rows and columns.
+ * \param aLogPrice Whether the Jacobian is in terms of log prices.
+ * \param aJacobian The unscaled Jacobian in row major order.
+ */
+void SolverWarmStartStore::recordJacobian( const int aPeriod, const vector<string>& aMarketNames,
+                                           const bool aLogPrice, const vector<double>& aJacobian )
+{
+    if( mPendingEntry.mPeriod != aPeriod ) {
+        return;
+    }
+    mPendingEntry.mLogPrice = aLogPrice;
+    mPendingEntry.mJacobianMarkets = aMarketNames;
+    mPendingEntry.mJacobian = aJacobian;
+}
+
+/*!
+ * \brief Read previously saved records from the warm start file if it exists.
+ */
+void SolverWarmStartStore::load() {
+    ifstream in( mFileName.c_str(), ios::in | ios::binary );
+    if( !in.is_open() ) {
+        return;
+    }
+
+    int version = 0;
+    size_t numEntries = 0;
+    if( !readValue( in, version ) || version != WARM_START_FILE_VERSION || !readValue( in, numEntries ) ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::WARNING );
+        mainLog << "Ignoring unrecognized solver warm start file " << mFileName << endl;
+        return;
+    }
+    for( size_t i = 0; i < numEntries; ++i ) {
+        WarmStartEntry entry;
+        if( !entry.read( in ) ) {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::WARNING );
+            mainLog << "Solver warm start file " << mFileName << " is truncated." << endl;
+            break;
+        }
+        mEntries.push_back( entry );
+    }
+}
+
+/*!
+ * \brief Write all of the records to the warm start file.
+ */
+void SolverWarmStartStore::save() const {
+    if( !mIsEnabled ) {
+        return;
+    }
+    ofstream out( mFileName.c_str(), ios::out | ios::binary | ios::trunc );
+    util::checkIsOpen( out, mFileName );
+    writeValue( out, WARM_START_FILE_VERSION );
+    writeValue( out, mEntries.size() );
+    for( list<WarmStartEntry>::const_iterator it = mEntries.begin(); it != mEntries.end(); ++it ) {
+        it->write( out );
+    }
+}
@@ -203,6 +203,10 @@ private:
     //! solve.
     double mMaxTax;
 
+    //! The taxes of the last trial run by runTrialTaxes, used to find the first
+    //! period a new trial changes.  Empty if the next trial must run all periods.
+    std::vector<double> mLastRunTaxes;
+
     void
         calculateHotellingPath( const double aIntialTax,
                                 const double aHotellingRate,
@@ -212,6 +216,8 @@ private:
                                 std::vector<double>& aTaxes );
 
     void setTrialTaxes( const std::vector<double> aTaxes );
+
+    bool runTrialTaxes( const std::vector<double>& aTaxes, Timer& aTimer );
     
     bool solveInitialTarget( std::vector<double>& aTaxes,
                              const ITarget* aPolicyTarget,
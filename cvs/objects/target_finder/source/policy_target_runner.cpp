@@ -415,6 +415,7 @@ bool PolicyTargetRunner::solveInitialTarget( vector<double>& aTaxes,
     logRunID();
     bool success = mSingleScenario->runScenarios( Scenario::RUN_ALL_PERIODS,
                                                   false, aTimer );
+    mLastRunTaxes = aTaxes;
     
     // If we are already below the target at a zero tax then we won't be able to
     // get to the target.
@@ -450,12 +451,19 @@ bool PolicyTargetRunner::solveInitialTarget( vector<double>& aTaxes,
                        mInitialTargetYear ) );
     
 
+    // Iterations are run against the climate emulator when one is available.
+    bool isEmulating = false;
     while( solver->getIterations() < aLimitIterations ) {
         pair<double, bool> trial = solver->getNextValue();
 
-        // Check for solution.
+        // Check for solution.  A solution found with the climate emulator is
+        // only a candidate, rerun the full climate model and check it again.
         if( trial.second ){
-            break;
+            if( !isEmulating ) {
+                break;
+            }
+            isEmulating = getInternalScenario()->setClimateEmulation( false );
+            continue;
         }
         
         if( !util::isValidNumber( trial.first ) ) {
@@ -476,15 +484,16 @@ bool PolicyTargetRunner::solveInitialTarget( vector<double>& aTaxes,
                                          finalModelYear,
                                          aTaxes );
 
-        setTrialTaxes( aTaxes );
-
         // Run the scenario at the trial tax.
         // TODO: If the run failed to solve then the target status may be unreliable.
+        isEmulating = getInternalScenario()->setClimateEmulation( true );
         logRunID();
-        success = mSingleScenario->runScenarios( Scenario::RUN_ALL_PERIODS, false, aTimer );
+        success = runTrialTaxes( aTaxes, aTimer );
 
         targetLog << "Scenario run complete.  Return status = " << success << endl;
     }
+    getInternalScenario()->setClimateEmulation( false );
+    mLastRunTaxes.clear();
 
     if( solver->getIterations() >= aLimitIterations ){
         targetLog.setLevel( ILogger::ERROR );
@@ -575,12 +584,19 @@ bool PolicyTargetRunner::solveFutureTarget( vector<double>& aTaxes,
                             // for the second initial guess.
                        currYear ) );
 
+    // Iterations are run against the climate emulator when one is available.
+    bool isEmulating = false;
     while( solver->getIterations() < aLimitIterations ){
         pair<double, bool> trial = solver->getNextValue();
         
-        // Check for solution.
+        // Check for solution.  A solution found with the climate emulator is
+        // only a candidate, rerun the full climate model and check it again.
         if( trial.second ){
-            break;
+            if( !isEmulating ) {
+                break;
+            }
+            isEmulating = getInternalScenario()->setClimateEmulation( false );
+            continue;
         }
 
         // Replace the current periods tax with the calculated tax.
@@ -592,9 +608,11 @@ bool PolicyTargetRunner::solveFutureTarget( vector<double>& aTaxes,
 
         // Run the base scenario.
         // TODO: If the run failed to solve then the target status may be unreliable.
+        isEmulating = getInternalScenario()->setClimateEmulation( true );
         logRunID();
         success = mSingleScenario->runScenarios( aPeriod, false, aTimer );
     }
+    getInternalScenario()->setClimateEmulation( false );
 
     if( solver->getIterations() >= aLimitIterations ){
         targetLog.setLevel( ILogger::ERROR );
@@ -691,12 +709,19 @@ bool PolicyTargetRunner::skipFuturePeriod( vector<double>& aTaxes,
                                      // for the second initial guess.
                                 currYear ) );
     
+    // Iterations are run against the climate emulator when one is available.
+    bool isEmulating = false;
     while( solver->getIterations() < aLimitIterations ){
         pair<double, bool> trial = solver->getNextValue();
         
-        // Check for solution.
+        // Check for solution.  A solution found with the climate emulator is
+        // only a candidate, rerun the full climate model and check it again.
         if( trial.second ){
-            break;
+            if( !isEmulating ) {
+                break;
+            }
+            isEmulating = getInternalScenario()->setClimateEmulation( false );
+            continue;
         }
         
         if( !util::isValidNumber( trial.first ) ) {
@@ -721,9 +746,11 @@ bool PolicyTargetRunner::skipFuturePeriod( vector<double>& aTaxes,
         
         // Run the base scenario.
         // TODO: If the run failed to solve then the target status may be unreliable.
+        isEmulating = getInternalScenario()->setClimateEmulation( true );
         logRunID();
         success = mSingleScenario->runScenarios( lastPeriodToCalc, false, aTimer );
     }
+    getInternalScenario()->setClimateEmulation( false );
     
     if( solver->getIterations() >= aLimitIterations ){
         targetLog.setLevel( ILogger::ERROR );
@@ -841,6 +868,52 @@ void PolicyTargetRunner::setTrialTaxes( const vector<double> aTaxes ) {
     mSingleScenario->getInternalScenario()->setTax( &tax );
 }
 
+/*!
+ * \brief Set a vector of trial taxes into the model and run it, recalculating
+ *        only the periods from the first one whose tax changed since the last
+ *        trial.
+ * \details A model period only depends on the periods before it, whose results
+ *          are kept in memory, so the periods before the first changed tax are
+ *          still valid and each calculated period starts from the stored end
+ *          of the preceding one.  The final period is always recalculated so
+ *          that the run is complete.  All periods are run if there was no
+ *          previous trial.  The periods which were not recalculated keep their
+ *          solved status from the earlier trial in Scenario::getUnsolvedPeriods.
+ * \param aTaxes Vector of taxes to set into the model. Must contain one value
+ *        for each model period.
+ * \param aTimer The timer used to print out the amount of time spent performing
+ *        operations.
+ * \return Whether all model periods solved successfully, including those
+ *         which were not recalculated.
+ */
+bool PolicyTargetRunner::runTrialTaxes( const vector<double>& aTaxes, Timer& aTimer ) {
+    setTrialTaxes( aTaxes );
+
+    if( mLastRunTaxes.size() != aTaxes.size() ) {
+        mLastRunTaxes = aTaxes;
+        return mSingleScenario->runScenarios( Scenario::RUN_ALL_PERIODS, false, aTimer );
+    }
+
+    const int finalPeriod = getInternalScenario()->getModeltime()->getmaxper() - 1;
+    int firstChangedPeriod = 0;
+    while( firstChangedPeriod < finalPeriod &&
+           aTaxes[ firstChangedPeriod ] == mLastRunTaxes[ firstChangedPeriod ] )
+    {
+        ++firstChangedPeriod;
+    }
+    for( int period = firstChangedPeriod; period < finalPeriod; ++period ) {
+        getInternalScenario()->invalidatePeriod( period );
+    }
+    mLastRunTaxes = aTaxes;
+
+    ILogger& targetLog = ILogger::getLogger( "target_finder_log" );
+    targetLog.setLevel( ILogger::DEBUG );
+    targetLog << "Trial taxes first changed in period " << firstChangedPeriod
+              << ", recalculating from there." << endl;
+    const bool success = mSingleScenario->runScenarios( finalPeriod, false, aTimer );
+    return success && getInternalScenario()->getUnsolvedPeriods().empty();
+}
+
 /*!
  * \brief Write a unique identifier into each of several log files
  */
@@ -52,6 +52,7 @@
 
 #include <xercesc/dom/DOMNode.hpp>
 #include "technologies/include/technology.h"
+#include "containers/include/info_key.h"
 
 // Forward declaration
 class Tabs;
@@ -90,6 +91,9 @@ public:
     virtual double calcShare( const IDiscreteChoice* aChoiceFn,
                               const GDP* aGDP,
                               int aPeriod ) const; 
+
+    virtual bool getStandardShareValues( const int aPeriod, const Value*& aShareWeight,
+                                         const Value*& aCost, bool& aHasFuelPrefElasticity ) const;
     
     virtual void production( const std::string& aRegionName,
                              const std::string& aSectorName, 
@@ -137,6 +141,13 @@ protected:
     //! Weak pointer to the land leaf which corresponds to this technology
     //! used to save time finding it over and over
     ALandAllocatorItem* mProductLeaf;
+
+    //! Market info key for the previous period's non-land variable cost which
+    //! is interned in completeInit to avoid building it each period.
+    InfoKey mPreVarCostKey;
+
+    //! Market info key for the previous period's yield.
+    InfoKey mPreYieldKey;
     
     void copy( const AgProductionTechnology& aOther );
 
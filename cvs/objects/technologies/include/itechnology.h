@@ -158,6 +158,9 @@ public:
     virtual double calcShare( const IDiscreteChoice* aChoiceFn,
                               const GDP* aGDP,
                               int aPeriod ) const = 0;
+
+    virtual bool getStandardShareValues( const int aPeriod, const Value*& aShareWeight,
+                                         const Value*& aCost, bool& aHasFuelPrefElasticity ) const = 0;
     
     virtual void calcCost( const std::string& aRegionName,
                            const std::string& aSectorName,
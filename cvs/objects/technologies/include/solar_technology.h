@@ -52,6 +52,7 @@
 // include files ***********************************************************
 
 #include "technologies/include/intermittent_technology.h"
+#include "containers/include/info_key.h"
 
 // namespaces **************************************************************
 
@@ -241,6 +242,9 @@ protected :
        DEFINE_VARIABLE( SIMPLE, "no-sun-days", mNoSunDays, double )
     )
     
+    //! Interned mTotalAnnualIrradianceKey, set in initCalc.
+    InfoKey mTotalAnnualIrradianceInfoKey;
+
     void copy( const SolarTechnology& aOther );
 
    virtual const std::string& getTechCostName( ) const;
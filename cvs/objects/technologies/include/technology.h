@@ -199,6 +199,9 @@ public:
     virtual double calcShare( const IDiscreteChoice* aChoiceFn,
                               const GDP* aGDP,
                               int aPeriod ) const;
+
+    virtual bool getStandardShareValues( const int aPeriod, const Value*& aShareWeight,
+                                         const Value*& aCost, bool& aHasFuelPrefElasticity ) const;
     
     virtual void calcCost( const std::string& aRegionName,
                            const std::string& aSectorName,
@@ -202,13 +202,7 @@ void AgProductionTechnology::initCalc( const string& aRegionName,
     // previous period technologies, need to save a previous period compounded cumulative
     // change in the MarketInfo
  
-    // Create a unique regional string for the yield and for the
-    // variable cost. 
-
-    const string preVarCostName = "preVarCost-" + mName + "-" + aRegionName;
     double preVarCost = 0.0;
-
-    const string preYieldName = "preYield-" + mName + "-" + aRegionName;
     double preYield = 0.0;
 
 
@@ -221,7 +215,7 @@ void AgProductionTechnology::initCalc( const string& aRegionName,
     // Note: you can never overwrite a positive yield with a zero yield. If the model sees a
     // zero non-land cost, it will copy from the previous period.
     if ( mNonLandVariableCost == 0 && aPeriod != 0 ) {
-         preVarCost = marketInfo->getDouble( preVarCostName, true );
+         preVarCost = marketInfo->getDouble( mPreVarCostKey, true );
          // Adjust last period's variable cost by tech change
          int timestep = modeltime->gettimestep( aPeriod );
          mNonLandVariableCost = preVarCost / pow(1 + mNonLandCostTechChange , timestep);
@@ -233,7 +227,7 @@ void AgProductionTechnology::initCalc( const string& aRegionName,
         // Note: you can never overwrite a positive yield with a zero yield. If the model sees a
         // zero yield, it will copy from the previous period.
         if ( mYield == 0 && aPeriod != 0 ) {
-            preYield = marketInfo->getDouble( preYieldName, true );
+            preYield = marketInfo->getDouble( mPreYieldKey, true );
             // Adjust last period's variable cost by tech change
             int timestep = modeltime->gettimestep( aPeriod );
             mYield = preYield * pow(1 + mAgProdChange , timestep);
@@ -245,8 +239,8 @@ void AgProductionTechnology::initCalc( const string& aRegionName,
     if( aPeriod + 1 < modeltime->getmaxper() ){
         IInfo* nextPerMarketInfo = marketplace->getMarketInfo( aSectorName, aRegionName, aPeriod + 1, true );
         assert( nextPerMarketInfo );
-        nextPerMarketInfo->setDouble( preVarCostName, mNonLandVariableCost );
-        nextPerMarketInfo->setDouble( preYieldName, mYield );
+        nextPerMarketInfo->setDouble( mPreVarCostKey, mNonLandVariableCost );
+        nextPerMarketInfo->setDouble( mPreYieldKey, mYield );
     }
 
     // If yield is GCal/kHa and prices are $/GCal, then rental rate is $/kHa
@@ -270,6 +264,11 @@ void AgProductionTechnology::completeInit( const std::string& aRegionName,
     // Store away the land allocator.
     mLandAllocator = aLandAllocator;
     mProductLeaf = aLandAllocator->findProductLeaf( mName );
+
+    // Create a unique regional key for the yield and for the variable cost
+    // which are passed between periods through the market info.
+    mPreVarCostKey = InfoKey( "preVarCost-" + mName + "-" + aRegionName );
+    mPreYieldKey = InfoKey( "preYield-" + mName + "-" + aRegionName );
  
     // Send "pointer to the land allocator" to each of the secondary outputs, e.g, residue biomass
     if ( mOutputs.size() ) {
@@ -372,6 +371,20 @@ double AgProductionTechnology::calcShare( const IDiscreteChoice* aChoiceFn,
 }
 
 
+/*!
+ * \brief Ag technologies do not use the discrete choice share.
+ * \param aPeriod Model period.
+ * \param aShareWeight Not set.
+ * \param aCost Not set.
+ * \param aHasFuelPrefElasticity Not set.
+ * \return False.
+ */
+bool AgProductionTechnology::getStandardShareValues( const int aPeriod, const Value*& aShareWeight,
+                                                     const Value*& aCost, bool& aHasFuelPrefElasticity ) const
+{
+    return false;
+}
+
 /* agTechnologies are not shared on cost, so this calCost method is overwritten
    by a calculation of technology profit which is passed to the land allocator
    where it is used for sharing land.  */
@@ -120,6 +120,12 @@ double EmptyTechnology::calcShare( const IDiscreteChoice* aChoiceFn,
     return -numeric_limits<double>::infinity();
 }
 
+bool EmptyTechnology::getStandardShareValues( const int aPeriod, const Value*& aShareWeight,
+                                              const Value*& aCost, bool& aHasFuelPrefElasticity ) const
+{
+    return false;
+}
+
 double EmptyTechnology::getFixedOutput( const string& aRegionName,
                                   const string& aSectorName,
                                   const bool aHasRequiredInput,
@@ -142,7 +142,7 @@ void SolarTechnology::calcCost(
    Marketplace*       pMarketplace = scenario->getMarketplace();
    const IInfo*       pInfo        = pMarketplace->getMarketInfo( ( *mResourceInput )->getName(), aRegionName, aPeriod, true );
 
-   double totalAnnualIrradiance = pInfo->hasValue( mTotalAnnualIrradianceKey ) ? pInfo->getDouble( mTotalAnnualIrradianceKey, true ) : DEFAULT_TOTAL_ANNUAL_IRRADIANCE;
+   double totalAnnualIrradiance = pInfo->hasValue( mTotalAnnualIrradianceInfoKey ) ? pInfo->getDouble( mTotalAnnualIrradianceInfoKey, true ) : DEFAULT_TOTAL_ANNUAL_IRRADIANCE;
    double dConnect              = pMarketplace->getPrice( ( *mResourceInput )->getName(), aRegionName, aPeriod );
    double CSPEfficiency         = getSolarEfficiency( aPeriod );
 
@@ -214,7 +214,7 @@ double SolarTechnology::calcResourceArea(
    Marketplace*       pMarketplace = scenario->getMarketplace();
    const IInfo*       pInfo        = pMarketplace->getMarketInfo( ( *mResourceInput )->getName(), aRegionName, aPeriod, true );
 
-   double totalAnnualIrradiance = pInfo->hasValue( mTotalAnnualIrradianceKey ) ? pInfo->getDouble( mTotalAnnualIrradianceKey, true ) : DEFAULT_TOTAL_ANNUAL_IRRADIANCE;
+   double totalAnnualIrradiance = pInfo->hasValue( mTotalAnnualIrradianceInfoKey ) ? pInfo->getDouble( mTotalAnnualIrradianceInfoKey, true ) : DEFAULT_TOTAL_ANNUAL_IRRADIANCE;
    double CSPGeneration         = aVariableDemand;
    double CSPEfficiency         = getSolarEfficiency( aPeriod );
 
@@ -363,6 +363,9 @@ void SolarTechnology::initCalc(
    // Need resource location so call this here.
    initializeInputLocations( aRegionName, aSectorName, aPeriod );
 
+   // Intern the irradiance key so it is not hashed each calc.
+   mTotalAnnualIrradianceInfoKey = InfoKey( mTotalAnnualIrradianceKey );
+
    // Get marketplace and make sure we have the total annual irradiance
    Marketplace*       pMarketplace = scenario->getMarketplace();
    const IInfo*       pInfo        = pMarketplace->getMarketInfo( ( *mResourceInput )->getName(), aRegionName, aPeriod, true );
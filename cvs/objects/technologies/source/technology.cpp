@@ -875,6 +875,51 @@ double Technology::calcShare( const IDiscreteChoice* aChoiceFn,
     return logshare;
 }
 
+/*!
+ * \brief Return whether the share of this technology is the standard discrete
+ *        choice share and if so the values it is calculated from.
+ * \details When this is true calcShare is exactly the unnormalized share of
+ *          the share weight and cost from the discrete choice function plus
+ *          the fuel preference elasticity adjustment.  This allows the
+ *          subsector to gather the values of all such technologies and
+ *          evaluate their shares together.  The answer only depends on the
+ *          production state, fixed output and inputs and so does not change
+ *          after initCalc.  Subclasses which override calcShare must also
+ *          override this method.
+ * \param aPeriod Model period.
+ * \param aShareWeight The share weight used by calcShare, set only if the
+ *        share is standard.
+ * \param aCost The cost used by calcShare in aPeriod, set only if the share
+ *        is standard.
+ * \param aHasFuelPrefElasticity Whether the fuel preference elasticity may be
+ *        non-zero.  It is always zero if no energy input has an income
+ *        elasticity.  Set only if the share is standard.
+ * \return Whether the technology has a standard share in the period.
+ * \sa Technology::calcShare()
+ */
+bool Technology::getStandardShareValues( const int aPeriod, const Value*& aShareWeight,
+                                         const Value*& aCost, bool& aHasFuelPrefElasticity ) const
+{
+    // These are the same conditions under which calcShare will return minus
+    // infinity.
+    if( !mProductionState[ aPeriod ] || !mProductionState[ aPeriod ]->isOperating() ||
+        !mProductionState[ aPeriod ]->isNewInvestment() ||
+        mFixedOutput != IProductionState::fixedOutputDefault() )
+    {
+        return false;
+    }
+
+    aShareWeight = &mShareWeight;
+    aCost = &mCosts[ aPeriod ];
+    aHasFuelPrefElasticity = false;
+    for( CInputIterator i = mInputs.begin(); i != mInputs.end(); ++i ){
+        if( (*i)->hasTypeFlag( IInput::ENERGY ) && (*i)->getIncomeElasticity( aPeriod ) != 0 ){
+            aHasFuelPrefElasticity = true;
+        }
+    }
+    return true;
+}
+
 /*! \brief Return true if technology is fixed for no output or input
 * 
 * returns true if this technology is set to never produce output or input
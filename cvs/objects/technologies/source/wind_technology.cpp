@@ -54,6 +54,7 @@
 #include "technologies/include/iproduction_state.h"
 #include "marketplace/include/marketplace.h"
 #include "containers/include/iinfo.h"
+#include "containers/include/info_key.h"
 #include "util/base/include/TValidatorInfo.h"
 #include "util/base/include/util.h"
 #include "util/base/include/xml_helper.h"
@@ -234,14 +235,18 @@ double WindTechnology::calcRealizedTurbineOutput( const IInfo* apInfo ) const
 {
    // Equation 5:
    // aveWindSpeedAtHub = aveWindSpeed * ( turbineHubHeight / referenceHeight ) ^ windVelocityExponent
-   double aveWindSpeed = apInfo->getDouble( sXMLTagNames[ AVERAGE_WIND_SPEED_KEY ], true );
-   double referenceHeight = apInfo->getDouble( sXMLTagNames[ REFERENCE_HEIGHT_KEY ], true );
-   double windVelocityExponent = apInfo->getDouble( sXMLTagNames[ WIND_VELOCITY_EXPONENT_KEY ], true );
+   static const InfoKey aveWindSpeedKey( sXMLTagNames[ AVERAGE_WIND_SPEED_KEY ] );
+   static const InfoKey referenceHeightKey( sXMLTagNames[ REFERENCE_HEIGHT_KEY ] );
+   static const InfoKey windVelocityExponentKey( sXMLTagNames[ WIND_VELOCITY_EXPONENT_KEY ] );
+   static const InfoKey airDensityKey( sXMLTagNames[ AIR_DENSITY_KEY ] );
+   double aveWindSpeed = apInfo->getDouble( aveWindSpeedKey, true );
+   double referenceHeight = apInfo->getDouble( referenceHeightKey, true );
+   double windVelocityExponent = apInfo->getDouble( windVelocityExponentKey, true );
    double aveWindSpeedAtHub = aveWindSpeed * std::pow( mTurbineHubHeight / referenceHeight, windVelocityExponent );
 
    // Equation 4:
    // RealizedTurbineOutput = ( IdealTurbineOutput / 10^6 ) * TurbineCoefficient * ( 1 - Derating ) * ( 1 - WindFarmLoss )
-   double airDensity = apInfo->getDouble( sXMLTagNames[ AIR_DENSITY_KEY ], true );
+   double airDensity = apInfo->getDouble( airDensityKey, true );
    double realizedTurbineOutput = ( calcIdealTurbineOutput( aveWindSpeedAtHub, mRotorDiameter, airDensity ) / 1.0e6 ) * calcTurbineCoefficient( aveWindSpeedAtHub, mTurbineRating, mRotorDiameter, airDensity, mCutOutSpeed ) * ( 1.0 - mTurbineDerating ) * ( 1.0 - mWindFarmLoss );
    mWindPowerVariance = computeWindPowerVariance( aveWindSpeedAtHub, mTurbineRating, mRotorDiameter, airDensity, mCutOutSpeed );
    return realizedTurbineOutput;
@@ -0,0 +1,297 @@
+#ifndef _ACTIVITY_PROFILER_H_
+#define _ACTIVITY_PROFILER_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file activity_profiler.h
+ * \ingroup Objects
+ * \brief ActivityProfiler class header file.
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <boost/core/noncopyable.hpp>
+#include <boost/unordered_map.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <atomic>
+#include <tbb/enumerable_thread_specific.h>
+#endif
+
+class IActivity;
+struct GrainSchedule;
+
+/*!
+ * \ingroup Objects
+ * \brief Records how long each activity and parallel grain takes during
+ *        World::calc and which thread ran it.
+ * \details When enabled, by setting the "activity-profile" file to write,
+ *          World::calc and the flow graph grains report the start and end of
+ *          every activity calculation into per-thread buffers.  Times are
+ *          aggregated by IActivity::getDescription() for the whole run while
+ *          the individual events of the first "activity-profile-trace-calcs"
+ *          calls to World::calc are kept as a trace.
+ *
+ *          For each traced flow graph calculation the critical path through
+ *          the grain schedule is found using the measured grain times, along
+ *          with the parallel efficiency (total grain time over elapsed time
+ *          times the number of threads) and the speedup bound (total grain
+ *          time over the critical path).
+ *
+ *          The trace is written in the Chrome trace event format, which can be
+ *          viewed in chrome://tracing or Perfetto, with the aggregates and
+ *          critical path analysis added as extra top level members.
+ *
+ *          Recording is not synchronized with flush() or write() which must
+ *          only be called when no model calculations are in progress.
+ */
+class ActivityProfiler : private boost::noncopyable {
+public:
+    static ActivityProfiler& getInstance();
+
+    bool isEnabled() const;
+
+    void setGrainSchedule( const GrainSchedule* aSchedule,
+                           const std::vector<IActivity*>* aOrdering );
+
+    void startCalc( const int aPeriod, const bool aIsFlowGraph );
+
+    void endCalc();
+
+    void calcActivity( IActivity* aActivity, const int aPeriod );
+
+    void startGrain();
+
+    void endGrain( const int aGrainIndex );
+
+    void flush();
+
+    void write() const;
+
+private:
+    ActivityProfiler();
+
+    //! Types of events which are recorded.
+    enum EventType {
+        CALC,
+        GRAIN,
+        ACTIVITY
+    };
+
+    //! A single recorded event.
+    struct Event {
+        //! The type of event.
+        EventType mType;
+
+        //! The World::calc call this event is part of.
+        int mCalc;
+
+        //! The period for a calc, grain index for a grain, or unused.
+        int mIndex;
+
+        //! Whether a calc used the flow graph.
+        bool mIsFlowGraph;
+
+        //! The activity which was calculated if this is an activity event.
+        const IActivity* mActivity;
+
+        //! Start time in microseconds since the profiler was created.
+        double mStart;
+
+        //! Duration in microseconds.
+        double mDuration;
+    };
+
+    //! Aggregate times of an activity.
+    struct ActivityStats {
+        ActivityStats();
+
+        //! Number of times it was calculated.
+        int mCount;
+
+        //! Total time in microseconds.
+        double mTotalTime;
+
+        //! Longest single calculation in microseconds.
+        double mMaxTime;
+
+        void add( const double aDuration );
+
+        void merge( const ActivityStats& aOther );
+    };
+
+    //! Recording state for a single thread.
+    struct ThreadState {
+        ThreadState();
+
+        //! The index of the thread in the trace.
+        int mThread;
+
+        //! The World::calc call being made by this thread or -1 if none.
+        int mCurrCalc;
+
+        //! The index of the current calc event in mEvents.
+        size_t mCalcEvent;
+
+        //! The start time of the grain being calculated.
+        double mGrainStart;
+
+        //! Events which have not been flushed.
+        std::vector<Event> mEvents;
+
+        //! Aggregate times by activity which have not been flushed.
+        boost::unordered_map<const IActivity*, ActivityStats> mActivityStats;
+    };
+
+    //! A flushed trace event.
+    struct TraceEvent {
+        //! The event name.
+        std::string mName;
+
+        //! The event category.
+        std::string mCategory;
+
+        //! The thread which ran it.
+        int mThread;
+
+        //! The World::calc call this event is part of.
+        int mCalc;
+
+        //! Start time in microseconds.
+        double mStart;
+
+        //! Duration in microseconds.
+        double mDuration;
+    };
+
+    //! A grain on the critical path.
+    struct CriticalGrain {
+        //! The grain index in the schedule.
+        int mGrain;
+
+        //! The measured time in seconds.
+        double mTime;
+
+        //! The number of activities in the grain.
+        int mNumActivities;
+
+        //! The description of the first activity in the grain.
+        std::string mFirstActivity;
+    };
+
+    //! Analysis of a single flow graph calculation.
+    struct GraphCalcAnalysis {
+        //! The World::calc call.
+        int mCalc;
+
+        //! The model period.
+        int mPeriod;
+
+        //! Elapsed time in seconds.
+        double mElapsed;
+
+        //! Total time spent in grains in seconds.
+        double mWork;
+
+        //! Length of the critical path in seconds.
+        double mCriticalPath;
+
+        //! Grains on the critical path in order.
+        std::vector<CriticalGrain> mCriticalGrains;
+    };
+
+    ThreadState& getThreadState();
+
+    double now() const;
+
+    void analyzeGraphCalc( const Event& aCalc, const std::vector<Event>& aGrains );
+
+    //! Whether profiling is enabled.
+    const bool mIsEnabled;
+
+    //! The file to write the results to.
+    std::string mFileName;
+
+    //! The number of World::calc calls to keep trace events for.
+    int mMaxTraceCalcs;
+
+    //! The time all events are measured from.
+    const std::chrono::steady_clock::time_point mEpoch;
+
+    //! The grain schedule of the flow graphs, if any.
+    const GrainSchedule* mGrainSchedule;
+
+    //! The global ordering the grain schedule refers to.
+    const std::vector<IActivity*>* mOrdering;
+
+#if GCAM_PARALLEL_ENABLED
+    //! The number of World::calc calls started.
+    std::atomic<int> mNumCalcs;
+
+    //! The flow graph calculation in progress or -1 if none.
+    std::atomic<int> mGraphCalc;
+
+    //! Recording state of each thread.
+    tbb::enumerable_thread_specific<ThreadState> mThreadStates;
+#else
+    //! The number of World::calc calls started.
+    int mNumCalcs;
+
+    //! The flow graph calculation in progress or -1 if none.
+    int mGraphCalc;
+
+    //! Recording state of the only thread.
+    ThreadState mThreadState;
+#endif
+
+    //! Flushed aggregate times by activity description.
+    std::map<std::string, ActivityStats> mStats;
+
+    //! Flushed trace events.
+    std::vector<TraceEvent> mTrace;
+
+    //! Analysis of the traced flow graph calculations.
+    std::vector<GraphCalcAnalysis> mGraphCalcs;
+
+    //! The number of threads available for the flow graph.
+    int mNumThreads;
+};
+
+#endif // _ACTIVITY_PROFILER_H_
@@ -0,0 +1,98 @@
+#ifndef _ISHARDABLE_VISITOR_H_
+#define _ISHARDABLE_VISITOR_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file ishardable_visitor.h
+ * \ingroup Objects
+ * \brief IShardableVisitor class header file.
+ */
+
+class IVisitor;
+
+/*!
+ * \brief An interface to a visitor which is able to visit each region
+ *        independently and have the results stitched back together.
+ * \details Reporting visitors typically walk the entire World after a scenario
+ *          has finished at which point the model state is read-only.  A visitor
+ *          which implements this interface in addition to IVisitor lets the World
+ *          visit regions concurrently.  The World will ask the visitor to create
+ *          one shard per region, visit each region with its shard (potentially in
+ *          parallel), then hand each shard back to the visitor to merge strictly
+ *          in region order so that the results are deterministic and identical to
+ *          a serial traversal.
+ * \note Shards must not share any mutable state with the parent visitor or each
+ *       other as they may be visited from separate threads.  Merging always
+ *       happens from the thread which called World::accept.
+ */
+class IShardableVisitor {
+public:
+    //! Virtual destructor so that instances of the interface may be deleted
+    //! correctly through a pointer to the interface.
+    inline virtual ~IShardableVisitor();
+
+    /*!
+     * \brief Whether regions should be visited in shards for this traversal.
+     * \details This allows a visitor to fall back to a regular serial traversal,
+     *          for instance when parallel execution is not available.
+     * \return True if the World should visit the regions using shards.
+     */
+    virtual bool shouldShardRegions() const = 0;
+
+    /*!
+     * \brief Create a new visitor which will be used to visit a single region.
+     * \details The caller takes ownership of the returned visitor and will
+     *          delete it after it has been passed to mergeRegionShard.
+     * \return A new visitor to visit a single region.
+     */
+    virtual IVisitor* createRegionShard() const = 0;
+
+    /*!
+     * \brief Merge the results of a shard which has completed visiting a region.
+     * \details Shards are merged in the same order as the regions are stored in
+     *          the World.
+     * \param aShard A shard which was previously created by createRegionShard.
+     */
+    virtual void mergeRegionShard( IVisitor* aShard ) = 0;
+};
+
+// Inline methods
+IShardableVisitor::~IShardableVisitor(){
+}
+
+#endif // _ISHARDABLE_VISITOR_H_
@@ -45,12 +45,20 @@
 
 #include <cassert>
 #include <forward_list>
+#include <vector>
+#include <map>
+#include <string>
+#include <functional>
+#include <utility>
 #include "util/base/include/definitions.h"
+#include "parallel/include/bitvector.hpp"
 
 class Value;
 
 #if GCAM_PARALLEL_ENABLED
 #include <tbb/task_arena.h>
+#include <tbb/concurrent_queue.h>
+class NodeBindingObserver;
 #endif
 
 /*!
@@ -66,6 +74,29 @@ class Value;
  *          developers do not need to worry about any of this.  All they have to do
  *          is ensure they appropriately tag their STATE Data.
  *
+ *          When the activity-state-reset configuration option is turned on the
+ *          state is laid out contiguously by the IActivity which calculates the
+ *          object containing it, in the global ordering.  State which is not
+ *          contained in an object calculated by an activity, such as in markets,
+ *          is shared and placed first.  A partial derivative then only needs to
+ *          reset the shared state, the state of the activities it will calculate,
+ *          and the state left changed by the previous calculation in the same
+ *          "scratch" space.  This relies on activities only changing STATE in
+ *          the objects they calculate, the shared state, or objects calculated
+ *          by activities which depend on them, which debug builds check before
+ *          each partial reset.
+ *
+ *          When the numa-aware configuration option is set and the machine has
+ *          more than one NUMA node, a thread pool is also created per node with
+ *          its workers bound to that node.  Each "scratch" space is assigned to
+ *          a node and first written from it so that its memory is local to the
+ *          threads which will use it.  A thread entering the thread pool of a
+ *          node trades the "scratch" space it holds for one of that node so
+ *          that the space follows the pool rather than the thread.  Regions are
+ *          assigned to nodes in contiguous blocks so that work such as Jacobian
+ *          columns can be run on the node which owns the region it mostly
+ *          touches.
+ *
  * \author Pralit Patel
  */
 class ManageStateVariables {
@@ -75,6 +106,8 @@ public:
     
     void copyState();
     
+    void copyState( const bitvector& aActivities );
+    
     void setPartialDeriv( const bool aIsPartialDeriv );
     
 #if GCAM_PARALLEL_ENABLED
@@ -83,6 +116,11 @@ public:
     //! appropriately sized and allocated a slot in mStateData for each thread to
     //! have as "scratch" space for it's computations.
     tbb::task_arena mThreadPool;
+    
+    int getRegionNode( const std::string& aRegionName ) const;
+    
+    void parallelForEachByNode( const std::vector<int>& aItems, const std::vector<int>& aItemNodes,
+                                const std::function<void( const int )>& aFunction );
 #endif
     
 private:
@@ -120,8 +158,61 @@ private:
     //! - When we are done with this period copy the "base" state back into each Value.
     std::forward_list<Value*> mStateValues;
     
+    //! The object calculated by an activity which contains each Value in
+    //! mStateValues, or null if none does.  This is only used while collecting.
+    std::forward_list<const void*> mStateOwners;
+    
+    //! Whether the state is laid out by activity so that partial derivatives
+    //! can reset only the state of the activities they calculate.
+    bool mIsPartitioned;
+    
+    //! The number of shared state values at the start of each state which are
+    //! not calculated by a single activity and are always reset.
+    size_t mNumShared;
+    
+    //! The range [first, second) in each state of the values calculated by
+    //! each activity, indexed by global ordering.  Activities which calculate
+    //! the same object share a range.
+    std::vector<std::pair<size_t, size_t> > mActivityStateRange;
+    
+    //! The activities whose state may differ from the "base" state in each
+    //! "scratch" space, indexed as mStateData.
+    std::vector<bitvector> mScratchChanged;
+    
+#if GCAM_PARALLEL_ENABLED
+    struct NodeThreadPool;
+    
+    //! A thread pool per NUMA node with its workers bound to that node, empty
+    //! unless NUMA aware execution is enabled.
+    std::vector<NodeThreadPool*> mNodeThreadPools;
+    
+    //! The NUMA node the calculations of each region are assigned to.
+    std::map<std::string, int> mRegionNodes;
+    
+    //! The NUMA node whose threads are given each state in mStateData first,
+    //! or -1 for any thread.
+    std::vector<int> mStateNodes;
+    
+    //! The states in mStateData which are not held by any thread while
+    //! calculating partial derivatives, by the NUMA node they are assigned to.
+    std::vector<tbb::concurrent_queue<int> > mFreeStates;
+    
+    //! Whether threads are currently given "scratch" spaces.
+    bool mIsPartialDeriv;
+    
+    void createNodeThreadPools();
+    
+    void moveToNode( const int aNode );
+    
+    friend class NodeBindingObserver;
+#endif
+    
     void collectState();
     
+    void layoutByActivity();
+    
+    size_t getScratchIndex() const;
+    
     void resetState();
     
     /*!
@@ -143,6 +234,16 @@ private:
         //! is found.
         bool mIgnoreCurrValue = false;
         
+        //! The object calculated by an activity which we are currently in, or
+        //! null if we are not in one.
+        const void* mCurrOwner = 0;
+        
+        void addStateValue( Value* aValue );
+        
+        void setOwner( const void* aOwner );
+        
+        void resetOwner( const void* aOwner );
+        
         // Templated callbacks for GCAMFusion
         template<typename DataType>
         void processData( DataType& aData );
@@ -67,6 +67,9 @@ public:
     ~SupplyDemandCurve();
     void calculatePoints( const int aNumPoints, SolutionInfoSet& aSolnSet, World* aWorld,
                           Marketplace* aMarketplace, const int aPeriod );
+    static void calculateCurves( const std::vector<SupplyDemandCurve*>& aCurves, const int aNumPoints,
+                                 SolutionInfoSet& aSolnSet, World* aWorld, Marketplace* aMarketplace,
+                                 const int aPeriod );
    void print( ILogger& aSDLog ) const;
 
 private:
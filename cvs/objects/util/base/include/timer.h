@@ -109,6 +109,7 @@ public:
         EDFUN_POST,
         EDFUN_AN_RESET,
         WRITE_DATA,
+        LINEAR_SOLVE,
         END
     };
     
@@ -0,0 +1,77 @@
+#ifndef _XML_COMPONENT_LOADER_H_
+#define _XML_COMPONENT_LOADER_H_
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file xml_component_loader.h
+ * \ingroup Objects
+ * \brief XMLComponentLoader class header file.
+ */
+
+#include <list>
+#include <string>
+
+class IParsable;
+
+/*!
+ * \ingroup Objects
+ * \brief Parses a list of XML files concurrently and applies them to a model
+ *        element in order.
+ * \details Reading a scenario consists of parsing dozens of scenario component
+ *          files, each of which is tokenized (and optionally validated) by
+ *          Xerces and then applied to the Scenario.  The first step is
+ *          independent for each file so this loader parses files on as many
+ *          threads as are available, each with its own parser, while the parsed
+ *          documents are handed to the model element strictly in the order
+ *          given so that add / merge / delete semantics are exactly the same as
+ *          parsing the files one at a time.  Only a bounded number of documents
+ *          are held in memory at once.
+ *
+ *          When parallel execution is not enabled the files are simply parsed
+ *          and applied one after the other.
+ * \note The Xerces platform must already be initialized, which is the case
+ *       once any file has been parsed with XMLHelper::parseXML.
+ */
+class XMLComponentLoader {
+public:
+    static bool parseXMLFiles( const std::list<std::string>& aXMLFiles,
+                               IParsable* aModelElement,
+                               const bool aValidate );
+};
+
+#endif // _XML_COMPONENT_LOADER_H_
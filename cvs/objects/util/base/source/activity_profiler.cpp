@@ -0,0 +1,514 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file activity_profiler.cpp
+ * \ingroup Objects
+ * \brief ActivityProfiler class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/task_scheduler_init.h>
+#include "parallel/include/gcam_parallel.hpp"
+#endif
+
+#include "util/base/include/activity_profiler.h"
+#include "util/base/include/configuration.h"
+#include "util/base/include/util.h"
+#include "containers/include/iactivity.h"
+
+using namespace std;
+
+namespace {
+#if GCAM_PARALLEL_ENABLED
+    //! The next index to give to a thread which records events.
+    atomic<int> gNextThread( 0 );
+#else
+    int gNextThread = 0;
+#endif
+
+    /*!
+     * \brief Write a string value to JSON, escaping as necessary.
+     * \param aOut The stream to write to.
+     * \param aValue The value to write.
+     */
+    void writeString( ostream& aOut, const string& aValue ) {
+        aOut << '"';
+        for( string::const_iterator it = aValue.begin(); it != aValue.end(); ++it ) {
+            if( *it == '"' || *it == '\\' ) {
+                aOut << '\\';
+            }
+            aOut << *it;
+        }
+        aOut << '"';
+    }
+
+    //! Order activity statistics from the most to the least total time.
+    template<class T>
+    bool greaterTotalTime( const T& aLHS, const T& aRHS ) {
+        return aLHS.second.mTotalTime > aRHS.second.mTotalTime;
+    }
+}
+
+//! Constructor
+ActivityProfiler::ActivityStats::ActivityStats():
+mCount( 0 ),
+mTotalTime( 0 ),
+mMaxTime( 0 )
+{
+}
+
+/*!
+ * \brief Add a single calculation.
+ * \param aDuration The time the calculation took.
+ */
+void ActivityProfiler::ActivityStats::add( const double aDuration ) {
+    ++mCount;
+    mTotalTime += aDuration;
+    mMaxTime = max( mMaxTime, aDuration );
+}
+
+/*!
+ * \brief Add all of the calculations of another set of statistics.
+ * \param aOther The statistics to merge in.
+ */
+void ActivityProfiler::ActivityStats::merge( const ActivityStats& aOther ) {
+    mCount += aOther.mCount;
+    mTotalTime += aOther.mTotalTime;
+    mMaxTime = max( mMaxTime, aOther.mMaxTime );
+}
+
+//! Constructor
+ActivityProfiler::ThreadState::ThreadState():
+mThread( gNextThread++ ),
+mCurrCalc( -1 ),
+mCalcEvent( 0 ),
+mGrainStart( 0 )
+{
+}
+
+//! Constructor
+ActivityProfiler::ActivityProfiler():
+mIsEnabled( Configuration::getInstance()->shouldWriteFile( "activity-profile", false, false ) ),
+mMaxTraceCalcs( 0 ),
+mEpoch( chrono::steady_clock::now() ),
+mGrainSchedule( 0 ),
+mOrdering( 0 ),
+mNumCalcs( 0 ),
+mGraphCalc( -1 ),
+#if GCAM_PARALLEL_ENABLED
+mNumThreads( tbb::task_scheduler_init::default_num_threads() )
+#else
+mNumThreads( 1 )
+#endif
+{
+    if( mIsEnabled ) {
+        const Configuration* conf = Configuration::getInstance();
+        mFileName = conf->getFile( "activity-profile", "activity-profile.json", false );
+        if( conf->shouldAppendScnToFile( "activity-profile" ) ) {
+            mFileName = util::appendScenarioToFileName( mFileName );
+        }
+        mMaxTraceCalcs = conf->getInt( "activity-profile-trace-calcs", 20 );
+    }
+}
+
+/*!
+ * \brief Get the single instance of the profiler.
+ * \return The activity profiler.
+ */
+ActivityProfiler& ActivityProfiler::getInstance() {
+    static ActivityProfiler sInstance;
+    return sInstance;
+}
+
+/*!
+ * \brief Whether profiling has been enabled by the user.
+ * \details Callers should check this and avoid calling any of the recording
+ *          methods when it is not.
+ * \return True if activities are being profiled.
+ */
+bool ActivityProfiler::isEnabled() const {
+    return mIsEnabled;
+}
+
+/*!
+ * \brief Set the grain schedule which flow graph grain indices refer to.
+ * \param aSchedule The grain schedule or null if it is being destroyed.
+ * \param aOrdering The global ordering of activities the schedule refers to.
+ */
+void ActivityProfiler::setGrainSchedule( const GrainSchedule* aSchedule,
+                                         const vector<IActivity*>* aOrdering )
+{
+    mGrainSchedule = aSchedule;
+    mOrdering = aOrdering;
+}
+
+/*!
+ * \brief Get the recording state of the calling thread.
+ * \return The thread state.
+ */
+ActivityProfiler::ThreadState& ActivityProfiler::getThreadState() {
+#if GCAM_PARALLEL_ENABLED
+    return mThreadStates.local();
+#else
+    return mThreadState;
+#endif
+}
+
+/*!
+ * \brief The current time.
+ * \return Microseconds since the profiler was created.
+ */
+double ActivityProfiler::now() const {
+    return chrono::duration<double, micro>( chrono::steady_clock::now() - mEpoch ).count();
+}
+
+/*!
+ * \brief Start a call to World::calc in the calling thread.
+ * \param aPeriod The period being calculated.
+ * \param aIsFlowGraph Whether the calculation uses the flow graph, in which
+ *                     case activities calculated on any thread are attributed
+ *                     to it.
+ */
+void ActivityProfiler::startCalc( const int aPeriod, const bool aIsFlowGraph ) {
+    ThreadState& state = getThreadState();
+    state.mCurrCalc = mNumCalcs++;
+    if( aIsFlowGraph ) {
+        mGraphCalc = state.mCurrCalc;
+    }
+    if( state.mCurrCalc < mMaxTraceCalcs ) {
+        Event calcEvent;
+        calcEvent.mType = CALC;
+        calcEvent.mCalc = state.mCurrCalc;
+        calcEvent.mIndex = aPeriod;
+        calcEvent.mIsFlowGraph = aIsFlowGraph;
+        calcEvent.mActivity = 0;
+        calcEvent.mStart = now();
+        calcEvent.mDuration = 0;
+        state.mCalcEvent = state.mEvents.size();
+        state.mEvents.push_back( calcEvent );
+    }
+}
+
+/*!
+ * \brief End the call to World::calc in the calling thread.
+ */
+void ActivityProfiler::endCalc() {
+    ThreadState& state = getThreadState();
+    if( state.mCurrCalc < mMaxTraceCalcs ) {
+        Event& calcEvent = state.mEvents[ state.mCalcEvent ];
+        calcEvent.mDuration = now() - calcEvent.mStart;
+    }
+    if( mGraphCalc == state.mCurrCalc ) {
+        mGraphCalc = -1;
+    }
+    state.mCurrCalc = -1;
+}
+
+/*!
+ * \brief Calculate an activity and record the time it took.
+ * \param aActivity The activity to calculate.
+ * \param aPeriod The period to calculate.
+ */
+void ActivityProfiler::calcActivity( IActivity* aActivity, const int aPeriod ) {
+    ThreadState& state = getThreadState();
+    const double start = now();
+    aActivity->calc( aPeriod );
+    const double duration = now() - start;
+    state.mActivityStats[ aActivity ].add( duration );
+
+    const int calc = state.mCurrCalc != -1 ? state.mCurrCalc : static_cast<int>( mGraphCalc );
+    if( calc != -1 && calc < mMaxTraceCalcs ) {
+        Event activityEvent;
+        activityEvent.mType = ACTIVITY;
+        activityEvent.mCalc = calc;
+        activityEvent.mIndex = 0;
+        activityEvent.mIsFlowGraph = false;
+        activityEvent.mActivity = aActivity;
+        activityEvent.mStart = start;
+        activityEvent.mDuration = duration;
+        state.mEvents.push_back( activityEvent );
+    }
+}
+
+/*!
+ * \brief Start calculating a flow graph grain in the calling thread.
+ */
+void ActivityProfiler::startGrain() {
+    getThreadState().mGrainStart = now();
+}
+
+/*!
+ * \brief Finish calculating a flow graph grain in the calling thread.
+ * \param aGrainIndex The index of the grain in the grain schedule or -1 if the
+ *                    flow graph was not created from the schedule.
+ */
+void ActivityProfiler::endGrain( const int aGrainIndex ) {
+    ThreadState& state = getThreadState();
+    const int calc = mGraphCalc;
+    if( calc != -1 && calc < mMaxTraceCalcs ) {
+        Event grainEvent;
+        grainEvent.mType = GRAIN;
+        grainEvent.mCalc = calc;
+        grainEvent.mIndex = aGrainIndex;
+        grainEvent.mIsFlowGraph = true;
+        grainEvent.mActivity = 0;
+        grainEvent.mStart = state.mGrainStart;
+        grainEvent.mDuration = now() - state.mGrainStart;
+        state.mEvents.push_back( grainEvent );
+    }
+}
+
+/*!
+ * \brief Resolve all recorded events and aggregates to activity descriptions
+ *        and analyze the traced flow graph calculations.
+ * \details This must be called while the activities which were recorded still
+ *          exist, such as at the end of a scenario run, and while no model
+ *          calculations are in progress.
+ */
+void ActivityProfiler::flush() {
+    if( !mIsEnabled ) {
+        return;
+    }
+    vector<ThreadState*> states;
+#if GCAM_PARALLEL_ENABLED
+    for( tbb::enumerable_thread_specific<ThreadState>::iterator it = mThreadStates.begin(); it != mThreadStates.end(); ++it ) {
+        states.push_back( &*it );
+    }
+#else
+    states.push_back( &mThreadState );
+#endif
+
+    vector<Event> graphCalcs;
+    vector<Event> grains;
+    for( vector<ThreadState*>::const_iterator stateIt = states.begin(); stateIt != states.end(); ++stateIt ) {
+        ThreadState& state = **stateIt;
+        typedef boost::unordered_map<const IActivity*, ActivityStats>::const_iterator StatsIterator;
+        for( StatsIterator it = state.mActivityStats.begin(); it != state.mActivityStats.end(); ++it ) {
+            mStats[ it->first->getDescription() ].merge( it->second );
+        }
+        state.mActivityStats.clear();
+
+        for( vector<Event>::const_iterator it = state.mEvents.begin(); it != state.mEvents.end(); ++it ) {
+            TraceEvent traceEvent;
+            traceEvent.mThread = state.mThread;
+            traceEvent.mCalc = it->mCalc;
+            traceEvent.mStart = it->mStart;
+            traceEvent.mDuration = it->mDuration;
+            if( it->mType == CALC ) {
+                traceEvent.mName = "World::calc period " + util::toString( it->mIndex );
+                traceEvent.mCategory = "calc";
+                if( it->mIsFlowGraph ) {
+                    graphCalcs.push_back( *it );
+                }
+            }
+            else if( it->mType == GRAIN ) {
+                traceEvent.mName = "grain " + util::toString( it->mIndex );
+                traceEvent.mCategory = "grain";
+                grains.push_back( *it );
+            }
+            else {
+                traceEvent.mName = it->mActivity->getDescription();
+                traceEvent.mCategory = "activity";
+            }
+            mTrace.push_back( traceEvent );
+        }
+        state.mEvents.clear();
+    }
+
+    for( vector<Event>::const_iterator calcIt = graphCalcs.begin(); calcIt != graphCalcs.end(); ++calcIt ) {
+        vector<Event> calcGrains;
+        for( vector<Event>::const_iterator it = grains.begin(); it != grains.end(); ++it ) {
+            if( it->mCalc == calcIt->mCalc ) {
+                calcGrains.push_back( *it );
+            }
+        }
+        analyzeGraphCalc( *calcIt, calcGrains );
+    }
+}
+
+/*!
+ * \brief Find the critical path and total work of a flow graph calculation.
+ * \details The grain schedule is in topological order so the longest path to
+ *          each grain can be found in a single sweep.  Grains which were not
+ *          calculated, because they were masked out, take no time.
+ * \param aCalc The calc event.
+ * \param aGrains The grain events of the calculation.
+ */
+void ActivityProfiler::analyzeGraphCalc( const Event& aCalc, const vector<Event>& aGrains ) {
+    GraphCalcAnalysis analysis;
+    analysis.mCalc = aCalc.mCalc;
+    analysis.mPeriod = aCalc.mIndex;
+    analysis.mElapsed = aCalc.mDuration / 1.0e6;
+    analysis.mWork = 0;
+    analysis.mCriticalPath = -1;
+    for( vector<Event>::const_iterator it = aGrains.begin(); it != aGrains.end(); ++it ) {
+        analysis.mWork += it->mDuration / 1.0e6;
+    }
+
+#if GCAM_PARALLEL_ENABLED
+    if( mGrainSchedule ) {
+        const int numGrains = static_cast<int>( mGrainSchedule->mGrainNodes.size() );
+        vector<double> grainTime( numGrains, 0.0 );
+        bool fromSchedule = true;
+        for( vector<Event>::const_iterator it = aGrains.begin(); it != aGrains.end(); ++it ) {
+            if( it->mIndex < 0 || it->mIndex >= numGrains ) {
+                fromSchedule = false;
+                break;
+            }
+            grainTime[ it->mIndex ] += it->mDuration / 1.0e6;
+        }
+        if( fromSchedule && numGrains > 0 ) {
+            vector<double> pathTo( numGrains, 0.0 );
+            vector<double> finish( numGrains, 0.0 );
+            vector<int> prev( numGrains, -1 );
+            int last = 0;
+            for( int grain = 0; grain < numGrains; ++grain ) {
+                finish[ grain ] = pathTo[ grain ] + grainTime[ grain ];
+                if( finish[ grain ] > finish[ last ] ) {
+                    last = grain;
+                }
+                const vector<int>& successors = mGrainSchedule->mGrainSuccessors[ grain ];
+                for( vector<int>::const_iterator succIt = successors.begin(); succIt != successors.end(); ++succIt ) {
+                    if( finish[ grain ] > pathTo[ *succIt ] ) {
+                        pathTo[ *succIt ] = finish[ grain ];
+                        prev[ *succIt ] = grain;
+                    }
+                }
+            }
+            analysis.mCriticalPath = finish[ last ];
+            for( int grain = last; grain != -1; grain = prev[ grain ] ) {
+                if( grainTime[ grain ] > 0 ) {
+                    const vector<int>& grainNodes = mGrainSchedule->mGrainNodes[ grain ];
+                    CriticalGrain criticalGrain;
+                    criticalGrain.mGrain = grain;
+                    criticalGrain.mTime = grainTime[ grain ];
+                    criticalGrain.mNumActivities = static_cast<int>( grainNodes.size() );
+                    criticalGrain.mFirstActivity = mOrdering && !grainNodes.empty() ?
+                        (*mOrdering)[ grainNodes.front() ]->getDescription() : "";
+                    analysis.mCriticalGrains.push_back( criticalGrain );
+                }
+            }
+            reverse( analysis.mCriticalGrains.begin(), analysis.mCriticalGrains.end() );
+        }
+    }
+#endif
+    mGraphCalcs.push_back( analysis );
+}
+
+/*!
+ * \brief Write the trace, aggregates, and analysis to the "activity-profile"
+ *        file.
+ * \details Any events recorded since the last flush() are not included.
+ */
+void ActivityProfiler::write() const {
+    if( !mIsEnabled ) {
+        return;
+    }
+    ofstream out( mFileName.c_str() );
+    util::checkIsOpen( out, mFileName );
+    out << setprecision( 10 );
+
+    out << "{\n  \"traceEvents\": [";
+    for( size_t i = 0; i < mTrace.size(); ++i ) {
+        const TraceEvent& event = mTrace[ i ];
+        out << ( i == 0 ? "\n" : ",\n" ) << "    { \"name\": ";
+        writeString( out, event.mName );
+        out << ", \"cat\": \"" << event.mCategory << "\", \"ph\": \"X\", \"ts\": " << event.mStart
+            << ", \"dur\": " << event.mDuration << ", \"pid\": 1, \"tid\": " << event.mThread
+            << ", \"args\": { \"calc\": " << event.mCalc << " } }";
+    }
+    out << ( mTrace.empty() ? "]" : "\n  ]" )
+        << ",\n  \"displayTimeUnit\": \"ms\""
+        << ",\n  \"threads\": " << mNumThreads
+        << ",\n  \"activities\": [";
+
+    typedef pair<string, ActivityStats> StatsEntry;
+    vector<StatsEntry> sortedStats( mStats.begin(), mStats.end() );
+    sort( sortedStats.begin(), sortedStats.end(), greaterTotalTime<StatsEntry> );
+    for( size_t i = 0; i < sortedStats.size(); ++i ) {
+        const ActivityStats& stats = sortedStats[ i ].second;
+        out << ( i == 0 ? "\n" : ",\n" ) << "    { \"description\": ";
+        writeString( out, sortedStats[ i ].first );
+        out << ", \"count\": " << stats.mCount
+            << ", \"total-time\": " << stats.mTotalTime / 1.0e6
+            << ", \"mean-time\": " << ( stats.mCount > 0 ? stats.mTotalTime / stats.mCount / 1.0e6 : 0.0 )
+            << ", \"max-time\": " << stats.mMaxTime / 1.0e6 << " }";
+    }
+    out << ( sortedStats.empty() ? "]" : "\n  ]" ) << ",\n  \"flow-graph-calcs\": [";
+
+    for( size_t i = 0; i < mGraphCalcs.size(); ++i ) {
+        const GraphCalcAnalysis& analysis = mGraphCalcs[ i ];
+        out << ( i == 0 ? "\n" : ",\n" )
+            << "    {\n      \"calc\": " << analysis.mCalc
+            << ",\n      \"period\": " << analysis.mPeriod
+            << ",\n      \"elapsed\": " << analysis.mElapsed
+            << ",\n      \"work\": " << analysis.mWork
+            << ",\n      \"parallel-efficiency\": ";
+        if( analysis.mElapsed > 0 ) {
+            out << analysis.mWork / ( analysis.mElapsed * mNumThreads );
+        }
+        else {
+            out << "null";
+        }
+        out << ",\n      \"critical-path\": ";
+        if( analysis.mCriticalPath >= 0 ) {
+            out << analysis.mCriticalPath << ",\n      \"speedup-bound\": ";
+            if( analysis.mCriticalPath > 0 ) {
+                out << analysis.mWork / analysis.mCriticalPath;
+            }
+            else {
+                out << "null";
+            }
+        }
+        else {
+            out << "null,\n      \"speedup-bound\": null";
+        }
+        out << ",\n      \"critical-path-grains\": [";
+        for( size_t j = 0; j < analysis.mCriticalGrains.size(); ++j ) {
+            const CriticalGrain& grain = analysis.mCriticalGrains[ j ];
+            out << ( j == 0 ? "\n" : ",\n" ) << "        { \"grain\": " << grain.mGrain
+                << ", \"time\": " << grain.mTime << ", \"activities\": " << grain.mNumActivities
+                << ", \"first-activity\": ";
+            writeString( out, grain.mFirstActivity );
+            out << " }";
+        }
+        out << ( analysis.mCriticalGrains.empty() ? "]" : "\n      ]" ) << "\n    }";
+    }
+    out << ( mGraphCalcs.empty() ? "]" : "\n  ]" ) << "\n}\n";
+}
@@ -39,6 +39,8 @@
  */
 
 #include <cstring>
+#include <algorithm>
+#include <unordered_map>
 
 #include "util/base/include/manage_state_variables.hpp"
 #include "util/base/include/value.h"
@@ -46,10 +48,18 @@
 #include "util/logger/include/ilogger.h"
 #include "util/base/include/gcam_fusion.hpp"
 #include "util/base/include/gcam_data_containers.h"
+#include "util/base/include/configuration.h"
+#include "containers/include/iactivity.h"
+#include "containers/include/market_dependency_finder.h"
 
 #if GCAM_PARALLEL_ENABLED
-#include <tbb/concurrent_queue.h>
+#include <memory>
 #include <tbb/task_scheduler_init.h>
+#include <tbb/task_scheduler_observer.h>
+#include <tbb/task_group.h>
+#include <tbb/parallel_for_each.h>
+#include "containers/include/world.h"
+#include "parallel/include/numa_topology.hpp"
 #endif
 
 using namespace std;
@@ -69,6 +79,30 @@ double* Value::sBaseCentralValue( 0 );
 #endif
 
 #if GCAM_PARALLEL_ENABLED
+/*!
+ * \brief Take an unused state slot, preferring one assigned to the given node.
+ * \details Aborts if every state slot is already in use.
+ * \param aFreeStates Thread safe queues, one per NUMA node, of the unused
+ *        indices into ManageStateVariables::mStateData.
+ * \param aNode The preferred node or -1 for none.
+ * \return The index of the state slot which the caller now holds.
+ */
+static int takeFreeState( vector<tbb::concurrent_queue<int> >& aFreeStates, const int aNode ) {
+    const int numQueues = static_cast<int>( aFreeStates.size() );
+    int nextState;
+    bool gotState = aNode >= 0 && aNode < numQueues && aFreeStates[ aNode ].try_pop( nextState );
+    for( int queue = 0; !gotState && queue < numQueues; ++queue ) {
+        gotState = aFreeStates[ queue ].try_pop( nextState );
+    }
+    if( !gotState ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::SEVERE );
+        mainLog << "Failed to get an unused state to assign to a worker thread." << endl;
+        abort();
+    }
+    return nextState;
+}
+
 /*!
  * \brief A helper functor to assign a state slot in ManageStateVariables::mStateData
  *        to each worker thread in ManageStateVariables::mThreadPool.  This functor
@@ -80,21 +114,14 @@ struct AssignThreadStateFun {
     //! A reference to ManageStateVariables::mStateData.
     double** mArr;
     
-    //! The maximum number of states that have been allocated in mStateData.
-    const int mMaxStates;
-    
-    //! A thread safe queue that will have as values each index into mStateData
-    //! and as each new thread consumes it's next value implies that thread gets
-    //! assigned that state slot.
-    tbb::concurrent_queue<int> mThreadStateIndex;
+    //! A reference to ManageStateVariables::mFreeStates which as each new thread
+    //! consumes it's next value implies that thread gets assigned that state slot.
+    vector<tbb::concurrent_queue<int> >* mFreeStates;
     
     //! Constructor
-    AssignThreadStateFun( double** aArr, const int aMaxStates ):mArr( aArr ), mMaxStates( aMaxStates ) {
-        // initialize the state index slots starting from 1 as 0 is always the
-        // "base" state.
-        for( int i = 1; i < mMaxStates; ++i ) {
-            mThreadStateIndex.push( i );
-        }
+    AssignThreadStateFun( double** aArr, vector<tbb::concurrent_queue<int> >& aFreeStates ):
+    mArr( aArr ), mFreeStates( &aFreeStates )
+    {
     }
     
     /*!
@@ -106,17 +133,61 @@ struct AssignThreadStateFun {
      *         free from interference from any other thread.
      */
     double* operator()() {
-        int nextState;
-        bool gotState = mThreadStateIndex.try_pop( nextState );
-        if( !gotState ) {
-            ILogger& mainLog = ILogger::getLogger( "main_log" );
-            mainLog.setLevel( ILogger::SEVERE );
-            mainLog << "Failed to get an unused state to assign to a worker thread." << endl;
-            abort();
+        // Prefer a slot on the node this thread is bound to and otherwise take
+        // any which is left.
+        return mArr[ takeFreeState( *mFreeStates, NumaTopology::getCurrentThreadNode() ) ];
+    }
+};
+
+/*!
+ * \brief Binds each worker thread which enters a task arena to a NUMA node and
+ *        gives each thread which enters it a "scratch" space of that node.
+ * \note Observing a single task arena requires TBB_PREVIEW_LOCAL_OBSERVER to
+ *       be defined by the build.
+ */
+class NodeBindingObserver : public tbb::task_scheduler_observer {
+public:
+    NodeBindingObserver( tbb::task_arena& aArena, ManageStateVariables* aStateManager, const int aNode ):
+    tbb::task_scheduler_observer( aArena ), mStateManager( aStateManager ), mNode( aNode )
+    {
+        observe( true );
+    }
+    
+    virtual void on_scheduler_entry( bool aIsWorker ) {
+        // Workers move between arenas so they are bound each time they enter
+        // this one.  The calling thread keeps its own binding.
+        if( aIsWorker && NumaTopology::getCurrentThreadNode() != mNode ) {
+            NumaTopology::getInstance().bindCurrentThread( mNode );
         }
-        
-        return mArr[ nextState ];
+        mStateManager->moveToNode( mNode );
     }
+    
+private:
+    //! The state manager whose "scratch" spaces threads use.
+    ManageStateVariables* mStateManager;
+    
+    //! The node to bind workers to.
+    const int mNode;
+};
+
+/*!
+ * \brief A thread pool whose workers are bound to a single NUMA node.
+ */
+struct ManageStateVariables::NodeThreadPool {
+    NodeThreadPool( ManageStateVariables* aStateManager, const int aNode, const int aNumThreads ):
+    mNumThreads( aNumThreads ), mArena( aNumThreads ), mObserver( mArena, aStateManager, aNode )
+    {
+    }
+    
+    //! The number of threads the pool may use.
+    const int mNumThreads;
+    
+    //! The task arena which acts as the thread pool.
+    tbb::task_arena mArena;
+    
+    //! Binds the workers of mArena, declared after it so that it stops
+    //! observing before the arena is destroyed.
+    NodeBindingObserver mObserver;
 };
 #endif
 
@@ -136,8 +207,13 @@ mStateData( new double*[ NUM_STATES ] ),
 mPeriodToCollect( aPeriod ),
 mYearToCollect( scenario->getModeltime()->getper_to_yr( aPeriod ) ),
 mCCStartYear( mYearToCollect - scenario->getModeltime()->gettimestep( aPeriod ) + 1 ),
-mNumCollected( 0 )
+mNumCollected( 0 ),
+mIsPartitioned( Configuration::getInstance()->getBool( "activity-state-reset", false ) ),
+mNumShared( 0 )
 {
+#if GCAM_PARALLEL_ENABLED
+    createNodeThreadPools();
+#endif
     collectState();
 }
 
@@ -155,10 +231,168 @@ ManageStateVariables::~ManageStateVariables() {
     Value::sCentralValue = 0;
 #else
     Value::sCentralValue.clear();
+    for( auto nodeThreadPool : mNodeThreadPools ) {
+        delete nodeThreadPool;
+    }
 #endif
     Value::sBaseCentralValue = 0;
 }
 
+#if GCAM_PARALLEL_ENABLED
+/*!
+ * \brief Create the thread pool for each NUMA node and assign "scratch" spaces
+ *        and regions to the nodes if NUMA aware execution is enabled.
+ * \details Each node is given as many "scratch" spaces as it has CPUs and the
+ *          regions are split into contiguous blocks of about equal size in the
+ *          order they were read in.
+ */
+void ManageStateVariables::createNodeThreadPools() {
+    mStateNodes.assign( NUM_STATES, -1 );
+    mIsPartialDeriv = false;
+    const NumaTopology& topology = NumaTopology::getInstance();
+    const int numNodes = topology.getNumNodes();
+    if( !Configuration::getInstance()->getBool( "numa-aware" ) || numNodes < 2 ) {
+        mFreeStates.resize( 1 );
+        return;
+    }
+    
+    mFreeStates.resize( numNodes );
+    
+    size_t stateInd = 1;
+    for( int node = 0; node < numNodes; ++node ) {
+        const int numCPUs = topology.getNumCPUs( node );
+        mNodeThreadPools.push_back( new NodeThreadPool( this, node, numCPUs ) );
+        for( int cpu = 0; cpu < numCPUs && stateInd < mStateNodes.size(); ++cpu ) {
+            mStateNodes[ stateInd++ ] = node;
+        }
+    }
+    for( int node = 0; stateInd < mStateNodes.size(); ++stateInd, node = ( node + 1 ) % numNodes ) {
+        mStateNodes[ stateInd ] = node;
+    }
+    
+    // The output region map includes an entry for the global region at index zero.
+    const map<string, int> regionMap = scenario->getWorld()->getOutputRegionMap();
+    const int numRegions = static_cast<int>( regionMap.size() ) - 1;
+    for( auto region : regionMap ) {
+        if( region.second > 0 ) {
+            mRegionNodes[ region.first ] = ( region.second - 1 ) * numNodes / numRegions;
+        }
+    }
+    
+    ILogger& mainLog = ILogger::getLogger( "main_log" );
+    mainLog.setLevel( ILogger::DEBUG );
+    mainLog << "Using NUMA aware execution on " << numNodes << " nodes." << endl;
+}
+
+/*!
+ * \brief Get the NUMA node the calculations of a region are assigned to.
+ * \param aRegionName The name of the region.
+ * \return The node or -1 if NUMA aware execution is not enabled or the region
+ *         is not known.
+ */
+int ManageStateVariables::getRegionNode( const string& aRegionName ) const {
+    map<string, int>::const_iterator it = mRegionNodes.find( aRegionName );
+    return it != mRegionNodes.end() ? it->second : -1;
+}
+
+/*!
+ * \brief Call a function on each item in parallel, preferring to run each on
+ *        the threads of the NUMA node given for it.
+ * \details Without NUMA aware execution all items are run in mThreadPool.
+ *          Otherwise the items of each node are run in that node's thread pool
+ *          and the nodes run concurrently.  Items without a node are given to
+ *          the nodes with the least work per thread.
+ * \param aItems The items to call aFunction on.
+ * \param aItemNodes The node for each item or -1 if it has none.
+ * \param aFunction The function to call.
+ */
+void ManageStateVariables::parallelForEachByNode( const vector<int>& aItems, const vector<int>& aItemNodes,
+                                                  const function<void( const int )>& aFunction )
+{
+    /*! \pre A node is given for each item. */
+    assert( aItems.size() == aItemNodes.size() );
+    
+    if( mNodeThreadPools.empty() ) {
+        tbb::task_group tg;
+        mThreadPool.execute([&](){
+            tg.run([&](){
+                tbb::parallel_for_each( aItems.begin(), aItems.end(), aFunction );
+            });
+        });
+        mThreadPool.execute([&tg](){ tg.wait(); });
+        return;
+    }
+    
+    const int numNodes = static_cast<int>( mNodeThreadPools.size() );
+    vector<vector<int> > nodeItems( numNodes );
+    vector<int> unassigned;
+    for( size_t i = 0; i < aItems.size(); ++i ) {
+        if( aItemNodes[ i ] >= 0 && aItemNodes[ i ] < numNodes ) {
+            nodeItems[ aItemNodes[ i ] ].push_back( aItems[ i ] );
+        }
+        else {
+            unassigned.push_back( aItems[ i ] );
+        }
+    }
+    for( auto item : unassigned ) {
+        int leastLoaded = 0;
+        for( int node = 1; node < numNodes; ++node ) {
+            if( nodeItems[ node ].size() * mNodeThreadPools[ leastLoaded ]->mNumThreads <
+                nodeItems[ leastLoaded ].size() * mNodeThreadPools[ node ]->mNumThreads )
+            {
+                leastLoaded = node;
+            }
+        }
+        nodeItems[ leastLoaded ].push_back( item );
+    }
+    
+    // Start the work on every node before waiting on any of them.
+    unique_ptr<tbb::task_group[]> taskGroups( new tbb::task_group[ numNodes ] );
+    for( int node = 0; node < numNodes; ++node ) {
+        if( !nodeItems[ node ].empty() ) {
+            tbb::task_group& tg = taskGroups[ node ];
+            const vector<int>& items = nodeItems[ node ];
+            mNodeThreadPools[ node ]->mArena.execute([&](){
+                tg.run([&](){
+                    tbb::parallel_for_each( items.begin(), items.end(), aFunction );
+                });
+            });
+        }
+    }
+    for( int node = 0; node < numNodes; ++node ) {
+        if( !nodeItems[ node ].empty() ) {
+            tbb::task_group& tg = taskGroups[ node ];
+            mNodeThreadPools[ node ]->mArena.execute([&tg](){ tg.wait(); });
+        }
+    }
+}
+
+/*!
+ * \brief Give the calling thread a "scratch" space of the given NUMA node while
+ *        calculating partial derivatives.
+ * \details Called as a thread enters the thread pool of a node.  If the space
+ *          the thread holds belongs to another node it is returned and one of
+ *          this node is taken instead, if any are left, so that threads which
+ *          move between thread pools use memory local to the pool they are
+ *          working in.  Each space is held by at most one thread at a time.
+ * \param aNode The node whose thread pool the calling thread is entering.
+ */
+void ManageStateVariables::moveToNode( const int aNode ) {
+    if( !mIsPartialDeriv ) {
+        return;
+    }
+    
+    // Note a thread which has not used a "scratch" space yet will be assigned
+    // one here.
+    const size_t stateInd = getScratchIndex();
+    const int stateNode = mStateNodes[ stateInd ];
+    if( stateNode != aNode ) {
+        mFreeStates[ max( stateNode, 0 ) ].push( static_cast<int>( stateInd ) );
+        Value::sCentralValue.local() = mStateData[ takeFreeState( mFreeStates, aNode ) ];
+    }
+}
+#endif
+
 /*!
  * \brief Search for all relevant STATE Values and allocate space for them in the
  *        central state data arrays.  The "base" state will get initialized as the
@@ -181,13 +415,32 @@ void ManageStateVariables::collectState() {
     GCAMFusion<DoCollect, true, true, true> gatherState( doCollectProc, collectStateSteps );
     gatherState.startFilter( scenario );
     
+    if( mIsPartitioned ) {
+        layoutByActivity();
+    }
+    mStateOwners.clear();
+    
     // DoCollect has now gathered all active state into the mStateValues list to
     // allow faster/easier processing for the remaining tasks at hand.
     ILogger& mainLog = ILogger::getLogger( "main_log" );
     mainLog.setLevel( ILogger::DEBUG );
     mainLog << "Number of active state values: " << mNumCollected << endl;
+    if( mIsPartitioned ) {
+        mainLog << "Number of shared state values: " << mNumShared << endl;
+    }
     // Allocate space for each active state value for each state slot.
     for( size_t stateInd = 0; stateInd < NUM_STATES; ++stateInd ) {
+#if GCAM_PARALLEL_ENABLED
+        if( mStateNodes[ stateInd ] != -1 ) {
+            // Write the "scratch" space from its node so that the memory is
+            // placed on that node.
+            NumaTopology::getInstance().runOnNode( mStateNodes[ stateInd ], [this, stateInd]() {
+                mStateData[ stateInd ] = new double[ mNumCollected ];
+                fill( mStateData[ stateInd ], mStateData[ stateInd ] + mNumCollected, 0.0 );
+            } );
+            continue;
+        }
+#endif
         mStateData[ stateInd ] = new double[ mNumCollected ];
     }
     
@@ -212,6 +465,73 @@ void ManageStateVariables::collectState() {
     }
 }
 
+/*!
+ * \brief Reorder the collected state so that the values in the objects calculated
+ *        by each activity are contiguous.
+ * \details Objects are laid out in the global ordering of the first activity
+ *          which calculates them.  Values which are not in an object calculated
+ *          by an activity are shared and placed first.  If there are no
+ *          activities the state is not partitioned.
+ */
+void ManageStateVariables::layoutByActivity() {
+    const vector<IActivity*> ordering = scenario->getMarketplace()->getDependencyFinder()->getOrdering();
+    if( ordering.empty() ) {
+        mIsPartitioned = false;
+        return;
+    }
+    
+    // Number the objects in the order of the first activity to calculate them.
+    const size_t NO_BLOCK = static_cast<size_t>( -1 );
+    unordered_map<const void*, size_t> ownerBlock;
+    vector<size_t> activityBlock( ordering.size(), NO_BLOCK );
+    for( size_t i = 0; i < ordering.size(); ++i ) {
+        const void* owner = ordering[ i ]->getCalcObject();
+        if( owner ) {
+            activityBlock[ i ] = ownerBlock.insert( make_pair( owner, ownerBlock.size() ) ).first->second;
+        }
+    }
+    
+    // Sort the values into the objects that contain them.
+    vector<vector<Value*> > blocks( ownerBlock.size() );
+    vector<Value*> shared;
+    auto ownerIter = mStateOwners.begin();
+    for( auto currValue : mStateValues ) {
+        auto blockIter = *ownerIter ? ownerBlock.find( *ownerIter ) : ownerBlock.end();
+        if( blockIter != ownerBlock.end() ) {
+            blocks[ blockIter->second ].push_back( currValue );
+        }
+        else {
+            shared.push_back( currValue );
+        }
+        ++ownerIter;
+    }
+    
+    // Lay out the shared values followed by each block in order.
+    vector<Value*> layout;
+    layout.reserve( mNumCollected );
+    layout.insert( layout.end(), shared.begin(), shared.end() );
+    mNumShared = shared.size();
+    vector<pair<size_t, size_t> > blockRange( blocks.size() );
+    for( size_t blockInd = 0; blockInd < blocks.size(); ++blockInd ) {
+        blockRange[ blockInd ].first = layout.size();
+        layout.insert( layout.end(), blocks[ blockInd ].begin(), blocks[ blockInd ].end() );
+        blockRange[ blockInd ].second = layout.size();
+    }
+    mStateValues.assign( layout.begin(), layout.end() );
+    
+    mActivityStateRange.assign( ordering.size(), make_pair( size_t( 0 ), size_t( 0 ) ) );
+    for( size_t i = 0; i < ordering.size(); ++i ) {
+        if( activityBlock[ i ] != NO_BLOCK ) {
+            mActivityStateRange[ i ] = blockRange[ activityBlock[ i ] ];
+        }
+    }
+    
+    // No scratch space has been copied from the base state yet.
+    bitvector allActivities( ordering.size() );
+    allActivities.setall();
+    mScratchChanged.assign( NUM_STATES, allActivities );
+}
+
 /*!
  * \brief Copy the "base" state back into each corresponding Value object before
  *        we move on from this model period and release the state memory.
@@ -245,6 +565,100 @@ void ManageStateVariables::copyState() {
     memcpy( mStateData[1], mStateData[0], (sizeof( double)) * mNumCollected );
 #else
     memcpy( Value::sCentralValue.local(), mStateData[0], (sizeof( double)) * mNumCollected );
+#endif
+    if( mIsPartitioned ) {
+        // We do not know which activities will be calculated next.
+        mScratchChanged[ getScratchIndex() ].setall();
+    }
+}
+
+/*!
+ * \brief Copies the "base" state over the parts of the "scratch" space which the
+ *        given activities calculate.
+ * \details This method is called before a partial derivative calculation which
+ *          will only calculate aActivities.  In addition to their state the shared
+ *          state and the state changed by the last calculation in this "scratch"
+ *          space are reset, so that every value the calculation reads is either
+ *          from the "base" state or calculated by it.  If the state is not
+ *          partitioned by activity the entire state is copied.
+ * \param aActivities The activities, by global ordering, which will be calculated.
+ */
+void ManageStateVariables::copyState( const bitvector& aActivities ) {
+    if( !mIsPartitioned ) {
+        copyState();
+        return;
+    }
+    
+    const size_t stateInd = getScratchIndex();
+    double* scratch = mStateData[ stateInd ];
+    const double* base = mStateData[ 0 ];
+    bitvector& changed = mScratchChanged[ stateInd ];
+#ifndef NDEBUG
+    // The state of the activities which the last calculation in this "scratch"
+    // space did not calculate is not reset, so it must still match the "base"
+    // state.  Otherwise one of those activities wrote STATE outside of its own,
+    // the shared or its dependents' state.
+    for( size_t activity = 0; activity < mActivityStateRange.size(); ++activity ) {
+        const pair<size_t, size_t>& range = mActivityStateRange[ activity ];
+        if( !changed.get( activity ) && range.first < range.second &&
+            memcmp( scratch + range.first, base + range.first,
+                    (sizeof( double)) * ( range.second - range.first ) ) != 0 )
+        {
+            ILogger& mainLog = ILogger::getLogger( "main_log" );
+            mainLog.setLevel( ILogger::SEVERE );
+            mainLog << "State of activity " << activity << " in the global ordering was changed by a"
+                    << " partial derivative calculation which did not calculate it."
+                    << " Turn off activity-state-reset." << endl;
+            assert( false );
+        }
+    }
+#endif
+    changed.setunion( aActivities );
+    
+    vector<pair<size_t, size_t> > ranges;
+    bitvector_iterator it( &changed );
+    while( it.next() ) {
+        const pair<size_t, size_t>& range = mActivityStateRange[ it.bindex() ];
+        if( range.first < range.second ) {
+            ranges.push_back( range );
+        }
+    }
+    sort( ranges.begin(), ranges.end() );
+    
+    // Copy the shared state along with the ranges, merging adjacent ranges and
+    // those shared by several activities.
+    size_t runStart = 0;
+    size_t runEnd = mNumShared;
+    for( auto range : ranges ) {
+        if( range.first > runEnd ) {
+            memcpy( scratch + runStart, base + runStart, (sizeof( double)) * ( runEnd - runStart ) );
+            runStart = range.first;
+        }
+        runEnd = std::max( runEnd, range.second );
+    }
+    memcpy( scratch + runStart, base + runStart, (sizeof( double)) * ( runEnd - runStart ) );
+    
+    changed = aActivities;
+}
+
+/*!
+ * \brief Get the index in mStateData of the "scratch" space used by the calling
+ *        thread.
+ * \return The index of the "scratch" space.
+ */
+size_t ManageStateVariables::getScratchIndex() const {
+#if !GCAM_PARALLEL_ENABLED
+    return 1;
+#else
+    const double* scratch = Value::sCentralValue.local();
+    for( size_t stateInd = 1; stateInd < mScratchChanged.size(); ++stateInd ) {
+        if( mStateData[ stateInd ] == scratch ) {
+            return stateInd;
+        }
+    }
+    /*! \invariant The calling thread has been assigned a "scratch" space. */
+    assert( false );
+    return 0;
 #endif
 }
 
@@ -256,6 +670,11 @@ void ManageStateVariables::copyState() {
  *                        derivative or not as set from the solution algorithm.
  */
 void ManageStateVariables::setPartialDeriv( const bool aIsPartialDeriv ) {
+    // The "base" state may have changed since the "scratch" spaces were last
+    // copied, and threads may be assigned different ones.
+    for( auto& changed : mScratchChanged ) {
+        changed.setall();
+    }
 #if !GCAM_PARALLEL_ENABLED
     Value::sCentralValue = mStateData[ aIsPartialDeriv ? 1 : 0 ];
 #else
@@ -264,10 +683,18 @@ void ManageStateVariables::setPartialDeriv( const bool aIsPartialDeriv ) {
         Value::sCentralValue = Value::CentralValueType( mStateData[0] );
     }
     else {
-        // Use the AssignThreadStateFun helper functor to uniquely assign a state
-        // slot to each worker thread.
-        Value::sCentralValue = Value::CentralValueType( AssignThreadStateFun( mStateData, NUM_STATES ) );
+        // Make every "scratch" space available again, starting from 1 as 0 is
+        // always the "base" state, and use the AssignThreadStateFun helper
+        // functor to uniquely assign a state slot to each worker thread.
+        for( auto& freeStates : mFreeStates ) {
+            freeStates.clear();
+        }
+        for( size_t stateInd = 1; stateInd < mStateNodes.size(); ++stateInd ) {
+            mFreeStates[ max( mStateNodes[ stateInd ], 0 ) ].push( static_cast<int>( stateInd ) );
+        }
+        Value::sCentralValue = Value::CentralValueType( AssignThreadStateFun( mStateData, mFreeStates ) );
     }
+    mIsPartialDeriv = aIsPartialDeriv;
 #endif
 }
 
@@ -283,6 +710,41 @@ void Value::doStateCheck() const {
 }
 #endif
 
+/*!
+ * \brief Add an active state value along with the object which contains it.
+ * \param aValue The state value.
+ */
+void ManageStateVariables::DoCollect::addStateValue( Value* aValue ) {
+    mParentClass->mStateValues.push_front( aValue );
+    mParentClass->mStateOwners.push_front( mCurrOwner );
+    ++mParentClass->mNumCollected;
+}
+
+/*!
+ * \brief Note that we are stepping into an object which may be calculated by an
+ *        activity.
+ * \details The pointer must be of the same type as the one returned by the
+ *          IActivity::getCalcObject of the activity.  Objects nested in another
+ *          such object are considered part of the outer one.
+ * \param aOwner The object.
+ */
+void ManageStateVariables::DoCollect::setOwner( const void* aOwner ) {
+    if( !mCurrOwner ) {
+        mCurrOwner = aOwner;
+    }
+}
+
+/*!
+ * \brief Note that we are stepping out of an object which may be calculated by
+ *        an activity.
+ * \param aOwner The object.
+ */
+void ManageStateVariables::DoCollect::resetOwner( const void* aOwner ) {
+    if( mCurrOwner == aOwner ) {
+        mCurrOwner = 0;
+    }
+}
+
 template<typename DataType>
 void ManageStateVariables::DoCollect::processData( DataType& aData ) {
 #if DEBUG_STATE
@@ -297,8 +759,7 @@ void ManageStateVariables::DoCollect::processData<Value>( Value& aData ) {
     // Any SINGLE value that is tagged is considered active so long as it is not
     // contained in a retired technology for instance.
     if( !mIgnoreCurrValue ) {
-        mParentClass->mStateValues.push_front( &aData );
-        ++mParentClass->mNumCollected;
+        addStateValue( &aData );
     }
 }
 
@@ -307,8 +768,7 @@ void ManageStateVariables::DoCollect::processData<objects::PeriodVector<Value> >
     // When an ARRAY of values are tagged only the Value in [ mPeriodToCollect] is
     // considered active.
     if( !mIgnoreCurrValue ) {
-        mParentClass->mStateValues.push_front( &aData[ mParentClass->mPeriodToCollect ] );
-        ++mParentClass->mNumCollected;
+        addStateValue( &aData[ mParentClass->mPeriodToCollect ] );
     }
 }
 
@@ -324,8 +784,7 @@ void ManageStateVariables::DoCollect::processData<objects::PeriodVector<objects:
     if( !mIgnoreCurrValue && mParentClass->mPeriodToCollect > 0 ) {
         objects::YearVector<Value>& currEmiss = *aData[ mParentClass->mPeriodToCollect ];
         for( int year = mParentClass->mCCStartYear; year <= mParentClass->mYearToCollect; ++year ) {
-            mParentClass->mStateValues.push_front( &currEmiss[ year ] );
-            ++mParentClass->mNumCollected;
+            addStateValue( &currEmiss[ year ] );
         }
     }
 }
@@ -337,8 +796,7 @@ void ManageStateVariables::DoCollect::processData<objects::YearVector<Value> >(
     // to be from [mCCStartYear, mYearToCollect])
     if( !mIgnoreCurrValue ) {
         for( int year = std::max( mParentClass->mCCStartYear, aData.getStartYear() ); year <= mParentClass->mYearToCollect; ++year ) {
-            mParentClass->mStateValues.push_front( &aData[ year ] );
-            ++mParentClass->mNumCollected;
+            addStateValue( &aData[ year ] );
         }
     }
 }
@@ -382,3 +840,54 @@ void ManageStateVariables::DoCollect::popFilterStep<Market*>( Market* const& aDa
     mIgnoreCurrValue = false;
 }
 
+// The objects which are calculated by activities.  Note the pointers are converted
+// to the type held by each activity.
+template<>
+void ManageStateVariables::DoCollect::pushFilterStep<Sector*>( Sector* const& aData ) {
+    setOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::popFilterStep<Sector*>( Sector* const& aData ) {
+    resetOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::pushFilterStep<AResource*>( AResource* const& aData ) {
+    setOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::popFilterStep<AResource*>( AResource* const& aData ) {
+    resetOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::pushFilterStep<AFinalDemand*>( AFinalDemand* const& aData ) {
+    setOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::popFilterStep<AFinalDemand*>( AFinalDemand* const& aData ) {
+    resetOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::pushFilterStep<LandAllocator*>( LandAllocator* const& aData ) {
+    setOwner( static_cast<const ILandAllocator*>( aData ) );
+}
+
+template<>
+void ManageStateVariables::DoCollect::popFilterStep<LandAllocator*>( LandAllocator* const& aData ) {
+    resetOwner( static_cast<const ILandAllocator*>( aData ) );
+}
+
+template<>
+void ManageStateVariables::DoCollect::pushFilterStep<Consumer*>( Consumer* const& aData ) {
+    setOwner( aData );
+}
+
+template<>
+void ManageStateVariables::DoCollect::popFilterStep<Consumer*>( Consumer* const& aData ) {
+    resetOwner( aData );
+}
@@ -51,6 +51,12 @@
 #include "solution/util/include/edfun.hpp"
 #include "containers/include/scenario.h"
 #include "util/base/include/manage_state_variables.hpp"
+#include "solution/util/include/solution_info.h"
+
+#if GCAM_PARALLEL_ENABLED
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+#endif
 
 extern Scenario* scenario;
 
@@ -72,41 +78,50 @@ SupplyDemandCurve::~SupplyDemandCurve() {
 
 /*! \brief Calculate given number of supply and demand points.
 *
-* This function first determines a series of price ratios to use to determine the prices to 
-* create SupplyDemandPoints for. It then saves the original marketplace information, and perturbs the price
-* as specified by the price ratios. Using this new perturbed price, it call World::Calc to determine supply and 
-* demand for the market. It saves that point for printing later, and continues to perform this process for each price.
-* Finally it restores the original market information.
+* Calculates the points for this curve only.  When curves are needed for
+* several markets calculateCurves should be used instead so that all of the
+* points share a single base evaluation and can be run concurrently.
 *
 * \param aNumPoints The number of points to calculate.
 * \param aSolnSet The solution set to interact with markets through.
 * \param aWorld The World object to use for World::calc
 * \param aMarketplace The marketplace to use to store and restore information.
 * \param aPeriod The period to perform the calculations on.
-* \todo Un-hardcode the prices. 
+* \sa calculateCurves
 */
-
 void SupplyDemandCurve::calculatePoints( const int aNumPoints, SolutionInfoSet& aSolnSet, World* aWorld,
                                          Marketplace* aMarketplace, const int aPeriod )
 {
-    vector<double> priceMults;
-
-    // Determine price ratios.
-    const int middle = static_cast<int>( floor( double( aNumPoints ) / double( 2 ) ) );
-
-    for( int pointNumber = 0; pointNumber < aNumPoints; pointNumber++ ) {
+    calculateCurves( vector<SupplyDemandCurve*>( 1, this ), aNumPoints, aSolnSet, aWorld,
+                     aMarketplace, aPeriod );
+}
 
-        if( pointNumber < middle ) {
-            priceMults.push_back( 1 - double( 1 ) / double( middle - abs( middle - pointNumber ) + 2 ) );
-        }
-        else if( pointNumber == middle ) {
-            priceMults.push_back( 1 );
-        }
-        else {
-            priceMults.push_back( 1 + double( 1 ) / double( middle - abs( middle - pointNumber ) + 2 ) );
-        }
+/*! \brief Calculate given number of supply and demand points for a set of curves.
+*
+* This function first evaluates the model at the current prices and saves that as the
+* "base" state.  Each point is then calculated as a partial derivative style evaluation
+* in which only the price of the curve's market is changed and only the model components
+* which depend on that market are recalculated, starting from the base state.  Since the
+* ManageStateVariables gives each thread its own scratch copy of the state, the points,
+* across all curves, are independent and are calculated concurrently when
+* GCAM_PARALLEL_ENABLED.  Finally the base state is restored.
+*
+* \param aCurves The curves to calculate, any existing points are replaced.
+* \param aNumPoints The number of points to calculate for each curve.
+* \param aSolnSet The solution set to interact with markets through.
+* \param aWorld The World object to use for World::calc
+* \param aMarketplace The marketplace to use to store and restore information.
+* \param aPeriod The period to perform the calculations on.
+* \todo Un-hardcode the prices. 
+*/
+void SupplyDemandCurve::calculateCurves( const vector<SupplyDemandCurve*>& aCurves, const int aNumPoints,
+                                         SolutionInfoSet& aSolnSet, World* aWorld,
+                                         Marketplace* aMarketplace, const int aPeriod )
+{
+    if( aCurves.empty() || aNumPoints <= 0 ) {
+        return;
     }
-    
+
     size_t nsolv = aSolnSet.getNumSolvable();
     using UBVECTOR = boost::numeric::ublas::vector<double>;
     UBVECTOR x( nsolv ), fx( nsolv );
@@ -114,8 +129,6 @@ void SupplyDemandCurve::calculatePoints( const int aNumPoints, SolutionInfoSet&
     for( size_t i = 0; i < nsolv; ++i ) {
         x[i] = aSolnSet.getSolvable( i ).getPrice();
     }
-    
-    // double basePrice = x[ mMarketNumber ];
 
     // This is the closure that will evaluate the ED function
     LogEDFun F(aSolnSet, aWorld, aMarketplace, aPeriod, false);
@@ -126,21 +139,52 @@ void SupplyDemandCurve::calculatePoints( const int aNumPoints, SolutionInfoSet&
     // Have the state manage save the current state as a "clean" state.
     scenario->getManageStateVariables()->setPartialDeriv(true);
 
+    // Clear out any existing points and make room for the new ones so that each
+    // point can be stored directly by the task which calculates it.
+    for( vector<SupplyDemandCurve*>::const_iterator curveIter = aCurves.begin(); curveIter != aCurves.end(); ++curveIter ) {
+        for( vector<SupplyDemandPoint*>::iterator i = ( *curveIter )->mPoints.begin(); i != ( *curveIter )->mPoints.end(); ++i ) {
+            delete *i;
+        }
+        ( *curveIter )->mPoints.assign( aNumPoints, 0 );
+    }
+
+    // Note x is a scaled price
+    const double priceStep = double( 10 ) / double( max( aNumPoints - 1, 1 ) );
+    auto calcPoint = [&]( const int aIndex ) {
+        SupplyDemandCurve* curve = aCurves[ aIndex / aNumPoints ];
+        const int market = curve->mMarketNumber;
+        const int pointNumber = aIndex % aNumPoints;
+        // Temporaries so that concurrent points do not share inputs or outputs.
+        UBVECTOR xx( x ), fxx( nsolv );
+
+        F.partial( market );
+        xx[ market ] = pointNumber * priceStep;
+        F( xx, fxx, market );
+
+        // The solution info reads the market state for this thread.
+        const SolutionInfo& marketInfo = aSolnSet.getSolvable( market );
+        curve->mPoints[ pointNumber ] = new SupplyDemandPoint( marketInfo.getPrice(),
+                                                               marketInfo.getDemand(),
+                                                               marketInfo.getSupply(),
+                                                               fxx[ market ] );
+    };
+
     // iterate through the points and determine supply and demand.
-    for ( int pointNumber2 = 0; pointNumber2 < aNumPoints; pointNumber2++ ) {
-        
-        F.partial(mMarketNumber);
-        // Note x is a scaled price
-        // x[ mMarketNumber ] = priceMults[ pointNumber2 ] * basePrice;
-        x[ mMarketNumber ] = pointNumber2 * ( double( 10 ) / double( aNumPoints - 1 ) );
-        F(x, fx, mMarketNumber);
-
-        mPoints.push_back( new SupplyDemandPoint( aSolnSet.getSolvable( mMarketNumber ).getPrice(),
-                                                  aSolnSet.getSolvable( mMarketNumber ).getDemand(),
-                                                  aSolnSet.getSolvable( mMarketNumber ).getSupply(),
-                                                  fx[ mMarketNumber ] ) );
-
-    } // Completed iterating through all price points.
+    const int numEvals = static_cast<int>( aCurves.size() ) * aNumPoints;
+#if !GCAM_PARALLEL_ENABLED
+    for( int i = 0; i < numEvals; ++i ) {
+        calcPoint( i );
+    }
+#else
+    tbb::task_arena& threadPool = scenario->getManageStateVariables()->mThreadPool;
+    tbb::task_group tg;
+    threadPool.execute([&](){
+        tg.run([&](){
+            tbb::parallel_for( 0, numEvals, calcPoint );
+        });
+    });
+    threadPool.execute([&tg](){ tg.wait(); });
+#endif
 
     // restore state information for summary.
     F.partial(-1);
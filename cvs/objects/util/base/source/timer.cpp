@@ -199,6 +199,9 @@ void TimerRegistry::printAllTimers( ostream& aOut ) const {
             case EDFUN_AN_RESET:
                 timerName = "EDFUN affected nodes reset";
                 break;
+            case LINEAR_SOLVE:
+                timerName = "Linear solves";
+                break;
                 
             default: timerName = "Predefined timer";
         }
@@ -0,0 +1,200 @@
+/*
+* LEGAL NOTICE
+* This computer software was prepared by Battelle Memorial Institute,
+* hereinafter the Contractor, under Contract No. DE-AC05-76RL0 1830
+* with the Department of Energy (DOE). NEITHER THE GOVERNMENT NOR THE
+* CONTRACTOR MAKES ANY WARRANTY, EXPRESS OR IMPLIED, OR ASSUMES ANY
+* LIABILITY FOR THE USE OF THIS SOFTWARE. This notice including this
+* sentence must appear on any copies of this computer software.
+* 
+* EXPORT CONTROL
+* User agrees that the Software will not be shipped, transferred or
+* exported into any country or used in any manner prohibited by the
+* United States Export Administration Act or any other applicable
+* export laws, restrictions or regulations (collectively the "Export Laws").
+* Export of the Software may require some form of license or other
+* authority from the U.S. Government, and failure to obtain such
+* export control license may result in criminal liability under
+* U.S. laws. In addition, if the Software is identified as export controlled
+* items under the Export Laws, User represents and warrants that User
+* is not a citizen, or otherwise located within, an embargoed nation
+* (including without limitation Iran, Syria, Sudan, Cuba, and North Korea)
+*     and that User is not otherwise prohibited
+* under the Export Laws from receiving the Software.
+* 
+* Copyright 2011 Battelle Memorial Institute.  All Rights Reserved.
+* Distributed as open-source under the terms of the Educational Community 
+* License version 2.0 (ECL 2.0). http://www.opensource.org/licenses/ecl2.php
+* 
+* For further details, see: http://www.globalchange.umd.edu/models/gcam/
+*
+*/
+
+
+/*! 
+ * \file xml_component_loader.cpp
+ * \ingroup Objects
+ * \brief XMLComponentLoader class source file.
+ */
+
+#include "util/base/include/definitions.h"
+#include <vector>
+#include <memory>
+#include <iostream>
+#include <xercesc/parsers/XercesDOMParser.hpp>
+#include <xercesc/dom/DOM.hpp>
+#include <xercesc/sax/HandlerBase.hpp>
+#include <xercesc/util/XMLException.hpp>
+
+#if GCAM_PARALLEL_ENABLED
+#include <atomic>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
+#endif
+
+#include "util/base/include/xml_component_loader.h"
+#include "util/base/include/xml_helper.h"
+#include "util/base/include/iparsable.h"
+#include "util/logger/include/ilogger.h"
+
+using namespace std;
+using namespace xercesc;
+
+namespace {
+    /*!
+     * \brief The result of parsing a single file.
+     */
+    struct ParsedFile {
+        ParsedFile():mIndex( 0 ), mDocument( 0 ) {}
+        
+        //! The position of the file in the list of files.
+        size_t mIndex;
+        
+        //! The parsed document, owned by this struct, or null if parsing failed.
+        DOMDocument* mDocument;
+        
+        //! The error message if parsing failed.
+        string mError;
+    };
+    
+    /*!
+     * \brief Parse a single file with a parser private to the calling thread.
+     * \details The parser is configured the same as the one in XMLHelper except
+     *          that validation may be turned off.  Validation errors are ignored
+     *          by the HandlerBase error handler either way so skipping it changes
+     *          nothing for inputs without a grammar other than the time spent.
+     * \param aXMLFile The file to parse.
+     * \param aValidate Whether to do schema validation.
+     * \param aResult The result to set the document or error into.
+     */
+    void parseFile( const string& aXMLFile, const bool aValidate, ParsedFile& aResult ) {
+        XercesDOMParser parser;
+        parser.setValidationScheme( aValidate ? XercesDOMParser::Val_Always : XercesDOMParser::Val_Never );
+        parser.setDoNamespaces( false );
+        parser.setDoSchema( aValidate );
+        parser.setCreateCommentNodes( false ); // No comment nodes
+        parser.setIncludeIgnorableWhitespace( false ); // No text nodes
+        HandlerBase errorHandler;
+        parser.setErrorHandler( &errorHandler );
+        try {
+            parser.parse( aXMLFile.c_str() );
+            // Take ownership of the document so that it out lives the parser.
+            aResult.mDocument = parser.adoptDocument();
+        } catch ( const XMLException& toCatch ) {
+            aResult.mError = XMLHelper<string>::safeTranscode( toCatch.getMessage() );
+        } catch ( const DOMException& toCatch ) {
+            aResult.mError = XMLHelper<string>::safeTranscode( toCatch.msg );
+        } catch ( const SAXException& toCatch ){
+            aResult.mError = XMLHelper<string>::safeTranscode( toCatch.getMessage() );
+        } catch (...) {
+            aResult.mError = "Unexpected XML Read Exception.";
+        }
+    }
+    
+    /*!
+     * \brief Apply a parsed file to the model element and release the document.
+     * \param aXMLFile The name of the file which was parsed.
+     * \param aParsed The parsed file.
+     * \param aModelElement Element to call XMLParse on.
+     * \return Whether the file was parsed and applied successfully.
+     */
+    bool applyFile( const string& aXMLFile, ParsedFile& aParsed, IParsable* aModelElement ) {
+        ILogger& mainLog = ILogger::getLogger( "main_log" );
+        mainLog.setLevel( ILogger::NOTICE );
+        mainLog << "Parsing " << aXMLFile << " scenario component." << endl;
+        if( !aParsed.mDocument ) {
+            cout << "ERROR: XML Read Exception message is:" << endl << aParsed.mError << endl;
+            return false;
+        }
+        bool success = aModelElement->XMLParse( aParsed.mDocument->getDocumentElement() );
+        aParsed.mDocument->release();
+        aParsed.mDocument = 0;
+        return success;
+    }
+}
+
+/*!
+ * \brief Parse each of the given files and apply them, in order, to the given
+ *        model element.
+ * \details Files are parsed concurrently when parallel execution is enabled
+ *          however parsing stops at the first file which fails to parse or apply
+ *          the same as it would when parsing files one at a time.
+ * \param aXMLFiles The files to parse in the order they should be applied.
+ * \param aModelElement Element to call XMLParse on.
+ * \param aValidate Whether to do schema validation while parsing.  This should
+ *                  only be turned off for trusted inputs.
+ * \return Whether all files were parsed successfully.
+ */
+bool XMLComponentLoader::parseXMLFiles( const list<string>& aXMLFiles,
+                                        IParsable* aModelElement,
+                                        const bool aValidate )
+{
+    const vector<string> files( aXMLFiles.begin(), aXMLFiles.end() );
+    bool success = true;
+#if GCAM_PARALLEL_ENABLED
+    // Limit the number of documents in flight so that we do not need to hold all
+    // of the DOMs in memory at once.
+    const size_t maxInFlight = 2 * tbb::task_scheduler_init::default_num_threads();
+    size_t nextFile = 0;
+    // The first and last filters may run concurrently so the status they share
+    // must be atomic.
+    atomic<bool> applied( true );
+    tbb::parallel_pipeline( maxInFlight,
+        tbb::make_filter<void, ParsedFile*>( tbb::filter::serial_in_order,
+            [&]( tbb::flow_control& aFlowControl ) -> ParsedFile* {
+                if( nextFile == files.size() || !applied ) {
+                    aFlowControl.stop();
+                    return 0;
+                }
+                ParsedFile* parsed = new ParsedFile();
+                parsed->mIndex = nextFile++;
+                return parsed;
+            } ) &
+        tbb::make_filter<ParsedFile*, ParsedFile*>( tbb::filter::parallel,
+            [&files, aValidate]( ParsedFile* aParsed ) -> ParsedFile* {
+                parseFile( files[ aParsed->mIndex ], aValidate, *aParsed );
+                return aParsed;
+            } ) &
+        tbb::make_filter<ParsedFile*, void>( tbb::filter::serial_in_order,
+            [&]( ParsedFile* aParsed ) {
+                // Files which were already in flight when a previous one failed
+                // are discarded.
+                if( applied ) {
+                    applied = applyFile( files[ aParsed->mIndex ], *aParsed, aModelElement );
+                }
+                if( aParsed->mDocument ) {
+                    aParsed->mDocument->release();
+                }
+                delete aParsed;
+            } ) );
+    success = applied;
+#else
+    for( size_t i = 0; i < files.size() && success; ++i ) {
+        ParsedFile parsed;
+        parsed.mIndex = i;
+        parseFile( files[ i ], aValidate, parsed );
+        success = applyFile( files[ i ], parsed, aModelElement );
+    }
+#endif
+    return success;
+}